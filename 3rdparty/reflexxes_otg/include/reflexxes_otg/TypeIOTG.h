@@ -253,6 +253,67 @@ public:
 										,	double*			NewVelocity	);
 
 
+//  ---------------------- Doxygen info ----------------------
+//! \fn int CalculateTrajectory(const double* CurrentPosition, const double* CurrentVelocity, const double* MaxVelocity, const double* MaxAcceleration, const double* TargetPosition, const bool* SelectionVector, TypeIOTGMath::TypeIMotionPolynomials* PolynomialArray, double* SynchronizationTime)
+//!
+//! \brief
+//! Calculates the complete synchronized trajectory from the current
+//! state of motion to the target position, without generating the
+//! next state of motion
+//!
+//! \details
+//! The same trajectory as the one computed by
+//! TypeIOTG::GetNextMotionState_Position() for the same input values
+//! is written to the given array of polynomials, with the time
+//! \f$ t = 0 \f$ corresponding to the given current state of motion.
+//! This method does not modify the state of the trajectory cache
+//! (see TypeIOTG::SetTrajectoryCaching()), so it can be called at any
+//! time, e.g. to preview the motion that is about to be executed.
+//!
+//! \param CurrentPosition
+//! The current position \f$ \vec{P}_{i} \f$
+//!
+//! \param CurrentVelocity
+//! The current velocity \f$ \vec{V}_{i} \f$
+//!
+//! \param MaxVelocity
+//! The maximum velocity \f$ \vec{V}^{\,max}_{i} \f$
+//!
+//! \param MaxAcceleration
+//! The maximum acceleration \f$ \vec{A}^{\,max}_{i} \f$
+//!
+//! \param TargetPosition
+//! The target Position \f$ \vec{P}^{\,trgt}_{i} \f$
+//!
+//! \param SelectionVector
+//! The selection vector \f$ \vec{S}_{i} \f$. The polynomials of
+//! non-selected degrees of freedom are marked as empty.
+//!
+//! \param PolynomialArray
+//! Pointer to an array of (at least) \c NoOfDOFs motion polynomials,
+//! to be calculated
+//!
+//! \param SynchronizationTime
+//! Pointer to a double value for the time in seconds that is
+//! required to reach the target position, to be calculated
+//!
+//! \return OnlineTrajectoryGenerator::OTG_MAX_VELOCITY_ERROR
+//! \return OnlineTrajectoryGenerator::OTG_MAX_ACCELERATION_ERROR
+//! \return OnlineTrajectoryGenerator::OTG_WORKING 
+//! \return OnlineTrajectoryGenerator::OTG_FINAL_STATE_REACHED
+//!
+//! \sa TypeIOTG::TypeIOTGResult
+//  ----------------------------------------------------------
+	int CalculateTrajectory			(		const double*							CurrentPosition
+										,	const double*							CurrentVelocity
+										,	const double*							MaxVelocity
+										,	const double*							MaxAcceleration
+										,	const double*							TargetPosition
+										,	const bool*								SelectionVector
+										,	TypeIOTGMath::TypeIMotionPolynomials*	PolynomialArray
+										,	double*									SynchronizationTime	);
+
+
 //  ---------------------- Doxygen info ----------------------
 //! \fn double GetExecutionTime(void) const
 //!
@@ -286,6 +347,56 @@ public:
 	double	GetExecutionTime(void) const;
 
 
+//  ---------------------- Doxygen info ----------------------
+//! \fn void SetTrajectoryCaching(const bool &Enable, const double &StateTolerance)
+//!
+//! \brief
+//! Enables or disables the reuse of synchronized trajectories across
+//! calls of TypeIOTG::GetNextMotionState_Position()
+//!
+//! \details
+//! With caching enabled, the motion polynomials computed by a call of
+//! TypeIOTG::GetNextMotionState_Position() are kept and simply
+//! evaluated at the next time stamp during subsequent calls, as long
+//! as the selection vector, the maximum velocities, the maximum
+//! accelerations, and the target positions are unchanged, and as long
+//! as the given current state of motion matches the output of the
+//! previous call. The trajectory is recalculated from scratch
+//! whenever one of these conditions is violated. Caching is disabled
+//! by default.
+//!
+//! \param Enable
+//! Set to true in order to enable the reuse of trajectories
+//!
+//! \param StateTolerance
+//! The maximum absolute difference between the given current
+//! position (or velocity) and the new position (or velocity) of the
+//! previous call, for which the current state of motion is still
+//! considered to lie on the cached trajectory
+//!
+//! \sa TypeIOTG::WasTrajectoryRecalculated()
+//  ----------------------------------------------------------
+	void	SetTrajectoryCaching(		const bool		&Enable
+									,	const double	&StateTolerance	);
+
+
+//  ---------------------- Doxygen info ----------------------
+//! \fn bool WasTrajectoryRecalculated(void) const
+//!
+//! \brief
+//! Indicates whether the last call of
+//! TypeIOTG::GetNextMotionState_Position() had to calculate a new
+//! trajectory
+//!
+//! \return false if the last call merely evaluated the cached
+//! trajectory, true otherwise (always true while caching is
+//! disabled)
+//!
+//! \sa TypeIOTG::SetTrajectoryCaching()
+//  ----------------------------------------------------------
+	bool	WasTrajectoryRecalculated(void) const;
+
+
 private:
 
 	double CalculateMinimumSynchronizationTime(const TypeIOTGMath::TypeIOTGInputParameters &IP) const;
@@ -294,18 +405,33 @@ private:
 								,	const double									&SynchronizationTime
 								,	TypeIOTGMath::TypeIMotionPolynomials			*PolynomialArray);
 
+	bool IsCachedTrajectoryValid(	const double*	CurrentPosition
+								,	const double*	CurrentVelocity
+								,	const double*	MaxVelocity
+								,	const double*	MaxAcceleration
+								,	const double*	TargetPosition
+								,	const bool*		SelectionVector	) const;
+
 	int CalculateOutputValues(		const TypeIOTGMath::TypeIMotionPolynomials		*PolynomialArray
 								,	const TypeIOTGMath::TypeIOTGBoolVector			&SelectionVector
+								,	const double									&TimeValue
 								,	TypeIOTGMath::TypeIOTGOutputParameters			*OP);
 
+	bool							TrajectoryCachingEnabled
+								,	CachedTrajectoryIsValid
+								,	TrajectoryWasRecalculated;
+
 	int								ReturnValue
 								,	NumberOfDOFs;
 
 	double							CycleTime										// in seconds
 								,	InternalClockInSeconds
-								,	TrajectoryExecutionTimeForTheUser;				// in seconds
+								,	TrajectoryExecutionTimeForTheUser				// in seconds
+								,	SynchronizationTimeOfCachedTrajectory			// in seconds
+								,	CachedStateTolerance;
 
-	TypeIOTGMath::TypeIOTGInputParameters		*CurrentInputParameters;
+	TypeIOTGMath::TypeIOTGInputParameters		*CurrentInputParameters
+											,	*PreviewInputParameters;
 		
 	TypeIOTGMath::TypeIOTGOutputParameters		*OutputParameters;
 
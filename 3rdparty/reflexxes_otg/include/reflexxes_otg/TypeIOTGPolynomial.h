@@ -132,6 +132,35 @@ public:
 								,	const double	&Diff);
 
 
+//  ---------------------- Doxygen info ----------------------
+//! \fn void GetCoefficients(double *Coeff2, double *Coeff1, double *Coeff0, double *Diff) const
+//! 
+//! \brief
+//!  Retrieves the coefficients of the polynomial
+//! 
+//! \details
+//! The counterpart of TypeIOTGPolynomial::SetCoefficients(), which
+//! allows users to evaluate the polynomial on their own, e.g. for
+//! many time values at once.
+//! 
+//! \param Coeff2
+//! \f$\ \Longleftarrow \ a_2\f$ \n
+//! 
+//! \param Coeff1
+//! \f$\ \Longleftarrow \ a_1\f$ \n
+//! 
+//! \param Coeff0
+//! \f$\ \Longleftarrow \ a_0\f$ \n
+//! 
+//! \param Diff
+//! \f$\ \Longleftarrow \ \Delta T\f$.
+//  ----------------------------------------------------------
+	void		GetCoefficients(	double			*Coeff2
+								,	double			*Coeff1
+								,	double			*Coeff0
+								,	double			*Diff) const;
+
+
 //  ---------------------- Doxygen info ----------------------
 //! \fn double CalculateValue(const double &t) const
 //! 
@@ -72,8 +72,14 @@ TypeIOTG::TypeIOTG(const unsigned int &NoOfDOFs, const double &CycleTimeInSecond
 	this->ReturnValue								=	TypeIOTG::OTG_FINAL_STATE_REACHED;
 	this->TrajectoryExecutionTimeForTheUser			=	-1.0;
 	this->InternalClockInSeconds					=	0.0;
+	this->SynchronizationTimeOfCachedTrajectory		=	0.0;
+	this->CachedStateTolerance						=	0.0;
+	this->TrajectoryCachingEnabled					=	false;
+	this->CachedTrajectoryIsValid					=	false;
+	this->TrajectoryWasRecalculated					=	true;
 
 	this->CurrentInputParameters					=	new TypeIOTGInputParameters	(NumberOfDOFs);
+	this->PreviewInputParameters					=	new TypeIOTGInputParameters	(NumberOfDOFs);
 	this->OutputParameters							=	new TypeIOTGOutputParameters(NumberOfDOFs);
 
 	this->Polynomials								=	new TypeIMotionPolynomials	[NumberOfDOFs];
@@ -86,6 +92,7 @@ TypeIOTG::TypeIOTG(const unsigned int &NoOfDOFs, const double &CycleTimeInSecond
 TypeIOTG::~TypeIOTG()
 {
 	delete(this->CurrentInputParameters		);
+	delete(this->PreviewInputParameters		);
 	delete(this->OutputParameters			);
 	delete[](this->Polynomials				);
 }
@@ -110,7 +117,6 @@ int TypeIOTG::GetNextMotionState_Position(		const double*	CurrentPosition
 
 	for (i = 0; i < this->NumberOfDOFs; i++)
 	{
-		(*this->CurrentInputParameters->SelectionVector)	[i]	=	SelectionVector	[i];
 		if (SelectionVector[i])
 		{
 			if (MaxVelocity[i] < OTG_MIN_VALUE_FOR_MAXVELOCITY)
@@ -121,28 +127,54 @@ int TypeIOTG::GetNextMotionState_Position(		const double*	CurrentPosition
 			{
 				return (TypeIOTG::OTG_MAX_ACCELERATION_ERROR);
 			}
-
-			(*this->CurrentInputParameters->CurrentPosition	)	[i]	=	CurrentPosition	[i];
-			(*this->CurrentInputParameters->CurrentVelocity	)	[i]	=	CurrentVelocity	[i];
-			(*this->CurrentInputParameters->MaxVelocity		)	[i]	=	MaxVelocity		[i];
-			(*this->CurrentInputParameters->MaxAcceleration	)	[i]	=	MaxAcceleration	[i];
-			(*this->CurrentInputParameters->TargetPosition	)	[i]	=	TargetPosition	[i];
 		}
 	}
 
-	// *******************************************************************************
-	// * Step 1: Calculate the minimum possile synchronization time
-	// *******************************************************************************
+	this->TrajectoryWasRecalculated	=	!(this->IsCachedTrajectoryValid(		CurrentPosition
+																			,	CurrentVelocity
+																			,	MaxVelocity
+																			,	MaxAcceleration
+																			,	TargetPosition
+																			,	SelectionVector));
 
-	MinimumSynchronizationTime = TypeIOTG::CalculateMinimumSynchronizationTime(*(this->CurrentInputParameters));
+	if (this->TrajectoryWasRecalculated)
+	{
+		for (i = 0; i < this->NumberOfDOFs; i++)
+		{
+			(*this->CurrentInputParameters->SelectionVector)	[i]	=	SelectionVector	[i];
+			if (SelectionVector[i])
+			{
+				(*this->CurrentInputParameters->CurrentPosition	)	[i]	=	CurrentPosition	[i];
+				(*this->CurrentInputParameters->CurrentVelocity	)	[i]	=	CurrentVelocity	[i];
+				(*this->CurrentInputParameters->MaxVelocity		)	[i]	=	MaxVelocity		[i];
+				(*this->CurrentInputParameters->MaxAcceleration	)	[i]	=	MaxAcceleration	[i];
+				(*this->CurrentInputParameters->TargetPosition	)	[i]	=	TargetPosition	[i];
+			}
+		}
 
-	// *******************************************************************************
-	// * Step 2: Synchronize all selected degrees of freedom
-	// *******************************************************************************
+		// ***************************************************************************
+		// * Step 1: Calculate the minimum possile synchronization time
+		// ***************************************************************************
+
+		MinimumSynchronizationTime = TypeIOTG::CalculateMinimumSynchronizationTime(*(this->CurrentInputParameters));
+
+		// ***************************************************************************
+		// * Step 2: Synchronize all selected degrees of freedom
+		// ***************************************************************************
 
-	TypeIOTG::SynchronizeTrajectory(		*(this->CurrentInputParameters)
-										,	MinimumSynchronizationTime
-										,	this->Polynomials);
+		TypeIOTG::SynchronizeTrajectory(		*(this->CurrentInputParameters)
+											,	MinimumSynchronizationTime
+											,	this->Polynomials);
+
+		this->SynchronizationTimeOfCachedTrajectory	=	MinimumSynchronizationTime;
+		this->InternalClockInSeconds				=	0.0;
+	}
+	else
+	{
+		// The current state of motion is the output of the previous
+		// call, so we simply advance along the existing polynomials.
+		this->InternalClockInSeconds				+=	this->CycleTime;
+	}
 
 	// *******************************************************************************
 	// * Step 3: Calculate output values
@@ -150,9 +182,17 @@ int TypeIOTG::GetNextMotionState_Position(		const double*	CurrentPosition
 
 	ReturnValue = TypeIOTG::CalculateOutputValues(		this->Polynomials
 													,	*(this->CurrentInputParameters->SelectionVector)
+													,	this->InternalClockInSeconds + this->CycleTime
 													,	OutputParameters);
 
-	TrajectoryExecutionTimeForTheUser = MinimumSynchronizationTime;
+	TrajectoryExecutionTimeForTheUser = this->SynchronizationTimeOfCachedTrajectory - this->InternalClockInSeconds;
+	if (TrajectoryExecutionTimeForTheUser < 0.0)
+	{
+		TrajectoryExecutionTimeForTheUser = 0.0;
+	}
+
+	this->CachedTrajectoryIsValid = (		this->TrajectoryCachingEnabled
+										&&	(ReturnValue != TypeIOTG::OTG_ERROR));
 
 	if (ReturnValue != TypeIOTG::OTG_ERROR)
 	{
@@ -170,6 +210,101 @@ int TypeIOTG::GetNextMotionState_Position(		const double*	CurrentPosition
 }
 
 
+//************************************************************************************
+// CalculateTrajectory
+
+int TypeIOTG::CalculateTrajectory(		const double*				CurrentPosition
+									,	const double*				CurrentVelocity
+									,	const double*				MaxVelocity
+									,	const double*				MaxAcceleration
+									,	const double*				TargetPosition
+									,	const bool*					SelectionVector
+									,	TypeIMotionPolynomials*		PolynomialArray
+									,	double*						SynchronizationTime	)
+{
+	int				i							=	0;
+
+	for (i = 0; i < this->NumberOfDOFs; i++)
+	{
+		(*this->PreviewInputParameters->SelectionVector)	[i]	=	SelectionVector	[i];
+		PolynomialArray[i].ValidPolynomials						=	0;
+		if (SelectionVector[i])
+		{
+			if (MaxVelocity[i] < OTG_MIN_VALUE_FOR_MAXVELOCITY)
+			{
+				return (TypeIOTG::OTG_MAX_VELOCITY_ERROR);
+			}
+			if (MaxAcceleration[i] < OTG_MIN_VALUE_FOR_MAXACCELERATION)
+			{
+				return (TypeIOTG::OTG_MAX_ACCELERATION_ERROR);
+			}
+
+			(*this->PreviewInputParameters->CurrentPosition	)	[i]	=	CurrentPosition	[i];
+			(*this->PreviewInputParameters->CurrentVelocity	)	[i]	=	CurrentVelocity	[i];
+			(*this->PreviewInputParameters->MaxVelocity		)	[i]	=	MaxVelocity		[i];
+			(*this->PreviewInputParameters->MaxAcceleration	)	[i]	=	MaxAcceleration	[i];
+			(*this->PreviewInputParameters->TargetPosition	)	[i]	=	TargetPosition	[i];
+		}
+	}
+
+	*SynchronizationTime = TypeIOTG::CalculateMinimumSynchronizationTime(*(this->PreviewInputParameters));
+
+	TypeIOTG::SynchronizeTrajectory(		*(this->PreviewInputParameters)
+										,	*SynchronizationTime
+										,	PolynomialArray);
+
+	if (*SynchronizationTime > 0.0)
+	{
+		return (TypeIOTG::OTG_WORKING);
+	}
+
+	return (TypeIOTG::OTG_FINAL_STATE_REACHED);
+}
+
+
+//************************************************************************************
+// IsCachedTrajectoryValid()
+
+bool TypeIOTG::IsCachedTrajectoryValid(		const double*	CurrentPosition
+										,	const double*	CurrentVelocity
+										,	const double*	MaxVelocity
+										,	const double*	MaxAcceleration
+										,	const double*	TargetPosition
+										,	const bool*		SelectionVector	) const
+{
+	int				i							=	0;
+
+	if (!this->CachedTrajectoryIsValid)
+	{
+		return (false);
+	}
+
+	for (i = 0; i < this->NumberOfDOFs; i++)
+	{
+		if ((*this->CurrentInputParameters->SelectionVector)[i] != SelectionVector[i])
+		{
+			return (false);
+		}
+		if (SelectionVector[i])
+		{
+			if (		((*this->CurrentInputParameters->MaxVelocity		)[i]	!=	MaxVelocity		[i])
+					||	((*this->CurrentInputParameters->MaxAcceleration	)[i]	!=	MaxAcceleration	[i])
+					||	((*this->CurrentInputParameters->TargetPosition		)[i]	!=	TargetPosition	[i]))
+			{
+				return (false);
+			}
+			if (		(fabs(CurrentPosition[i] - (*this->OutputParameters->NewPosition)[i])	>	this->CachedStateTolerance)
+					||	(fabs(CurrentVelocity[i] - (*this->OutputParameters->NewVelocity)[i])	>	this->CachedStateTolerance))
+			{
+				return (false);
+			}
+		}
+	}
+
+	return (true);
+}
+
+
 //************************************************************************************
 // CalculateMinimumSynchronizationTime()
 
@@ -292,7 +427,7 @@ void TypeIOTG::SynchronizeTrajectory(		const TypeIOTGInputParameters	&IP
 			SignsWereSwitched					=	false;
 			ElapsedTime							=	0.0;
 
-			Polynomials[i].ValidPolynomials	=	0;
+			PolynomialArray[i].ValidPolynomials	=	0;
 
 			if (!TypeIOTGMath::Decision_2001(CurrentVelocity))
 			{
@@ -384,6 +519,7 @@ void TypeIOTG::SynchronizeTrajectory(		const TypeIOTGInputParameters	&IP
 
 int TypeIOTG::CalculateOutputValues(		const TypeIMotionPolynomials	*PolynomialArray
 										,	const TypeIOTGBoolVector		&SelectionVector
+										,	const double					&TimeValue
 										,	TypeIOTGOutputParameters		*OP)
 {
 	int				i							=	0
@@ -397,7 +533,7 @@ int TypeIOTG::CalculateOutputValues(		const TypeIMotionPolynomials	*PolynomialAr
 
 		if (SelectionVector[i])
 		{
-			while (this->CycleTime >= PolynomialArray[i].PolynomialTimes[SegmentCounter])
+			while (TimeValue >= PolynomialArray[i].PolynomialTimes[SegmentCounter])
 			{
 				SegmentCounter++;
 				if (SegmentCounter > PolynomialArray[i].ValidPolynomials)
@@ -406,8 +542,8 @@ int TypeIOTG::CalculateOutputValues(		const TypeIMotionPolynomials	*PolynomialAr
 				}
 			}
 			
-			(*OP->NewPosition)[i] = PolynomialArray[i].PositionPolynomial[SegmentCounter].CalculateValue(this->CycleTime);
-			(*OP->NewVelocity)[i] = PolynomialArray[i].VelocityPolynomial[SegmentCounter].CalculateValue(this->CycleTime);
+			(*OP->NewPosition)[i] = PolynomialArray[i].PositionPolynomial[SegmentCounter].CalculateValue(TimeValue);
+			(*OP->NewVelocity)[i] = PolynomialArray[i].VelocityPolynomial[SegmentCounter].CalculateValue(TimeValue);
 
 
 			if (SegmentCounter + 1 < PolynomialArray[i].ValidPolynomials)
@@ -438,6 +574,8 @@ int TypeIOTG::GetNextMotionState_Velocity(		const double*	CurrentPosition
 	double			MinimumExecutionTime		=	0.0;
 
 	this->TrajectoryExecutionTimeForTheUser		=	0.0;
+	this->CachedTrajectoryIsValid				=	false;
+	this->TrajectoryWasRecalculated				=	true;
 	
 	for (i = 0; i < this->NumberOfDOFs; i++)
 	{
@@ -491,3 +629,23 @@ double TypeIOTG::GetExecutionTime(void) const
 	return(TrajectoryExecutionTimeForTheUser);
 }
 
+
+//*******************************************************************************************
+// SetTrajectoryCaching()
+
+void TypeIOTG::SetTrajectoryCaching(		const bool		&Enable
+										,	const double	&StateTolerance	)
+{
+	this->TrajectoryCachingEnabled	=	Enable;
+	this->CachedStateTolerance		=	StateTolerance;
+	this->CachedTrajectoryIsValid	=	false;
+}
+
+
+//*******************************************************************************************
+// WasTrajectoryRecalculated()
+
+bool TypeIOTG::WasTrajectoryRecalculated(void) const
+{
+	return(TrajectoryWasRecalculated);
+}
@@ -107,6 +107,21 @@ void TypeIOTGMath::TypeIOTGPolynomial::SetCoefficients(		const double	&Coeff2
 }
 
 
+//*******************************************************************************************
+// GetCoefficients()
+
+void TypeIOTGMath::TypeIOTGPolynomial::GetCoefficients(		double			*Coeff2
+														,	double			*Coeff1
+														,	double			*Coeff0
+														,	double			*Diff) const
+{
+	*Coeff2	= a2;
+	*Coeff1	= a1;
+	*Coeff0	= a0;
+	*Diff	= DeltaT;
+}
+
+
 //*******************************************************************************************
 // CalculateValue()
 // calculates f(t)
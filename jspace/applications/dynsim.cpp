@@ -26,6 +26,8 @@
 #include <tao/dynamics/taoNode.h>
 #include <tao/dynamics/taoJoint.h>
 #include <tao/dynamics/taoDynamics.h>
+#include <tao/dynamics/taoABDynamics.h>
+#include <tao/dynamics/taoIntegrator.h>
 
 #include <jspace/tao_dump.hpp>
 //#include <jspace/tao_util.hpp>
@@ -110,6 +112,7 @@ int main(int argc, char ** argv)
   string saifname("robot.xml");
   double timestep(1e-3);
   size_t nsubsteps(10);
+  taoIntegratorType integrator_type(TAO_INTEGRATOR_EULER);
   vector<double> state[2];
   vector<double> & position(state[0]);
   vector<double> & velocity(state[1]);
@@ -159,6 +162,22 @@ int main(int argc, char ** argv)
 	errx(EXIT_FAILURE, "nsubsteps must be > 0");
       }
     }
+    else if ("-I" == opt) {
+      ++iopt;
+      if (iopt >= argc) {
+	errx(EXIT_FAILURE, "-I requires an argument (use -h for some help)");
+      }
+      string const name(argv[iopt]);
+      if ("euler" == name) {
+	integrator_type = TAO_INTEGRATOR_EULER;
+      }
+      else if ("rk4" == name) {
+	integrator_type = TAO_INTEGRATOR_RK4;
+      }
+      else {
+	errx(EXIT_FAILURE, "invalid integrator `%s' (use euler or rk4)", argv[iopt]);
+      }
+    }
     else if ("-v" == opt) {
       ++verbosity;
     }
@@ -200,6 +219,8 @@ int main(int argc, char ** argv)
 	     "                        (default is 1ms, i.e. a 1kHz control loop)\n"
 	     "  -n  nsubsteps         the number of integration substeps\n"
 	     "                        (default is 10)\n"
+	     "  -I  integrator        euler or rk4\n"
+	     "                        (default is euler, rk4 usually needs a single substep)\n"
 	     "  -P  startpos          start position (vector of space-delimited numbers)\n"
 	     "  -V  startvel          start velocity (vector of space-delimited numbers)\n"
 	     "  -v                    verbose mode (multiple times makes it more verbose)\n"
@@ -293,6 +314,11 @@ int main(int argc, char ** argv)
   
   static deVector3 gravity(0, 0, -9.81); // let's assume we're on Earth
   double const substep_dt(timestep / nsubsteps);
+  taoABTraversal tao_traversal(tao_tree->root);
+  taoIntegrator integrator(integrator_type);
+  if ( ! integrator.build(&tao_traversal)) {
+    errx(EXIT_FAILURE, "the robot has joints which the integrator does not support");
+  }
   
   for (size_t lineno(1); *is; ++lineno) {
     
@@ -317,9 +343,9 @@ int main(int argc, char ** argv)
     
     for (size_t ii(0); ii < nsubsteps; ++ii) {
       set_tau(tao_tree, &tau[0]);
-      taoDynamics::fwdDynamics(tao_tree->root, &gravity);
-      taoDynamics::integrate(tao_tree->root, substep_dt);
-      taoDynamics::updateTransformation(tao_tree->root);
+      taoDynamics::fwdDynamics(&tao_traversal, &gravity);
+      integrator.integrate(&gravity, substep_dt);
+      taoDynamics::updateTransformation(&tao_traversal);
     }
     
     get_state(tao_tree, &position[0], &velocity[0]);
@@ -28,6 +28,7 @@
 #include <tao/dynamics/taoNode.h>
 #include <tao/dynamics/taoJoint.h>
 #include <tao/dynamics/taoDynamics.h>
+#include <algorithm>
 
 #undef DEBUG
 
@@ -60,8 +61,11 @@ namespace jspace {
   Model()
     : ndof_(0),
       kgm_tree_(0),
-      cc_tree_(0)
+      cc_tree_(0),
+      jacobian_cache_hits_(0),
+      jacobian_cache_misses_(0)
   {
+    pthread_mutex_init(&jacobian_cache_mutex_, 0);
   }
   
   
@@ -142,6 +146,7 @@ namespace jspace {
   {
     delete kgm_tree_;
     delete cc_tree_;
+    pthread_mutex_destroy(&jacobian_cache_mutex_);
   }
   
   
@@ -158,6 +163,9 @@ namespace jspace {
   setState(State const & state)
   {
     state_ = state;
+    for (size_t ii(0); ii < jacobian_cache_.size(); ++ii) {
+      jacobian_cache_[ii].valid = false;
+    }
     for (size_t ii(0); ii < ndof_; ++ii) {
       taoJoint * joint(kgm_tree_->info[ii].joint);
       joint->setQ(&const_cast<State&>(state).position_.coeffRef(ii));
@@ -289,6 +297,22 @@ namespace jspace {
       return false;
     }
     
+    // Use the rotation matrix cached by taoDNode::updateFrame() if
+    // there is one, which saves the quaternion conversion.
+    deCachedFrame const * cached(node->cachedFrameGlobal());
+    if (cached) {
+      deMatrix3 const & tao_rot(cached->rotationMatrix());
+      deVector3 const & tao_trans(cached->translation());
+      global_transform.setIdentity();
+      for (size_t ii(0); ii < 3; ++ii) {
+	for (size_t jj(0); jj < 3; ++jj) {
+	  global_transform.linear().coeffRef(ii, jj) = tao_rot.elementAt(ii, jj);
+	}
+	global_transform.translation().coeffRef(ii) = tao_trans[ii];
+      }
+      return true;
+    }
+    
     deFrame const * tao_frame(node->frameGlobal());
     deQuaternion const & tao_quat(tao_frame->rotation());
     deVector3 const & tao_trans(tao_frame->translation());
@@ -342,6 +366,144 @@ namespace jspace {
   }
 
     
+  Model::jacobian_cache_entry_s * Model::
+  findJacobianCacheEntry(taoDNode const * node,
+			 double local_x, double local_y, double local_z) const
+  {
+    for (size_t ii(0); ii < jacobian_cache_.size(); ++ii) {
+      jacobian_cache_entry_s & entry(jacobian_cache_[ii]);
+      if (entry.valid
+	  && (entry.node == node)
+	  && (entry.local[0] == local_x)
+	  && (entry.local[1] == local_y)
+	  && (entry.local[2] == local_z)) {
+	return &entry;
+      }
+    }
+    return 0;
+  }
+  
+  
+  bool Model::
+  getSupportingDOF(taoDNode const * node,
+		   std::vector<size_t> & dof) const
+  {
+    if ( ! node) {
+      return false;
+    }
+    ancestry_table_t::const_iterator iae(ancestry_table_.find(const_cast<taoDNode*>(node)));
+    if (iae == ancestry_table_.end()) {
+      return false;
+    }
+    ancestry_list_t const & alist(iae->second);
+    dof.clear();
+    for (ancestry_list_t::const_iterator ia(alist.begin()); ia != alist.end(); ++ia) {
+      dof.push_back(ia->id);
+    }
+    std::sort(dof.begin(), dof.end());
+    return true;
+  }
+  
+  
+  bool Model::
+  getCachedFrameJacobian(taoDNode const * node,
+			 double local_x, double local_y, double local_z,
+			 Transform & global_transform,
+			 Matrix * opt_linear_jacobian,
+			 Matrix * opt_angular_jacobian,
+			 bool * opt_hit) const
+  {
+    if ( ! node) {
+      return false;
+    }
+    
+    // Take whatever is already there, and note what is missing.
+    bool need_frame(true);
+    bool need_linear(0 != opt_linear_jacobian);
+    bool need_angular(0 != opt_angular_jacobian);
+    pthread_mutex_lock(&jacobian_cache_mutex_);
+    jacobian_cache_entry_s const * entry(findJacobianCacheEntry(node, local_x, local_y, local_z));
+    if (entry) {
+      need_frame = false;
+      global_transform.setIdentity();
+      global_transform.linear() = entry->rotation;
+      global_transform.translation() = entry->translation;
+      if (need_linear && entry->has_linear) {
+	*opt_linear_jacobian = entry->linear;
+	need_linear = false;
+      }
+      if (need_angular && entry->has_angular) {
+	*opt_angular_jacobian = entry->angular;
+	need_angular = false;
+      }
+    }
+    if ( ! (need_linear || need_angular)) {
+      ++jacobian_cache_hits_;
+      pthread_mutex_unlock(&jacobian_cache_mutex_);
+      if (opt_hit) {
+	*opt_hit = true;
+      }
+      return true;
+    }
+    pthread_mutex_unlock(&jacobian_cache_mutex_);
+    
+    // Compute outside of the lock, the kinematic tree is only read
+    // here. Two threads racing for the same entry will both compute
+    // it, but only the first one gets stored.
+    if (need_frame && ( ! computeGlobalFrame(node, local_x, local_y, local_z, global_transform))) {
+      return false;
+    }
+    if (need_linear && ( ! computeLinearJacobian(node,
+						 global_transform.translation()[0],
+						 global_transform.translation()[1],
+						 global_transform.translation()[2],
+						 *opt_linear_jacobian))) {
+      return false;
+    }
+    if (need_angular && ( ! computeAngularJacobian(node, *opt_angular_jacobian))) {
+      return false;
+    }
+    
+    pthread_mutex_lock(&jacobian_cache_mutex_);
+    ++jacobian_cache_misses_;
+    jacobian_cache_entry_s * store(findJacobianCacheEntry(node, local_x, local_y, local_z));
+    if ( ! store) {
+      for (size_t ii(0); ii < jacobian_cache_.size(); ++ii) {
+	if ( ! jacobian_cache_[ii].valid) {
+	  store = &jacobian_cache_[ii];
+	  break;
+	}
+      }
+      if ( ! store) {
+	jacobian_cache_.push_back(jacobian_cache_entry_s());
+	store = &jacobian_cache_.back();
+      }
+      store->node = node;
+      store->local[0] = local_x;
+      store->local[1] = local_y;
+      store->local[2] = local_z;
+      store->rotation = global_transform.linear();
+      store->translation = global_transform.translation();
+      store->has_linear = false;
+      store->has_angular = false;
+      store->valid = true;
+    }
+    if (need_linear && ( ! store->has_linear)) {
+      store->linear = *opt_linear_jacobian;
+      store->has_linear = true;
+    }
+    if (need_angular && ( ! store->has_angular)) {
+      store->angular = *opt_angular_jacobian;
+      store->has_angular = true;
+    }
+    pthread_mutex_unlock(&jacobian_cache_mutex_);
+    if (opt_hit) {
+      *opt_hit = false;
+    }
+    return true;
+  }
+  
+  
   bool Model::
   computeGlobalCOMFrame(taoDNode const * node,
 			Transform & global_com_transform) const
@@ -436,6 +598,70 @@ namespace jspace {
   }
   
   
+  bool Model::
+  computeLinearJacobian(taoDNode const * node,
+			double gx, double gy, double gz,
+			Matrix & jacobian) const
+  {
+    if ( ! node) {
+      return false;
+    }
+    ancestry_table_t::const_iterator iae(ancestry_table_.find(const_cast<taoDNode*>(node)));
+    if (iae == ancestry_table_.end()) {
+      return false;
+    }
+    ancestry_list_t const & alist(iae->second);
+    
+    if ((3 != jacobian.rows()) || (ndof_ != static_cast<size_t>(jacobian.cols()))) {
+      jacobian.resize(3, ndof_);
+    }
+    jacobian.setZero();
+    ancestry_list_t::const_iterator ia(alist.begin());
+    ancestry_list_t::const_iterator iend(alist.end());
+    for (/**/; ia != iend; ++ia) {
+      deVector6 Jg_col;
+      ia->joint->getJgColumns(&Jg_col);
+      int const icol(ia->id);
+      // same cross product as in computeJacobian()
+      jacobian.coeffRef(0, icol) = Jg_col.elementAt(0) - (-gz * Jg_col.elementAt(4) + gy * Jg_col.elementAt(5));
+      jacobian.coeffRef(1, icol) = Jg_col.elementAt(1) - ( gz * Jg_col.elementAt(3) - gx * Jg_col.elementAt(5));
+      jacobian.coeffRef(2, icol) = Jg_col.elementAt(2) - (-gy * Jg_col.elementAt(3) + gx * Jg_col.elementAt(4));
+    }
+    return true;
+  }
+  
+  
+  bool Model::
+  computeAngularJacobian(taoDNode const * node,
+			 Matrix & jacobian) const
+  {
+    if ( ! node) {
+      return false;
+    }
+    ancestry_table_t::const_iterator iae(ancestry_table_.find(const_cast<taoDNode*>(node)));
+    if (iae == ancestry_table_.end()) {
+      return false;
+    }
+    ancestry_list_t const & alist(iae->second);
+    
+    if ((3 != jacobian.rows()) || (ndof_ != static_cast<size_t>(jacobian.cols()))) {
+      jacobian.resize(3, ndof_);
+    }
+    jacobian.setZero();
+    ancestry_list_t::const_iterator ia(alist.begin());
+    ancestry_list_t::const_iterator iend(alist.end());
+    for (/**/; ia != iend; ++ia) {
+      deVector6 Jg_col;
+      ia->joint->getJgColumns(&Jg_col);
+      int const icol(ia->id);
+      jacobian.coeffRef(0, icol) = Jg_col.elementAt(3);
+      jacobian.coeffRef(1, icol) = Jg_col.elementAt(4);
+      jacobian.coeffRef(2, icol) = Jg_col.elementAt(5);
+    }
+    return true;
+  }
+  
+  
   void Model::
   updateDynamics()
   {
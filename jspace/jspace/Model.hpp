@@ -33,6 +33,7 @@
 #include <list>
 #include <map>
 #include <set>
+#include <pthread.h>
 
 // Clients of Model never really need to worry about what exactly lies
 // behind TAO, they can treat this as an opaque pointer type.
@@ -283,6 +284,89 @@ namespace jspace {
 				Matrix & jacobian) const
     { return computeJacobian(node, global_point[0], global_point[1], global_point[2], jacobian); }
     
+    /** Compute only the translational part J_v of the Jacobian of a
+	given node, at a point expressed wrt the global frame. This
+	skips the rotational rows that computeJacobian() would also
+	produce. The result is written into the given matrix, which
+	only gets resized if it is not already 3xN.
+	
+	\return True on success, with the same failure modes as
+	computeJacobian(). */
+    bool computeLinearJacobian(taoDNode const * node,
+			       double gx, double gy, double gz,
+			       Matrix & jacobian) const;
+    
+    /** Convenience method in case you are holding the global position
+	in a three-dimensional vector. */
+    inline bool computeLinearJacobian(taoDNode const * node,
+				      Vector const & global_point,
+				      Matrix & jacobian) const
+    { return computeLinearJacobian(node, global_point[0], global_point[1], global_point[2], jacobian); }
+    
+    /** Compute only the rotational part J_omega of the Jacobian of a
+	given node. It does not depend on the point. The result is
+	written into the given matrix, which only gets resized if it
+	is not already 3xN.
+	
+	\return True on success, with the same failure modes as
+	computeJacobian(). */
+    bool computeAngularJacobian(taoDNode const * node,
+				Matrix & jacobian) const;
+    
+    /** Retrieve the indices of the DOF that can have non-zero
+	columns in the Jacobian of a given node, i.e. the joints on the
+	path from the root to that node. They are sorted in ascending
+	order. The list only depends on the kinematic structure, so
+	you can retrieve it once at init time.
+	
+	\return True on success. The only possible failure stems from
+	an invalid node. */
+    bool getSupportingDOF(taoDNode const * node,
+			  std::vector<size_t> & dof) const;
+    
+    /** Retrieve the global frame of a point expressed wrt the origin
+	of a given node, along with the linear and/or angular Jacobian
+	at that point. Results are cached until the next setState(),
+	keyed by node and local point, and each half of the Jacobian
+	is computed only once it is asked for. Several tasks attached
+	to the same end effector thus share one computation per
+	tick. The cache is protected by a mutex, so tasks can query it
+	from multiple threads.
+	
+	Pass NULL for the Jacobian half you are not interested
+	in. Otherwise, the given matrices receive 3xN results, see
+	computeLinearJacobian() and computeAngularJacobian().
+	
+	\return True on success, with the same failure modes as
+	computeJacobian(). If opt_hit is non-NULL, it is set to true
+	if nothing had to be computed. */
+    bool getCachedFrameJacobian(taoDNode const * node,
+				double local_x, double local_y, double local_z,
+				Transform & global_transform,
+				Matrix * opt_linear_jacobian,
+				Matrix * opt_angular_jacobian,
+				bool * opt_hit = 0) const;
+    
+    /** Convenience method in case you are holding the local point in
+	a three-dimensional vector. */
+    inline bool getCachedFrameJacobian(taoDNode const * node,
+				       Vector const & local_point,
+				       Transform & global_transform,
+				       Matrix * opt_linear_jacobian,
+				       Matrix * opt_angular_jacobian,
+				       bool * opt_hit = 0) const
+    { return getCachedFrameJacobian(node, local_point[0], local_point[1], local_point[2],
+				    global_transform, opt_linear_jacobian, opt_angular_jacobian,
+				    opt_hit); }
+    
+    /** Number of getCachedFrameJacobian() calls that were served
+	from the cache. */
+    size_t getJacobianCacheHits() const { return jacobian_cache_hits_; }
+    
+    /** Number of getCachedFrameJacobian() calls that had to
+	compute (part of) the frame and Jacobian. */
+    size_t getJacobianCacheMisses() const { return jacobian_cache_misses_; }
+    
     //////////////////////////////////////////////////
     // dynamics facet
     
@@ -386,6 +470,30 @@ namespace jspace {
     typedef std::list<ancestry_entry_s> ancestry_list_t;
     typedef std::map<taoDNode *, ancestry_list_t> ancestry_table_t;
     ancestry_table_t ancestry_table_;
+    
+    /** Entries get invalidated by setState(), but their storage is
+	kept around so that a steady set of queries does not
+	allocate. The frame is kept as rotation plus translation
+	because a Transform would need an aligned allocator. */
+    struct jacobian_cache_entry_s {
+      taoDNode const * node;
+      double local[3];
+      Eigen::Matrix3d rotation;
+      Eigen::Vector3d translation;
+      Matrix linear;
+      Matrix angular;
+      bool has_linear;
+      bool has_angular;
+      bool valid;
+    };
+    typedef std::vector<jacobian_cache_entry_s> jacobian_cache_t;
+    mutable jacobian_cache_t jacobian_cache_;
+    mutable pthread_mutex_t jacobian_cache_mutex_;
+    mutable size_t jacobian_cache_hits_;
+    mutable size_t jacobian_cache_misses_;
+    
+    jacobian_cache_entry_s * findJacobianCacheEntry(taoDNode const * node,
+						    double local_x, double local_y, double local_z) const;
   };
   
 }
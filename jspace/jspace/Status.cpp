@@ -24,6 +24,9 @@
 */
 
 #include "Status.hpp"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace jspace {
   
@@ -34,4 +37,59 @@ namespace jspace {
   {
   }
   
+  
+  static __thread char context_buffer__[RTStatus::context_nbuffers][RTStatus::context_size];
+  static __thread unsigned int context_index__(0);
+  
+  static char * next_context_buffer()
+  {
+    context_index__ = (context_index__ + 1) % RTStatus::context_nbuffers;
+    return context_buffer__[context_index__];
+  }
+  
+  
+  RTStatus::
+  RTStatus(Status const & status)
+    : code(status.ok ? STATUS_OK : STATUS_FAILED),
+      message(""),
+      context(0)
+  {
+    if ( ! status.ok) {
+      char * buf(next_context_buffer());
+      strncpy(buf, status.errstr.c_str(), context_size - 1);
+      buf[context_size - 1] = '\0';
+      context = buf;
+    }
+  }
+  
+  
+  RTStatus RTStatus::
+  fail(status_code_t code, char const * message, char const * fmt, ...)
+  {
+    char * buf(next_context_buffer());
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, context_size, fmt, ap);
+    va_end(ap);
+    RTStatus st(code, message);
+    st.context = buf;
+    return st;
+  }
+  
+  
+  Status RTStatus::
+  toStatus() const
+  {
+    if (STATUS_OK == code) {
+      return Status();
+    }
+    if ( ! context) {
+      return Status(false, message);
+    }
+    if ( ! message[0]) {
+      return Status(false, context);
+    }
+    return Status(false, std::string(message) + ": " + context);
+  }
+  
 }
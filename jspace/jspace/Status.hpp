@@ -44,6 +44,85 @@ namespace jspace {
     std::string errstr;
   };
   
+  
+  /**
+     Error codes of RTStatus. Only STATUS_OK means success.
+  */
+  typedef enum {
+    STATUS_OK = 0,
+    STATUS_FAILED,		//!< anything not covered below, see the message
+    STATUS_NOT_INITIALIZED,
+    STATUS_INVALID_DIMENSION,
+    STATUS_INVALID_PARAMETER,
+    STATUS_NUMERIC_ERROR	//!< singularity, NaN, no convergence, ...
+  } status_code_t;
+  
+  
+  /**
+     Allocation-free alternative to Status for code that runs in the
+     servo loop, e.g. Task::update() and Controller::computeCommand()
+     in opspace. It only holds a code and a pointer to a static
+     message, so neither success nor failure touch the heap.
+     
+     Failures that need details which are only known at runtime can
+     attach a context with fail(). It gets formatted into one of
+     context_nbuffers preallocated buffers which belong to the
+     calling thread, and stays valid until that thread has formatted
+     context_nbuffers further contexts. That is enough for passing a
+     failure up the call chain, also when a caller wraps the context
+     of a callee into its own.
+     
+     For source compatibility, RTStatus converts to and from
+     Status. Code which stores the result of a hot path method in a
+     Status, or returns a Status from one, keeps working. These
+     conversions do allocate, though, so they should be restricted to
+     failure paths and non-realtime code.
+  */
+  class RTStatus
+  {
+  public:
+    enum {
+      context_size = 256,
+      context_nbuffers = 4
+    };
+    
+    /** Default ctor means success, like Status(). */
+    inline RTStatus(): code(STATUS_OK), message(""), context(0) {}
+    
+    /** The message must be a string literal or otherwise outlive the RTStatus. */
+    inline RTStatus(status_code_t code_, char const * message_)
+      : code(code_), message(message_), context(0) {}
+    
+    /**
+       Conversion from Status. A failure gets code STATUS_FAILED, and
+       the errstr gets copied into a context buffer of the calling
+       thread (truncated to context_size - 1 characters).
+    */
+    RTStatus(Status const & status);
+    
+    /**
+       Create a failure with a printf-style context, for example
+       RTStatus::fail(STATUS_INVALID_DIMENSION, "invalid Jacobian
+       dimension", "task `%s'", name.c_str()).
+    */
+    static RTStatus fail(status_code_t code, char const * message, char const * fmt, ...)
+      __attribute__ ((format (printf, 3, 4)));
+    
+    inline operator bool () const { return STATUS_OK == code; }
+    
+    /**
+       Conversion to Status. The errstr is the message, followed by
+       the context (if any) after a colon.
+    */
+    Status toStatus() const;
+    
+    inline operator Status () const { return toStatus(); }
+    
+    status_code_t code;
+    char const * message;
+    char const * context;	//!< null, or points into a per-thread buffer
+  };
+  
 }
 
 #endif // JSPACE_STATUS_HPP
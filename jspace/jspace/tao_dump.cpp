@@ -160,7 +160,7 @@ std::string inertia_matrix_to_string(deMatrix3 const & mx)
   static void _dump_tao_tree_info_saixml(std::ostream & os, taoDNode * root, tao_tree_info_s::node_info_t const & info,
 					 std::string prefix) throw(std::runtime_error)
   {
-    deFrame * const home(root->frameHome());
+    deFrame const * const home(root->frameHome());
     if ( ! home) {
 	throw std::runtime_error("_dump_tao_tree_info_saixml(): no home frame");
     }
@@ -267,18 +267,18 @@ std::string inertia_matrix_to_string(deMatrix3 const & mx)
     //////////////////////////////////////////////////
     // root
     
-    deFrame * home(tree->root->frameHome());
+    deFrame const * home(tree->root->frameHome());
     if ( ! home) {
       throw std::runtime_error("dump_tao_tree_info_lotusxml(): no root home frame");
     }
-    deVector3 & pos(home->translation());
-    deQuaternion & rot(home->rotation());
+    deVector3 const & root_pos(home->translation());
+    deQuaternion const & root_rot(home->rotation());
     
     os << "    <root_link>\n"
        << "      <link_name>" << root_link_name << "</link_name>\n"
-       << "      <position_in_parent>" << pos[0] << "  " << pos[1] << "  " << pos[2] << "</position_in_parent>\n"
+       << "      <position_in_parent>" << root_pos[0] << "  " << root_pos[1] << "  " << root_pos[2] << "</position_in_parent>\n"
        << "      <orientation_in_parent>"
-       << rot[0] << "  " << rot[1] << "  " << rot[2] <<  "  " << rot[3] << "</orientation_in_parent>\n"
+       << root_rot[0] << "  " << root_rot[1] << "  " << root_rot[2] <<  "  " << root_rot[3] << "</orientation_in_parent>\n"
        << "    </root_link>\n";
 
     //////////////////////////////////////////////////
@@ -290,8 +290,8 @@ std::string inertia_matrix_to_string(deMatrix3 const & mx)
       if ( ! home) {
 	throw std::runtime_error("dump_tao_tree_info_lotusxml(): no home frame in link `" + inode->link_name + "'");
       }
-      pos = home->translation();
-      rot = home->rotation();
+      deVector3 const & pos(home->translation());
+      deQuaternion const & rot(home->rotation());
       deVector3 const & com(*inode->node->center());
       deMatrix3 const * inertia(inode->node->inertia());
       taoJoint const * joint(inode->node->getJointList());
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <sstream>
 
 using namespace std;
 
@@ -171,12 +172,11 @@ namespace jspace {
     }
     
     
-    static jspace::Model * _create_model(create_brep_t create_brep) throw(runtime_error)
+    static jspace::Model * _create_model(BranchingRepresentation * kg_brep,
+					 BranchingRepresentation * cc_brep) throw(runtime_error)
     {
-      BranchingRepresentation * kg_brep(create_brep());
       jspace::tao_tree_info_s * kg_tree(kg_brep->createTreeInfo());
       delete kg_brep;
-      BranchingRepresentation * cc_brep(create_brep());
       jspace::tao_tree_info_s * cc_tree(cc_brep->createTreeInfo());
       delete cc_brep;
       jspace::Model * model(new jspace::Model());
@@ -189,6 +189,13 @@ namespace jspace {
     }
     
     
+    static jspace::Model * _create_model(create_brep_t create_brep) throw(runtime_error)
+    {
+      BranchingRepresentation * kg_brep(create_brep());
+      return _create_model(kg_brep, create_brep());
+    }
+    
+    
     jspace::Model * create_puma_model() throw(runtime_error)
     {
       return _create_model(create_puma_brep);
@@ -489,6 +496,51 @@ namespace jspace {
     }
     
     
+    static std::string create_unit_mass_nR_xml(size_t ndof) throw(runtime_error)
+    {
+      std::ostringstream xml;
+      xml << "<?xml version=\"1.0\" ?>\n"
+	  << "<dynworld>\n"
+	  << "  <baseNode>\n"
+	  << "    <gravity>0, 0, -9.81</gravity>\n"
+	  << "    <pos>0, 0, 0</pos>\n"
+	  << "    <rot>1, 0, 0, 0</rot>\n";
+      std::string indent("    ");
+      for (size_t ii(0); ii < ndof; ++ii) {
+	xml << indent << "<jointNode>\n"
+	    << indent << "  <ID>" << ii << "</ID>\n"
+	    << indent << "  <type>R</type>\n"
+	    << indent << "  <axis>" << ((0 == ii % 2) ? "Z" : "Y") << "</axis>\n"
+	    << indent << "  <mass>1</mass>\n"
+	    << indent << "  <inertia>0.1, 0.1, 0.1</inertia>\n"
+	    << indent << "  <com>0.5, 0, 0</com>\n"
+	    << indent << "  <pos>" << ((0 == ii) ? "0, 0, 1" : "1, 0, 0") << "</pos>\n"
+	    << indent << "  <rot>1, 0, 0, 0</rot>\n";
+	indent += "  ";
+      }
+      for (size_t ii(0); ii < ndof; ++ii) {
+	indent.resize(indent.size() - 2);
+	xml << indent << "</jointNode>\n";
+      }
+      xml << "  </baseNode>\n"
+	  << "</dynworld>\n";
+      std::string result(create_tmpfile("unit_mass_nR.xml.XXXXXX", xml.str().c_str()));
+      return result;
+    }
+    
+    
+    jspace::Model * create_unit_mass_nR_model(size_t ndof) throw(std::runtime_error)
+    {
+      if (0 == ndof) {
+	throw std::runtime_error("jspace::test::create_unit_mass_nR_model(): ndof must be positive");
+      }
+      string const xml_filename(create_unit_mass_nR_xml(ndof));
+      BRParser brp;
+      BranchingRepresentation * kg_brep(brp.parse(xml_filename));
+      return _create_model(kg_brep, brp.parse(xml_filename));
+    }
+    
+    
     void compute_fork_4R_kinematics(double q1, double q2, double q3, double q4,
 				    jspace::Vector & o1, jspace::Vector & o2, jspace::Vector & o3, jspace::Vector & o4,
 				    jspace::Vector & com1, jspace::Vector & com2,
@@ -40,6 +40,11 @@ namespace jspace {
     
     jspace::Model * create_fork_4R_model() throw(std::runtime_error);
     
+    /** Serial chain of ndof revolute joints with alternating Z and Y
+	axes, unit mass links of unit length, and a small isotropic
+	inertia. Useful for scaling benchmarks. */
+    jspace::Model * create_unit_mass_nR_model(size_t ndof) throw(std::runtime_error);
+    
     /** q1...q4 are the joint angles in rad. o1...o4 are the node
 	origins in global frame. c1...c4 are the COM positions in
 	global frame. J1...J4 are the Jacobians at the node
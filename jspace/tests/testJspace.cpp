@@ -538,6 +538,52 @@ TEST (jspaceModel, Jacobian_RP)
 }
 
 
+TEST (jspaceModel, Jacobian_halves_puma)
+{
+  jspace::Model * model(0);
+  try {
+    model = create_puma_model();
+    size_t const ndof(model->getNDOF());
+    jspace::State state(ndof, ndof, 0);
+    jspace::Matrix Jv(3, ndof);
+    jspace::Matrix Jw(3, ndof);
+    double const * const Jv_data(Jv.data());
+    double const * const Jw_data(Jw.data());
+    
+    for (size_t istate(0); istate < 5; ++istate) {
+      for (size_t ii(0); ii < ndof; ++ii) {
+	state.position_[ii] = 0.3 * istate - 0.2 * ii + 0.1;
+      }
+      model->update(state);
+      
+      for (size_t inode(0); inode < model->getNNodes(); ++inode) {
+	taoDNode * node(model->getNode(inode));
+	jspace::Transform gframe;
+	ASSERT_TRUE (model->computeGlobalFrame(node, 0.1, -0.2, 0.3, gframe));
+	jspace::Vector const gpos(gframe.translation());
+	jspace::Matrix Jg;
+	ASSERT_TRUE (model->computeJacobian(node, gpos, Jg));
+	ASSERT_TRUE (model->computeLinearJacobian(node, gpos, Jv));
+	ASSERT_TRUE (model->computeAngularJacobian(node, Jw));
+	
+	// the buffers are reused as they are
+	EXPECT_EQ (Jv_data, Jv.data());
+	EXPECT_EQ (Jw_data, Jw.data());
+	
+	std::ostringstream msg;
+	msg << "Checking Jacobian halves of node " << inode << " for q = " << state.position_ << "\n";
+	EXPECT_TRUE (check_matrix("linear", Jg.block(0, 0, 3, ndof), Jv, 1e-12, msg)) << msg.str();
+	EXPECT_TRUE (check_matrix("angular", Jg.block(3, 0, 3, ndof), Jw, 1e-12, msg)) << msg.str();
+      }
+    }
+  }
+  catch (std::exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+  delete model;
+}
+
+
 TEST (jspaceModel, com_RP)
 {
   jspace::Model * model(0);
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_ACTIVE_SET_QP_HPP
+#define OPSPACE_ACTIVE_SET_QP_HPP
+
+#include <jspace/Status.hpp>
+#include <jspace/wrap_eigen.hpp>
+#include <vector>
+
+namespace opspace {
+  
+  using jspace::Status;
+  using jspace::RTStatus;
+  using jspace::Vector;
+  using jspace::Matrix;
+  
+  
+  /**
+     Small dense active-set solver for strictly convex quadratic
+     programs with inequality constraints,
+     
+     \f[
+       \min_x \frac{1}{2} x^T H x + f^T x
+       \quad \mbox{s.t.} \quad C x \le d
+     \f]
+     
+     where H must be positive definite. Each iteration solves the
+     equality-constrained problem on the current working set W via
+     its Schur complement,
+     
+     \f[
+       (C_W H^{-1} C_W^T) \lambda_W = C_W x_0 - d_W, \quad
+       x = x_0 - H^{-1} C_W^T \lambda_W
+     \f]
+     
+     with the unconstrained minimum \f$ x_0 = -H^{-1} f \f$. Then it
+     either drops the working constraint with the most negative
+     multiplier, or adds the most violated constraint, until the KKT
+     conditions hold. Constraints which turn out to be linearly
+     dependent on the working set are set aside for the rest of the
+     solve.
+     
+     The working set is kept from one solve() to the next. When the
+     active constraints do not change between control ticks, a solve
+     costs one Cholesky factorization of H plus one of the (small)
+     Schur complement. Buffers only get reallocated when the size of
+     the working set changes.
+  */
+  class ActiveSetQP
+  {
+  public:
+    ActiveSetQP();
+    
+    /** Preallocate for the given problem size and forget the warm
+	start. Calling solve() with different dimensions does this
+	automatically. */
+    void init(size_t nvars, size_t ncons);
+    
+    /** Forget the working set, so that the next solve() starts
+	cold. */
+    void reset();
+    
+    /**
+       Solve the QP, warm-starting from the working set of the
+       previous call.
+       
+       \return failure if H is not positive definite, if the
+       iteration limit is reached, or if the constraints are
+       infeasible. In the latter two cases, x contains the last
+       iterate.
+    */
+    RTStatus solve(Matrix const & H, Vector const & f,
+		 Matrix const & C, Vector const & d,
+		 Vector & x);
+    
+    void setMaxIterations(size_t max_iterations) { max_iterations_ = max_iterations; }
+    
+    /** Number of equality-constrained subproblems solved during the
+	last call to solve(). This is 1 when the warm start was
+	exact. */
+    size_t getNIterations() const { return niterations_; }
+    
+    size_t getNActive() const { return working_.size(); }
+    bool isActive(size_t constraint) const { return active_[constraint]; }
+    
+    /** Lagrange multipliers of the last solution, one per constraint,
+	zero for the inactive ones. */
+    Vector const & getMultipliers() const { return lambda_; }
+    
+  protected:
+    size_t nvars_;
+    size_t ncons_;
+    size_t max_iterations_;
+    size_t niterations_;
+    
+    std::vector<size_t> working_; // constraint indices, in order of addition
+    std::vector<char> active_;	  // per constraint (avoids std::vector<bool>)
+    std::vector<char> blocked_;	  // per constraint, dependent on the working set
+    
+    Matrix hchol_;		// Cholesky factor of H
+    Vector x0_;			// unconstrained minimum
+    Matrix zz_;			// L^{-1} C_W^T
+    Matrix schur_;		// C_W H^{-1} C_W^T
+    Matrix schur_chol_;
+    Vector lambda_w_;
+    Vector lambda_;
+    Vector dx_;
+  };
+  
+}
+
+#endif // OPSPACE_ACTIVE_SET_QP_HPP
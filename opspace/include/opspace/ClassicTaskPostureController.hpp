@@ -28,6 +28,22 @@
 namespace opspace {
   
   
+  /**
+     Two-level operational space controller: a task in the range
+     space, and a posture in its dynamically consistent nullspace.
+     
+     All buffers get sized in init() (or upon the first
+     computeCommand() if the task dimension is not yet known), after
+     which computeCommand() does not allocate any heap memory as long
+     as the task inertia is well conditioned and the dimensions stay
+     the same.
+     
+     The posture command gets projected into the nullspace as
+     v - J^T (Jbar^T v), which takes O(N m) work for N DOF and an
+     m-dimensional task. The explicit N x N projector is only formed
+     if the "debug_nullspace" parameter is set to a non-zero value,
+     otherwise the "nullspace" parameter stays empty.
+  */
   class ClassicTaskPostureController
     : public Controller
   {
@@ -36,15 +52,24 @@ namespace opspace {
     
     virtual Status init(Model const & model);
     
-    virtual Status computeCommand(Model const & model,
-				  Skill & skill,
-				  Vector & gamma);
+    virtual RTStatus computeCommand(Model const & model,
+				    Skill & skill,
+				    Vector & gamma);
 
     virtual void dbg(std::ostream & os,
 		     std::string const & title,
 		     std::string const & prefix) const;
     
   protected:
+    size_t ndof_;
+    Matrix ainv_;
+    Vector grav_;
+    Matrix ainv_jt_;
+    Matrix lambda_inv_;
+    Matrix lambda_ws_;
+    Vector fproj_;
+    int debug_nullspace_;
+    
     Vector jpos_;
     Vector jvel_;
     Vector gamma_;
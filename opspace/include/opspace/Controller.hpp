@@ -40,9 +40,9 @@ namespace opspace {
   public:
     virtual Status init(Model const & model) = 0;
     
-    virtual Status computeCommand(Model const & model,
-				  Skill & skill,
-				  Vector & gamma) = 0;
+    virtual RTStatus computeCommand(Model const & model,
+				    Skill & skill,
+				    Vector & gamma) = 0;
     
     virtual void dbg(std::ostream & os,
 		     std::string const & title,
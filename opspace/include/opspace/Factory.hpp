@@ -26,6 +26,8 @@
 #include <boost/shared_ptr.hpp>
 #include <vector>
 #include <map>
+#include <typeinfo>
+#include <stdint.h>
 
 
 namespace opspace {
@@ -41,16 +43,19 @@ namespace opspace {
   struct ShopAPI {
     virtual ~ShopAPI() {}
     virtual base_type * create(std::string const & name) = 0;
+    virtual std::type_info const & getTypeInfo() const = 0;
   };
   
   template<typename task_subtype>
   struct TaskShop : public ShopAPI<Task> {
     virtual Task * create(std::string const & name) { return new task_subtype(name); }
+    virtual std::type_info const & getTypeInfo() const { return typeid(task_subtype); }
   };
   
   template<typename skill_subtype>
   struct SkillShop : public ShopAPI<Skill> {
     virtual Skill * create(std::string const & name) { return new skill_subtype(name); }
+    virtual std::type_info const & getTypeInfo() const { return typeid(skill_subtype); }
   };
   
   
@@ -132,6 +137,14 @@ namespace opspace {
     
     static Skill * createSkill(std::string const & type, std::string const & name);
     
+    /**
+       Reverse lookup of the type name under which the class of the
+       given instance has been registered. Returns an empty string if
+       the exact class has not been registered.
+    */
+    static std::string findTaskType(Task const & task);
+    static std::string findSkillType(Skill const & skill);
+    
     /**
        Parse a YAML document contained in a string. Retrieve the
        result using getTaskTable().
@@ -150,6 +163,77 @@ namespace opspace {
     */
     Status parseStream(std::istream & yaml_istream);
     
+    /**
+       Like parseFile(), but goes through a binary snapshot (see
+       saveSnapshot()) which is keyed by hashSource() of the YAML
+       file. If the snapshot exists and its key matches, it gets
+       loaded without any YAML parsing. Otherwise, the YAML file gets
+       parsed and the snapshot is (re)written, so a stale cache gets
+       rebuilt automatically. Failing to write the snapshot is not an
+       error, the next call will simply parse the YAML again.
+       
+       \note This should be used on an empty Factory, because the
+       snapshot contains all tasks and skills of the Factory.
+       
+       \param rebuilt Optional, set to true if the YAML file had to be
+       parsed.
+    */
+    Status parseFileCached(std::string const & yaml_filename,
+			   std::string const & snapshot_filename,
+			   bool * rebuilt = 0);
+    
+    /**
+       Like the above, but the snapshot key is computed by
+       hashSources() over the YAML file followed by the given
+       dependencies, so that editing any of them rebuilds the
+       snapshot. Pass the files that the YAML setup was written
+       against, e.g. the SAI XML robot description.
+       
+       \note Only the tasks and skills of the Factory get cached. The
+       dependencies are hashed, not parsed: the robot model still has
+       to be loaded by the caller (e.g. with jspace::test::parse_sai_xml_file()
+       or the BRParser) on every run.
+    */
+    Status parseFileCached(std::string const & yaml_filename,
+			   std::vector<std::string> const & dependencies,
+			   std::string const & snapshot_filename,
+			   bool * rebuilt = 0);
+    
+    /**
+       Write all tasks and skills to a compact binary file: their
+       type names and instance names, the values of all their
+       parameters, and the tasks assigned to the slots of each
+       skill. The key is stored in the file and checked by
+       loadSnapshot(), pass hashSources() of whatever the Factory was
+       built from. The data is written to a temporary file which then
+       gets renamed, so an existing snapshot is replaced atomically
+       and remains untouched if writing fails.
+    */
+    Status saveSnapshot(std::string const & filename, uint64_t key) const;
+    
+    /**
+       Re-create the tasks and skills of a file written by
+       saveSnapshot() and append them to the tables. Parameters are
+       only set where their value differs from the default of the
+       freshly created instance. Fails without touching the tables if
+       the file does not exist, is corrupt, or was written with a
+       different key.
+    */
+    Status loadSnapshot(std::string const & filename, uint64_t key);
+    
+    /**
+       Compute the 64-bit FNV-1a hash of the contents of a file,
+       together with the version of the snapshot format. Fails if the
+       file cannot be read. Same as hashSources() with a single file.
+    */
+    static Status hashSource(std::string const & filename, uint64_t & hash);
+    
+    /**
+       Like hashSource(), but over the contents of several files in
+       the given order. Fails if any of them cannot be read.
+    */
+    static Status hashSources(std::vector<std::string> const & filenames, uint64_t & hash);
+    
     /**
        The task table contains pointers to all task instances ever
        created by this Factory, in the order that they were
@@ -191,6 +275,8 @@ namespace opspace {
     
     task_table_t task_table_;
     skill_table_t skill_table_;
+    
+    Status writeSnapshot(std::ostream & os, uint64_t key) const;
   };
   
 }
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_HIERARCHICAL_CONTROLLER_HPP
+#define OPSPACE_HIERARCHICAL_CONTROLLER_HPP
+
+#include <opspace/Controller.hpp>
+#include <vector>
+
+namespace opspace {
+  
+  
+  /**
+     Strict-priority operational space controller for task tables of
+     arbitrary length. Task number zero has the highest priority, each
+     following task gets projected into the dynamically consistent
+     nullspace of all the tasks before it:
+     
+     \f[
+       J^*_k = J_k N_{k-1}, \quad
+       \Lambda^*_k = (J^*_k A^{-1} J^{*T}_k)^+, \quad
+       N_k = N_{k-1} - \bar{J}^*_k J^*_k
+     \f]
+     
+     with \f$ N_0 = I \f$ and \f$ \bar{J}^*_k = A^{-1} J^{*T}_k
+     \Lambda^*_k \f$. The product \f$ A^{-1} J^{*T}_k \f$ is computed
+     once per level and reused for \f$ \Lambda^*_k \f$, \f$ \bar{J}^*_k
+     \f$, and the nullspace update. Each task command is interpreted as
+     an acceleration, and the acceleration already produced by
+     higher-priority torques is compensated before the task force is
+     computed. Gravity torques are added at the end.
+     
+     Tasks with an empty Jacobian (e.g. an inactive JointLimitTask)
+     are skipped. Skill::checkJStarSV() is called with the singular
+     values of \f$ \Lambda^{*-1}_k \f$ of each active level, and its
+     failure aborts the computation.
+     
+     The joint-space buffers are allocated in init(). Per-level
+     buffers are allocated the first time a task table gets used and
+     only reallocated when the number of tasks or one of their
+     dimensions changes.
+  */
+  class HierarchicalController
+    : public Controller
+  {
+  public:
+    explicit HierarchicalController(std::string const & name);
+    
+    virtual Status init(Model const & model);
+    
+    virtual RTStatus computeCommand(Model const & model,
+				    Skill & skill,
+				    Vector & gamma);
+    
+    virtual void dbg(std::ostream & os,
+		     std::string const & title,
+		     std::string const & prefix) const;
+    
+  protected:
+    struct level_s {
+      Matrix jstar;		// J*_k = J_k N_{k-1}
+      Matrix ainv_jstar_t;	// A^{-1} J*_k^T, shared by lambda, jbar and nstar
+      Matrix lambda_inv;	// J*_k A^{-1} J*_k^T
+      Matrix lambda;
+      Matrix jbar;
+      Vector sv;
+      Vector xddot;		// command minus already achieved acceleration
+      Vector fstar;
+    };
+    
+    size_t ndof_;
+    Matrix ainv_;
+    Vector grav_;
+    Matrix nstar_;
+    Vector ainv_gamma_;
+    std::vector<level_s> level_;
+    
+    Vector jpos_;
+    Vector jvel_;
+    Vector gamma_;
+  };
+  
+}
+
+#endif // OPSPACE_HIERARCHICAL_CONTROLLER_HPP
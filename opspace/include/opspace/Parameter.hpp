@@ -26,12 +26,14 @@
 #include <jspace/wrap_eigen.hpp>
 #include <boost/shared_ptr.hpp>
 #include <map>
+#include <vector>
 
 
 namespace opspace {
   
   
   using jspace::Status;
+  using jspace::RTStatus;
   using jspace::Vector;
   using jspace::Matrix;
   
@@ -51,8 +53,9 @@ namespace opspace {
 
   typedef enum {
     PARAMETER_FLAG_DEFAULT = 0,
-    PARAMETER_FLAG_NOLOG = 1,
-    PARAMETER_FLAG_READONLY = 2
+    PARAMETER_FLAG_NOLOG = 1,	  //!< ParameterLog and ParameterRingLog skip it
+    PARAMETER_FLAG_READONLY = 2,
+    PARAMETER_FLAG_LOG_CHANGES = 4 //!< ParameterLog only records it when it changes
   } parameter_flags_t;
   
   
@@ -244,6 +247,23 @@ namespace opspace {
     
     parameter_lookup_t const & getParameterTable() const { return parameter_lookup_; }
     
+    /**
+       \return An integer handle for the named parameter, or -1 if the
+       name does not match. Handles are assigned in declaration order
+       and remain valid for the lifetime of the instance. Resolve them
+       once, then use getParameter() to skip the string lookup.
+    */
+    int getParameterHandle(std::string const & name) const;
+    
+    /** \return The parameter for a handle from getParameterHandle(). */
+    inline Parameter * getParameter(int handle) { return parameter_handle_[handle]; }
+    
+    /** \return The parameter for a handle from getParameterHandle(). */
+    inline Parameter const * getParameter(int handle) const { return parameter_handle_[handle]; }
+    
+    /** \return The number of parameters, i.e. one past the highest handle. */
+    inline size_t getNParameters() const { return parameter_handle_.size(); }
+    
     virtual void dump(std::ostream & os,
 		      std::string const & title,
 		      std::string const & prefix) const;
@@ -289,6 +309,7 @@ namespace opspace {
     
   private:
     parameter_lookup_t parameter_lookup_;
+    std::vector<Parameter *> parameter_handle_;
   };
   
   
@@ -327,29 +348,188 @@ namespace opspace {
 				      std::string const & parameter_name,
 				      parameter_type_t parameter_type) const;
     
+    /**
+       Resolve a parameter once and turn it into an integer handle,
+       which getParameter() maps back to the parameter without any
+       string lookups. Compiling the same parameter again yields the
+       same handle.
+       
+       \return The handle, or -1 if the parameter does not exist.
+    */
+    int compileParameter(std::string const & type_name,
+			 std::string const & instance_name,
+			 std::string const & parameter_name);
+    
+    /**
+       Like compileParameter(std::string const &, std::string const &,
+       std::string const &), but also fails (returns -1) if the
+       parameter does not have the given type.
+    */
+    int compileParameter(std::string const & type_name,
+			 std::string const & instance_name,
+			 std::string const & parameter_name,
+			 parameter_type_t parameter_type);
+    
+    /** \return The parameter for a handle from compileParameter(). */
+    inline Parameter * getParameter(int handle) { return compiled_[handle]; }
+    
+    /** \return The parameter for a handle from compileParameter(). */
+    inline Parameter const * getParameter(int handle) const { return compiled_[handle]; }
+    
   private:
     typedef std::map<std::string, boost::shared_ptr<ParameterReflection> > instance_map_t;
     typedef std::map<std::string, instance_map_t> type_map_t;
     type_map_t type_map_;
+    std::vector<Parameter *> compiled_;
   };
   
   
+  /**
+     Lock-free hand-over of parameter updates from a tuning thread to
+     the servo thread, for retuning a running controller.
+     
+     The tuning thread calls stage() for any number of new values,
+     followed by commit() to publish them as one batch. The servo
+     thread calls apply() at the beginning of each cycle, which sets
+     all committed values through the usual Parameter::set(). Thus the
+     checks of the owning ParameterReflection still run, in the servo
+     thread where they see a consistent state, and a batch (say, kp
+     and kd) never takes effect halfway through a tick.
+     
+     The queue is a fixed-size single-producer single-consumer ring
+     buffer. Its slots keep their storage across uses, so applying
+     integer, real, and (same-sized) vector or matrix values does not
+     allocate unless a check fails and builds an error message.
+     
+     \note At most one thread may stage and commit, and at most one
+     thread may apply, per instance.
+  */
+  class ParameterStage
+  {
+  public:
+    /** Allocates room for capacity staged but not yet applied values. */
+    explicit ParameterStage(size_t capacity);
+    
+    /**
+       Tuning thread: queue a new value for the next commit(). The
+       type and read-only flag are checked right away, the
+       ParameterReflection::check() is deferred to apply().
+       
+       \return Failure if the parameter is null, read-only, of a
+       different type, or if the queue is full.
+    */
+    Status stage(Parameter * parameter, int value);
+    
+    /** See stage(Parameter *, int)... */
+    Status stage(Parameter * parameter, std::string const & value);
+    
+    /** See stage(Parameter *, int)... */
+    Status stage(Parameter * parameter, double value);
+    
+    /** See stage(Parameter *, int)... */
+    Status stage(Parameter * parameter, Vector const & value);
+    
+    /** See stage(Parameter *, int)... */
+    Status stage(Parameter * parameter, Matrix const & value);
+    
+    /** Tuning thread: publish all values staged since the last commit(). */
+    void commit();
+    
+    /** Tuning thread: drop all values staged since the last commit(). */
+    void discard();
+    
+    /**
+       Servo thread: set all committed values, in the order they were
+       staged. Values rejected by Parameter::set() are skipped.
+       
+       \return Failure (prefixed by the parameter name) for the first
+       rejected value, success if all values were accepted or nothing
+       was pending.
+    */
+    Status apply();
+    
+    /** Number of values accepted by apply() so far. */
+    inline size_t getNApplied() const { return napplied_; }
+    
+    /** Number of values rejected by apply() so far. */
+    inline size_t getNRejected() const { return nrejected_; }
+    
+  protected:
+    struct entry_s {
+      Parameter * parameter;
+      int integer;
+      std::string string;
+      double real;
+      Vector vector;
+      Matrix matrix;
+    };
+    
+    entry_s * prepareEntry(Parameter * parameter, parameter_type_t type, Status & st);
+    
+    std::vector<entry_s> ring_;
+    size_t staged_;		// only used by the tuning thread
+    size_t volatile committed_;	// written by the tuning thread
+    size_t volatile applied_;	// written by the servo thread
+    size_t napplied_;
+    size_t nrejected_;
+  };
+  
+  
+  /**
+     Records the values of a set of parameters over time, and writes
+     them to one text file per parameter. Parameters flagged with
+     PARAMETER_FLAG_NOLOG are skipped.
+     
+     By default, each parameter gets recorded at every update(). To
+     reduce the amount of data, each parameter can be decimated
+     (recorded only every Nth update) and/or recorded only when its
+     value has changed since the last entry. The latter is the default
+     for parameters flagged with PARAMETER_FLAG_LOG_CHANGES. Each
+     entry carries its own timestamp, so the files stay
+     self-contained either way.
+  */
   class ParameterLog
   {
   public:
     template<typename parameter_t, typename storage_t>
     struct log_s {
-      explicit log_s(parameter_t const * pp): parameter(pp) {}
+      explicit log_s(parameter_t const * pp)
+	: parameter(pp),
+	  decimation(1),
+	  change_only(pp->flags_ & PARAMETER_FLAG_LOG_CHANGES) {}
       parameter_t const * parameter;
+      size_t decimation;
+      bool change_only;
+      std::vector<long long> timestamp;
       std::vector<storage_t> log;
     };
     
     ParameterLog(std::string const & name, parameter_lookup_t const & parameter_lookup);
     
+    /**
+       Record a parameter only at every decimation-th update(),
+       starting with the first one.
+       
+       \return Failure if the parameter is not part of the log, or if
+       decimation is zero.
+    */
+    Status setDecimation(std::string const & parameter_name, size_t decimation);
+    
+    /**
+       Record a parameter only when it differs from its previous
+       entry. Mostly useful for strings, integers, and other
+       parameters which rarely change.
+       
+       \return Failure if the parameter is not part of the log.
+    */
+    Status setChangeOnly(std::string const & parameter_name, bool change_only);
+    
     void update(long long timestamp);
     void writeFiles(std::string const & prefix, std::ostream * progress) const;
     
     std::string const name;
+    
+    /** One entry per update(), regardless of decimation. */
     std::vector<long long> timestamp;
     std::vector<log_s<IntegerParameter, int> > intlog;
     std::vector<log_s<StringParameter, std::string> > strlog;
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_PARAMETER_RING_LOG_HPP
+#define OPSPACE_PARAMETER_RING_LOG_HPP
+
+#include <opspace/Parameter.hpp>
+#include <pthread.h>
+#include <stdio.h>
+
+
+namespace opspace {
+
+
+  /**
+     Fixed-capacity alternative to ParameterLog for long runs. All
+     storage gets allocated by the constructor: one contiguous column
+     per parameter, holding capacity records of the shape the
+     parameter had at construction time. Calling update() from the
+     servo thread only copies the current values into the next free
+     row, it never allocates.
+
+     After open(), a background thread periodically flushes the
+     recorded rows to a compact binary file and hands them back to
+     the ring, so memory use stays constant no matter how long the
+     log runs. Use convertParameterLog() (or the dumpParameterLog
+     utility) to turn such a file into the text format of
+     ParameterLog::writeFiles().
+
+     Alternatively, openBlackBox() turns the ring into a flight
+     recorder: update() keeps overwriting the oldest row, so that the
+     ring always holds the last capacity records (e.g. 5000 for the
+     last five seconds at 1kHz). A failed Status passed to
+     triggerOnFailure(), or a call to trigger() from any thread,
+     freezes the ring. The background thread then dumps the frozen
+     records to the file.
+
+     Differences to ParameterLog:
+     - when the ring is full, update() drops the record and counts
+       it (see getNDropped()) instead of growing
+     - vector and matrix parameters whose size differs from the one
+       at construction get recorded as NaN (see getNMismatched())
+     - strings are truncated to string_width - 1 characters
+     - decimation (see setDecimation()) applies to whole records,
+       and there is no change-only mode, because every record has a
+       row in all columns
+
+     \note update() and the flushing thread form a single-producer
+     single-consumer pair. Only one thread may call update().
+  */
+  class ParameterRingLog
+  {
+  public:
+    enum {
+      /** Bytes reserved for each string value, including the terminating zero. */
+      string_width = 64
+    };
+
+    /**
+       Per-parameter column of the ring. The row for record number
+       ii starts at element (ii % capacity) * width of the storage
+       that matches the type.
+    */
+    struct column_s {
+      Parameter const * parameter;
+      parameter_type_t type;
+      size_t rows;		// vector length or matrix rows, 1 otherwise
+      size_t cols;		// matrix columns, 1 otherwise
+      size_t width;		// number of elements per row
+      std::vector<int> integer;
+      std::vector<double> real;
+      std::vector<char> string;
+    };
+
+    /**
+       Sets up columns for all parameters in the lookup table, except
+       those flagged with PARAMETER_FLAG_NOLOG. The capacity gets
+       rounded up to a power of two.
+    */
+    ParameterRingLog(std::string const & name,
+		     parameter_lookup_t const & parameter_lookup,
+		     size_t capacity);
+
+    /** Calls close(), which flushes everything that is still in the ring. */
+    virtual ~ParameterRingLog();
+
+    /**
+       Create the binary log file, write its header, and start the
+       background thread which flushes the ring every period_usec
+       microseconds. Records which were collected before open() go
+       to the file as well.
+    */
+    Status open(std::string const & filename, unsigned int period_usec = 10000);
+
+    /**
+       Start black box mode. Nothing gets written until the ring is
+       frozen by triggerOnFailure() or trigger(). At that point the
+       background thread, which checks every period_usec
+       microseconds, writes the frozen records (oldest first) to a
+       newly created file with the format of open(). Further
+       update() calls are counted as dropped. Call close() and
+       openBlackBox() again to re-arm.
+    */
+    Status openBlackBox(std::string const & filename, unsigned int period_usec = 10000);
+
+    /**
+       Stop the background thread, flush whatever is left in the ring,
+       and close the file. In black box mode, dumps the ring if it has
+       been frozen but not dumped yet. Does nothing if neither open()
+       nor openBlackBox() was called.
+    */
+    Status close();
+
+    /**
+       Black box mode, any thread: freeze the ring right after the
+       next update().
+    */
+    void trigger();
+
+    /**
+       Black box mode, servo thread: freeze the ring immediately if
+       status indicates a failure. Call this after update(), so that
+       the values which led to the failure are part of the dump.
+    */
+    void triggerOnFailure(Status const & status);
+
+    /** Same as above, for the RTStatus returned by Task::update() and friends. */
+    void triggerOnFailure(RTStatus const & status);
+
+    /** True once the black box has been frozen. */
+    inline bool isTriggered() const { return frozen_; }
+
+    /** True once the frozen black box has been written to its file. */
+    inline bool isDumped() const { return dumped_; }
+
+    /**
+       Record only every decimation-th call to update(), starting
+       with the first one. In black box mode, this stretches the ring
+       over capacity * decimation updates, but triggerOnFailure() may
+       then freeze it on a call which did not get recorded.
+
+       \return Failure if decimation is zero.
+    */
+    Status setDecimation(size_t decimation);
+
+    /**
+       Wait until all records made before the call have been written
+       to the file. Records added by update() while waiting do not
+       delay the return. In black box mode, returns immediately unless
+       the ring is frozen, in which case it waits for the dump.
+    */
+    void flush();
+
+    /** Servo thread: record the current values of all parameters. */
+    void update(long long timestamp);
+
+    inline std::string const & getName() const { return name_; }
+    inline size_t getCapacity() const { return capacity_; }
+    inline std::vector<column_s> const & getColumns() const { return column_; }
+
+    /** Number of records that did not fit into the ring, or arrived after a black box trigger. */
+    inline size_t getNDropped() const { return ndropped_; }
+
+    /** Number of vector or matrix values which had the wrong size. */
+    inline size_t getNMismatched() const { return nmismatched_; }
+
+    /** Number of records written to the file so far. */
+    inline size_t getNWritten() const { return tail_; }
+
+  protected:
+    static void * run(void * arg);
+
+    /** \return The number of records written, or -1 on write errors. */
+    int drain();
+
+    Status createFile(std::string const & filename);
+    Status startThread(unsigned int period_usec);
+    void dumpFrozen();
+
+    std::string const name_;
+    size_t capacity_;
+    std::vector<long long> timestamp_;
+    std::vector<column_s> column_;
+
+    size_t volatile head_;	// written by update() only
+    size_t volatile tail_;	// written by drain() only
+    size_t ndropped_;
+    size_t nmismatched_;
+    size_t decimation_;
+    size_t ntick_;		// calls to update(), recorded or not
+
+    FILE * file_;
+    unsigned int period_usec_;
+    bool running_;
+    int volatile quit_;
+    int volatile error_;
+    pthread_t thread_;
+
+    bool blackbox_;
+    std::string filename_;
+    int volatile trigger_;	// set by trigger() from any thread
+    int volatile frozen_;	// set by the servo thread
+    int volatile dumped_;	// set by whoever calls dumpFrozen()
+
+  private:
+    ParameterRingLog(ParameterRingLog const &);
+    ParameterRingLog & operator = (ParameterRingLog const &);
+  };
+
+
+  /**
+     Read a binary file written by ParameterRingLog and convert it to
+     the text files which ParameterLog::writeFiles() would have
+     produced for the same data, i.e. one prefix-name-param.dump file
+     per parameter.
+  */
+  Status convertParameterLog(std::string const & filename,
+			     std::string const & prefix,
+			     std::ostream * progress);
+
+}
+
+#endif // OPSPACE_PARAMETER_RING_LOG_HPP
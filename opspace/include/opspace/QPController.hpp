@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_QP_CONTROLLER_HPP
+#define OPSPACE_QP_CONTROLLER_HPP
+
+#include <opspace/Controller.hpp>
+#include <opspace/ActiveSetQP.hpp>
+
+namespace opspace {
+  
+  
+  /**
+     Whole-body controller which turns the task table of a Skill into
+     a weighted quadratic program over the joint accelerations, with
+     box limits on the joint torques and accelerations:
+     
+     \f[
+       \min_{\ddot q} \sum_k w_k \| J_k \ddot q - \ddot x_k \|^2
+         + \rho \| \ddot q \|^2
+       \quad \mbox{s.t.} \quad
+       | A \ddot q + g | \le \tau_{max}, \quad
+       | \ddot q | \le \ddot q_{max}
+     \f]
+     
+     where \f$ \ddot x_k \f$ is the command of task k, interpreted as
+     an acceleration like in the other controllers. The output torque
+     is \f$ A \ddot q + g \f$, Coriolis and centrifugal effects are
+     ignored just like in ClassicTaskPostureController.
+     
+     Priorities are approximated by weights: if the "weights"
+     parameter has one entry per task, those get used, otherwise task
+     k gets \f$ w_k = r^k \f$ with r the "priority_ratio" (default
+     1e-3). The "regularization" \f$ \rho \f$ keeps the problem
+     strictly convex. The "taumax" and "qddmax" parameters can be
+     empty (no limit), one-dimensional (same limit for all joints), or
+     have one entry per DOF. They are read in init().
+     
+     The QP gets solved by an ActiveSetQP, which warm-starts from the
+     previous tick's active set unless "warm_start" is zero. Tasks with
+     an empty Jacobian (e.g. an inactive JointLimitTask) are skipped.
+  */
+  class QPController
+    : public Controller
+  {
+  public:
+    explicit QPController(std::string const & name);
+    
+    virtual Status init(Model const & model);
+    
+    virtual RTStatus computeCommand(Model const & model,
+				    Skill & skill,
+				    Vector & gamma);
+    
+    virtual void dbg(std::ostream & os,
+		     std::string const & title,
+		     std::string const & prefix) const;
+    
+  protected:
+    Vector weights_;
+    double priority_ratio_;
+    double regularization_;
+    Vector taumax_;
+    Vector qddmax_;
+    int max_iterations_;
+    int warm_start_;
+    
+    size_t ndof_;
+    Vector qddlim_;		// expanded qddmax_, empty if unlimited
+    Vector taulim_;		// expanded taumax_, empty if unlimited
+    size_t tau_row_;		// first torque constraint row
+    Matrix aa_;
+    Vector grav_;
+    Matrix hh_;
+    Vector ff_;
+    Matrix cc_;
+    Vector dd_;
+    ActiveSetQP qp_;
+    
+    Vector qdd_;
+    Vector gamma_;
+    Vector jpos_;
+    Vector jvel_;
+    int niterations_;
+    int nactive_;
+  };
+  
+}
+
+#endif // OPSPACE_QP_CONTROLLER_HPP
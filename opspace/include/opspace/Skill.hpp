@@ -31,6 +31,8 @@
 #include <boost/shared_ptr.hpp>
 #include <vector>
 
+class deThreadPool;
+
 namespace opspace {
   
   
@@ -101,18 +103,48 @@ namespace opspace {
   {
   public:
     typedef std::vector<Task *> task_table_t;
+    typedef std::map<std::string, boost::shared_ptr<TaskSlotAPI> > slot_map_t;
     
     virtual ~Skill();
     
-    virtual Status update(Model const & model) = 0;
+    virtual RTStatus update(Model const & model) = 0;
     virtual task_table_t const * getTaskTable() = 0;
     
     virtual Status init(Model const & model);
-    virtual Status checkJStarSV(Task const * task, Vector const & sv) { Status ok; return ok; }
+    
+    /**
+       Optional preparation for switching skills at runtime, which
+       gets called outside of the servo thread (see SkillSwitch). The
+       default implementation checks that all non-optional slots are
+       filled, calls Task::prepare() on all task instances, and sizes
+       the buffers for parallel task updates. Subclasses which build
+       task tables should do so here as well, so that the init() at
+       the switch does not need to allocate.
+       
+       \note The same restrictions as for Task::prepare() apply: only
+       the structure of the model may be used, and the task instances
+       must not be in use by the currently active skill.
+    */
+    virtual Status prepare(Model const & model);
+    
+    virtual RTStatus checkJStarSV(Task const * task, Vector const & sv) { RTStatus ok; return ok; }
     
     inline std::string const & getName() const { return name_; }
     
+    /**
+       Opt-in parallel task updates. With a non-null pool, updateTasks()
+       (and thus the update() methods of the skills in the
+       skill_library) hands each task of the table to the pool. Tasks
+       only read the Model, so they are independent of each other. The
+       pool is not owned by the skill, and should be created in
+       spinning mode for use inside a servo loop. Set it back to null
+       for sequential updates, which is the default.
+    */
+    void setThreadPool(deThreadPool * pool) { thread_pool_ = pool; }
+    deThreadPool * getThreadPool() { return thread_pool_; }
+    
     boost::shared_ptr<TaskSlotAPI> lookupSlot(std::string const & name);
+    inline slot_map_t const & getSlotMap() const { return slot_map_; }
     
     virtual void dump(std::ostream & os,
 		      std::string const & title,
@@ -137,13 +169,87 @@ namespace opspace {
       return slot_api;
     }
     
+    /**
+       Update all tasks of the given table, in parallel if a thread
+       pool has been set. The sequential version stops at the first
+       failure. The parallel version updates all tasks, and then
+       returns the first failure in table order, so the result does
+       not depend on thread scheduling. The context of such a failure
+       gets copied into a buffer of the task's slot on the pool thread,
+       and then into the context buffers of the calling thread, so it
+       stays valid as described for jspace::RTStatus.
+    */
+    RTStatus updateTasks(Model const & model, task_table_t const & tasks);
+    
     std::string const name_;
     
   private:
-    typedef std::map<std::string, boost::shared_ptr<TaskSlotAPI> > slot_map_t;
+    Status checkSlots() const;
+    
+    static void updateTaskJob(void * arg, int index);
+    
+    deThreadPool * thread_pool_;
+    Model const * update_model_;
+    task_table_t const * update_tasks_;
+    std::vector<RTStatus> update_status_;
+    std::vector<char> update_context_; // RTStatus::context_size per task
+    
     slot_map_t slot_map_;
   };
   
+  
+  /**
+     Hands skills over to the servo thread without stalling it. The
+     expensive part of a switch happens in prepare(), which gets
+     called from some other thread and calls Skill::prepare() on the
+     new skill. The servo thread calls tick() at the beginning of
+     each servo cycle. When a prepared skill is pending, tick()
+     exchanges the active skill pointer and calls Skill::init(),
+     which then merely picks up the current state because all
+     allocations have already been done.
+     
+     There is one preparing thread and one servo thread, which
+     communicate through a single pending pointer. The skills are
+     owned by the preparing side, and skills which got switched out
+     get released in the next call to prepare(), so their destruction
+     never happens inside the servo loop.
+  */
+  class SkillSwitch
+  {
+  public:
+    SkillSwitch();
+    
+    /**
+       Prepare a skill and queue it for activation at the next
+       tick(). Fails without touching the skill if a previously
+       prepared one has not been picked up yet, if it is the active
+       skill, or if it shares a task instance with the active skill.
+    */
+    Status prepare(Model const & model, boost::shared_ptr<Skill> skill);
+    
+    /**
+       Call this from the servo thread at the beginning of each
+       cycle. If a prepared skill is pending, it gets switched in and
+       initialized. If the initialization fails, the previous skill
+       stays active and the error is returned.
+       
+       \note The switch costs a pointer exchange plus the (now
+       allocation-free) Skill::init() of the new skill.
+    */
+    Status tick(Model const & model);
+    
+    /** The currently active skill, or null before the first switch. */
+    inline Skill * getActive() const { return active_; }
+    
+    /** True while a prepared skill waits for the next tick(). */
+    inline bool isPending() const { return 0 != pending_; }
+    
+  protected:
+    Skill * volatile pending_;
+    Skill * volatile active_;
+    std::vector<boost::shared_ptr<Skill> > owned_;
+  };
+  
 }
 
 #endif // OPSPACE_SKILL_HPP
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_SPARSE_JACOBIAN_HPP
+#define OPSPACE_SPARSE_JACOBIAN_HPP
+
+#include <jspace/Model.hpp>
+#include <jspace/Status.hpp>
+#include <vector>
+
+namespace opspace {
+  
+  using jspace::Model;
+  using jspace::Status;
+  using jspace::RTStatus;
+  using jspace::Vector;
+  using jspace::Matrix;
+  
+  
+  /**
+     Jacobian which only stores the columns of its supporting DOF,
+     i.e. the joints which can actually move the task. For a hand
+     task on a humanoid, these are the joints on the path from the
+     root to the hand, which can be a small fraction of all DOF. The
+     list of supporting DOF comes from jspace::Model::getSupportingDOF()
+     and only depends on the kinematic structure, so it gets set up
+     once at init time. Each tick, gather() then copies the relevant
+     columns out of a dense Jacobian.
+     
+     Use computeSparseAinvJt() and computeSparseLambdaInverse() to
+     compute the task inertia while only reading the columns of
+     A^{-1} that correspond to supporting DOF.
+  */
+  class SparseJacobian
+  {
+  public:
+    SparseJacobian();
+    
+    /**
+       Set up the supporting DOF of a node, and size the compact
+       storage for nrows task dimensions.
+    */
+    Status init(Model const & model, taoDNode const * node, size_t nrows);
+    
+    /**
+       Set up an explicit list of supporting DOF, which must be sorted
+       in ascending order and smaller than ndof.
+    */
+    Status init(std::vector<size_t> const & dof, size_t ndof, size_t nrows);
+    
+    /**
+       Copy the supporting columns of a dense nrows x ndof
+       Jacobian. Columns of non-supporting DOF are assumed to be zero
+       and are simply ignored.
+    */
+    void gather(Matrix const & dense);
+    
+    /**
+       Write the equivalent dense Jacobian, for debugging and
+       testing. The matrix only gets resized if needed.
+    */
+    void scatter(Matrix & dense) const;
+    
+    /**
+       Compute J * qd into a task-space vector, reading only the
+       supporting entries of qd. Fails if qd does not have ndof
+       entries.
+    */
+    RTStatus multiply(Vector const & qd, Vector & result) const;
+    
+    /**
+       Compute J^T * ff into a joint-space vector. Entries of
+       non-supporting DOF are set to zero. Fails if ff does not have
+       one entry per row of the Jacobian.
+    */
+    RTStatus multiplyTranspose(Vector const & ff, Vector & result) const;
+    
+    inline std::vector<size_t> const & getDOF() const { return dof_; }
+    inline size_t getNDOF() const { return ndof_; }
+    inline Matrix const & getCompact() const { return compact_; }
+    inline Matrix & getCompact() { return compact_; }
+    
+  protected:
+    std::vector<size_t> dof_;
+    size_t ndof_;
+    Matrix compact_;
+  };
+  
+  
+  /**
+     Compute the dense ndof x nrows product A^{-1} J^T, reading only
+     the columns of A^{-1} that correspond to supporting DOF (A^{-1}
+     is symmetric, so its columns are also its rows). This costs
+     ndof * nsupport * nrows instead of ndof * ndof * nrows. The
+     result matches the dense product up to rounding, and ainv_jt
+     only gets resized if needed.
+  */
+  void computeSparseAinvJt(SparseJacobian const & jac,
+			   Matrix const & ainv,
+			   Matrix & ainv_jt);
+  
+  /**
+     Compute the inverse task inertia J A^{-1} J^T from the output of
+     computeSparseAinvJt(), reading only its supporting rows. Pass the
+     result to symmetricPseudoInverse() to get Lambda, after which
+     Jbar is simply ainv_jt * Lambda. The result matches the dense
+     product up to rounding, and lambda_inv only gets resized if
+     needed.
+  */
+  void computeSparseLambdaInverse(SparseJacobian const & jac,
+				  Matrix const & ainv_jt,
+				  Matrix & lambda_inv);
+  
+}
+
+#endif // OPSPACE_SPARSE_JACOBIAN_HPP
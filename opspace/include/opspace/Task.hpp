@@ -34,6 +34,8 @@ namespace opspace {
   
   using jspace::Model;
   
+  class SparseJacobian;
+  
   
   /**
      Partially abstract base class for all operational space
@@ -66,7 +68,7 @@ namespace opspace {
       return update(model);
     }
     
-    virtual Status update(Model const & model) {
+    virtual RTStatus update(Model const & model) {
       actual_ = model.getState().position_;
       if (actual_[0] > temp_) {
 	command_[0] = 1;
@@ -75,7 +77,7 @@ namespace opspace {
 	command_[0] = 0;
       }
       // jacobian_ was set in init() and never changes in this example
-      Status ok;
+      RTStatus ok;
       return ok;
     }
     
@@ -102,6 +104,21 @@ namespace opspace {
     */
     virtual Status init(Model const & model) = 0;
     
+    /**
+       Optional preparation for switching tasks at runtime. It gets
+       called through Skill::prepare() outside of the servo thread,
+       before the skill gets switched in (see SkillSwitch). Subclasses
+       should allocate and size everything that init() would
+       otherwise allocate, so that the init() at the switch merely
+       picks up the current state.
+       
+       \note This runs while the servo thread keeps updating the
+       model, so implementations must only use its structure
+       (getNDOF(), getNode(), getNodeByName(), and so on), never its
+       state. The default implementation does nothing.
+    */
+    virtual Status prepare(Model const & model) { Status ok; return ok; }
+    
     /**
        Abstract, implemented by subclasses in order to compute the
        current task state, the command acceleration, and the
@@ -113,8 +130,12 @@ namespace opspace {
        
        \note Make sure your subclass sets the actual_, command_, and
        jacobian_ fields in the implementation of this method.
+       
+       \note This runs in the servo loop, so it returns an RTStatus
+       instead of a Status. Failures should use static messages, or
+       RTStatus::fail() if they need runtime details.
     */
-    virtual Status update(Model const & model) = 0;
+    virtual RTStatus update(Model const & model) = 0;
     
     /**
        \return The actual "position" of the robot in this task
@@ -145,6 +166,15 @@ namespace opspace {
        set by subclasses in their update() method.
     */
     Matrix const & getJacobian() const { return jacobian_; }
+    
+    /**
+       \return The supporting columns of getJacobian(), or null if
+       the task does not track them (the default). Controllers use
+       this to compute the task inertia from only those columns of
+       A^{-1}. Tasks which override this must keep the returned
+       SparseJacobian in sync with jacobian_ in their update().
+    */
+    virtual SparseJacobian const * getSparseJacobian() const { return 0; }
 
     /**
        SVD cutoff value for pseudo inverse, exists in all tasks
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_TELEMETRY_HPP
+#define OPSPACE_TELEMETRY_HPP
+
+#include <opspace/Parameter.hpp>
+#include <stdint.h>
+
+
+namespace opspace {
+
+
+  /**
+     Fixed layout at the start of a telemetry segment. All offsets are
+     in bytes from the start of the segment. The schema block
+     (nentries telemetry_entry_s) follows the header, and the data
+     block follows the schema.
+  */
+  struct telemetry_header_s {
+    char magic[8];
+    uint32_t version;
+    uint32_t nentries;
+    uint32_t schema_offset;
+    uint32_t data_offset;
+    uint32_t data_size;
+    uint32_t padding;
+    /** Seqlock counter, odd while the publisher writes a snapshot. */
+    uint64_t volatile sequence;
+    int64_t volatile timestamp;
+  };
+
+
+  /**
+     Schema entry describing where and how one parameter is stored in
+     the data block of a telemetry segment. Names are zero-terminated
+     and get truncated if they do not fit.
+  */
+  struct telemetry_entry_s {
+    enum { name_width = 64 };
+    char type_name[name_width];
+    char instance_name[name_width];
+    char parameter_name[name_width];
+    uint32_t type;		// parameter_type_t
+    uint32_t rows;		// vector length or matrix rows, 1 otherwise
+    uint32_t cols;		// matrix columns, 1 otherwise
+    uint32_t offset;		// into the data block
+    uint32_t size;		// in bytes
+    uint32_t padding;
+  };
+
+
+  /**
+     Exports the current values of all parameters of a
+     ReflectionRegistry through a POSIX shared memory segment, for
+     plotters and monitors which run as separate processes on the same
+     machine.
+
+     open() lays out the segment once: a header, a schema block
+     describing the name, type, and shape of each parameter, and a
+     data block. publish() copies all values into the data block under
+     a seqlock, so it never blocks and never allocates, no matter what
+     the readers are doing. Readers (see TelemetryReader) retry if
+     they catch the publisher in the middle of an update.
+
+     The shapes of vector and matrix parameters are fixed at open()
+     time. Values which have changed size since then are published as
+     NaN and counted in getNMismatched(). Strings are truncated to
+     string_width - 1 characters. Integers are stored as int32,
+     everything else as double (matrices in column-major order).
+  */
+  class TelemetryPublisher
+  {
+  public:
+    enum {
+      /** Bytes reserved for each string value, including the terminating zero. */
+      string_width = 64
+    };
+
+    TelemetryPublisher();
+
+    /** Calls close(). */
+    virtual ~TelemetryPublisher();
+
+    /**
+       Create (or replace) the shared memory segment with the given
+       name, which should start with a slash, and lay it out for all
+       parameters currently in the registry.
+    */
+    Status open(std::string const & shm_name, ReflectionRegistry & registry);
+
+    /** Unmap and unlink the segment. Attached readers keep their mapping. */
+    void close();
+
+    /** Servo thread: copy the current parameter values to the segment. */
+    void publish(long long timestamp);
+
+    inline size_t getNEntries() const { return slot_.size(); }
+    inline size_t getNMismatched() const { return nmismatched_; }
+
+  protected:
+    struct slot_s {
+      Parameter const * parameter;
+      size_t rows;
+      size_t cols;
+      char * data;
+    };
+
+    std::string shm_name_;
+    char * segment_;
+    size_t segment_size_;
+    telemetry_header_s * header_;
+    std::vector<slot_s> slot_;
+    size_t nmismatched_;
+
+  private:
+    TelemetryPublisher(TelemetryPublisher const &);
+    TelemetryPublisher & operator = (TelemetryPublisher const &);
+  };
+
+
+  /**
+     Attaches (read-only) to the segment of a TelemetryPublisher,
+     possibly from another process, and reads consistent snapshots of
+     it.
+  */
+  class TelemetryReader
+  {
+  public:
+    TelemetryReader();
+
+    /** Calls detach(). */
+    virtual ~TelemetryReader();
+
+    /**
+       Map the named segment and parse its schema. Fails if there is
+       no such segment, if it has not been completely laid out yet,
+       or if any schema entry does not fit into the data block or has
+       a size which does not match its type and shape.
+    */
+    Status attach(std::string const & shm_name);
+
+    void detach();
+
+    inline size_t getNEntries() const { return schema_.size(); }
+    inline telemetry_entry_s const & getEntry(size_t index) const { return schema_[index]; }
+
+    /** \return The index of the given parameter, or -1 if it is not in the schema. */
+    int findEntry(std::string const & type_name,
+		  std::string const & instance_name,
+		  std::string const & parameter_name) const;
+
+    /**
+       Copy the data block into the internal snapshot, retrying up to
+       max_retries times when the publisher modifies it concurrently.
+
+       \return True if a consistent snapshot was read. On success, the
+       getters below return values from that snapshot.
+    */
+    bool update(size_t max_retries = 100);
+
+    /** Timestamp passed to TelemetryPublisher::publish() for the current snapshot. */
+    inline long long getTimestamp() const { return timestamp_; }
+
+    /** Seqlock counter of the current snapshot, twice the number of publish() calls. */
+    inline unsigned long long getSequence() const { return sequence_; }
+
+    bool getInteger(size_t index, int & value) const;
+    bool getString(size_t index, std::string & value) const;
+    bool getReal(size_t index, double & value) const;
+    bool getVector(size_t index, Vector & value) const;
+    bool getMatrix(size_t index, Matrix & value) const;
+
+  protected:
+    char const * segment_;
+    size_t segment_size_;
+    telemetry_header_s const * header_;
+    size_t data_offset_;
+    std::vector<telemetry_entry_s> schema_;
+    std::vector<char> snapshot_;
+    long long timestamp_;
+    unsigned long long sequence_;
+
+  private:
+    TelemetryReader(TelemetryReader const &);
+    TelemetryReader & operator = (TelemetryReader const &);
+  };
+
+}
+
+#endif // OPSPACE_TELEMETRY_HPP
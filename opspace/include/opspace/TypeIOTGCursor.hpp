@@ -24,14 +24,93 @@
 
 #include <jspace/wrap_eigen.hpp>
 #include <reflexxes_otg/TypeIOTG.h>
+#include <vector>
 
 namespace opspace {
   
   using jspace::Vector;
+  using jspace::Matrix;
 
   char const * otg_errstr(int otg_error_code);
   
   
+  /**
+     A piece of a trajectory during which the acceleration is
+     constant. Times are in seconds, relative to the state from which
+     the trajectory was computed. The position and velocity are the
+     ones at t_begin.
+  */
+  struct otg_segment_s {
+    double t_begin;
+    double t_end;
+    double position;
+    double velocity;
+    double acceleration;
+  };
+  
+  
+  /**
+     The complete future of a TypeIOTGCursor, as computed by
+     TypeIOTGCursor::preview(). For each DOF, it holds the
+     synchronized polynomial segments with their switching times. The
+     last segment of each DOF holds the goal and lasts forever
+     (t_end is infinity).
+     
+     Use sample() to evaluate many future time points at once, e.g.
+     for visualization, collision pre-checking, or for warm-starting
+     a predictive controller.
+  */
+  class TypeIOTGTrajectory
+  {
+  public:
+    TypeIOTGTrajectory();
+    
+    inline size_t getNDOF() const { return ndof_; }
+    
+    /** Time (in seconds) needed to reach the goal. */
+    inline double getDuration() const { return duration_; }
+    
+    inline size_t getNSegments(size_t dof) const
+    { return nsegments_[dof]; }
+    
+    inline otg_segment_s const & getSegment(size_t dof, size_t index) const
+    { return segments_[dof * MAXIMAL_NO_OF_POLYNOMIALS + index]; }
+    
+    /**
+       Evaluate position and velocity of all DOFs at the nsamples time
+       points t0, t0 + dt, t0 + 2 * dt, ... The results are stored
+       DOF by DOF, i.e. the position of DOF jj at sample ii ends up in
+       pos[jj * nsamples + ii]. Both buffers must have room for
+       getNDOF() * nsamples values.
+    */
+    void sample(double t0, double dt, size_t nsamples,
+		double * pos, double * vel) const;
+    
+    /**
+       Same as the pointer-based sample(), but stores the results in
+       nsamples x getNDOF() matrices (one column per DOF), which get
+       resized if needed.
+    */
+    void sample(double t0, double dt, size_t nsamples,
+		Matrix & pos, Matrix & vel) const;
+    
+    /**
+       Fill in the segments from the motion polynomials of a
+       reflexxes_otg::TypeIOTG. Called by TypeIOTGCursor::preview(),
+       does not allocate unless the number of DOFs changes.
+    */
+    void set(size_t ndof,
+	     double duration,
+	     TypeIOTGMath::TypeIMotionPolynomials const * polynomials);
+    
+  protected:
+    size_t ndof_;
+    double duration_;
+    std::vector<size_t> nsegments_;
+    std::vector<otg_segment_s> segments_;
+  };
+  
+  
   /**
      Utility for using reflexxes_otg::TypeIOTG. This class wraps a
      acceleration-bounded trajectory object from the reflexxes_otg
@@ -41,6 +120,12 @@ namespace opspace {
      The idea is that you simply initialize it by setting the starting
      position() and velocity(), and then repeatedly call next() to
      advance to the next desired position and velocity.
+     
+     By default, the cursor keeps the trajectory that was synchronized
+     by the previous call to next() and merely evaluates it at the
+     following time stamp, as long as the goal and the limits stay the
+     same and position() and velocity() have not been changed from the
+     outside. See setCaching().
   */
   class TypeIOTGCursor
   {
@@ -77,6 +162,43 @@ namespace opspace {
 	     double maxacc,
 	     double goal);
     
+    /**
+       Compute the entire trajectory from the current position() and
+       velocity() to the goal, without advancing the cursor. The
+       arguments are the same as for next(), and sampling the
+       resulting trajectory at dt_seconds_, 2 * dt_seconds_, ... yields
+       the states that successive calls to next() would produce (as
+       long as the goal and limits stay the same).
+       
+       \return reflexxes_otg::TypeIOTGResult: 0 if there is some
+       motion ahead, 1 if we are already at the goal, and negative
+       values on error.
+    */
+    int preview(Vector const & maxvel,
+		Vector const & maxacc,
+		Vector const & goal,
+		TypeIOTGTrajectory & trajectory);
+    
+    /**
+       Enable or disable reuse of the synchronized trajectory across
+       calls to next(). The trajectory gets recomputed whenever the
+       maximum velocity, acceleration, or goal differ from the
+       previous call, or whenever position() or velocity() deviate by
+       more than the given tolerance from what the previous call
+       produced (e.g. because they were re-anchored to the actual
+       robot state). Caching is on by default, with a tolerance of
+       default_cache_tolerance.
+    */
+    void setCaching(bool enable, double tolerance = default_cache_tolerance);
+    
+    /**
+       \return true if the most recent call to next() had to compute a
+       new trajectory, false if it reused the cached one.
+    */
+    inline bool replanned() const { return otg_.WasTrajectoryRecalculated(); }
+    
+    static double const default_cache_tolerance;
+    
     inline Vector & position()             { return pos_clean_; }
     inline Vector const & position() const { return pos_clean_; }
     inline Vector & velocity()             { return vel_clean_; }
@@ -86,6 +208,7 @@ namespace opspace {
     typedef Eigen::Matrix<bool, Eigen::Dynamic, 1> boolvec_t;
     
     TypeIOTG otg_;
+    std::vector<TypeIOTGMath::TypeIMotionPolynomials> preview_polynomials_;
     boolvec_t selection_;
     Vector pos_clean_;
     Vector vel_clean_;
@@ -93,6 +216,65 @@ namespace opspace {
     Vector vel_dirty_;
   };
   
+  
+  /**
+     Unsynchronized counterpart of TypeIOTGCursor. Each degree of
+     freedom follows its own time-optimal Type I profile, i.e. the
+     DOFs do not wait for each other to arrive at the goal at the same
+     time. This is what you want for a set of independent 1-DOF
+     trajectories, such as the ones used by opspace::JointLimitTask.
+     
+     Instead of one reflexxes_otg::TypeIOTG instance per DOF, the
+     profiles are stored as one vector per quantity and evaluated in
+     closed form by a single loop over all DOFs, which does not branch
+     on the profile shape and can thus be vectorized by the compiler.
+     
+     Only the DOFs which are flagged in selection() are advanced by
+     next(), the others keep their position() and velocity(). All DOFs
+     are selected after construction.
+  */
+  class TypeIOTGUnsyncCursor
+  {
+  public:
+    typedef Eigen::Matrix<bool, Eigen::Dynamic, 1> boolvec_t;
+    
+    size_t const ndof_;
+    double const dt_seconds_;
+    
+    TypeIOTGUnsyncCursor(size_t ndof,
+			 double dt_seconds);
+    
+    /**
+       Compute the next desired position() and velocity() of all
+       selected DOFs. Semantics are the same as TypeIOTGCursor::next(),
+       except that each DOF reaches its goal as quickly as its own
+       limits allow.
+       
+       \return reflexxes_otg::TypeIOTGResult: 0 if at least one
+       selected DOF is still moving, 1 if all of them are at their
+       goal, and negative values if the limits of a selected DOF are
+       invalid (in which case nothing gets updated).
+    */
+    int next(Vector const & maxvel,
+	     Vector const & maxacc,
+	     Vector const & goal);
+    
+    inline Vector & position()                { return pos_; }
+    inline Vector const & position() const    { return pos_; }
+    inline Vector & velocity()                { return vel_; }
+    inline Vector const & velocity() const    { return vel_; }
+    inline boolvec_t & selection()             { return selection_; }
+    inline boolvec_t const & selection() const { return selection_; }
+    
+  protected:
+    boolvec_t selection_;
+    Vector pos_;
+    Vector vel_;
+    Vector pos_next_;
+    Vector vel_next_;
+    Vector remaining_;
+  };
+  
 }
 
 #endif // OPSPACE_TYPE_I_OTG_CURSOR_HPP
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPSPACE_PD_SATURATION_HPP
+#define OPSPACE_PD_SATURATION_HPP
+
+#include <stddef.h>
+
+namespace opspace {
+  
+  /**
+     Arguments of the PD kernels below, as raw arrays so that the
+     kernels can work directly on the storage of PDTask members and
+     the compiler does not need to reason about Eigen expressions. All
+     arrays have ndim entries, except kp, kd, and maxvel for
+     pdSaturateNorm(), which only uses their first entry. The output
+     arrays must not overlap the inputs.
+     
+     Each kernel computes errpos = goalpos - curpos and errvel =
+     goalvel - curvel, and then command = kp * errpos, saturated as
+     described for PDTask::saturation_policy_t, plus kd * errvel, in
+     one pass (two for pdSaturateMaxComponent()). Components whose kd
+     or maxvel are not above 1e-4 are never saturated.
+     
+     The saturation is written without branches (clamping to kd *
+     maxvel, or scaling by a factor which is one when the limit is
+     not reached), so the loops get vectorized. For ndim == 3, which
+     is the case of Cartesian position tasks, the kernels dispatch to
+     fully unrolled fixed-size instances. The results are the same as
+     the per-component loops PDTask used to have, up to rounding.
+  */
+  struct pd_kernel_s {
+    size_t ndim;
+    double const * goalpos;
+    double const * curpos;
+    double const * goalvel;
+    double const * curvel;
+    double const * kp;
+    double const * kd;
+    double const * maxvel;
+    double * errpos;
+    double * errvel;
+    double * command;
+  };
+  
+  /** PDTask::SATURATION_OFF: plain PD command, no saturation. */
+  void pdSaturateOff(pd_kernel_s const & pd);
+  
+  /** PDTask::SATURATION_COMPONENT_WISE: each kp * errpos gets
+      clamped to +/- kd * maxvel. */
+  void pdSaturateComponentWise(pd_kernel_s const & pd);
+  
+  /** PDTask::SATURATION_MAX_COMPONENT: kp * errpos gets scaled such
+      that its most saturated component reaches kd * maxvel. */
+  void pdSaturateMaxComponent(pd_kernel_s const & pd);
+  
+  /** PDTask::SATURATION_NORM: kp * errpos gets scaled such that its
+      norm does not exceed kd * maxvel (one-dimensional gains). */
+  void pdSaturateNorm(pd_kernel_s const & pd);
+  
+}
+
+#endif // OPSPACE_PD_SATURATION_HPP
@@ -44,6 +44,86 @@ namespace opspace {
 		     Matrix & invMatrix,
 		     Vector * opt_sigmaOut = 0);
   
+  /**
+     Pseudo-inverse specialized for symmetric positive semidefinite
+     matrices, such as the inverse task inertia J A^{-1} J^T. The
+     result is the same as pseudoInverse() with the same
+     sigmaThreshold (up to rounding), but much cheaper in the common
+     well-conditioned case:
+     
+     - First, a Cholesky decomposition gets attempted. If it succeeds
+       and all eigenvalues are provably above sigmaThreshold, its
+       inverse is returned directly.
+     - Otherwise, a self-adjoint eigendecomposition replaces the
+       general SVD, and eigenvalues at or below sigmaThreshold get
+       zeroed just like pseudoInverse() does with singular values.
+     
+     If opt_sigmaOut is given, it receives the eigenvalues sorted in
+     decreasing order. For a symmetric positive semidefinite matrix
+     these are its singular values, in the same order as returned by
+     pseudoInverse(), so they can be fed to Skill::checkJStarSV().
+     
+     
+     \note The input is assumed to be symmetric, only its lower
+     triangle is used by the decompositions.
+  */
+  void symmetricPseudoInverse(Matrix const & matrix,
+			      double sigmaThreshold,
+			      Matrix & invMatrix,
+			      Vector * opt_sigmaOut = 0);
+  
+  /**
+     In-place Cholesky factorization matrix = lower * lower^T, written
+     into the lower triangle of the given output (the strictly upper
+     triangle is left untouched). Does not allocate if lower already
+     has the right dimensions.
+     
+     \return false if the matrix is not positive definite, in which
+     case lower contains garbage.
+  */
+  bool choleskyFactor(Matrix const & matrix, Matrix & lower);
+  
+  /** Solve lower * x = rhs in place, column by column, using the
+      output of choleskyFactor(). */
+  void choleskyForwardSubstitute(Matrix const & lower, Vector & rhs);
+  void choleskyForwardSubstitute(Matrix const & lower, Matrix & rhs);
+  
+  /** Solve lower^T * x = rhs in place, column by column, using the
+      output of choleskyFactor(). Applying choleskyForwardSubstitute()
+      and then choleskyBackSubstitute() solves matrix * x = rhs. */
+  void choleskyBackSubstitute(Matrix const & lower, Vector & rhs);
+  void choleskyBackSubstitute(Matrix const & lower, Matrix & rhs);
+  
+  /**
+     Workspace variant of symmetricPseudoInverse() for use in servo
+     loops. The workspace must have the same dimensions as the input
+     matrix, and invMatrix should already have them too. As long as the
+     Cholesky fast path succeeds, this does not allocate any heap
+     memory. Rank deficient or badly conditioned inputs fall back to
+     symmetricPseudoInverse(), which does allocate.
+     
+     \return true if the Cholesky fast path was taken.
+  */
+  bool symmetricPseudoInverse(Matrix const & matrix,
+			      double sigmaThreshold,
+			      Matrix & invMatrix,
+			      Matrix & workspace);
+  
+  /** Fixed-size overload of symmetricPseudoInverse() for 3-D task
+      spaces, e.g. end-effector positions. Does not allocate. */
+  void symmetricPseudoInverse(Eigen::Matrix3d const & matrix,
+			      double sigmaThreshold,
+			      Eigen::Matrix3d & invMatrix,
+			      Eigen::Vector3d * opt_sigmaOut = 0);
+  
+  /** Fixed-size overload of symmetricPseudoInverse() for 6-D task
+      spaces, e.g. end-effector position and orientation. Does not
+      allocate. */
+  void symmetricPseudoInverse(Eigen::Matrix<double, 6, 6> const & matrix,
+			      double sigmaThreshold,
+			      Eigen::Matrix<double, 6, 6> & invMatrix,
+			      Eigen::Matrix<double, 6, 1> * opt_sigmaOut = 0);
+  
 }
 
 #endif // OPSPACE_PSEUDO_INVERSE_HPP
@@ -35,7 +35,8 @@ namespace opspace {
     GenericSkill(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     virtual task_table_t const * getTaskTable();
     
     void appendTask(boost::shared_ptr<Task> task);
@@ -53,9 +54,10 @@ namespace opspace {
     TaskPostureSkill(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     virtual task_table_t const * getTaskTable();
-    virtual Status checkJStarSV(Task const * task, Vector const & sv);
+    virtual RTStatus checkJStarSV(Task const * task, Vector const & sv);
     
   protected:
     CartPosTask * eepos_;
@@ -71,9 +73,10 @@ namespace opspace {
     TaskPostureTrjSkill(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     virtual task_table_t const * getTaskTable();
-    virtual Status checkJStarSV(Task const * task, Vector const & sv);
+    virtual RTStatus checkJStarSV(Task const * task, Vector const & sv);
     
   protected:
     CartPosTrjTask * eepos_;
@@ -27,10 +27,13 @@
 #define OPSPACE_TASK_LIBRARY_HPP
 
 #include <opspace/Task.hpp>
+#include <opspace/SparseJacobian.hpp>
 
 namespace opspace {
   
   class TypeIOTGCursor;
+  class TypeIOTGUnsyncCursor;
+  class TypeIOTGTrajectory;
   
 
   /**
@@ -108,6 +111,15 @@ namespace opspace {
     */
     Status initPDTask(Vector const & initpos);
     
+    /**
+       Does the parameter checks and conversions of initPDTask() for
+       an ndim-dimensional task, and sizes the goal and error
+       vectors, without touching the state. Subclasses call this
+       from their prepare() so that the subsequent initPDTask() does
+       not allocate.
+    */
+    Status preparePDTask(size_t ndim);
+    
     /**
        Compute PD command, with velocity saturation determined by the
        saturation_policy specified at construction time. This drives
@@ -115,9 +127,9 @@ namespace opspace {
               
        \return Success if everything went well, failure otherwise.
     */
-    Status computePDCommand(Vector const & curpos,
-			    Vector const & curvel,
-			    Vector & command);
+    RTStatus computePDCommand(Vector const & curpos,
+			      Vector const & curvel,
+			      Vector & command);
     
     saturation_policy_t const saturation_policy_;
     bool initialized_;
@@ -141,7 +153,7 @@ namespace opspace {
     virtual Status check(Vector const * param, Vector const & value) const;
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual RTStatus update(Model const & model);
     
     virtual void dbg(std::ostream & os,
 		     std::string const & title,
@@ -150,9 +162,9 @@ namespace opspace {
   protected:
     Status initDraftPIDTask(Vector const & initpos);
     
-    Status computeDraftPIDCommand(Vector const & curpos,
-				  Vector const & curvel,
-				  Vector & command);
+    RTStatus computeDraftPIDCommand(Vector const & curpos,
+				    Vector const & curvel,
+				    Vector & command);
     
     double dt_seconds_;
     Vector ki_;
@@ -174,6 +186,8 @@ namespace opspace {
      Parameters (see also PDTask for inherited parameters):
      - end_effector (string): name of the end effector link
      - control_point (vector): reference point wrt end effector frame
+     - jacobian_cache_hits (integer): Model::getCachedFrameJacobian() hits
+     - jacobian_cache_misses (integer): Model::getCachedFrameJacobian() misses
   */
   class CartPosTask
     : public PDTask
@@ -182,8 +196,10 @@ namespace opspace {
     explicit CartPosTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     virtual Status check(std::string const * param, std::string const & value) const;
+    virtual SparseJacobian const * getSparseJacobian() const;
     
     inline void quickSetup(Vector const & kp, Vector const & kd, Vector const & maxvel,
 			   std::string const & name, Vector const & control_point)
@@ -198,6 +214,11 @@ namespace opspace {
     Vector control_point_;
     
     mutable taoDNode const * end_effector_node_;
+    int jacobian_cache_hits_;
+    int jacobian_cache_misses_;
+    
+    taoDNode const * sparse_node_;
+    SparseJacobian sparse_jacobian_;
     
     taoDNode const * updateActual(Model const & model);
   };
@@ -218,7 +239,8 @@ namespace opspace {
     explicit JPosTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
   };
   
   
@@ -238,7 +260,7 @@ namespace opspace {
     explicit SelectedJointPostureTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual RTStatus update(Model const & model);
     virtual Status check(double const * param, double value) const;
     virtual Status check(Vector const * param, Vector const & value) const;
     
@@ -292,6 +314,18 @@ namespace opspace {
 		     std::string const & title,
 		     std::string const & prefix) const;
     
+    /**
+       Computes the entire remaining trajectory from the current
+       cursor state toward trjgoal, without advancing the cursor. The
+       result can be sampled at arbitrary future times, e.g. for
+       look-ahead collision checks or visualization. Call this from
+       the same thread that updates the task.
+       
+       \return Failure if the task has not been initialized or the
+       trajectory generator reports an error.
+    */
+    Status previewTrajectory(TypeIOTGTrajectory & trajectory);
+    
   protected:
     typedef PDTask::saturation_policy_t saturation_policy_t;
     
@@ -306,14 +340,22 @@ namespace opspace {
     */
     Status initTrajectoryTask(Vector const & initpos);
     
+    /**
+       Does the checks and conversions of initTrajectoryTask() for an
+       ndim-dimensional task, and allocates the cursor. Subclasses
+       call this from their prepare() so that the subsequent
+       initTrajectoryTask() does not allocate.
+    */
+    Status prepareTrajectoryTask(size_t ndim);
+    
     /**
        Computes the command for following the trajectory. It advances
        the cursor by dt_seconds toward the trjgoal and servos to that
        position and velocity using PDTask::computePDCommand().
     */
-    Status computeTrajectoryCommand(Vector const & curpos,
-				    Vector const & curvel,
-				    Vector & command);
+    RTStatus computeTrajectoryCommand(Vector const & curpos,
+				      Vector const & curvel,
+				      Vector & command);
     
     TypeIOTGCursor * cursor_;
     double dt_seconds_;
@@ -333,6 +375,8 @@ namespace opspace {
      Parameters (see also TrajectoryTask for inherited parameters):
      - end_effector_id (integer): identifier of the end effector link
      - control_point (vector): reference point wrt end effector frame
+     - jacobian_cache_hits (integer): Model::getCachedFrameJacobian() hits
+     - jacobian_cache_misses (integer): Model::getCachedFrameJacobian() misses
   */
   class CartPosTrjTask
     : public TrajectoryTask
@@ -341,11 +385,18 @@ namespace opspace {
     explicit CartPosTrjTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
+    virtual SparseJacobian const * getSparseJacobian() const;
     
   protected:
     int end_effector_id_;
     Vector control_point_;
+    int jacobian_cache_hits_;
+    int jacobian_cache_misses_;
+    
+    taoDNode const * sparse_node_;
+    SparseJacobian sparse_jacobian_;
     
     taoDNode const * updateActual(Model const & model);
   };
@@ -365,7 +416,8 @@ namespace opspace {
     explicit JPosTrjTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     
     /**
        \todo Maybe move this (or something similar) to the superclass?
@@ -384,7 +436,8 @@ namespace opspace {
     virtual Status check(Vector const * param, Vector const & value) const;
     virtual Status check(double const * param, double const & value) const;
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual Status prepare(Model const & model);
+    virtual RTStatus update(Model const & model);
     
     virtual void dbg(std::ostream & os,
 		     std::string const & title,
@@ -408,9 +461,15 @@ namespace opspace {
     Vector lower_stop_;
     Vector lower_trigger_;
     
-    std::vector<TypeIOTGCursor *> cursor_;
+    /** One unsynchronized trajectory per joint. Its selection()
+	flags the joints which are currently being pushed away from
+	their limits. Allocated by prepare() or init(), so that
+	(re-)entering a joint limit does not allocate. */
+    TypeIOTGUnsyncCursor * cursor_;
     Vector goal_;
 
+    Status checkDimensions(size_t ndof) const;
+    void prepareCursor(size_t ndof);
     void updateState(Model const & model);
   };
   
@@ -422,7 +481,7 @@ namespace opspace {
     explicit OrientationTask(std::string const & name);
     
     virtual Status init(Model const & model);
-    virtual Status update(Model const & model);
+    virtual RTStatus update(Model const & model);
     
     virtual void dbg(std::ostream & os,
 		     std::string const & title,
@@ -445,6 +504,8 @@ namespace opspace {
     double kd_;
     double maxvel_;
     Vector eepos_;		// just for logging...
+    int jacobian_cache_hits_;
+    int jacobian_cache_misses_;
   };
 
   
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/ActiveSetQP.hpp>
+#include <opspace/pseudo_inverse.hpp>
+#include <cmath>
+
+using namespace std;
+
+namespace opspace {
+  
+  
+  ActiveSetQP::
+  ActiveSetQP()
+    : nvars_(0),
+      ncons_(0),
+      max_iterations_(100),
+      niterations_(0)
+  {
+  }
+  
+  
+  void ActiveSetQP::
+  init(size_t nvars, size_t ncons)
+  {
+    nvars_ = nvars;
+    ncons_ = ncons;
+    working_.clear();
+    working_.reserve(ncons);
+    active_.assign(ncons, 0);
+    blocked_.assign(ncons, 0);
+    hchol_ = Matrix::Zero(nvars, nvars);
+    x0_ = Vector::Zero(nvars);
+    dx_ = Vector::Zero(nvars);
+    lambda_ = Vector::Zero(ncons);
+    zz_.resize(nvars, 0);
+    schur_.resize(0, 0);
+    schur_chol_.resize(0, 0);
+    lambda_w_.resize(0);
+    niterations_ = 0;
+  }
+  
+  
+  void ActiveSetQP::
+  reset()
+  {
+    for (size_t ii(0); ii < working_.size(); ++ii) {
+      active_[working_[ii]] = 0;
+    }
+    working_.clear();
+  }
+  
+  
+  RTStatus ActiveSetQP::
+  solve(Matrix const & H, Vector const & f,
+	Matrix const & C, Vector const & d,
+	Vector & x)
+  {
+    niterations_ = 0;
+    if ((H.rows() != H.cols()) || (f.rows() != H.rows())
+	|| (C.cols() != H.rows()) || (d.rows() != C.rows())) {
+      return RTStatus(jspace::STATUS_INVALID_DIMENSION, "inconsistent QP dimensions");
+    }
+    if ((static_cast<size_t>(H.rows()) != nvars_) || (static_cast<size_t>(C.rows()) != ncons_)) {
+      init(H.rows(), C.rows());
+    }
+    if (static_cast<size_t>(x.rows()) != nvars_) {
+      x.resize(nvars_);
+    }
+    
+    if ( ! choleskyFactor(H, hchol_)) {
+      return RTStatus(jspace::STATUS_NUMERIC_ERROR, "QP Hessian is not positive definite");
+    }
+    x0_ = -f;
+    choleskyForwardSubstitute(hchol_, x0_);
+    choleskyBackSubstitute(hchol_, x0_);
+    
+    for (size_t ii(0); ii < ncons_; ++ii) {
+      blocked_[ii] = 0;
+    }
+    
+    while (niterations_ < max_iterations_) {
+      ++niterations_;
+      int const nw(working_.size());
+      
+      // Solve the equality-constrained problem on the working set.
+      if (zz_.cols() != nw) {
+	zz_.resize(nvars_, nw);
+	schur_.resize(nw, nw);
+	schur_chol_.resize(nw, nw);
+	lambda_w_.resize(nw);
+      }
+      for (int kk(0); kk < nw; ++kk) {
+	size_t const ic(working_[kk]);
+	double rhs(-d.coeff(ic));
+	for (size_t jj(0); jj < nvars_; ++jj) {
+	  zz_.coeffRef(jj, kk) = C.coeff(ic, jj);
+	  rhs += C.coeff(ic, jj) * x0_.coeff(jj);
+	}
+	lambda_w_.coeffRef(kk) = rhs;
+      }
+      x = x0_;
+      if (nw > 0) {
+	choleskyForwardSubstitute(hchol_, zz_);
+	schur_ = (zz_.transpose() * zz_).lazy();
+	if ( ! choleskyFactor(schur_, schur_chol_)) {
+	  // The most recently added constraint is linearly dependent
+	  // on the rest of the working set: set it aside.
+	  size_t const ic(working_.back());
+	  working_.pop_back();
+	  active_[ic] = 0;
+	  blocked_[ic] = 1;
+	  continue;
+	}
+	choleskyForwardSubstitute(schur_chol_, lambda_w_);
+	choleskyBackSubstitute(schur_chol_, lambda_w_);
+	dx_ = (zz_ * lambda_w_).lazy();
+	choleskyBackSubstitute(hchol_, dx_);
+	x -= dx_;
+      }
+      
+      // Dual feasibility: drop the most negative multiplier.
+      double lmax(0);
+      for (int kk(0); kk < nw; ++kk) {
+	lmax = max(lmax, fabs(lambda_w_.coeff(kk)));
+      }
+      int drop(-1);
+      double lmin(-1e-10 * (1 + lmax));
+      for (int kk(0); kk < nw; ++kk) {
+	if (lambda_w_.coeff(kk) < lmin) {
+	  lmin = lambda_w_.coeff(kk);
+	  drop = kk;
+	}
+      }
+      if (drop >= 0) {
+	active_[working_[drop]] = 0;
+	working_.erase(working_.begin() + drop);
+	// constraints set aside earlier may have become independent
+	for (size_t ic(0); ic < ncons_; ++ic) {
+	  blocked_[ic] = 0;
+	}
+	continue;
+      }
+      
+      // Primal feasibility: add the most violated constraint.
+      int add(-1);
+      double vmax(0);
+      bool blocked_violated(false);
+      for (size_t ic(0); ic < ncons_; ++ic) {
+	if (active_[ic]) {
+	  continue;
+	}
+	double viol(-d.coeff(ic));
+	for (size_t jj(0); jj < nvars_; ++jj) {
+	  viol += C.coeff(ic, jj) * x.coeff(jj);
+	}
+	viol /= 1 + fabs(d.coeff(ic));
+	if (viol <= 1e-9) {
+	  continue;
+	}
+	if (blocked_[ic]) {
+	  blocked_violated = true;
+	}
+	else if (viol > vmax) {
+	  vmax = viol;
+	  add = ic;
+	}
+      }
+      if (add >= 0) {
+	working_.push_back(add);
+	active_[add] = 1;
+	continue;
+      }
+      if (blocked_violated) {
+	return RTStatus(jspace::STATUS_NUMERIC_ERROR, "QP constraints are infeasible");
+      }
+      
+      lambda_.setZero();
+      for (int kk(0); kk < nw; ++kk) {
+	lambda_.coeffRef(working_[kk]) = lambda_w_.coeff(kk);
+      }
+      return RTStatus();
+    }
+    
+    return RTStatus(jspace::STATUS_NUMERIC_ERROR, "QP active set did not converge");
+  }
+  
+}
@@ -21,6 +21,7 @@
 
 #include <opspace/ClassicTaskPostureController.hpp>
 #include <opspace/pseudo_inverse.hpp>
+#include <opspace/SparseJacobian.hpp>
 
 // hmm...
 #include <Eigen/LU>
@@ -35,7 +36,9 @@ namespace opspace {
   
   ClassicTaskPostureController::
   ClassicTaskPostureController(std::string const & name)
-    : Controller(name)
+    : Controller(name),
+      ndof_(0),
+      debug_nullspace_(0)
   {
     declareParameter("jpos", &jpos_);
     declareParameter("jvel", &jvel_);
@@ -44,72 +47,126 @@ namespace opspace {
     declareParameter("lambda", &lambda_);
     declareParameter("jbar", &jbar_);
     declareParameter("nullspace", &nullspace_);
+    declareParameter("debug_nullspace", &debug_nullspace_, PARAMETER_FLAG_NOLOG);
   }
   
   
   Status ClassicTaskPostureController::
   init(Model const & model)
   {
+    ndof_ = model.getNDOF();
+    ainv_ = Matrix::Zero(ndof_, ndof_);
+    grav_ = Vector::Zero(ndof_);
+    if (debug_nullspace_) {
+      nullspace_ = Matrix::Identity(ndof_, ndof_);
+    }
+    else {
+      nullspace_.resize(0, 0);
+    }
+    jpos_ = Vector::Zero(ndof_);
+    jvel_ = Vector::Zero(ndof_);
+    gamma_ = Vector::Zero(ndof_);
+    // task-space buffers get sized once the task dimension is known
+    ainv_jt_.resize(ndof_, 0);
+    jbar_.resize(ndof_, 0);
+    lambda_inv_.resize(0, 0);
+    lambda_.resize(0, 0);
+    lambda_ws_.resize(0, 0);
+    fstar_.resize(0);
+    fproj_.resize(0);
     return Status();
   }
   
   
-  Status ClassicTaskPostureController::
+  RTStatus ClassicTaskPostureController::
   computeCommand(Model const & model,
 		 Skill & skill,
 		 Vector & gamma)
   {
-    Status st(skill.update(model));
+    RTStatus st(skill.update(model));
     if ( ! st) {
       return st;
     }
     
     Skill::task_table_t const * tasks(skill.getTaskTable());
     if ( ! tasks) {
-      st.ok = false;
-      st.errstr = "null task table";
-      return st;
+      return RTStatus(jspace::STATUS_FAILED, "null task table");
     }
     if (2 != tasks->size()) {
-      st.ok = false;
-      st.errstr = "task table must have exactly 2 entries";
-      return st;
+      return RTStatus(jspace::STATUS_INVALID_DIMENSION, "task table must have exactly 2 entries");
+    }
+    if (model.getNDOF() != ndof_) {
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "number of DOF changed, did you forget to init()?");
     }
     
     Task const * task((*tasks)[0]);
     Task const * posture((*tasks)[1]);
     
-    Matrix ainv;
-    if ( ! model.getInverseMassInertia(ainv)) {
-      st.ok = false;
-      st.errstr = "failed to retrieve inverse mass inertia";
-      return st;
+    if ( ! model.getInverseMassInertia(ainv_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve inverse mass inertia");
     }
-    Vector grav;
-    if ( ! model.getGravity(grav)) {
-      st.ok = false;
-      st.errstr = "failed to retrieve gravity torques";
-      return st;
+    if ( ! model.getGravity(grav_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve gravity torques");
     }
     
-    size_t const ndof(model.getNDOF());
-    
     Matrix const & jac(task->getJacobian());
-    if (jac.cols() != ainv.rows()) {
-      st.ok = false;
-      st.errstr = "invalid Jacobian dimension (did you initialize and update the model?)";
-      return st;
+    if (static_cast<size_t>(jac.cols()) != ndof_) {
+      return RTStatus(jspace::STATUS_INVALID_DIMENSION,
+		      "invalid Jacobian dimension (did you initialize and update the model?)");
+    }
+    if (static_cast<size_t>(posture->getCommand().rows()) != ndof_) {
+      return RTStatus(jspace::STATUS_INVALID_DIMENSION, "posture command must have one entry per DOF");
+    }
+    int const ndim(jac.rows());
+    if (lambda_.rows() != ndim) {
+      // only happens on the first tick, or if the task changes shape
+      ainv_jt_.resize(ndof_, ndim);
+      jbar_.resize(ndof_, ndim);
+      lambda_inv_.resize(ndim, ndim);
+      lambda_.resize(ndim, ndim);
+      lambda_ws_.resize(ndim, ndim);
+      fstar_.resize(ndim);
+      fproj_.resize(ndim);
     }
     
-    pseudoInverse(jac * ainv * jac.transpose(),
-		  task->getSigmaThreshold(),
-		  lambda_,
-		  0);
-    fstar_ = lambda_ * task->getCommand();
-    jbar_ = ainv * jac.transpose() * lambda_;
-    nullspace_ = Matrix::Identity(ndof, ndof) - jac.transpose() * jbar_.transpose();
+    // All products are evaluated lazily into preallocated buffers, so
+    // that no temporaries get created here. If the task tracks which
+    // columns of its Jacobian can be non-zero, only those columns of
+    // A^{-1} get read.
+    SparseJacobian const * sparse(task->getSparseJacobian());
+    if (sparse && (sparse->getNDOF() == ndof_) && (sparse->getCompact().rows() == ndim)) {
+      computeSparseAinvJt(*sparse, ainv_, ainv_jt_);
+      computeSparseLambdaInverse(*sparse, ainv_jt_, lambda_inv_);
+    }
+    else {
+      ainv_jt_ = (ainv_ * jac.transpose()).lazy();
+      lambda_inv_ = (jac * ainv_jt_).lazy();
+    }
+    symmetricPseudoInverse(lambda_inv_, task->getSigmaThreshold(), lambda_, lambda_ws_);
+    fstar_ = (lambda_ * task->getCommand()).lazy();
+    jbar_ = (ainv_jt_ * lambda_).lazy();
+    
+    // Nullspace projection of the posture command v without forming
+    // the projector: N^T v = v - J^T (Jbar^T v). The range-space part
+    // J^T fstar is folded into the same product.
+    Vector const & pcmd(posture->getCommand());
+    fproj_ = (jbar_.transpose() * pcmd).lazy();
+    fproj_ = fstar_ - fproj_;
+    gamma_ = pcmd;
+    gamma_ += (jac.transpose() * fproj_).lazy();
+    gamma_ += grav_;
+    
+    if (debug_nullspace_) {
+      if (static_cast<size_t>(nullspace_.rows()) != ndof_) {
+	nullspace_.resize(ndof_, ndof_);
+      }
+      nullspace_.setIdentity();
+      nullspace_ -= (jac.transpose() * jbar_.transpose()).lazy();
+    }
+    else if (0 != nullspace_.rows()) {
+      nullspace_.resize(0, 0);
+    }
     
-    gamma_ = jac.transpose() * fstar_ + nullspace_ * posture->getCommand() + grav;
     gamma = gamma_;
     
     jpos_ = model.getState().position_;
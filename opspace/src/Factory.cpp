@@ -25,10 +25,74 @@
 #include <opspace/skill_library.hpp>
 #include <opspace/parse_yaml.hpp>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
 
 using jspace::pretty_print;
 
+
+// Layout of the binary snapshot files, all in host byte order:
+//
+//   header:  char[8] magic, uint32 byte order mark, uint32 version,
+//            uint64 key
+//   tasks:   uint32 number of tasks, for each task: string type,
+//            string name, parameters
+//   skills:  uint32 number of skills, for each skill: string type,
+//            string name, parameters, uint32 number of slots, for
+//            each slot: string slot name, uint32 number of instances,
+//            uint32 task table index of each instance
+//
+// where parameters are a uint32 count followed by, for each
+// parameter, string name, uint32 type, and the value: int32, string,
+// double, uint32 rows and double[rows] for vectors, or uint32 rows,
+// uint32 cols and double[rows * cols] (column-major) for matrices. A
+// string is a uint32 length followed by that many chars.
+
+static char const snapshot_magic[8] = { 'o', 'p', 's', 'p', 's', 'n', 'p', '\0' };
+static uint32_t const snapshot_byte_order(0x01020304);
+static uint32_t const snapshot_version(1);
+
+
+template<typename value_type>
+static void write_pod(std::ostream & os, value_type value)
+{
+  os.write(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+
+static void write_string(std::ostream & os, std::string const & value)
+{
+  write_pod<uint32_t>(os, value.size());
+  os.write(value.data(), value.size());
+}
+
+
+template<typename value_type>
+static bool read_pod(std::istream & is, value_type & value)
+{
+  return ! is.read(reinterpret_cast<char *>(&value), sizeof(value)).fail();
+}
+
+
+// Lengths come from the file, so a corrupt one must not make us
+// allocate more than the whole file could possibly hold.
+static bool read_string(std::istream & is, std::string & value, uint64_t max_size)
+{
+  uint32_t len;
+  if (( ! read_pod(is, len)) || (len > max_size)) {
+    return false;
+  }
+  value.resize(len);
+  if (0 == len) {
+    return true;
+  }
+  return ! is.read(&value[0], len).fail();
+}
+
 namespace opspace {
   
 
@@ -106,6 +170,33 @@ namespace opspace {
   }
   
   
+  template<typename shop_t, typename instance_t>
+  static std::string find_type(shop_t const & shop, instance_t const & instance)
+  {
+    init_shops();
+    for (typename shop_t::const_iterator ii(shop.begin()); ii != shop.end(); ++ii) {
+      if (typeid(instance) == ii->second->getTypeInfo()) {
+	return ii->first;
+      }
+    }
+    return "";
+  }
+  
+  
+  std::string Factory::
+  findTaskType(Task const & task)
+  {
+    return find_type(task_shop__, task);
+  }
+  
+  
+  std::string Factory::
+  findSkillType(Skill const & skill)
+  {
+    return find_type(skill_shop__, skill);
+  }
+  
+  
   Status Factory::
   parseString(std::string const & yaml_string)
   {
@@ -179,6 +270,471 @@ namespace opspace {
   }
   
   
+  Status Factory::
+  parseFileCached(std::string const & yaml_filename,
+		  std::string const & snapshot_filename,
+		  bool * rebuilt)
+  {
+    return parseFileCached(yaml_filename, std::vector<std::string>(),
+			   snapshot_filename, rebuilt);
+  }
+  
+  
+  Status Factory::
+  parseFileCached(std::string const & yaml_filename,
+		  std::vector<std::string> const & dependencies,
+		  std::string const & snapshot_filename,
+		  bool * rebuilt)
+  {
+    std::vector<std::string> sources(1, yaml_filename);
+    sources.insert(sources.end(), dependencies.begin(), dependencies.end());
+    uint64_t key;
+    Status st(hashSources(sources, key));
+    if ( ! st) {
+      return st;
+    }
+    
+    st = loadSnapshot(snapshot_filename, key);
+    if (st) {
+      if (rebuilt) {
+	*rebuilt = false;
+      }
+      return st;
+    }
+    if (dbg__) {
+      *dbg__ << "Factory::parseFileCached(): rebuilding `" << snapshot_filename
+	     << "' because " << st.errstr << "\n";
+    }
+    
+    if (rebuilt) {
+      *rebuilt = true;
+    }
+    st = parseFile(yaml_filename);
+    if ( ! st) {
+      return st;
+    }
+    
+    Status const save(saveSnapshot(snapshot_filename, key));
+    if (( ! save) && dbg__) {
+      *dbg__ << "Factory::parseFileCached(): " << save.errstr << "\n";
+    }
+    return st;
+  }
+  
+  
+  static void write_parameters(std::ostream & os, ParameterReflection const & reflection)
+  {
+    std::vector<Parameter const *> params;
+    for (size_t ii(0); ii < reflection.getNParameters(); ++ii) {
+      Parameter const * param(reflection.getParameter(ii));
+      if ( ! (param->flags_ & PARAMETER_FLAG_READONLY)) {
+	params.push_back(param);
+      }
+    }
+    
+    write_pod<uint32_t>(os, params.size());
+    for (size_t ii(0); ii < params.size(); ++ii) {
+      Parameter const * param(params[ii]);
+      write_string(os, param->name_);
+      write_pod<uint32_t>(os, param->type_);
+      switch (param->type_) {
+      case PARAMETER_TYPE_STRING:
+	write_string(os, *param->getString());
+	break;
+      case PARAMETER_TYPE_INTEGER:
+	write_pod<int32_t>(os, *param->getInteger());
+	break;
+      case PARAMETER_TYPE_REAL:
+	write_pod<double>(os, *param->getReal());
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	{
+	  Vector const & vv(*param->getVector());
+	  write_pod<uint32_t>(os, vv.rows());
+	  for (int jj(0); jj < vv.rows(); ++jj) {
+	    write_pod<double>(os, vv[jj]);
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	{
+	  Matrix const & mm(*param->getMatrix());
+	  write_pod<uint32_t>(os, mm.rows());
+	  write_pod<uint32_t>(os, mm.cols());
+	  for (int jj(0); jj < mm.cols(); ++jj) {
+	    for (int kk(0); kk < mm.rows(); ++kk) {
+	      write_pod<double>(os, mm.coeff(kk, jj));
+	    }
+	  }
+	}
+	break;
+      default:
+	break;
+      }
+    }
+  }
+  
+  
+  Status Factory::
+  writeSnapshot(std::ostream & os, uint64_t key) const
+  {
+    os.write(snapshot_magic, sizeof(snapshot_magic));
+    write_pod(os, snapshot_byte_order);
+    write_pod(os, snapshot_version);
+    write_pod(os, key);
+    
+    write_pod<uint32_t>(os, task_table_.size());
+    for (size_t ii(0); ii < task_table_.size(); ++ii) {
+      Task const & task(*task_table_[ii]);
+      std::string const type(findTaskType(task));
+      if (type.empty()) {
+	return Status(false, "type of task `" + task.getName() + "' is not registered");
+      }
+      write_string(os, type);
+      write_string(os, task.getName());
+      write_parameters(os, task);
+    }
+    
+    write_pod<uint32_t>(os, skill_table_.size());
+    for (size_t ii(0); ii < skill_table_.size(); ++ii) {
+      Skill const & skill(*skill_table_[ii]);
+      std::string const type(findSkillType(skill));
+      if (type.empty()) {
+	return Status(false, "type of skill `" + skill.getName() + "' is not registered");
+      }
+      write_string(os, type);
+      write_string(os, skill.getName());
+      write_parameters(os, skill);
+      
+      Skill::slot_map_t const & slots(skill.getSlotMap());
+      write_pod<uint32_t>(os, slots.size());
+      for (Skill::slot_map_t::const_iterator is(slots.begin()); is != slots.end(); ++is) {
+	TaskSlotAPI & slot(*is->second);
+	write_string(os, is->first);
+	write_pod<uint32_t>(os, slot.getNInstances());
+	for (size_t jj(0); jj < slot.getNInstances(); ++jj) {
+	  Task const * instance(slot.getInstance(jj).get());
+	  size_t index(0);
+	  while ((index < task_table_.size()) && (task_table_[index].get() != instance)) {
+	    ++index;
+	  }
+	  if (index == task_table_.size()) {
+	    return Status(false, "skill `" + skill.getName() + "' slot `" + is->first
+			  + "' contains a task which is not in the table");
+	  }
+	  write_pod<uint32_t>(os, index);
+	}
+      }
+    }
+    
+    return Status();
+  }
+  
+  
+  Status Factory::
+  saveSnapshot(std::string const & filename, uint64_t key) const
+  {
+    // Write to a temporary file next to the snapshot and rename() it
+    // into place, so that readers never see a partially written
+    // snapshot, and a failed write leaves the previous one intact.
+    std::ostringstream tmpname;
+    tmpname << filename << ".tmp." << getpid();
+    std::string const tmpfile(tmpname.str());
+    
+    std::ofstream os(tmpfile.c_str(), std::ios::binary | std::ios::trunc);
+    if ( ! os) {
+      return Status(false, "could not open file `" + tmpfile + "' for writing");
+    }
+    Status st(writeSnapshot(os, key));
+    os.close();
+    if (st && ( ! os)) {
+      st = Status(false, "write error on `" + tmpfile + "'");
+    }
+    if (st && (0 != rename(tmpfile.c_str(), filename.c_str()))) {
+      st = Status(false, "could not rename `" + tmpfile + "' to `" + filename
+		  + "': " + strerror(errno));
+    }
+    if ( ! st) {
+      unlink(tmpfile.c_str());
+    }
+    return st;
+  }
+  
+  
+  static void read_parameters(std::istream & is,
+			      uint64_t max_size,
+			      std::string const & com_type,
+			      ParameterReflection & reflection)
+  {
+    uint32_t nparams;
+    if ( ! read_pod(is, nparams)) {
+      throw std::runtime_error("truncated parameter count of " + com_type
+			       + " `" + reflection.getName() + "'");
+    }
+    for (uint32_t ii(0); ii < nparams; ++ii) {
+      std::string name;
+      uint32_t type;
+      if (( ! read_string(is, name, max_size)) || ( ! read_pod(is, type))) {
+	throw std::runtime_error("truncated parameter of " + com_type
+				 + " `" + reflection.getName() + "'");
+      }
+      Parameter * param(reflection.lookupParameter(name, static_cast<parameter_type_t>(type)));
+      if ( ! param) {
+	throw std::runtime_error(com_type + " `" + reflection.getName()
+				 + "' has no parameter `" + name + "' of matching type");
+      }
+      
+      // Only call set() where the value differs from the default, so
+      // that parameters which reject their own default (e.g. error
+      // signals which are read-only by way of check()) are left alone.
+      bool ok(true);
+      Status st;
+      switch (param->type_) {
+      case PARAMETER_TYPE_STRING:
+	{
+	  std::string value;
+	  ok = read_string(is, value, max_size);
+	  if (ok && (value != *param->getString())) {
+	    st = param->set(value);
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_INTEGER:
+	{
+	  int32_t value;
+	  ok = read_pod(is, value);
+	  if (ok && (value != *param->getInteger())) {
+	    st = param->set(static_cast<int>(value));
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_REAL:
+	{
+	  double value;
+	  ok = read_pod(is, value);
+	  if (ok && (value != *param->getReal())) {
+	    st = param->set(value);
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	{
+	  uint32_t rows;
+	  ok = read_pod(is, rows) && (static_cast<uint64_t>(rows) * sizeof(double) <= max_size);
+	  Vector value(ok ? rows : 0);
+	  for (uint32_t jj(0); ok && (jj < rows); ++jj) {
+	    ok = read_pod(is, value[jj]);
+	  }
+	  Vector const & current(*param->getVector());
+	  if (ok && ((current.rows() != value.rows()) || (current != value))) {
+	    st = param->set(value);
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	{
+	  uint32_t rows, cols;
+	  ok = read_pod(is, rows) && read_pod(is, cols)
+	    && (static_cast<uint64_t>(rows) * cols <= max_size / sizeof(double));
+	  Matrix value(ok ? rows : 0, ok ? cols : 0);
+	  for (uint32_t jj(0); ok && (jj < cols); ++jj) {
+	    for (uint32_t kk(0); ok && (kk < rows); ++kk) {
+	      ok = read_pod(is, value.coeffRef(kk, jj));
+	    }
+	  }
+	  Matrix const & current(*param->getMatrix());
+	  if (ok && ((current.rows() != value.rows()) || (current.cols() != value.cols())
+		     || (current != value))) {
+	    st = param->set(value);
+	  }
+	}
+	break;
+      default:
+	throw std::runtime_error("parameter `" + name + "' of " + com_type
+				 + " `" + reflection.getName() + "' has invalid type");
+      }
+      if ( ! ok) {
+	throw std::runtime_error("truncated value of parameter `" + name + "' of "
+				 + com_type + " `" + reflection.getName() + "'");
+      }
+      if ( ! st) {
+	throw std::runtime_error("setting parameter `" + name + "' of " + com_type
+				 + " `" + reflection.getName() + "' failed: " + st.errstr);
+      }
+    }
+  }
+  
+  
+  Status Factory::
+  loadSnapshot(std::string const & filename, uint64_t key)
+  {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if ( ! is) {
+      return Status(false, "could not open file `" + filename + "' for reading");
+    }
+    
+    char magic[sizeof(snapshot_magic)];
+    uint32_t byte_order, version;
+    uint64_t file_key;
+    if (( ! is.read(magic, sizeof(magic)))
+	|| (0 != memcmp(magic, snapshot_magic, sizeof(magic)))
+	|| ( ! read_pod(is, byte_order))
+	|| ( ! read_pod(is, version))
+	|| ( ! read_pod(is, file_key))) {
+      return Status(false, "`" + filename + "' is not a factory snapshot");
+    }
+    if (snapshot_byte_order != byte_order) {
+      return Status(false, "`" + filename + "' was written with a different byte order");
+    }
+    if (snapshot_version != version) {
+      return Status(false, "`" + filename + "' has an unsupported version");
+    }
+    if (key != file_key) {
+      return Status(false, "`" + filename + "' is stale (key mismatch)");
+    }
+    
+    std::streampos const start(is.tellg());
+    is.seekg(0, std::ios::end);
+    std::streampos const end(is.tellg());
+    is.seekg(start);
+    if (( ! is) || (end < start)) {
+      return Status(false, "could not determine the size of `" + filename + "'");
+    }
+    uint64_t const max_size(end - start);
+    
+    task_table_t task_table;
+    skill_table_t skill_table;
+    
+    try {
+      uint32_t ntasks;
+      if ( ! read_pod(is, ntasks)) {
+	throw std::runtime_error("truncated task count");
+      }
+      for (uint32_t ii(0); ii < ntasks; ++ii) {
+	std::string type, name;
+	if (( ! read_string(is, type, max_size)) || ( ! read_string(is, name, max_size))) {
+	  throw std::runtime_error("truncated task entry");
+	}
+	Task * task(createTask(type, name));
+	if ( ! task) {
+	  throw std::runtime_error("createTask(`" + type + "', `" + name + "') failed");
+	}
+	task_table.push_back(boost::shared_ptr<Task>(task));
+	read_parameters(is, max_size, "task", *task);
+      }
+      
+      uint32_t nskills;
+      if ( ! read_pod(is, nskills)) {
+	throw std::runtime_error("truncated skill count");
+      }
+      for (uint32_t ii(0); ii < nskills; ++ii) {
+	std::string type, name;
+	if (( ! read_string(is, type, max_size)) || ( ! read_string(is, name, max_size))) {
+	  throw std::runtime_error("truncated skill entry");
+	}
+	Skill * skill(createSkill(type, name));
+	if ( ! skill) {
+	  throw std::runtime_error("createSkill(`" + type + "', `" + name + "') failed");
+	}
+	skill_table.push_back(boost::shared_ptr<Skill>(skill));
+	read_parameters(is, max_size, "skill", *skill);
+	
+	uint32_t nslots;
+	if ( ! read_pod(is, nslots)) {
+	  throw std::runtime_error("truncated slot count of skill `" + name + "'");
+	}
+	for (uint32_t jj(0); jj < nslots; ++jj) {
+	  std::string slot_name;
+	  uint32_t ninstances;
+	  if (( ! read_string(is, slot_name, max_size)) || ( ! read_pod(is, ninstances))) {
+	    throw std::runtime_error("truncated slot of skill `" + name + "'");
+	  }
+	  boost::shared_ptr<TaskSlotAPI> slot(skill->lookupSlot(slot_name));
+	  if ( ! slot) {
+	    throw std::runtime_error("skill `" + name + "' has no slot `" + slot_name + "'");
+	  }
+	  for (uint32_t kk(0); kk < ninstances; ++kk) {
+	    uint32_t index;
+	    if ( ! read_pod(is, index)) {
+	      throw std::runtime_error("truncated slot `" + slot_name + "' of skill `" + name + "'");
+	    }
+	    if (index >= task_table.size()) {
+	      throw std::runtime_error("invalid task index in slot `" + slot_name
+				       + "' of skill `" + name + "'");
+	    }
+	    Status const st(slot->assign(task_table[index]));
+	    if ( ! st) {
+	      throw std::runtime_error("assigning task instance `" + task_table[index]->getName()
+				       + "' to skill `" + name + "' slot `" + slot_name
+				       + "': " + st.errstr);
+	    }
+	  }
+	}
+      }
+    }
+    catch (std::exception const & ee) {
+      // Also catches std::bad_alloc, so that the caller can fall back
+      // on parsing the YAML.
+      if (dbg__) {
+	*dbg__ << "Factory::loadSnapshot(): " << ee.what() << "\n";
+      }
+      return Status(false, "`" + filename + "': " + ee.what());
+    }
+    
+    task_table_.insert(task_table_.end(), task_table.begin(), task_table.end());
+    skill_table_.insert(skill_table_.end(), skill_table.begin(), skill_table.end());
+    return Status();
+  }
+  
+  
+  static void fnv_update(uint64_t & hash, void const * data, size_t nbytes)
+  {
+    for (size_t ii(0); ii < nbytes; ++ii) {
+      hash ^= reinterpret_cast<unsigned char const *>(data)[ii];
+      hash *= 1099511628211ULL;
+    }
+  }
+  
+  
+  Status Factory::
+  hashSource(std::string const & filename, uint64_t & hash)
+  {
+    return hashSources(std::vector<std::string>(1, filename), hash);
+  }
+  
+  
+  Status Factory::
+  hashSources(std::vector<std::string> const & filenames, uint64_t & hash)
+  {
+    // 64-bit FNV-1a, seeded with the snapshot version so that a
+    // format change invalidates existing snapshots as well.
+    hash = 14695981039346656037ULL;
+    fnv_update(hash, &snapshot_version, sizeof(snapshot_version));
+    
+    char buf[4096];
+    for (size_t ifile(0); ifile < filenames.size(); ++ifile) {
+      std::ifstream is(filenames[ifile].c_str(), std::ios::binary);
+      if ( ! is) {
+	return Status(false, "could not open file `" + filenames[ifile] + "' for reading");
+      }
+      uint64_t nbytes(0);
+      while (is) {
+	is.read(buf, sizeof(buf));
+	std::streamsize const nread(is.gcount());
+	fnv_update(hash, buf, nread);
+	nbytes += nread;
+      }
+      if ( ! is.eof()) {
+	return Status(false, "read error on `" + filenames[ifile] + "'");
+      }
+      // The length separates the files, so that moving bytes from
+      // one file to the next changes the key.
+      fnv_update(hash, &nbytes, sizeof(nbytes));
+    }
+    return Status();
+  }
+  
+  
   Factory::task_table_t const & Factory::
   getTaskTable() const
   {
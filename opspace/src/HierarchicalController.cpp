@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/HierarchicalController.hpp>
+#include <opspace/pseudo_inverse.hpp>
+#include <opspace/SparseJacobian.hpp>
+#include <sstream>
+
+using jspace::pretty_print;
+
+namespace opspace {
+  
+  
+  HierarchicalController::
+  HierarchicalController(std::string const & name)
+    : Controller(name),
+      ndof_(0)
+  {
+    declareParameter("jpos", &jpos_);
+    declareParameter("jvel", &jvel_);
+    declareParameter("gamma", &gamma_);
+  }
+  
+  
+  Status HierarchicalController::
+  init(Model const & model)
+  {
+    ndof_ = model.getNDOF();
+    ainv_ = Matrix::Zero(ndof_, ndof_);
+    grav_ = Vector::Zero(ndof_);
+    nstar_ = Matrix::Identity(ndof_, ndof_);
+    ainv_gamma_ = Vector::Zero(ndof_);
+    gamma_ = Vector::Zero(ndof_);
+    jpos_ = Vector::Zero(ndof_);
+    jvel_ = Vector::Zero(ndof_);
+    return Status();
+  }
+  
+  
+  RTStatus HierarchicalController::
+  computeCommand(Model const & model,
+		 Skill & skill,
+		 Vector & gamma)
+  {
+    RTStatus st(skill.update(model));
+    if ( ! st) {
+      return st;
+    }
+    
+    Skill::task_table_t const * tasks(skill.getTaskTable());
+    if ( ! tasks) {
+      return RTStatus(jspace::STATUS_FAILED, "null task table");
+    }
+    if (tasks->empty()) {
+      return RTStatus(jspace::STATUS_FAILED, "empty task table");
+    }
+    if (model.getNDOF() != ndof_) {
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "number of DOF changed, did you forget to init()?");
+    }
+    
+    if ( ! model.getInverseMassInertia(ainv_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve inverse mass inertia");
+    }
+    if ( ! model.getGravity(grav_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve gravity torques");
+    }
+    
+    if (level_.size() < tasks->size()) {
+      level_.resize(tasks->size());
+    }
+    
+    nstar_.setIdentity();
+    gamma_.setZero();
+    bool first(true);
+    
+    for (size_t ii(0); ii < tasks->size(); ++ii) {
+      Task const * task((*tasks)[ii]);
+      Matrix const & jac(task->getJacobian());
+      if (0 == jac.rows()) {
+	continue;
+      }
+      if (static_cast<size_t>(jac.cols()) != ndof_) {
+	return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION, "invalid Jacobian dimension",
+			      "task `%s' (did you initialize and update the model?)",
+			      task->getName().c_str());
+      }
+      if (task->getCommand().rows() != jac.rows()) {
+	return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION,
+			      "command and Jacobian have different dimensions",
+			      "task `%s'", task->getName().c_str());
+      }
+      
+      level_s & lv(level_[ii]);
+      if (first) {
+	lv.jstar = jac;
+      }
+      else {
+	lv.jstar = (jac * nstar_).lazy();
+      }
+      
+      // The top level uses the plain task Jacobian, so its inertia
+      // can be computed from the supporting columns of A^{-1}
+      // only. Lower levels are projected into the nullspace, which
+      // fills in the other columns.
+      SparseJacobian const * sparse(first ? task->getSparseJacobian() : 0);
+      if (sparse && (sparse->getNDOF() == ndof_) && (sparse->getCompact().rows() == jac.rows())) {
+	computeSparseAinvJt(*sparse, ainv_, lv.ainv_jstar_t);
+	computeSparseLambdaInverse(*sparse, lv.ainv_jstar_t, lv.lambda_inv);
+      }
+      else {
+	lv.ainv_jstar_t = (ainv_ * lv.jstar.transpose()).lazy();
+	lv.lambda_inv = (lv.jstar * lv.ainv_jstar_t).lazy();
+      }
+      symmetricPseudoInverse(lv.lambda_inv, task->getSigmaThreshold(), lv.lambda, &lv.sv);
+      st = skill.checkJStarSV(task, lv.sv);
+      if ( ! st) {
+	return st;
+      }
+      
+      // compensate for the acceleration caused by the higher-priority
+      // torques, which are exactly zero for the first active level
+      lv.xddot = task->getCommand();
+      if ( ! first) {
+	ainv_gamma_ = (ainv_ * gamma_).lazy();
+	lv.xddot -= (jac * ainv_gamma_).lazy();
+      }
+      lv.fstar = (lv.lambda * lv.xddot).lazy();
+      gamma_ += (lv.jstar.transpose() * lv.fstar).lazy();
+      
+      lv.jbar = (lv.ainv_jstar_t * lv.lambda).lazy();
+      nstar_ -= (lv.jbar * lv.jstar).lazy();
+      first = false;
+    }
+    
+    if (first) {
+      return RTStatus(jspace::STATUS_FAILED, "all tasks have empty Jacobians");
+    }
+    
+    gamma_ += grav_;
+    gamma = gamma_;
+    
+    jpos_ = model.getState().position_;
+    jvel_ = model.getState().velocity_;
+    
+    return st;
+  }
+  
+  
+  void HierarchicalController::
+  dbg(std::ostream & os,
+      std::string const & title,
+      std::string const & prefix) const
+  {
+    if ( ! title.empty()) {
+      os << title << "\n";
+    }
+    pretty_print(jpos_, os, prefix + "jpos", prefix + "  ");
+    pretty_print(jvel_, os, prefix + "jvel", prefix + "  ");
+    pretty_print(gamma_, os, prefix + "gamma", prefix + "  ");
+    for (size_t ii(0); ii < level_.size(); ++ii) {
+      std::ostringstream msg;
+      msg << prefix << "level[" << ii << "] ";
+      pretty_print(level_[ii].sv, os, msg.str() + "sv", prefix + "  ");
+      pretty_print(level_[ii].fstar, os, msg.str() + "fstar", prefix + "  ");
+    }
+  }
+  
+}
@@ -400,6 +400,18 @@ namespace opspace {
   }
   
   
+  int ParameterReflection::
+  getParameterHandle(std::string const & name) const
+  {
+    for (size_t ii(0); ii < parameter_handle_.size(); ++ii) {
+      if (name == parameter_handle_[ii]->name_) {
+	return ii;
+      }
+    }
+    return -1;
+  }
+  
+  
   Status ParameterReflection::
   check(int const * param, int value) const
   {
@@ -456,7 +468,9 @@ namespace opspace {
   declareParameter(std::string const & name, int * integer, parameter_flags_t flags)
   {
     IntegerParameter * entry(new IntegerParameter(name, flags, this, integer));
-    parameter_lookup_.insert(std::make_pair(name, entry));
+    if (parameter_lookup_.insert(std::make_pair(name, entry)).second) {
+      parameter_handle_.push_back(entry);
+    }
     return entry;
   }
     
@@ -465,7 +479,9 @@ namespace opspace {
   declareParameter(std::string const & name, std::string * instance, parameter_flags_t flags)
   {
     StringParameter * entry(new StringParameter(name, flags, this, instance));
-    parameter_lookup_.insert(std::make_pair(name, entry));
+    if (parameter_lookup_.insert(std::make_pair(name, entry)).second) {
+      parameter_handle_.push_back(entry);
+    }
     return entry;
   }
   
@@ -474,7 +490,9 @@ namespace opspace {
   declareParameter(std::string const & name, double * real, parameter_flags_t flags)
   {
     RealParameter * entry(new RealParameter(name, flags, this, real));
-    parameter_lookup_.insert(std::make_pair(name, entry));
+    if (parameter_lookup_.insert(std::make_pair(name, entry)).second) {
+      parameter_handle_.push_back(entry);
+    }
     return entry;
   }
   
@@ -483,7 +501,9 @@ namespace opspace {
   declareParameter(std::string const & name, Vector * vector, parameter_flags_t flags)
   {
     VectorParameter * entry(new VectorParameter(name, flags, this, vector));
-    parameter_lookup_.insert(std::make_pair(name, entry));
+    if (parameter_lookup_.insert(std::make_pair(name, entry)).second) {
+      parameter_handle_.push_back(entry);
+    }
     return entry;
   }
   
@@ -492,7 +512,9 @@ namespace opspace {
   declareParameter(std::string const & name, Matrix * matrix, parameter_flags_t flags)
   {
     MatrixParameter * entry(new MatrixParameter(name, flags, this, matrix));
-    parameter_lookup_.insert(std::make_pair(name, entry));
+    if (parameter_lookup_.insert(std::make_pair(name, entry)).second) {
+      parameter_handle_.push_back(entry);
+    }
     return entry;
   }
   
@@ -538,28 +560,128 @@ namespace opspace {
   }
   
   
-  void ParameterLog::
-  update(long long timestamp_)
+  template<typename parameter_t, typename storage_t>
+  static ParameterLog::log_s<parameter_t, storage_t> *
+  find_log(std::vector<ParameterLog::log_s<parameter_t, storage_t> > & collection,
+	   std::string const & parameter_name)
   {
-    timestamp.push_back(timestamp_);
-    for (size_t ii(0); ii < intlog.size(); ++ii) {
-      intlog[ii].log.push_back(*intlog[ii].parameter->getInteger());
+    for (size_t ii(0); ii < collection.size(); ++ii) {
+      if (parameter_name == collection[ii].parameter->name_) {
+	return &collection[ii];
+      }
     }
-    for (size_t ii(0); ii < strlog.size(); ++ii) {
-      strlog[ii].log.push_back(*strlog[ii].parameter->getString());
+    return 0;
+  }
+  
+  
+  Status ParameterLog::
+  setDecimation(std::string const & parameter_name, size_t decimation)
+  {
+    if (0 == decimation) {
+      return Status(false, "decimation must be > 0");
+    }
+    if (log_s<IntegerParameter, int> * ll = find_log(intlog, parameter_name)) {
+      ll->decimation = decimation;
+    }
+    else if (log_s<StringParameter, std::string> * ll = find_log(strlog, parameter_name)) {
+      ll->decimation = decimation;
+    }
+    else if (log_s<RealParameter, double> * ll = find_log(reallog, parameter_name)) {
+      ll->decimation = decimation;
+    }
+    else if (log_s<VectorParameter, Vector> * ll = find_log(veclog, parameter_name)) {
+      ll->decimation = decimation;
     }
-    for (size_t ii(0); ii < reallog.size(); ++ii) {
-      reallog[ii].log.push_back(*reallog[ii].parameter->getReal());
+    else if (log_s<MatrixParameter, Matrix> * ll = find_log(mxlog, parameter_name)) {
+      ll->decimation = decimation;
     }
-    for (size_t ii(0); ii < veclog.size(); ++ii) {
-      veclog[ii].log.push_back(*veclog[ii].parameter->getVector());
+    else {
+      return Status(false, "no parameter `" + parameter_name + "' in log " + name);
+    }
+    return Status();
+  }
+  
+  
+  Status ParameterLog::
+  setChangeOnly(std::string const & parameter_name, bool change_only)
+  {
+    if (log_s<IntegerParameter, int> * ll = find_log(intlog, parameter_name)) {
+      ll->change_only = change_only;
     }
-    for (size_t ii(0); ii < mxlog.size(); ++ii) {
-      mxlog[ii].log.push_back(*mxlog[ii].parameter->getMatrix());
+    else if (log_s<StringParameter, std::string> * ll = find_log(strlog, parameter_name)) {
+      ll->change_only = change_only;
+    }
+    else if (log_s<RealParameter, double> * ll = find_log(reallog, parameter_name)) {
+      ll->change_only = change_only;
+    }
+    else if (log_s<VectorParameter, Vector> * ll = find_log(veclog, parameter_name)) {
+      ll->change_only = change_only;
+    }
+    else if (log_s<MatrixParameter, Matrix> * ll = find_log(mxlog, parameter_name)) {
+      ll->change_only = change_only;
+    }
+    else {
+      return Status(false, "no parameter `" + parameter_name + "' in log " + name);
+    }
+    return Status();
+  }
+  
+  
+  static int const & current_value(IntegerParameter const * pp) { return *pp->getInteger(); }
+  static std::string const & current_value(StringParameter const * pp) { return *pp->getString(); }
+  static double const & current_value(RealParameter const * pp) { return *pp->getReal(); }
+  static Vector const & current_value(VectorParameter const * pp) { return *pp->getVector(); }
+  static Matrix const & current_value(MatrixParameter const * pp) { return *pp->getMatrix(); }
+  
+  template<typename value_t>
+  static bool same_value(value_t const & lhs, value_t const & rhs)
+  {
+    return lhs == rhs;
+  }
+  
+  static bool same_value(Vector const & lhs, Vector const & rhs)
+  {
+    return (lhs.rows() == rhs.rows()) && (lhs == rhs);
+  }
+  
+  static bool same_value(Matrix const & lhs, Matrix const & rhs)
+  {
+    return (lhs.rows() == rhs.rows()) && (lhs.cols() == rhs.cols()) && (lhs == rhs);
+  }
+  
+  
+  template<typename parameter_t, typename storage_t>
+  static void record(std::vector<ParameterLog::log_s<parameter_t, storage_t> > & collection,
+		     size_t tick, long long timestamp)
+  {
+    for (size_t ii(0); ii < collection.size(); ++ii) {
+      ParameterLog::log_s<parameter_t, storage_t> & log(collection[ii]);
+      if (0 != tick % log.decimation) {
+	continue;
+      }
+      storage_t const & value(current_value(log.parameter));
+      if (log.change_only && ( ! log.log.empty()) && same_value(log.log.back(), value)) {
+	continue;
+      }
+      log.timestamp.push_back(timestamp);
+      log.log.push_back(value);
     }
   }
   
   
+  void ParameterLog::
+  update(long long timestamp_)
+  {
+    size_t const tick(timestamp.size());
+    timestamp.push_back(timestamp_);
+    record(intlog, tick, timestamp_);
+    record(strlog, tick, timestamp_);
+    record(reallog, tick, timestamp_);
+    record(veclog, tick, timestamp_);
+    record(mxlog, tick, timestamp_);
+  }
+  
+  
   void ParameterLog::
   writeFiles(std::string const & prefix, std::ostream * progress) const
   {
@@ -586,7 +708,7 @@ namespace opspace {
 	       << "# type: integer\n"
 	       << "# size: " << nn << "\n";
 	    for (size_t jj(0); jj < nn; ++jj) {
-	      os << timestamp[jj] << "   " << log.log[jj] << "\n";
+	      os << log.timestamp[jj] << "   " << log.log[jj] << "\n";
 	    }
 	  }
 	}
@@ -615,7 +737,7 @@ namespace opspace {
 	       << "# type: string\n"
 	       << "# size: " << nn << "\n";
 	    for (size_t jj(0); jj < nn; ++jj) {
-	      os << timestamp[jj] << "   " << log.log[jj] << "\n";
+	      os << log.timestamp[jj] << "   " << log.log[jj] << "\n";
 	    }
 	  }
 	}
@@ -644,7 +766,7 @@ namespace opspace {
 	       << "# type: real\n"
 	       << "# size: " << nn << "\n";
 	    for (size_t jj(0); jj < nn; ++jj) {
-	      os << timestamp[jj] << "   " << log.log[jj] << "\n";
+	      os << log.timestamp[jj] << "   " << log.log[jj] << "\n";
 	    }
 	  }
 	}
@@ -673,7 +795,7 @@ namespace opspace {
 	       << "# type: vector\n"
 	       << "# size: " << nn << "\n";
 	    for (size_t jj(0); jj < nn; ++jj) {
-	      os << timestamp[jj] << "   ";
+	      os << log.timestamp[jj] << "   ";
 	      jspace::pretty_print(log.log[jj], os, "", "");
 	    }
 	  }
@@ -705,7 +827,7 @@ namespace opspace {
 	       << "# line format: tstamp nrows ncols row_0 row_1 ...\n";
 	    for (size_t jj(0); jj < nn; ++jj) {
 	      Matrix const & mx(log.log[jj]);
-	      os << timestamp[jj] << "   " << mx.rows() << "  " << mx.cols();
+	      os << log.timestamp[jj] << "   " << mx.rows() << "  " << mx.cols();
 	      for (int kk(0); kk < mx.rows(); ++kk) {
 		os << "   ";
 		for (int ll(0); ll < mx.cols(); ++ll) {
@@ -769,6 +891,44 @@ namespace opspace {
   }
   
   
+  /**
+     \return The index of parameter in compiled, appending it if it is
+     not already there, or -1 if parameter is null.
+  */
+  static int compile(std::vector<Parameter *> & compiled, Parameter * parameter)
+  {
+    if ( ! parameter) {
+      return -1;
+    }
+    for (size_t ii(0); ii < compiled.size(); ++ii) {
+      if (parameter == compiled[ii]) {
+	return ii;
+      }
+    }
+    compiled.push_back(parameter);
+    return compiled.size() - 1;
+  }
+  
+  
+  int ReflectionRegistry::
+  compileParameter(std::string const & type_name,
+		   std::string const & instance_name,
+		   std::string const & parameter_name)
+  {
+    return compile(compiled_, lookupParameter(type_name, instance_name, parameter_name));
+  }
+  
+  
+  int ReflectionRegistry::
+  compileParameter(std::string const & type_name,
+		   std::string const & instance_name,
+		   std::string const & parameter_name,
+		   parameter_type_t parameter_type)
+  {
+    return compile(compiled_, lookupParameter(type_name, instance_name, parameter_name, parameter_type));
+  }
+  
+  
   Parameter * ReflectionRegistry::
   lookupParameter(std::string const & type_name,
 		  std::string const & instance_name,
@@ -824,4 +984,179 @@ namespace opspace {
     return ref->lookupParameter(parameter_name, parameter_type);
   }
 
+  
+  
+  ParameterStage::
+  ParameterStage(size_t capacity)
+    : ring_(capacity + 1),
+      staged_(0),
+      committed_(0),
+      applied_(0),
+      napplied_(0),
+      nrejected_(0)
+  {
+    for (size_t ii(0); ii < ring_.size(); ++ii) {
+      ring_[ii].parameter = 0;
+    }
+  }
+  
+  
+  ParameterStage::entry_s * ParameterStage::
+  prepareEntry(Parameter * parameter, parameter_type_t type, Status & st)
+  {
+    if ( ! parameter) {
+      st.ok = false;
+      st.errstr = "null parameter";
+      return 0;
+    }
+    if (type != parameter->type_) {
+      st.ok = false;
+      st.errstr = "type mismatch";
+      return 0;
+    }
+    if (parameter->flags_ & PARAMETER_FLAG_READONLY) {
+      st.ok = false;
+      st.errstr = "read-only parameter";
+      return 0;
+    }
+    if ((staged_ + 1) % ring_.size() == applied_) {
+      st.ok = false;
+      st.errstr = "staging queue full";
+      return 0;
+    }
+    entry_s * entry(&ring_[staged_]);
+    entry->parameter = parameter;
+    staged_ = (staged_ + 1) % ring_.size();
+    return entry;
+  }
+  
+  
+  Status ParameterStage::
+  stage(Parameter * parameter, int value)
+  {
+    Status st;
+    entry_s * entry(prepareEntry(parameter, PARAMETER_TYPE_INTEGER, st));
+    if (entry) {
+      entry->integer = value;
+    }
+    return st;
+  }
+  
+  
+  Status ParameterStage::
+  stage(Parameter * parameter, std::string const & value)
+  {
+    Status st;
+    entry_s * entry(prepareEntry(parameter, PARAMETER_TYPE_STRING, st));
+    if (entry) {
+      entry->string = value;
+    }
+    return st;
+  }
+  
+  
+  Status ParameterStage::
+  stage(Parameter * parameter, double value)
+  {
+    Status st;
+    entry_s * entry(prepareEntry(parameter, PARAMETER_TYPE_REAL, st));
+    if (entry) {
+      entry->real = value;
+    }
+    return st;
+  }
+  
+  
+  Status ParameterStage::
+  stage(Parameter * parameter, Vector const & value)
+  {
+    Status st;
+    entry_s * entry(prepareEntry(parameter, PARAMETER_TYPE_VECTOR, st));
+    if (entry) {
+      entry->vector = value;
+    }
+    return st;
+  }
+  
+  
+  Status ParameterStage::
+  stage(Parameter * parameter, Matrix const & value)
+  {
+    Status st;
+    entry_s * entry(prepareEntry(parameter, PARAMETER_TYPE_MATRIX, st));
+    if (entry) {
+      entry->matrix = value;
+    }
+    return st;
+  }
+  
+  
+  void ParameterStage::
+  commit()
+  {
+    // The staged values have to be visible before the new end of the
+    // batch is.
+    __sync_synchronize();
+    committed_ = staged_;
+  }
+  
+  
+  void ParameterStage::
+  discard()
+  {
+    staged_ = committed_;
+  }
+  
+  
+  Status ParameterStage::
+  apply()
+  {
+    Status result;
+    size_t const end(committed_);
+    if (end == applied_) {
+      return result;
+    }
+    __sync_synchronize();
+    
+    for (size_t ii(applied_); ii != end; ii = (ii + 1) % ring_.size()) {
+      entry_s const & entry(ring_[ii]);
+      Status st;
+      switch (entry.parameter->type_) {
+      case PARAMETER_TYPE_INTEGER:
+	st = entry.parameter->set(entry.integer);
+	break;
+      case PARAMETER_TYPE_STRING:
+	st = entry.parameter->set(entry.string);
+	break;
+      case PARAMETER_TYPE_REAL:
+	st = entry.parameter->set(entry.real);
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	st = entry.parameter->set(entry.vector);
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	st = entry.parameter->set(entry.matrix);
+	break;
+      default:
+	st = Status(false, "invalid parameter type");
+      }
+      if (st) {
+	++napplied_;
+      }
+      else {
+	++nrejected_;
+	if (result) {
+	  result.ok = false;
+	  result.errstr = entry.parameter->name_ + ": " + st.errstr;
+	}
+      }
+    }
+    
+    // Only hand the slots back to the tuning thread once we are done
+    // reading them.
+    __sync_synchronize();
+    applied_ = end;
+    return result;
+  }
+  
 }
@@ -0,0 +1,705 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/ParameterRingLog.hpp>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// Layout of the binary log files, all in host byte order:
+//
+//   header:  char[8] magic, uint32 byte order mark, uint32 version,
+//            string log name, uint32 number of columns,
+//            for each column: uint32 type, uint32 rows, uint32 cols,
+//            string parameter name
+//   chunks:  uint32 number of records N, int64 timestamps[N],
+//            for each column: its N rows back to back, as int32,
+//            double, or char[string_width] depending on the type
+//
+// where a string is a uint32 length followed by that many chars.
+
+static char const log_magic[8] = { 'o', 'p', 's', 'p', 'l', 'o', 'g', '\0' };
+static uint32_t const log_byte_order(0x01020304);
+static uint32_t const log_version(1);
+
+
+static bool write_u32(FILE * ff, uint32_t value)
+{
+  return 1 == fwrite(&value, sizeof(value), 1, ff);
+}
+
+
+static bool write_string(FILE * ff, std::string const & value)
+{
+  if ( ! write_u32(ff, value.size())) {
+    return false;
+  }
+  return value.size() == fwrite(value.data(), 1, value.size(), ff);
+}
+
+
+static bool read_u32(FILE * ff, uint32_t & value)
+{
+  return 1 == fread(&value, sizeof(value), 1, ff);
+}
+
+
+static bool read_string(FILE * ff, std::string & value)
+{
+  uint32_t len;
+  if ( ! read_u32(ff, len)) {
+    return false;
+  }
+  value.resize(len);
+  if (0 == len) {
+    return true;
+  }
+  return len == fread(&value[0], 1, len, ff);
+}
+
+
+namespace opspace {
+
+
+  ParameterRingLog::
+  ParameterRingLog(std::string const & name,
+		   parameter_lookup_t const & parameter_lookup,
+		   size_t capacity)
+    : name_(name),
+      capacity_(1),
+      head_(0),
+      tail_(0),
+      ndropped_(0),
+      nmismatched_(0),
+      decimation_(1),
+      ntick_(0),
+      file_(0),
+      period_usec_(10000),
+      running_(false),
+      quit_(0),
+      error_(0),
+      blackbox_(false),
+      trigger_(0),
+      frozen_(0),
+      dumped_(0)
+  {
+    while (capacity_ < capacity) {
+      capacity_ <<= 1;
+    }
+    timestamp_.resize(capacity_);
+
+    for (parameter_lookup_t::const_iterator ii(parameter_lookup.begin());
+	 ii != parameter_lookup.end(); ++ii) {
+      Parameter const * pp(ii->second);
+      if (pp->flags_ & PARAMETER_FLAG_NOLOG) {
+	continue;
+      }
+      column_s cc;
+      cc.parameter = pp;
+      cc.type = pp->type_;
+      cc.rows = 1;
+      cc.cols = 1;
+      switch (pp->type_) {
+      case PARAMETER_TYPE_INTEGER:
+	cc.width = 1;
+	cc.integer.resize(capacity_);
+	break;
+      case PARAMETER_TYPE_STRING:
+	cc.width = string_width;
+	cc.string.resize(capacity_ * string_width, '\0');
+	break;
+      case PARAMETER_TYPE_REAL:
+	cc.width = 1;
+	cc.real.resize(capacity_);
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	cc.rows = pp->getVector()->rows();
+	cc.width = cc.rows;
+	cc.real.resize(capacity_ * cc.width);
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	cc.rows = pp->getMatrix()->rows();
+	cc.cols = pp->getMatrix()->cols();
+	cc.width = cc.rows * cc.cols;
+	cc.real.resize(capacity_ * cc.width);
+	break;
+      default:
+	continue;
+      }
+      column_.push_back(cc);
+    }
+  }
+
+
+  ParameterRingLog::
+  ~ParameterRingLog()
+  {
+    close();
+  }
+
+
+  Status ParameterRingLog::
+  createFile(std::string const & filename)
+  {
+    file_ = fopen(filename.c_str(), "wb");
+    if ( ! file_) {
+      return Status(false, "failed to open " + filename + ": " + strerror(errno));
+    }
+
+    bool ok(sizeof(log_magic) == fwrite(log_magic, 1, sizeof(log_magic), file_));
+    ok = ok && write_u32(file_, log_byte_order);
+    ok = ok && write_u32(file_, log_version);
+    ok = ok && write_string(file_, name_);
+    ok = ok && write_u32(file_, column_.size());
+    for (size_t ii(0); ok && (ii < column_.size()); ++ii) {
+      ok = ok && write_u32(file_, column_[ii].type);
+      ok = ok && write_u32(file_, column_[ii].rows);
+      ok = ok && write_u32(file_, column_[ii].cols);
+      ok = ok && write_string(file_, column_[ii].parameter->name_);
+    }
+    if ( ! ok) {
+      fclose(file_);
+      file_ = 0;
+      return Status(false, "failed to write header to " + filename);
+    }
+
+    return Status();
+  }
+
+
+  Status ParameterRingLog::
+  startThread(unsigned int period_usec)
+  {
+    period_usec_ = period_usec;
+    quit_ = 0;
+    error_ = 0;
+    if (0 != pthread_create(&thread_, 0, run, this)) {
+      return Status(false, "failed to create flushing thread");
+    }
+    running_ = true;
+    return Status();
+  }
+
+
+  Status ParameterRingLog::
+  open(std::string const & filename, unsigned int period_usec)
+  {
+    if (running_) {
+      return Status(false, "already open");
+    }
+    Status st(createFile(filename));
+    if ( ! st) {
+      return st;
+    }
+    blackbox_ = false;
+    st = startThread(period_usec);
+    if ( ! st) {
+      fclose(file_);
+      file_ = 0;
+    }
+    return st;
+  }
+
+
+  Status ParameterRingLog::
+  openBlackBox(std::string const & filename, unsigned int period_usec)
+  {
+    if (running_) {
+      return Status(false, "already open");
+    }
+    filename_ = filename;
+    trigger_ = 0;
+    frozen_ = 0;
+    dumped_ = 0;
+    blackbox_ = true;
+    Status const st(startThread(period_usec));
+    if ( ! st) {
+      blackbox_ = false;
+    }
+    return st;
+  }
+
+
+  Status ParameterRingLog::
+  close()
+  {
+    if ( ! running_) {
+      return Status();
+    }
+    quit_ = 1;
+    pthread_join(thread_, 0);
+    running_ = false;
+
+    if (blackbox_) {
+      if (frozen_ && ( ! dumped_)) {
+	dumpFrozen();
+      }
+    }
+    else {
+      drain();
+      if (0 != fclose(file_)) {
+	error_ = 1;
+      }
+      file_ = 0;
+    }
+
+    if (error_) {
+      return Status(false, "error writing parameter log " + name_);
+    }
+    return Status();
+  }
+
+
+  void ParameterRingLog::
+  dumpFrozen()
+  {
+    if ( ! createFile(filename_)) {
+      error_ = 1;
+    }
+    else {
+      // Update() is not touching the ring anymore, so we can simply
+      // rewind to the oldest row which has not been overwritten.
+      size_t const head(head_);
+      tail_ = (head > capacity_) ? head - capacity_ : 0;
+      drain();
+      if (0 != fclose(file_)) {
+	error_ = 1;
+      }
+      file_ = 0;
+    }
+    __sync_synchronize();
+    dumped_ = 1;
+  }
+
+
+  void ParameterRingLog::
+  trigger()
+  {
+    trigger_ = 1;
+  }
+
+
+  void ParameterRingLog::
+  triggerOnFailure(Status const & status)
+  {
+    if (blackbox_ && ( ! status) && ( ! frozen_)) {
+      __sync_synchronize();
+      frozen_ = 1;
+    }
+  }
+
+
+  void ParameterRingLog::
+  triggerOnFailure(RTStatus const & status)
+  {
+    if (blackbox_ && ( ! status) && ( ! frozen_)) {
+      __sync_synchronize();
+      frozen_ = 1;
+    }
+  }
+
+
+  Status ParameterRingLog::
+  setDecimation(size_t decimation)
+  {
+    if (0 == decimation) {
+      return Status(false, "decimation must be > 0");
+    }
+    decimation_ = decimation;
+    return Status();
+  }
+
+
+  void ParameterRingLog::
+  flush()
+  {
+    if (blackbox_) {
+      // Nothing gets written before the ring is frozen, and tail_ is
+      // rewound for the dump, so wait for that instead.
+      while (running_ && frozen_ && ( ! dumped_)) {
+	usleep(period_usec_);
+      }
+      return;
+    }
+    // The counters only ever increase, and drain() may already be
+    // past the captured head if update() keeps running meanwhile.
+    size_t const head(head_);
+    while (running_ && (static_cast<ptrdiff_t>(head - tail_) > 0)) {
+      usleep(period_usec_);
+    }
+  }
+
+
+  void ParameterRingLog::
+  update(long long timestamp)
+  {
+    if (0 != ntick_++ % decimation_) {
+      return;
+    }
+    size_t const head(head_);
+    if (blackbox_) {
+      if (frozen_) {
+	++ndropped_;
+	return;
+      }
+    }
+    else if (head - tail_ >= capacity_) {
+      ++ndropped_;
+      return;
+    }
+    size_t const row(head & (capacity_ - 1));
+
+    timestamp_[row] = timestamp;
+    for (size_t ii(0); ii < column_.size(); ++ii) {
+      column_s & cc(column_[ii]);
+      switch (cc.type) {
+      case PARAMETER_TYPE_INTEGER:
+	cc.integer[row] = *cc.parameter->getInteger();
+	break;
+      case PARAMETER_TYPE_STRING:
+	{
+	  char * dst(&cc.string[row * string_width]);
+	  strncpy(dst, cc.parameter->getString()->c_str(), string_width - 1);
+	  dst[string_width - 1] = '\0';
+	}
+	break;
+      case PARAMETER_TYPE_REAL:
+	cc.real[row] = *cc.parameter->getReal();
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	{
+	  Vector const & vv(*cc.parameter->getVector());
+	  std::vector<double>::iterator dst(cc.real.begin() + row * cc.width);
+	  if (static_cast<size_t>(vv.rows()) == cc.rows) {
+	    std::copy(vv.data(), vv.data() + cc.width, dst);
+	  }
+	  else {
+	    std::fill(dst, dst + cc.width, std::numeric_limits<double>::quiet_NaN());
+	    ++nmismatched_;
+	  }
+	}
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	{
+	  Matrix const & mm(*cc.parameter->getMatrix());
+	  std::vector<double>::iterator dst(cc.real.begin() + row * cc.width);
+	  if ((static_cast<size_t>(mm.rows()) == cc.rows)
+	      && (static_cast<size_t>(mm.cols()) == cc.cols)) {
+	    std::copy(mm.data(), mm.data() + cc.width, dst);
+	  }
+	  else {
+	    std::fill(dst, dst + cc.width, std::numeric_limits<double>::quiet_NaN());
+	    ++nmismatched_;
+	  }
+	}
+	break;
+      default:
+	break;
+      }
+    }
+
+    // The row has to be complete before the flushing thread sees it.
+    __sync_synchronize();
+    head_ = head + 1;
+
+    // A trigger from another thread takes effect after recording the
+    // current values.
+    if (blackbox_ && trigger_) {
+      __sync_synchronize();
+      frozen_ = 1;
+    }
+  }
+
+
+  int ParameterRingLog::
+  drain()
+  {
+    size_t const head(head_);
+    __sync_synchronize();
+    size_t tail(tail_);
+    int count(0);
+
+    while (tail != head) {
+      // Write the longest run of rows which does not wrap around.
+      size_t const row(tail & (capacity_ - 1));
+      size_t nn(head - tail);
+      if (nn > capacity_ - row) {
+	nn = capacity_ - row;
+      }
+
+      bool ok(write_u32(file_, nn));
+      ok = ok && (nn == fwrite(&timestamp_[row], sizeof(long long), nn, file_));
+      for (size_t ii(0); ok && (ii < column_.size()); ++ii) {
+	column_s const & cc(column_[ii]);
+	size_t const ne(nn * cc.width);
+	if (0 == ne) {
+	  continue;
+	}
+	switch (cc.type) {
+	case PARAMETER_TYPE_INTEGER:
+	  ok = (ne == fwrite(&cc.integer[row], sizeof(int), ne, file_));
+	  break;
+	case PARAMETER_TYPE_STRING:
+	  ok = (ne == fwrite(&cc.string[row * cc.width], 1, ne, file_));
+	  break;
+	default:
+	  ok = (ne == fwrite(&cc.real[row * cc.width], sizeof(double), ne, file_));
+	}
+      }
+      if ( ! ok) {
+	// Keep the servo going, the error gets reported by close().
+	error_ = 1;
+      }
+
+      tail += nn;
+      count += nn;
+      // Hand the rows back only once we are done reading them.
+      __sync_synchronize();
+      tail_ = tail;
+    }
+
+    if (count > 0) {
+      fflush(file_);
+    }
+    return error_ ? -1 : count;
+  }
+
+
+  void * ParameterRingLog::
+  run(void * arg)
+  {
+    ParameterRingLog * self(reinterpret_cast<ParameterRingLog*>(arg));
+    while ( ! self->quit_) {
+      if (self->blackbox_) {
+	if (self->frozen_ && ( ! self->dumped_)) {
+	  __sync_synchronize();
+	  self->dumpFrozen();
+	}
+	else {
+	  usleep(self->period_usec_);
+	}
+      }
+      else if (self->drain() <= 0) {
+	usleep(self->period_usec_);
+      }
+    }
+    return 0;
+  }
+
+
+  template<typename parameter_t, typename storage_t>
+  static size_t find_slot(std::vector<ParameterLog::log_s<parameter_t, storage_t> > const & collection,
+			  Parameter const * parameter)
+  {
+    for (size_t ii(0); ii < collection.size(); ++ii) {
+      if (parameter == collection[ii].parameter) {
+	return ii;
+      }
+    }
+    return collection.size();
+  }
+
+
+  static size_t find_slot(ParameterLog const & log, Parameter const * parameter)
+  {
+    switch (parameter->type_) {
+    case PARAMETER_TYPE_INTEGER:
+      return find_slot(log.intlog, parameter);
+    case PARAMETER_TYPE_STRING:
+      return find_slot(log.strlog, parameter);
+    case PARAMETER_TYPE_REAL:
+      return find_slot(log.reallog, parameter);
+    case PARAMETER_TYPE_VECTOR:
+      return find_slot(log.veclog, parameter);
+    default:
+      return find_slot(log.mxlog, parameter);
+    }
+  }
+
+
+  Status
+  convertParameterLog(std::string const & filename,
+		      std::string const & prefix,
+		      std::ostream * progress)
+  {
+    FILE * ff(fopen(filename.c_str(), "rb"));
+    if ( ! ff) {
+      return Status(false, "failed to open " + filename + ": " + strerror(errno));
+    }
+
+    char magic[sizeof(log_magic)];
+    uint32_t byte_order, version, ncolumns;
+    std::string name;
+    if ((sizeof(magic) != fread(magic, 1, sizeof(magic), ff))
+	|| (0 != memcmp(magic, log_magic, sizeof(magic)))) {
+      fclose(ff);
+      return Status(false, filename + " is not a parameter log");
+    }
+    if (( ! read_u32(ff, byte_order)) || (log_byte_order != byte_order)) {
+      fclose(ff);
+      return Status(false, filename + " was written with a different byte order");
+    }
+    if (( ! read_u32(ff, version)) || (log_version != version)) {
+      fclose(ff);
+      return Status(false, filename + " has an unsupported version");
+    }
+    if (( ! read_string(ff, name)) || ( ! read_u32(ff, ncolumns))) {
+      fclose(ff);
+      return Status(false, filename + ": truncated header");
+    }
+
+    // Stand-in parameters (without any storage behind them) let us
+    // reuse ParameterLog::writeFiles() for the text output.
+    std::vector<ParameterRingLog::column_s> column(ncolumns);
+    for (size_t ii(0); ii < ncolumns; ++ii) {
+      column[ii].parameter = 0;
+    }
+    parameter_lookup_t lookup;
+    Status st;
+    for (size_t ii(0); ii < ncolumns; ++ii) {
+      uint32_t type, rows, cols;
+      std::string pname;
+      if (( ! read_u32(ff, type)) || ( ! read_u32(ff, rows))
+	  || ( ! read_u32(ff, cols)) || ( ! read_string(ff, pname))) {
+	st = Status(false, filename + ": truncated header");
+	break;
+      }
+      ParameterRingLog::column_s & cc(column[ii]);
+      cc.type = static_cast<parameter_type_t>(type);
+      cc.rows = rows;
+      cc.cols = cols;
+      cc.width = rows * cols;
+      switch (cc.type) {
+      case PARAMETER_TYPE_INTEGER:
+	cc.parameter = new IntegerParameter(pname, PARAMETER_FLAG_DEFAULT, 0, 0);
+	break;
+      case PARAMETER_TYPE_STRING:
+	cc.width = ParameterRingLog::string_width;
+	cc.parameter = new StringParameter(pname, PARAMETER_FLAG_DEFAULT, 0, 0);
+	break;
+      case PARAMETER_TYPE_REAL:
+	cc.parameter = new RealParameter(pname, PARAMETER_FLAG_DEFAULT, 0, 0);
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	cc.parameter = new VectorParameter(pname, PARAMETER_FLAG_DEFAULT, 0, 0);
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	cc.parameter = new MatrixParameter(pname, PARAMETER_FLAG_DEFAULT, 0, 0);
+	break;
+      default:
+	cc.parameter = 0;
+	st = Status(false, filename + ": invalid parameter type");
+      }
+      if ( ! cc.parameter) {
+	break;
+      }
+      lookup.insert(std::make_pair(pname, const_cast<Parameter*>(cc.parameter)));
+    }
+
+    if (st) {
+      // ParameterLog sorts the stand-ins into one vector per type,
+      // find out where each column ended up.
+      ParameterLog log(name, lookup);
+      std::vector<size_t> slot(ncolumns);
+      for (size_t ii(0); ii < ncolumns; ++ii) {
+	slot[ii] = find_slot(log, column[ii].parameter);
+      }
+      std::vector<long long> timestamp;
+      std::vector<int> ibuf;
+      std::vector<char> sbuf;
+      std::vector<double> rbuf;
+      uint32_t nn;
+      while (st && read_u32(ff, nn)) {
+	timestamp.resize(nn);
+	if ((0 < nn) && (nn != fread(&timestamp[0], sizeof(long long), nn, ff))) {
+	  st = Status(false, filename + ": truncated chunk");
+	  break;
+	}
+	log.timestamp.insert(log.timestamp.end(), timestamp.begin(), timestamp.end());
+
+	for (size_t ii(0); st && (ii < column.size()); ++ii) {
+	  ParameterRingLog::column_s const & cc(column[ii]);
+	  size_t const ne(nn * cc.width);
+	  size_t const kk(slot[ii]);
+	  bool ok(true);
+	  switch (cc.type) {
+	  case PARAMETER_TYPE_INTEGER:
+	    ibuf.resize(ne);
+	    ok = (0 == ne) || (ne == fread(&ibuf[0], sizeof(int), ne, ff));
+	    for (size_t jj(0); ok && (jj < nn); ++jj) {
+	      log.intlog[kk].timestamp.push_back(timestamp[jj]);
+	      log.intlog[kk].log.push_back(ibuf[jj]);
+	    }
+	    break;
+	  case PARAMETER_TYPE_STRING:
+	    sbuf.resize(ne);
+	    ok = (0 == ne) || (ne == fread(&sbuf[0], 1, ne, ff));
+	    for (size_t jj(0); ok && (jj < nn); ++jj) {
+	      log.strlog[kk].timestamp.push_back(timestamp[jj]);
+	      log.strlog[kk].log.push_back(std::string(&sbuf[jj * cc.width]));
+	    }
+	    break;
+	  default:
+	    rbuf.resize(ne);
+	    ok = (0 == ne) || (ne == fread(&rbuf[0], sizeof(double), ne, ff));
+	    for (size_t jj(0); ok && (jj < nn); ++jj) {
+	      std::vector<double>::const_iterator src(rbuf.begin() + jj * cc.width);
+	      if (PARAMETER_TYPE_REAL == cc.type) {
+		log.reallog[kk].timestamp.push_back(timestamp[jj]);
+		log.reallog[kk].log.push_back(*src);
+	      }
+	      else if (PARAMETER_TYPE_VECTOR == cc.type) {
+		Vector vv(cc.rows);
+		std::copy(src, src + cc.width, vv.data());
+		log.veclog[kk].timestamp.push_back(timestamp[jj]);
+		log.veclog[kk].log.push_back(vv);
+	      }
+	      else {
+		Matrix mm(cc.rows, cc.cols);
+		std::copy(src, src + cc.width, mm.data());
+		log.mxlog[kk].timestamp.push_back(timestamp[jj]);
+		log.mxlog[kk].log.push_back(mm);
+	      }
+	    }
+	  }
+	  if ( ! ok) {
+	    st = Status(false, filename + ": truncated chunk");
+	  }
+	}
+      }
+      if (st) {
+	log.writeFiles(prefix, progress);
+      }
+    }
+
+    for (size_t ii(0); ii < column.size(); ++ii) {
+      delete column[ii].parameter;
+    }
+    fclose(ff);
+    return st;
+  }
+
+}
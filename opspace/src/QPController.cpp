@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/QPController.hpp>
+#include <cmath>
+
+using jspace::pretty_print;
+
+namespace opspace {
+  
+  
+  static Status expand_limit(Vector const & limit, size_t ndof,
+			     std::string const & name, Vector & expanded)
+  {
+    if (0 == limit.rows()) {
+      expanded.resize(0);
+    }
+    else if (1 == limit.rows()) {
+      expanded = limit[0] * Vector::Ones(ndof);
+    }
+    else if (ndof == static_cast<size_t>(limit.rows())) {
+      expanded = limit;
+    }
+    else {
+      return Status(false, "invalid " + name + " dimension");
+    }
+    for (int ii(0); ii < expanded.rows(); ++ii) {
+      if (expanded[ii] < 0) {
+	return Status(false, name + " must be >= 0");
+      }
+    }
+    return Status();
+  }
+  
+  
+  QPController::
+  QPController(std::string const & name)
+    : Controller(name),
+      priority_ratio_(1e-3),
+      regularization_(1e-6),
+      max_iterations_(100),
+      warm_start_(1),
+      ndof_(0),
+      tau_row_(0),
+      niterations_(0),
+      nactive_(0)
+  {
+    declareParameter("weights", &weights_, PARAMETER_FLAG_NOLOG);
+    declareParameter("priority_ratio", &priority_ratio_, PARAMETER_FLAG_NOLOG);
+    declareParameter("regularization", &regularization_, PARAMETER_FLAG_NOLOG);
+    declareParameter("taumax", &taumax_, PARAMETER_FLAG_NOLOG);
+    declareParameter("qddmax", &qddmax_, PARAMETER_FLAG_NOLOG);
+    declareParameter("max_iterations", &max_iterations_, PARAMETER_FLAG_NOLOG);
+    declareParameter("warm_start", &warm_start_, PARAMETER_FLAG_NOLOG);
+    declareParameter("qdd", &qdd_);
+    declareParameter("gamma", &gamma_);
+    declareParameter("jpos", &jpos_);
+    declareParameter("jvel", &jvel_);
+    declareParameter("iterations", &niterations_);
+    declareParameter("nactive", &nactive_);
+  }
+  
+  
+  Status QPController::
+  init(Model const & model)
+  {
+    if (regularization_ <= 0) {
+      return Status(false, "regularization must be > 0");
+    }
+    if (max_iterations_ <= 0) {
+      return Status(false, "max_iterations must be > 0");
+    }
+    
+    ndof_ = model.getNDOF();
+    Status st(expand_limit(qddmax_, ndof_, "qddmax", qddlim_));
+    if ( ! st) {
+      return st;
+    }
+    st = expand_limit(taumax_, ndof_, "taumax", taulim_);
+    if ( ! st) {
+      return st;
+    }
+    
+    // Constraint rows come in +/- pairs per joint: first the
+    // acceleration limits, which are constant, then the torque limits,
+    // which get rebuilt each tick from the mass inertia and gravity.
+    size_t const ncons(2 * qddlim_.rows() + 2 * taulim_.rows());
+    tau_row_ = 2 * qddlim_.rows();
+    cc_ = Matrix::Zero(ncons, ndof_);
+    dd_ = Vector::Zero(ncons);
+    for (int ii(0); ii < qddlim_.rows(); ++ii) {
+      cc_.coeffRef(2 * ii, ii) = 1;
+      cc_.coeffRef(2 * ii + 1, ii) = -1;
+      dd_[2 * ii] = qddlim_[ii];
+      dd_[2 * ii + 1] = qddlim_[ii];
+    }
+    
+    aa_ = Matrix::Zero(ndof_, ndof_);
+    grav_ = Vector::Zero(ndof_);
+    hh_ = Matrix::Zero(ndof_, ndof_);
+    ff_ = Vector::Zero(ndof_);
+    qdd_ = Vector::Zero(ndof_);
+    gamma_ = Vector::Zero(ndof_);
+    jpos_ = Vector::Zero(ndof_);
+    jvel_ = Vector::Zero(ndof_);
+    qp_.init(ndof_, ncons);
+    qp_.setMaxIterations(max_iterations_);
+    niterations_ = 0;
+    nactive_ = 0;
+    
+    return st;
+  }
+  
+  
+  RTStatus QPController::
+  computeCommand(Model const & model,
+		 Skill & skill,
+		 Vector & gamma)
+  {
+    RTStatus st(skill.update(model));
+    if ( ! st) {
+      return st;
+    }
+    
+    Skill::task_table_t const * tasks(skill.getTaskTable());
+    if ( ! tasks) {
+      return RTStatus(jspace::STATUS_FAILED, "null task table");
+    }
+    if (tasks->empty()) {
+      return RTStatus(jspace::STATUS_FAILED, "empty task table");
+    }
+    if (model.getNDOF() != ndof_) {
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "number of DOF changed, did you forget to init()?");
+    }
+    
+    if ( ! model.getMassInertia(aa_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve mass inertia");
+    }
+    if ( ! model.getGravity(grav_)) {
+      return RTStatus(jspace::STATUS_FAILED, "failed to retrieve gravity torques");
+    }
+    
+    hh_.setIdentity();
+    hh_ *= regularization_;
+    ff_.setZero();
+    bool const use_weights(tasks->size() == static_cast<size_t>(weights_.rows()));
+    double weight(1);
+    bool empty(true);
+    for (size_t ii(0); ii < tasks->size(); ++ii) {
+      if (use_weights) {
+	weight = weights_[ii];
+      }
+      else if (ii > 0) {
+	weight *= priority_ratio_;
+      }
+      Task const * task((*tasks)[ii]);
+      Matrix const & jac(task->getJacobian());
+      if (0 == jac.rows()) {
+	continue;
+      }
+      if (static_cast<size_t>(jac.cols()) != ndof_) {
+	return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION, "invalid Jacobian dimension",
+			      "task `%s' (did you initialize and update the model?)",
+			      task->getName().c_str());
+      }
+      if (task->getCommand().rows() != jac.rows()) {
+	return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION,
+			      "command and Jacobian have different dimensions",
+			      "task `%s'", task->getName().c_str());
+      }
+      hh_ += weight * (jac.transpose() * jac).lazy();
+      ff_ -= weight * (jac.transpose() * task->getCommand()).lazy();
+      empty = false;
+    }
+    if (empty) {
+      return RTStatus(jspace::STATUS_FAILED, "all tasks have empty Jacobians");
+    }
+    
+    for (int ii(0); ii < taulim_.rows(); ++ii) {
+      size_t const row(tau_row_ + 2 * ii);
+      for (size_t jj(0); jj < ndof_; ++jj) {
+	cc_.coeffRef(row, jj) = aa_.coeff(ii, jj);
+	cc_.coeffRef(row + 1, jj) = -aa_.coeff(ii, jj);
+      }
+      dd_[row] = taulim_[ii] - grav_[ii];
+      dd_[row + 1] = taulim_[ii] + grav_[ii];
+    }
+    
+    if ( ! warm_start_) {
+      qp_.reset();
+    }
+    st = qp_.solve(hh_, ff_, cc_, dd_, qdd_);
+    niterations_ = qp_.getNIterations();
+    nactive_ = qp_.getNActive();
+    if ( ! st) {
+      return st;
+    }
+    
+    gamma_ = (aa_ * qdd_).lazy();
+    gamma_ += grav_;
+    gamma = gamma_;
+    
+    jpos_ = model.getState().position_;
+    jvel_ = model.getState().velocity_;
+    
+    return st;
+  }
+  
+  
+  void QPController::
+  dbg(std::ostream & os,
+      std::string const & title,
+      std::string const & prefix) const
+  {
+    if ( ! title.empty()) {
+      os << title << "\n";
+    }
+    pretty_print(jpos_, os, prefix + "jpos", prefix + "  ");
+    pretty_print(jvel_, os, prefix + "jvel", prefix + "  ");
+    pretty_print(qdd_, os, prefix + "qdd", prefix + "  ");
+    pretty_print(gamma_, os, prefix + "gamma", prefix + "  ");
+    os << prefix << "iterations: " << niterations_ << "  active constraints: " << nactive_ << "\n";
+  }
+  
+}
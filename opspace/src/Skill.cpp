@@ -25,6 +25,8 @@
 
 #include <opspace/Skill.hpp>
 #include <opspace/task_library.hpp>
+#include <tao/utility/TaoDeThreadPool.h>
+#include <string.h>
 
 using boost::shared_ptr;
 
@@ -34,7 +36,11 @@ namespace opspace {
   
   Skill::
   Skill(std::string const & name)
-    : ParameterReflection("skill", name)
+    : ParameterReflection("skill", name),
+      name_(name),
+      thread_pool_(0),
+      update_model_(0),
+      update_tasks_(0)
   {
   }
   
@@ -45,46 +51,141 @@ namespace opspace {
   }
   
   
+  Status Skill::
+  checkSlots() const
+  {
+    // Only build the error message in case of failure, so that the
+    // init() after a prepare() does not allocate.
+    std::string errstr;
+    for (slot_map_t::const_iterator is(slot_map_.begin()); is != slot_map_.end(); ++is) {
+      if ((0 == is->second->getNInstances())
+	  && ( ! is->second->isOptional())) {
+	errstr += "  slot `" + is->first + "' task `" + is->first + "'\n";
+      }
+    }
+    if ( ! errstr.empty()) {
+      return Status(false, "missing non-optional task instances:\n" + errstr);
+    }
+    return Status();
+  }
+  
+  
   Status Skill::
   init(Model const & model)
   {
+    Status const st(checkSlots());
+    if ( ! st) {
+      return st;
+    }
+    
+    std::string errstr;
+    for (slot_map_t::const_iterator is(slot_map_.begin()); is != slot_map_.end(); ++is) {
+      for (size_t it(0); it < is->second->getNInstances(); ++it) {
+	shared_ptr<Task> task(is->second->getInstance(it));
+	Status const tst(task->init(model));
+	if ( ! tst) {
+	  std::ostringstream msg;
+	  msg << "  slot `" << is->first << "' task[" << it << "] `" << task->getName()
+	      << "': " << tst.errstr << "\n";
+	  errstr += msg.str();
+	}
+      }
+    }
+    if ( ! errstr.empty()) {
+      return Status(false, "failed task initializations:\n" + errstr);
+    }
+    return st;
+  }
+  
+  
+  Status Skill::
+  prepare(Model const & model)
+  {
+    Status const st(checkSlots());
+    if ( ! st) {
+      return st;
+    }
+    
+    std::ostringstream msg;
     bool ok(true);
-
-    {
-      std::ostringstream msg;
-      msg << "missing non-optional task instances:\n";
-      for (slot_map_t::const_iterator is(slot_map_.begin()); is != slot_map_.end(); ++is) {
-	if ((0 == is->second->getNInstances())
-	    && ( ! is->second->isOptional())) {
+    size_t ntasks(0);
+    for (slot_map_t::const_iterator is(slot_map_.begin()); is != slot_map_.end(); ++is) {
+      for (size_t it(0); it < is->second->getNInstances(); ++it) {
+	shared_ptr<Task> task(is->second->getInstance(it));
+	Status const tst(task->prepare(model));
+	if ( ! tst) {
 	  ok = false;
-	  msg << "  slot `" << is->first << "' task `" << is->first << "'\n";
+	  msg << "  slot `" << is->first << "' task[" << it << "] `" << task->getName()
+	      << "': " << tst.errstr << "\n";
 	}
+	++ntasks;
       }
-      if ( ! ok) {
-	return Status(false, msg.str());
-      }
+    }
+    if ( ! ok) {
+      return Status(false, "failed task preparations:\n" + msg.str());
     }
     
-    {
-      std::ostringstream msg;
-      msg << "failed task initializations:\n";
-      for (slot_map_t::const_iterator is(slot_map_.begin()); is != slot_map_.end(); ++is) {
-	for (size_t it(0); it < is->second->getNInstances(); ++it) {
-	  shared_ptr<Task> task(is->second->getInstance(it));
-	  Status const st(task->init(model));
-	  if ( ! st) {
-	    ok = false;
-	    msg << "  slot `" << is->first << "' task[" << it << "] `" << task->getName()
-		<< "': " << st.errstr << "\n";
-	  }
+    if (update_status_.size() < ntasks) {
+      update_status_.resize(ntasks);
+      update_context_.resize(ntasks * RTStatus::context_size);
+    }
+    return st;
+  }
+  
+  
+  RTStatus Skill::
+  updateTasks(Model const & model, task_table_t const & tasks)
+  {
+    if (( ! thread_pool_) || (tasks.size() < 2)) {
+      for (size_t ii(0); ii < tasks.size(); ++ii) {
+	RTStatus const st(tasks[ii]->update(model));
+	if ( ! st) {
+	  return st;
 	}
       }
-      if ( ! ok) {
-	return Status(false, msg.str());
-      }
+      RTStatus ok;
+      return ok;
     }
     
-    return Status();
+    if (update_status_.size() < tasks.size()) {
+      update_status_.resize(tasks.size());
+      update_context_.resize(tasks.size() * RTStatus::context_size);
+    }
+    update_model_ = &model;
+    update_tasks_ = &tasks;
+    thread_pool_->run(updateTaskJob, this, tasks.size());
+    
+    for (size_t ii(0); ii < tasks.size(); ++ii) {
+      RTStatus const & st(update_status_[ii]);
+      if ( ! st) {
+	if ( ! st.context) {
+	  return st;
+	}
+	// Move the context from the slot buffer into those of the
+	// calling thread, so it follows the usual RTStatus lifetime.
+	return RTStatus::fail(st.code, st.message, "%s", st.context);
+      }
+    }
+    RTStatus ok;
+    return ok;
+  }
+  
+  
+  void Skill::
+  updateTaskJob(void * arg, int index)
+  {
+    Skill * skill(static_cast<Skill*>(arg));
+    RTStatus & st(skill->update_status_[index]);
+    st = (*skill->update_tasks_)[index]->update(*skill->update_model_);
+    // The context lives in the buffers of this pool thread, which may
+    // fail further tasks of the same run, or exit, before the calling
+    // thread gets to see it.
+    if (st.context) {
+      char * buf(&skill->update_context_[index * RTStatus::context_size]);
+      strncpy(buf, st.context, RTStatus::context_size - 1);
+      buf[RTStatus::context_size - 1] = '\0';
+      st.context = buf;
+    }
   }
   
   
@@ -148,4 +249,102 @@ namespace opspace {
     }
   }
   
+  
+  static Task const * find_shared_task(Skill const & lhs, Skill const & rhs)
+  {
+    Skill::slot_map_t const & lmap(lhs.getSlotMap());
+    Skill::slot_map_t const & rmap(rhs.getSlotMap());
+    for (Skill::slot_map_t::const_iterator il(lmap.begin()); il != lmap.end(); ++il) {
+      for (size_t it(0); it < il->second->getNInstances(); ++it) {
+	Task const * task(il->second->getInstance(it).get());
+	for (Skill::slot_map_t::const_iterator ir(rmap.begin()); ir != rmap.end(); ++ir) {
+	  for (size_t jt(0); jt < ir->second->getNInstances(); ++jt) {
+	    if (ir->second->getInstance(jt).get() == task) {
+	      return task;
+	    }
+	  }
+	}
+      }
+    }
+    return 0;
+  }
+  
+  
+  SkillSwitch::
+  SkillSwitch()
+    : pending_(0),
+      active_(0)
+  {
+  }
+  
+  
+  Status SkillSwitch::
+  prepare(Model const & model, boost::shared_ptr<Skill> skill)
+  {
+    if ( ! skill) {
+      return Status(false, "null skill");
+    }
+    if (pending_) {
+      return Status(false, "previously prepared skill is still pending");
+    }
+    
+    // The servo thread has settled on active_, so every other skill
+    // we hold on to can go now.
+    __sync_synchronize();
+    Skill * const active(active_);
+    
+    // Skill::prepare() would re-prepare tasks under the feet of the
+    // servo thread, which keeps updating the active skill.
+    if (skill.get() == active) {
+      return Status(false, "skill `" + skill->getName() + "' is currently active");
+    }
+    if (active) {
+      Task const * shared(find_shared_task(*skill, *active));
+      if (shared) {
+	return Status(false, "task `" + shared->getName() + "' is in use by the active skill `"
+		      + active->getName() + "'");
+      }
+    }
+    
+    for (size_t ii(0); ii < owned_.size(); /**/) {
+      if (owned_[ii].get() == active) {
+	++ii;
+      }
+      else {
+	owned_.erase(owned_.begin() + ii);
+      }
+    }
+    
+    Status const st(skill->prepare(model));
+    if ( ! st) {
+      return st;
+    }
+    owned_.push_back(skill);
+    __sync_synchronize();
+    pending_ = skill.get();
+    return st;
+  }
+  
+  
+  Status SkillSwitch::
+  tick(Model const & model)
+  {
+    Skill * const next(pending_);
+    if ( ! next) {
+      return Status();
+    }
+    __sync_synchronize();
+    
+    // On failure, the previous skill simply stays active.
+    Status const st(next->init(model));
+    if (st) {
+      active_ = next;
+    }
+    
+    // Clearing pending_ tells prepare() which skill we settled on.
+    __sync_synchronize();
+    pending_ = 0;
+    return st;
+  }
+  
 }
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/SparseJacobian.hpp>
+
+using namespace std;
+
+namespace opspace {
+  
+  
+  SparseJacobian::
+  SparseJacobian()
+    : ndof_(0)
+  {
+  }
+  
+  
+  Status SparseJacobian::
+  init(Model const & model, taoDNode const * node, size_t nrows)
+  {
+    vector<size_t> dof;
+    if ( ! model.getSupportingDOF(node, dof)) {
+      return Status(false, "invalid node");
+    }
+    return init(dof, model.getNDOF(), nrows);
+  }
+  
+  
+  Status SparseJacobian::
+  init(std::vector<size_t> const & dof, size_t ndof, size_t nrows)
+  {
+    for (size_t ii(0); ii < dof.size(); ++ii) {
+      if (dof[ii] >= ndof) {
+	return Status(false, "supporting DOF index out of range");
+      }
+      if ((ii > 0) && (dof[ii] <= dof[ii - 1])) {
+	return Status(false, "supporting DOF must be sorted and unique");
+      }
+    }
+    dof_ = dof;
+    ndof_ = ndof;
+    compact_ = Matrix::Zero(nrows, dof_.size());
+    Status ok;
+    return ok;
+  }
+  
+  
+  void SparseJacobian::
+  gather(Matrix const & dense)
+  {
+    size_t const nsup(dof_.size());
+    for (size_t ii(0); ii < nsup; ++ii) {
+      compact_.col(ii) = dense.col(dof_[ii]);
+    }
+  }
+  
+  
+  void SparseJacobian::
+  scatter(Matrix & dense) const
+  {
+    if ((compact_.rows() != dense.rows()) || (ndof_ != static_cast<size_t>(dense.cols()))) {
+      dense.resize(compact_.rows(), ndof_);
+    }
+    dense.setZero();
+    size_t const nsup(dof_.size());
+    for (size_t ii(0); ii < nsup; ++ii) {
+      dense.col(dof_[ii]) = compact_.col(ii);
+    }
+  }
+  
+  
+  RTStatus SparseJacobian::
+  multiply(Vector const & qd, Vector & result) const
+  {
+    if (static_cast<size_t>(qd.size()) != ndof_) {
+      return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION, "invalid joint velocity dimension",
+			    "%d instead of %d", static_cast<int>(qd.size()), static_cast<int>(ndof_));
+    }
+    size_t const nrows(compact_.rows());
+    size_t const nsup(dof_.size());
+    if (nrows != static_cast<size_t>(result.size())) {
+      result.resize(nrows);
+    }
+    result.setZero();
+    for (size_t kk(0); kk < nsup; ++kk) {
+      double const qdk(qd.coeff(dof_[kk]));
+      for (size_t rr(0); rr < nrows; ++rr) {
+	result.coeffRef(rr) += compact_.coeff(rr, kk) * qdk;
+      }
+    }
+    RTStatus ok;
+    return ok;
+  }
+  
+  
+  RTStatus SparseJacobian::
+  multiplyTranspose(Vector const & ff, Vector & result) const
+  {
+    size_t const nrows(compact_.rows());
+    if (static_cast<size_t>(ff.size()) != nrows) {
+      return RTStatus::fail(jspace::STATUS_INVALID_DIMENSION, "invalid task force dimension",
+			    "%d instead of %d", static_cast<int>(ff.size()), static_cast<int>(nrows));
+    }
+    size_t const nsup(dof_.size());
+    if (ndof_ != static_cast<size_t>(result.size())) {
+      result.resize(ndof_);
+    }
+    result.setZero();
+    for (size_t kk(0); kk < nsup; ++kk) {
+      double sum(0);
+      for (size_t rr(0); rr < nrows; ++rr) {
+	sum += compact_.coeff(rr, kk) * ff.coeff(rr);
+      }
+      result.coeffRef(dof_[kk]) = sum;
+    }
+    RTStatus ok;
+    return ok;
+  }
+  
+  
+  void computeSparseAinvJt(SparseJacobian const & jac,
+			   Matrix const & ainv,
+			   Matrix & ainv_jt)
+  {
+    std::vector<size_t> const & dof(jac.getDOF());
+    Matrix const & compact(jac.getCompact());
+    size_t const ndof(jac.getNDOF());
+    size_t const nrows(compact.rows());
+    size_t const nsup(dof.size());
+    if ((ndof != static_cast<size_t>(ainv_jt.rows()))
+	|| (nrows != static_cast<size_t>(ainv_jt.cols()))) {
+      ainv_jt.resize(ndof, nrows);
+    }
+    
+    // ainv_jt(ii, rr) = sum_k ainv(ii, dof[k]) * J(rr, k), where
+    // column dof[k] of the (column-major) ainv is contiguous.
+    if (0 == nsup) {
+      ainv_jt.setZero();
+      return;
+    }
+    double const * const adata(ainv.data());
+    size_t const astride(ainv.rows());
+    for (size_t rr(0); rr < nrows; ++rr) {
+      double * const out(ainv_jt.data() + rr * ndof);
+      double const * acol(adata + dof[0] * astride);
+      double jrk(compact.coeff(rr, 0));
+      for (size_t ii(0); ii < ndof; ++ii) {
+	out[ii] = acol[ii] * jrk;
+      }
+      for (size_t kk(1); kk < nsup; ++kk) {
+	acol = adata + dof[kk] * astride;
+	jrk = compact.coeff(rr, kk);
+	for (size_t ii(0); ii < ndof; ++ii) {
+	  out[ii] += acol[ii] * jrk;
+	}
+      }
+    }
+  }
+  
+  
+  void computeSparseLambdaInverse(SparseJacobian const & jac,
+				  Matrix const & ainv_jt,
+				  Matrix & lambda_inv)
+  {
+    std::vector<size_t> const & dof(jac.getDOF());
+    Matrix const & compact(jac.getCompact());
+    size_t const nrows(compact.rows());
+    size_t const nsup(dof.size());
+    if ((nrows != static_cast<size_t>(lambda_inv.rows()))
+	|| (nrows != static_cast<size_t>(lambda_inv.cols()))) {
+      lambda_inv.resize(nrows, nrows);
+    }
+    
+    // Only the lower triangle gets computed, the result is symmetric.
+    for (size_t cc(0); cc < nrows; ++cc) {
+      for (size_t rr(cc); rr < nrows; ++rr) {
+	double sum(0);
+	for (size_t kk(0); kk < nsup; ++kk) {
+	  sum += compact.coeff(rr, kk) * ainv_jt.coeff(dof[kk], cc);
+	}
+	lambda_inv.coeffRef(rr, cc) = sum;
+	lambda_inv.coeffRef(cc, rr) = sum;
+      }
+    }
+  }
+  
+}
@@ -0,0 +1,514 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/Telemetry.hpp>
+#include <limits>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static char const telemetry_magic[8] = { 'o', 'p', 's', 'p', 't', 'l', 'm', '\0' };
+static uint32_t const telemetry_version(1);
+
+
+static void copy_name(char * dst, std::string const & src)
+{
+  strncpy(dst, src.c_str(), opspace::telemetry_entry_s::name_width - 1);
+  dst[opspace::telemetry_entry_s::name_width - 1] = '\0';
+}
+
+
+// Reader side: check that a schema entry describes a value which
+// lies within a data block of data_size bytes, and that its size
+// matches its type and shape. Everything is computed in 64 bits so
+// that garbage cannot wrap around.
+static bool check_entry(opspace::telemetry_entry_s const & entry, uint64_t data_size)
+{
+  uint64_t expected;
+  switch (entry.type) {
+  case opspace::PARAMETER_TYPE_INTEGER:
+    expected = sizeof(int32_t);
+    break;
+  case opspace::PARAMETER_TYPE_STRING:
+    expected = opspace::TelemetryPublisher::string_width;
+    break;
+  case opspace::PARAMETER_TYPE_REAL:
+    expected = sizeof(double);
+    break;
+  case opspace::PARAMETER_TYPE_VECTOR:
+    expected = static_cast<uint64_t>(entry.rows) * sizeof(double);
+    break;
+  case opspace::PARAMETER_TYPE_MATRIX:
+    expected = static_cast<uint64_t>(entry.rows) * entry.cols * sizeof(double);
+    break;
+  default:
+    return false;
+  }
+  return (expected == entry.size)
+    && (static_cast<uint64_t>(entry.offset) + entry.size <= data_size);
+}
+
+
+static size_t align8(size_t nbytes)
+{
+  return (nbytes + 7) & ~static_cast<size_t>(7);
+}
+
+
+namespace opspace {
+
+
+  TelemetryPublisher::
+  TelemetryPublisher()
+    : segment_(0),
+      segment_size_(0),
+      header_(0),
+      nmismatched_(0)
+  {
+  }
+
+
+  TelemetryPublisher::
+  ~TelemetryPublisher()
+  {
+    close();
+  }
+
+
+  Status TelemetryPublisher::
+  open(std::string const & shm_name, ReflectionRegistry & registry)
+  {
+    if (segment_) {
+      return Status(false, "already open");
+    }
+
+    ReflectionRegistry::enumeration_t enumeration;
+    registry.enumerate(enumeration);
+
+    // Lay out the schema first, so that we know how big the segment
+    // has to be.
+    std::vector<telemetry_entry_s> schema;
+    std::vector<Parameter const *> parameter;
+    size_t data_size(0);
+    for (size_t ii(0); ii < enumeration.size(); ++ii) {
+      Parameter const * pp(enumeration[ii].parameter);
+      telemetry_entry_s entry;
+      memset(&entry, 0, sizeof(entry));
+      copy_name(entry.type_name, enumeration[ii].type_name);
+      copy_name(entry.instance_name, enumeration[ii].instance_name);
+      copy_name(entry.parameter_name, enumeration[ii].parameter_name);
+      entry.type = pp->type_;
+      entry.rows = 1;
+      entry.cols = 1;
+      switch (pp->type_) {
+      case PARAMETER_TYPE_INTEGER:
+	entry.size = sizeof(int32_t);
+	break;
+      case PARAMETER_TYPE_STRING:
+	entry.size = string_width;
+	break;
+      case PARAMETER_TYPE_REAL:
+	entry.size = sizeof(double);
+	break;
+      case PARAMETER_TYPE_VECTOR:
+	entry.rows = pp->getVector()->rows();
+	entry.size = entry.rows * sizeof(double);
+	break;
+      case PARAMETER_TYPE_MATRIX:
+	entry.rows = pp->getMatrix()->rows();
+	entry.cols = pp->getMatrix()->cols();
+	entry.size = entry.rows * entry.cols * sizeof(double);
+	break;
+      default:
+	continue;
+      }
+      entry.offset = data_size;
+      data_size += align8(entry.size);
+      schema.push_back(entry);
+      parameter.push_back(pp);
+    }
+
+    size_t const schema_offset(align8(sizeof(telemetry_header_s)));
+    size_t const data_offset(schema_offset + schema.size() * sizeof(telemetry_entry_s));
+    size_t const segment_size(data_offset + data_size);
+
+    int const fd(shm_open(shm_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644));
+    if (0 > fd) {
+      return Status(false, "shm_open " + shm_name + ": " + strerror(errno));
+    }
+    if (0 != ftruncate(fd, segment_size)) {
+      Status const err(false, "ftruncate " + shm_name + ": " + strerror(errno));
+      ::close(fd);
+      shm_unlink(shm_name.c_str());
+      return err;
+    }
+    void * mm(mmap(0, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    ::close(fd);
+    if (MAP_FAILED == mm) {
+      Status const err(false, "mmap " + shm_name + ": " + strerror(errno));
+      shm_unlink(shm_name.c_str());
+      return err;
+    }
+
+    shm_name_ = shm_name;
+    segment_ = static_cast<char*>(mm);
+    segment_size_ = segment_size;
+    header_ = reinterpret_cast<telemetry_header_s*>(segment_);
+    header_->version = telemetry_version;
+    header_->nentries = schema.size();
+    header_->schema_offset = schema_offset;
+    header_->data_offset = data_offset;
+    header_->data_size = data_size;
+    header_->padding = 0;
+    header_->sequence = 0;
+    header_->timestamp = 0;
+    if ( ! schema.empty()) {
+      memcpy(segment_ + schema_offset, &schema[0], schema.size() * sizeof(telemetry_entry_s));
+    }
+
+    slot_.resize(schema.size());
+    for (size_t ii(0); ii < schema.size(); ++ii) {
+      slot_[ii].parameter = parameter[ii];
+      slot_[ii].rows = schema[ii].rows;
+      slot_[ii].cols = schema[ii].cols;
+      slot_[ii].data = segment_ + data_offset + schema[ii].offset;
+    }
+    nmismatched_ = 0;
+
+    // Readers check the magic last, it tells them the layout is complete.
+    __sync_synchronize();
+    memcpy(header_->magic, telemetry_magic, sizeof(telemetry_magic));
+
+    return Status();
+  }
+
+
+  void TelemetryPublisher::
+  close()
+  {
+    if ( ! segment_) {
+      return;
+    }
+    munmap(segment_, segment_size_);
+    shm_unlink(shm_name_.c_str());
+    segment_ = 0;
+    segment_size_ = 0;
+    header_ = 0;
+    slot_.clear();
+  }
+
+
+  void TelemetryPublisher::
+  publish(long long timestamp)
+  {
+    if ( ! segment_) {
+      return;
+    }
+
+    uint64_t const sequence(header_->sequence);
+    header_->sequence = sequence + 1;
+    __sync_synchronize();
+
+    header_->timestamp = timestamp;
+    for (size_t ii(0); ii < slot_.size(); ++ii) {
+      slot_s const & slot(slot_[ii]);
+      switch (slot.parameter->type_) {
+      case PARAMETER_TYPE_INTEGER:
+	{
+	  int32_t const value(*slot.parameter->getInteger());
+	  memcpy(slot.data, &value, sizeof(value));
+	}
+	break;
+      case PARAMETER_TYPE_STRING:
+	strncpy(slot.data, slot.parameter->getString()->c_str(), string_width - 1);
+	slot.data[string_width - 1] = '\0';
+	break;
+      case PARAMETER_TYPE_REAL:
+	memcpy(slot.data, slot.parameter->getReal(), sizeof(double));
+	break;
+      case PARAMETER_TYPE_VECTOR:
+      case PARAMETER_TYPE_MATRIX:
+	{
+	  double const * src;
+	  bool ok;
+	  if (PARAMETER_TYPE_VECTOR == slot.parameter->type_) {
+	    Vector const & vv(*slot.parameter->getVector());
+	    src = vv.data();
+	    ok = static_cast<size_t>(vv.rows()) == slot.rows;
+	  }
+	  else {
+	    Matrix const & mm(*slot.parameter->getMatrix());
+	    src = mm.data();
+	    ok = (static_cast<size_t>(mm.rows()) == slot.rows)
+	      && (static_cast<size_t>(mm.cols()) == slot.cols);
+	  }
+	  size_t const nn(slot.rows * slot.cols);
+	  if ( ! ok) {
+	    double const nan(std::numeric_limits<double>::quiet_NaN());
+	    for (size_t jj(0); jj < nn; ++jj) {
+	      memcpy(slot.data + jj * sizeof(double), &nan, sizeof(double));
+	    }
+	    ++nmismatched_;
+	  }
+	  else if (0 < nn) {
+	    memcpy(slot.data, src, nn * sizeof(double));
+	  }
+	}
+	break;
+      default:
+	break;
+      }
+    }
+
+    __sync_synchronize();
+    header_->sequence = sequence + 2;
+  }
+
+
+  TelemetryReader::
+  TelemetryReader()
+    : segment_(0),
+      segment_size_(0),
+      header_(0),
+      data_offset_(0),
+      timestamp_(0),
+      sequence_(0)
+  {
+  }
+
+
+  TelemetryReader::
+  ~TelemetryReader()
+  {
+    detach();
+  }
+
+
+  Status TelemetryReader::
+  attach(std::string const & shm_name)
+  {
+    if (segment_) {
+      return Status(false, "already attached");
+    }
+
+    int const fd(shm_open(shm_name.c_str(), O_RDONLY, 0));
+    if (0 > fd) {
+      return Status(false, "shm_open " + shm_name + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+      Status const err(false, "fstat " + shm_name + ": " + strerror(errno));
+      ::close(fd);
+      return err;
+    }
+    size_t const segment_size(st.st_size);
+    if (segment_size < sizeof(telemetry_header_s)) {
+      ::close(fd);
+      return Status(false, shm_name + " is not a telemetry segment");
+    }
+    void * mm(mmap(0, segment_size, PROT_READ, MAP_SHARED, fd, 0));
+    ::close(fd);
+    if (MAP_FAILED == mm) {
+      return Status(false, "mmap " + shm_name + ": " + strerror(errno));
+    }
+
+    segment_ = static_cast<char const *>(mm);
+    segment_size_ = segment_size;
+    header_ = reinterpret_cast<telemetry_header_s const *>(segment_);
+    __sync_synchronize();
+    if (0 != memcmp(header_->magic, telemetry_magic, sizeof(telemetry_magic))) {
+      detach();
+      return Status(false, shm_name + " is not (yet) a telemetry segment");
+    }
+    if (telemetry_version != header_->version) {
+      detach();
+      return Status(false, shm_name + " has an unsupported telemetry version");
+    }
+
+    // Copy the layout out of the segment before checking it, so that
+    // a publisher scribbling over the header cannot change it between
+    // the checks and its use.
+    uint64_t const nentries(header_->nentries);
+    uint64_t const schema_offset(header_->schema_offset);
+    uint64_t const data_offset(header_->data_offset);
+    uint64_t const data_size(header_->data_size);
+    if ((schema_offset < sizeof(telemetry_header_s))
+	|| (schema_offset + nentries * sizeof(telemetry_entry_s) > data_offset)
+	|| (data_offset + data_size > segment_size)) {
+      detach();
+      return Status(false, shm_name + " has an inconsistent layout");
+    }
+
+    telemetry_entry_s const * entry(reinterpret_cast<telemetry_entry_s const *>
+				    (segment_ + schema_offset));
+    schema_.assign(entry, entry + nentries);
+    for (size_t ii(0); ii < schema_.size(); ++ii) {
+      telemetry_entry_s & ee(schema_[ii]);
+      ee.type_name[telemetry_entry_s::name_width - 1] = '\0';
+      ee.instance_name[telemetry_entry_s::name_width - 1] = '\0';
+      ee.parameter_name[telemetry_entry_s::name_width - 1] = '\0';
+      if ( ! check_entry(ee, data_size)) {
+	std::ostringstream msg;
+	msg << shm_name << " has an inconsistent schema entry " << ii;
+	detach();
+	return Status(false, msg.str());
+      }
+    }
+    data_offset_ = data_offset;
+    snapshot_.resize(data_size);
+    timestamp_ = 0;
+    sequence_ = 0;
+
+    return Status();
+  }
+
+
+  void TelemetryReader::
+  detach()
+  {
+    if ( ! segment_) {
+      return;
+    }
+    munmap(const_cast<char*>(segment_), segment_size_);
+    segment_ = 0;
+    segment_size_ = 0;
+    header_ = 0;
+    schema_.clear();
+  }
+
+
+  int TelemetryReader::
+  findEntry(std::string const & type_name,
+	    std::string const & instance_name,
+	    std::string const & parameter_name) const
+  {
+    for (size_t ii(0); ii < schema_.size(); ++ii) {
+      if ((type_name == schema_[ii].type_name)
+	  && (instance_name == schema_[ii].instance_name)
+	  && (parameter_name == schema_[ii].parameter_name)) {
+	return ii;
+      }
+    }
+    return -1;
+  }
+
+
+  bool TelemetryReader::
+  update(size_t max_retries)
+  {
+    if ( ! segment_) {
+      return false;
+    }
+    for (size_t attempt(0); attempt <= max_retries; ++attempt) {
+      uint64_t const before(header_->sequence);
+      if (before & 1) {
+	continue;		// publisher is writing
+      }
+      __sync_synchronize();
+      long long const timestamp(header_->timestamp);
+      if ( ! snapshot_.empty()) {
+	memcpy(&snapshot_[0], segment_ + data_offset_, snapshot_.size());
+      }
+      __sync_synchronize();
+      if (before == header_->sequence) {
+	timestamp_ = timestamp;
+	sequence_ = before;
+	return true;
+      }
+    }
+    return false;
+  }
+
+
+  bool TelemetryReader::
+  getInteger(size_t index, int & value) const
+  {
+    if ((index >= schema_.size()) || (PARAMETER_TYPE_INTEGER != schema_[index].type)) {
+      return false;
+    }
+    int32_t vv;
+    memcpy(&vv, &snapshot_[schema_[index].offset], sizeof(vv));
+    value = vv;
+    return true;
+  }
+
+
+  bool TelemetryReader::
+  getString(size_t index, std::string & value) const
+  {
+    if ((index >= schema_.size()) || (PARAMETER_TYPE_STRING != schema_[index].type)) {
+      return false;
+    }
+    value = &snapshot_[schema_[index].offset];
+    return true;
+  }
+
+
+  bool TelemetryReader::
+  getReal(size_t index, double & value) const
+  {
+    if ((index >= schema_.size()) || (PARAMETER_TYPE_REAL != schema_[index].type)) {
+      return false;
+    }
+    memcpy(&value, &snapshot_[schema_[index].offset], sizeof(value));
+    return true;
+  }
+
+
+  bool TelemetryReader::
+  getVector(size_t index, Vector & value) const
+  {
+    if ((index >= schema_.size()) || (PARAMETER_TYPE_VECTOR != schema_[index].type)) {
+      return false;
+    }
+    telemetry_entry_s const & entry(schema_[index]);
+    if (static_cast<size_t>(value.rows()) != entry.rows) {
+      value.resize(entry.rows);
+    }
+    if (0 < entry.size) {
+      memcpy(value.data(), &snapshot_[entry.offset], entry.size);
+    }
+    return true;
+  }
+
+
+  bool TelemetryReader::
+  getMatrix(size_t index, Matrix & value) const
+  {
+    if ((index >= schema_.size()) || (PARAMETER_TYPE_MATRIX != schema_[index].type)) {
+      return false;
+    }
+    telemetry_entry_s const & entry(schema_[index]);
+    if ((static_cast<size_t>(value.rows()) != entry.rows)
+	|| (static_cast<size_t>(value.cols()) != entry.cols)) {
+      value.resize(entry.rows, entry.cols);
+    }
+    if (0 < entry.size) {
+      memcpy(value.data(), &snapshot_[entry.offset], entry.size);
+    }
+    return true;
+  }
+
+}
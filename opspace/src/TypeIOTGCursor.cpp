@@ -20,15 +20,22 @@
  */
 
 #include <opspace/TypeIOTGCursor.hpp>
+#include <reflexxes_otg/TypeIOTGMath.h>
+#include <limits>
+#include <math.h>
 
 namespace opspace {
   
   
+  double const TypeIOTGCursor::default_cache_tolerance(1e-9);
+  
+  
   TypeIOTGCursor::
   TypeIOTGCursor(size_t ndof, double dt_seconds)
     : ndof_(ndof),
       dt_seconds_(dt_seconds),
-      otg_(ndof, dt_seconds)
+      otg_(ndof, dt_seconds),
+      preview_polynomials_(ndof)
   {
     pos_clean_ = Vector::Zero(ndof);
     vel_clean_ = Vector::Zero(ndof);
@@ -38,6 +45,14 @@ namespace opspace {
     for (size_t ii(0); ii < ndof; ++ii) {
       selection_[ii] = true;
     }
+    otg_.SetTrajectoryCaching(true, default_cache_tolerance);
+  }
+  
+  
+  void TypeIOTGCursor::
+  setCaching(bool enable, double tolerance)
+  {
+    otg_.SetTrajectoryCaching(enable, tolerance);
   }
   
   
@@ -86,6 +101,289 @@ namespace opspace {
   }
   
   
+  int TypeIOTGCursor::
+  preview(Vector const & maxvel,
+	  Vector const & maxacc,
+	  Vector const & goal,
+	  TypeIOTGTrajectory & trajectory)
+  {
+    double duration;
+    int const result(otg_.CalculateTrajectory(pos_clean_.data(),
+					      vel_clean_.data(),
+					      maxvel.data(),
+					      maxacc.data(),
+					      goal.data(),
+					      selection_.data(),
+					      &preview_polynomials_[0],
+					      &duration));
+    if (0 <= result) {
+      trajectory.set(ndof_, duration, &preview_polynomials_[0]);
+    }
+    return result;
+  }
+  
+  
+  TypeIOTGTrajectory::
+  TypeIOTGTrajectory()
+    : ndof_(0),
+      duration_(0)
+  {
+  }
+  
+  
+  void TypeIOTGTrajectory::
+  set(size_t ndof,
+      double duration,
+      TypeIOTGMath::TypeIMotionPolynomials const * polynomials)
+  {
+    if (ndof != ndof_) {
+      ndof_ = ndof;
+      nsegments_.resize(ndof);
+      segments_.resize(ndof * MAXIMAL_NO_OF_POLYNOMIALS);
+    }
+    duration_ = duration;
+    
+    for (size_t jj(0); jj < ndof; ++jj) {
+      TypeIOTGMath::TypeIMotionPolynomials const & poly(polynomials[jj]);
+      otg_segment_s * seg(&segments_[jj * MAXIMAL_NO_OF_POLYNOMIALS]);
+      double t_begin(0);
+      nsegments_[jj] = poly.ValidPolynomials;
+      for (size_t kk(0); kk < poly.ValidPolynomials; ++kk) {
+	// p(t) = a2 * (t - delta)^2 + a1 * (t - delta) + a0
+	double a2, a1, a0, delta;
+	poly.PositionPolynomial[kk].GetCoefficients(&a2, &a1, &a0, &delta);
+	double const tau(t_begin - delta);
+	seg[kk].t_begin = t_begin;
+	if (poly.PolynomialTimes[kk] >= OTG_INFINITY) {
+	  seg[kk].t_end = std::numeric_limits<double>::infinity();
+	}
+	else {
+	  seg[kk].t_end = poly.PolynomialTimes[kk];
+	}
+	seg[kk].position = (a2 * tau + a1) * tau + a0;
+	seg[kk].velocity = 2.0 * a2 * tau + a1;
+	seg[kk].acceleration = 2.0 * a2;
+	t_begin = seg[kk].t_end;
+      }
+    }
+  }
+  
+  
+  /**
+     Index of the first of the nsamples time points t0 + ii * dt which
+     is not before tt.
+  */
+  static inline size_t first_sample_from(double tt, double t0, double dt, size_t nsamples)
+  {
+    if (tt <= t0) {
+      return 0;
+    }
+    double const ff((tt - t0) / dt);
+    if (ff >= nsamples) {
+      return nsamples;
+    }
+    return static_cast<size_t>(ceil(ff));
+  }
+  
+  
+  void TypeIOTGTrajectory::
+  sample(double t0, double dt, size_t nsamples,
+	 double * pos, double * vel) const
+  {
+    for (size_t jj(0); jj < ndof_; ++jj) {
+      double * const pp(pos + jj * nsamples);
+      double * const vv(vel + jj * nsamples);
+      otg_segment_s const * seg(&segments_[jj * MAXIMAL_NO_OF_POLYNOMIALS]);
+      size_t const nseg(nsegments_[jj]);
+      if (0 == nseg) {
+	for (size_t ii(0); ii < nsamples; ++ii) {
+	  pp[ii] = 0;
+	  vv[ii] = 0;
+	}
+	continue;
+      }
+      
+      // Each segment covers a contiguous range of samples. Samples
+      // before the first segment start get extrapolated from it, and
+      // the last segment extends to infinity.
+      size_t begin(0);
+      for (size_t kk(0); kk < nseg; ++kk) {
+	size_t const end((kk + 1 == nseg)
+			 ? nsamples
+			 : first_sample_from(seg[kk].t_end, t0, dt, nsamples));
+	double const offset(t0 - seg[kk].t_begin);
+	double const p0(seg[kk].position);
+	double const v0(seg[kk].velocity);
+	double const acc(seg[kk].acceleration);
+	for (size_t ii(begin); ii < end; ++ii) {
+	  double const tau(offset + ii * dt);
+	  pp[ii] = p0 + tau * (v0 + 0.5 * acc * tau);
+	  vv[ii] = v0 + acc * tau;
+	}
+	if (end > begin) {
+	  begin = end;
+	}
+      }
+    }
+  }
+  
+  
+  void TypeIOTGTrajectory::
+  sample(double t0, double dt, size_t nsamples,
+	 Matrix & pos, Matrix & vel) const
+  {
+    if ((static_cast<size_t>(pos.rows()) != nsamples)
+	|| (static_cast<size_t>(pos.cols()) != ndof_)) {
+      pos.resize(nsamples, ndof_);
+    }
+    if ((static_cast<size_t>(vel.rows()) != nsamples)
+	|| (static_cast<size_t>(vel.cols()) != ndof_)) {
+      vel.resize(nsamples, ndof_);
+    }
+    sample(t0, dt, nsamples, pos.data(), vel.data());
+  }
+  
+  
+  /**
+     Advance (pp, vv) by min(rem, duration) seconds at constant
+     acceleration acc, and subtract that time from rem.
+  */
+  static inline void advance_segment(double & pp, double & vv, double & rem,
+				     double acc, double duration)
+  {
+    double const tau(rem < duration ? rem : duration);
+    pp += tau * (vv + 0.5 * acc * tau);
+    vv += acc * tau;
+    rem -= tau;
+  }
+  
+  
+  TypeIOTGUnsyncCursor::
+  TypeIOTGUnsyncCursor(size_t ndof, double dt_seconds)
+    : ndof_(ndof),
+      dt_seconds_(dt_seconds)
+  {
+    selection_ = boolvec_t::Constant(ndof, true);
+    pos_ = Vector::Zero(ndof);
+    vel_ = Vector::Zero(ndof);
+    pos_next_ = Vector::Zero(ndof);
+    vel_next_ = Vector::Zero(ndof);
+    remaining_ = Vector::Zero(ndof);
+  }
+  
+  
+  /**
+     Advance all ndof profiles by one cycle of dt seconds. Reads
+     position and velocity from (pos, vel) and writes the state at
+     the end of the cycle to (pos_next, vel_next), along with the time
+     that each profile needs beyond this cycle to reach its goal.
+     
+     The loop body is free of branches and of stores that depend on
+     the profile shape, so that it can be vectorized (see the
+     compiler flags for this file in opspace/CMakeLists.txt).
+  */
+  static void unsync_step(size_t ndof,
+			  double dt,
+			  double const * __restrict__ vmax,
+			  double const * __restrict__ amax,
+			  double const * __restrict__ goal,
+			  double const * __restrict__ pos,
+			  double const * __restrict__ vel,
+			  double * __restrict__ pos_next,
+			  double * __restrict__ vel_next,
+			  double * __restrict__ remaining)
+  {
+    // Each DOF follows (at most) five constant-acceleration segments:
+    // (A) slow down to maxvel, (B) brake to a standstill if we are
+    // moving away from the goal or would overshoot it, then the
+    // trapezoid or triangle toward the goal with (C) acceleration,
+    // (D) cruise, and (E) deceleration. Unneeded segments simply get
+    // zero duration.
+    
+    for (size_t ii(0); ii < ndof; ++ii) {
+      double const am(amax[ii]);
+      double const inv_am(1.0 / am);
+      double const vm(vmax[ii]);
+      double const gg(goal[ii]);
+      double pp(pos[ii]);
+      double vv(vel[ii]);
+      double rem(dt);
+      
+      double const sa(vv < 0 ? -1.0 : 1.0);
+      double const excess(sa * vv - vm);
+      double const ta((excess > 0 ? excess : 0.0) * inv_am);
+      double const pa(pp + ta * (vv - 0.5 * sa * am * ta));
+      double const va(vv - sa * am * ta);
+      
+      double const sb(va < 0 ? -1.0 : 1.0);
+      double const overshoot(sb * (0.5 * va * fabs(va) * inv_am - (gg - pa)));
+      double const tb((overshoot > 0 ? fabs(va) : 0.0) * inv_am);
+      double const pb(pa + tb * (va - 0.5 * sb * am * tb));
+      double const vb(va - sb * am * tb);
+      
+      double const sc(gg < pb ? -1.0 : 1.0);
+      double const dist(sc * (gg - pb));
+      double const uu(sc * vb);
+      double const vpeak_sqr(am * dist + 0.5 * uu * uu);
+      double const vpeak_tri(sqrt(vpeak_sqr > 0 ? vpeak_sqr : 0.0));
+      double const vpeak(vpeak_tri < vm ? vpeak_tri : vm);
+      double const accel(vpeak - uu);
+      double const tc((accel > 0 ? accel : 0.0) * inv_am);
+      double const cruise(dist - (vpeak * vpeak - 0.5 * uu * uu) * inv_am);
+      double const td((cruise > 0 ? cruise : 0.0) / (vpeak > 0 ? vpeak : 1.0));
+      double const te(vpeak * inv_am);
+      double const total(ta + tb + tc + td + te);
+      
+      advance_segment(pp, vv, rem, -sa * am, ta);
+      advance_segment(pp, vv, rem, -sb * am, tb);
+      advance_segment(pp, vv, rem, sc * am, tc);
+      advance_segment(pp, vv, rem, 0.0, td);
+      advance_segment(pp, vv, rem, -sc * am, te);
+      
+      // Snap onto the goal once the whole profile fits into this
+      // cycle, to avoid accumulating round-off at standstill.
+      pos_next[ii] = total > dt ? pp : gg;
+      vel_next[ii] = total > dt ? vv : 0.0;
+      remaining[ii] = total - dt;
+    }
+  }
+  
+  
+  int TypeIOTGUnsyncCursor::
+  next(Vector const & maxvel,
+       Vector const & maxacc,
+       Vector const & goal)
+  {
+    for (size_t ii(0); ii < ndof_; ++ii) {
+      if (selection_[ii]) {
+	if (maxvel[ii] < OTG_MIN_VALUE_FOR_MAXVELOCITY) {
+	  return TypeIOTG::OTG_MAX_VELOCITY_ERROR;
+	}
+	if (maxacc[ii] < OTG_MIN_VALUE_FOR_MAXACCELERATION) {
+	  return TypeIOTG::OTG_MAX_ACCELERATION_ERROR;
+	}
+      }
+    }
+    
+    // Unselected DOFs get computed as well (and then discarded), which
+    // is cheaper than breaking up the vectorized loop.
+    unsync_step(ndof_, dt_seconds_, maxvel.data(), maxacc.data(), goal.data(),
+		pos_.data(), vel_.data(), pos_next_.data(), vel_next_.data(), remaining_.data());
+    
+    int result(TypeIOTG::OTG_FINAL_STATE_REACHED);
+    for (size_t ii(0); ii < ndof_; ++ii) {
+      if (selection_[ii]) {
+	pos_[ii] = pos_next_[ii];
+	vel_[ii] = vel_next_[ii];
+	if (remaining_[ii] > 0) {
+	  result = TypeIOTG::OTG_WORKING;
+	}
+      }
+    }
+    return result;
+  }
+  
+  
   char const * otg_errstr(int otg_error_code)
   {
     switch (otg_error_code) {
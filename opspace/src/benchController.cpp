@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchController.cpp
+   \brief Latency of HierarchicalController::computeCommand() as the
+   number of prioritized tasks grows, with ClassicTaskPostureController
+   as two-task baseline.
+*/
+
+#include <opspace/skill_library.hpp>
+#include <opspace/ClassicTaskPostureController.hpp>
+#include <opspace/HierarchicalController.hpp>
+#include <jspace/test/model_library.hpp>
+#include <iostream>
+#include <sstream>
+#include <err.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using jspace::Model;
+using jspace::State;
+using namespace opspace;
+using boost::shared_ptr;
+using namespace std;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+static shared_ptr<Task> create_task(string const & name, Vector const & selection)
+{
+  SelectedJointPostureTask * task(new SelectedJointPostureTask(name));
+  Parameter * sel_p(task->lookupParameter("selection", PARAMETER_TYPE_VECTOR));
+  if ( ! sel_p) {
+    errx(EXIT_FAILURE, "failed to retrieve selection parameter");
+  }
+  Status const st(sel_p->set(selection));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "failed to set selection: %s", st.errstr.c_str());
+  }
+  return shared_ptr<Task>(task);
+}
+
+
+/**
+   Task k < ntasks-1 selects joints k and k+1 (modulo ndof), so
+   consecutive levels overlap and J*_k is rank deficient from time to
+   time. The last task is a full posture.
+*/
+static void fill_skill(GenericSkill & skill, size_t ntasks, size_t ndof)
+{
+  for (size_t ii(0); ii + 1 < ntasks; ++ii) {
+    Vector sel(Vector::Zero(ndof));
+    sel[ii % ndof] = 1;
+    sel[(ii + 1) % ndof] = 1;
+    ostringstream name;
+    name << "task" << ii;
+    skill.appendTask(create_task(name.str(), sel));
+  }
+  skill.appendTask(create_task("posture", Vector::Ones(ndof)));
+}
+
+
+static void bench(Controller & ctrl, Skill & skill, Model & model, int niter,
+		  double & mean_us, double & max_us)
+{
+  Status st(skill.init(model));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "skill init: %s", st.errstr.c_str());
+  }
+  st = ctrl.init(model);
+  if ( ! st) {
+    errx(EXIT_FAILURE, "controller init: %s", st.errstr.c_str());
+  }
+  Vector gamma;
+  mean_us = 0;
+  max_us = 0;
+  for (int ii(0); ii < niter; ++ii) {
+    double const t0(now());
+    st = ctrl.computeCommand(model, skill, gamma);
+    double const dt(1e6 * (now() - t0));
+    if ( ! st) {
+      errx(EXIT_FAILURE, "computeCommand: %s", st.errstr.c_str());
+    }
+    mean_us += dt;
+    if (dt > max_us) {
+      max_us = dt;
+    }
+  }
+  mean_us /= niter;
+}
+
+
+int main(int argc, char ** argv)
+{
+  int niter(10000);
+  size_t maxtasks(8);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-n" == opt) {
+      is >> niter;
+    }
+    else if ("-t" == opt) {
+      is >> maxtasks;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -n niter -t maxtasks)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  Model * puma;
+  try {
+    puma = jspace::test::create_puma_model();
+  }
+  catch (std::exception const & ee) {
+    errx(EXIT_FAILURE, "failed to create model: %s", ee.what());
+  }
+  size_t const ndof(puma->getNDOF());
+  State state(ndof, ndof, 0);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    state.position_[ii] = 0.01 * ii + 0.08;
+    state.velocity_[ii] = 0.02 - 0.005 * ii;
+  }
+  puma->update(state);
+  
+  double mean_us, max_us;
+  cout << "# " << ndof << " DOF, " << niter << " iterations\n"
+       << "# controller      ntasks  mean[us]  max[us]\n";
+  {
+    ClassicTaskPostureController ctrl("classic");
+    GenericSkill skill("classic");
+    fill_skill(skill, 2, ndof);
+    bench(ctrl, skill, *puma, niter, mean_us, max_us);
+    cout << "  classic\t  2\t  " << mean_us << "\t  " << max_us << "\n";
+  }
+  for (size_t ntasks(1); ntasks <= maxtasks; ++ntasks) {
+    HierarchicalController ctrl("hierarchical");
+    GenericSkill skill("hierarchical");
+    fill_skill(skill, ntasks, ndof);
+    bench(ctrl, skill, *puma, niter, mean_us, max_us);
+    cout << "  hierarchical\t  " << ntasks << "\t  " << mean_us << "\t  " << max_us << "\n";
+  }
+  
+  delete puma;
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchPDTask.cpp
+   \brief Time to compute a saturated PD command for each
+   PDTask::saturation_policy_t, using the per-component loops that
+   PDTask used to have versus the pd_saturation kernels, for 3-D
+   Cartesian tasks and for posture tasks of growing size.
+*/
+
+#include <opspace/task_library.hpp>
+#include <opspace/pd_saturation.hpp>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <err.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using namespace opspace;
+using namespace std;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+// Same order as the protected PDTask::saturation_policy_t.
+enum {
+  PD_OFF,
+  PD_COMPONENT_WISE,
+  PD_MAX_COMPONENT,
+  PD_NORM
+};
+
+
+struct pd_data_s {
+  Vector goalpos, curpos, goalvel, curvel, kp, kd, maxvel;
+  Vector errpos, errvel;
+};
+
+
+// What PDTask::computePDCommand() did before the kernels.
+static void loop_pd(int policy, pd_data_s & dd, Vector const & curpos, Vector & command)
+{
+  dd.errpos = dd.goalpos - curpos;
+  dd.errvel = dd.goalvel - dd.curvel;
+  
+  if (PD_NORM == policy) {
+    command = dd.kp[0] * dd.errpos;
+    if ((dd.maxvel[0] > 1e-4) && (dd.kd[0] > 1e-4)) {
+      double const sat(command.norm() / dd.maxvel[0] / dd.kd[0]);
+      if (sat > 1.0) {
+	command /= sat;
+      }
+    }
+    command += dd.kd[0] * dd.errvel;
+    return;
+  }
+  
+  command = dd.kp.cwise() * dd.errpos;
+  
+  if (PD_COMPONENT_WISE == policy) {
+    for (int ii(0); ii < command.rows(); ++ii) {
+      if ((dd.maxvel[ii] > 1e-4) && (dd.kd[ii] > 1e-4)) {
+	double const sat(fabs((command[ii] / dd.maxvel[ii]) / dd.kd[ii]));
+	if (sat > 1.0) {
+	  command[ii] /= sat;
+	}
+      }
+    }
+  }
+  else if (PD_MAX_COMPONENT == policy) {
+    double saturation(0.0);
+    for (int ii(0); ii < command.rows(); ++ii) {
+      if ((dd.maxvel[ii] > 1e-4) && (dd.kd[ii] > 1e-4)) {
+	double const sat(fabs((command[ii] / dd.maxvel[ii]) / dd.kd[ii]));
+	if (sat > saturation) {
+	  saturation = sat;
+	}
+      }
+    }
+    if (saturation > 1.0) {
+      command /= saturation;
+    }
+  }
+  
+  command += dd.kd.cwise() * dd.errvel;
+}
+
+
+static void kernel_pd(int policy, pd_data_s & dd, Vector const & curpos, Vector & command)
+{
+  pd_kernel_s pd;
+  pd.ndim = dd.goalpos.rows();
+  pd.goalpos = dd.goalpos.data();
+  pd.curpos = curpos.data();
+  pd.goalvel = dd.goalvel.data();
+  pd.curvel = dd.curvel.data();
+  pd.kp = dd.kp.data();
+  pd.kd = dd.kd.data();
+  pd.maxvel = dd.maxvel.data();
+  pd.errpos = dd.errpos.data();
+  pd.errvel = dd.errvel.data();
+  pd.command = command.data();
+  switch (policy) {
+  case PD_COMPONENT_WISE:
+    pdSaturateComponentWise(pd);
+    break;
+  case PD_MAX_COMPONENT:
+    pdSaturateMaxComponent(pd);
+    break;
+  case PD_NORM:
+    pdSaturateNorm(pd);
+    break;
+  default:
+    pdSaturateOff(pd);
+  }
+}
+
+
+static char const * policy_name(int policy)
+{
+  switch (policy) {
+  case PD_OFF: return "off";
+  case PD_COMPONENT_WISE: return "component";
+  case PD_MAX_COMPONENT: return "max_comp";
+  case PD_NORM: return "norm";
+  }
+  return "unknown";
+}
+
+
+static void bench(int policy, size_t ndim, int niter)
+{
+  pd_data_s dd;
+  dd.goalpos.resize(ndim);
+  dd.curpos.resize(ndim);
+  dd.goalvel.resize(ndim);
+  dd.curvel.resize(ndim);
+  dd.kp.resize(ndim);
+  dd.kd.resize(ndim);
+  dd.maxvel.resize(ndim);
+  dd.errpos.resize(ndim);
+  dd.errvel.resize(ndim);
+  for (size_t ii(0); ii < ndim; ++ii) {
+    dd.goalpos[ii] = sin(0.7 * ii + 0.3);
+    dd.curpos[ii] = 0.0;
+    dd.goalvel[ii] = 0.0;
+    dd.curvel[ii] = 0.2 * cos(0.9 * ii);
+    dd.kp[ii] = 100.0;
+    dd.kd[ii] = 20.0;
+    dd.maxvel[ii] = 0.5;
+  }
+  
+  // Nudge the current position a little on each iteration, so that
+  // saturation kicks in on some ticks but not on others, like on a
+  // real robot converging to its goal.
+  Vector curpos(dd.curpos), command(ndim);
+  double check(0);
+  double const t0(now());
+  for (int ii(0); ii < niter; ++ii) {
+    curpos[ii % ndim] = dd.goalpos[ii % ndim] * ((ii / ndim) % 2);
+    loop_pd(policy, dd, curpos, command);
+    check += command[ii % ndim];
+  }
+  double const loop_us(1e6 * (now() - t0) / niter);
+  
+  curpos = dd.curpos;
+  double const t1(now());
+  for (int ii(0); ii < niter; ++ii) {
+    curpos[ii % ndim] = dd.goalpos[ii % ndim] * ((ii / ndim) % 2);
+    kernel_pd(policy, dd, curpos, command);
+    check -= command[ii % ndim];
+  }
+  double const kernel_us(1e6 * (now() - t1) / niter);
+  
+  cout << "  " << policy_name(policy) << "\t  " << ndim
+       << "\t  " << loop_us << "\t  " << kernel_us
+       << "\t  " << loop_us / kernel_us
+       << "\t  " << fabs(check) << "\n";
+}
+
+
+int main(int argc, char ** argv)
+{
+  int niter(1000000);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-n" == opt) {
+      is >> niter;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -n niter)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  static int const policy[] = {
+    PD_OFF,
+    PD_COMPONENT_WISE,
+    PD_MAX_COMPONENT,
+    PD_NORM
+  };
+  static size_t const dims[] = { 3, 7, 38 };
+  
+  cout << "# " << niter << " iterations per run\n"
+       << "# policy  ndim  loop[us]  kernel[us]  speedup  |diff|\n";
+  for (size_t ipol(0); ipol < sizeof(policy) / sizeof(*policy); ++ipol) {
+    for (size_t idim(0); idim < sizeof(dims) / sizeof(*dims); ++idim) {
+      bench(policy[ipol], dims[idim], niter);
+    }
+  }
+}
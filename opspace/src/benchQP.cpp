@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchQP.cpp
+   \brief Solve time per tick of QPController::computeCommand() for
+   7, 20 and 40 DOF chains with active torque limits, with and without
+   warm-starting the active set.
+*/
+
+#include <opspace/skill_library.hpp>
+#include <opspace/QPController.hpp>
+#include <jspace/test/model_library.hpp>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <err.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using jspace::Model;
+using jspace::State;
+using namespace opspace;
+using boost::shared_ptr;
+using namespace std;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+static shared_ptr<Task> create_task(string const & name, Vector const & selection)
+{
+  SelectedJointPostureTask * task(new SelectedJointPostureTask(name));
+  Parameter * sel_p(task->lookupParameter("selection", PARAMETER_TYPE_VECTOR));
+  if ( ! sel_p) {
+    errx(EXIT_FAILURE, "failed to retrieve selection parameter");
+  }
+  Status const st(sel_p->set(selection));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "failed to set selection: %s", st.errstr.c_str());
+  }
+  return shared_ptr<Task>(task);
+}
+
+
+/** Slowly varying state, so that the torque limits move around a bit
+    from one tick to the next. */
+static void set_state(Model & model, size_t tick)
+{
+  size_t const ndof(model.getNDOF());
+  State state(ndof, ndof, 0);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    state.position_[ii] = 0.3 * sin(0.1 * ii + 1e-3 * tick);
+    state.velocity_[ii] = 0.5 * cos(0.2 * ii + 1e-3 * tick);
+  }
+  model.update(state);
+}
+
+
+static void bench(size_t ndof, int niter)
+{
+  Model * model;
+  try {
+    model = jspace::test::create_unit_mass_nR_model(ndof);
+  }
+  catch (std::exception const & ee) {
+    errx(EXIT_FAILURE, "failed to create model: %s", ee.what());
+  }
+  set_state(*model, 0);
+  
+  // a high-priority task on the first three joints, plus a posture
+  GenericSkill skill("skill");
+  Vector sel(Vector::Zero(ndof));
+  sel[0] = sel[1] = sel[2] = 1;
+  skill.appendTask(create_task("task", sel));
+  skill.appendTask(create_task("posture", Vector::Ones(ndof)));
+  Status st(skill.init(*model));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "skill init: %s", st.errstr.c_str());
+  }
+  
+  // Torque limits which cut the dynamic part of the unconstrained
+  // solution in half, so that many of them are active.
+  QPController ctrl("qp");
+  st = ctrl.init(*model);
+  if ( ! st) {
+    errx(EXIT_FAILURE, "controller init: %s", st.errstr.c_str());
+  }
+  Vector gamma;
+  st = ctrl.computeCommand(*model, skill, gamma);
+  if ( ! st) {
+    errx(EXIT_FAILURE, "computeCommand: %s", st.errstr.c_str());
+  }
+  Vector grav;
+  model->getGravity(grav);
+  Vector taumax(ndof);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    taumax[ii] = fabs(grav[ii]) + 0.5 * fabs(gamma[ii] - grav[ii]) + 1e-3;
+  }
+  ctrl.lookupParameter("taumax", PARAMETER_TYPE_VECTOR)->set(taumax);
+  
+  for (int warm(1); warm >= 0; --warm) {
+    ctrl.lookupParameter("warm_start", PARAMETER_TYPE_INTEGER)->set(warm);
+    st = ctrl.init(*model);
+    if ( ! st) {
+      errx(EXIT_FAILURE, "controller init: %s", st.errstr.c_str());
+    }
+    int const * iterations(ctrl.lookupParameter("iterations", PARAMETER_TYPE_INTEGER)->getInteger());
+    int const * nactive(ctrl.lookupParameter("nactive", PARAMETER_TYPE_INTEGER)->getInteger());
+    double mean_us(0), max_us(0), mean_iter(0), mean_active(0);
+    for (int ii(0); ii < niter; ++ii) {
+      set_state(*model, ii);
+      double const t0(now());
+      st = ctrl.computeCommand(*model, skill, gamma);
+      double const dt(1e6 * (now() - t0));
+      if ( ! st) {
+	errx(EXIT_FAILURE, "computeCommand: %s", st.errstr.c_str());
+      }
+      mean_us += dt;
+      if (dt > max_us) {
+	max_us = dt;
+      }
+      mean_iter += *iterations;
+      mean_active += *nactive;
+    }
+    cout << "  " << ndof << "\t  " << (warm ? "warm" : "cold")
+	 << "\t  " << mean_us / niter << "\t  " << max_us
+	 << "\t  " << mean_iter / niter << "\t  " << mean_active / niter << "\n";
+  }
+  
+  delete model;
+}
+
+
+int main(int argc, char ** argv)
+{
+  int niter(2000);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-n" == opt) {
+      is >> niter;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -n niter)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  cout << "# " << niter << " ticks per run\n"
+       << "# ndof  start  mean[us]  max[us]  iterations  active\n";
+  bench(7, niter);
+  bench(20, niter);
+  bench(40, niter);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchSparseJacobian.cpp
+   \brief Time to compute A^{-1} J^T and J A^{-1} J^T for a
+   three-dimensional task supported by 9 DOF, on chains of growing
+   length, using dense products versus SparseJacobian.
+*/
+
+#include <opspace/SparseJacobian.hpp>
+#include <jspace/test/model_library.hpp>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <err.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using jspace::Model;
+using jspace::State;
+using namespace opspace;
+using namespace std;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+static void bench(size_t ndof, size_t nsupport, int niter)
+{
+  Model * model;
+  try {
+    model = jspace::test::create_unit_mass_nR_model(ndof);
+  }
+  catch (std::exception const & ee) {
+    errx(EXIT_FAILURE, "failed to create model: %s", ee.what());
+  }
+  State state(ndof, ndof, 0);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    state.position_[ii] = 0.3 * sin(0.1 * ii);
+  }
+  model->update(state);
+  
+  // the task sits on the node which has nsupport joints above it
+  taoDNode const * node(model->getNode(nsupport - 1));
+  Matrix ainv, jac;
+  model->getInverseMassInertia(ainv);
+  model->computeLinearJacobian(node, 0.0, 0.0, 0.0, jac);
+  SparseJacobian sparse;
+  Status const st(sparse.init(*model, node, 3));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "sparse Jacobian init: %s", st.errstr.c_str());
+  }
+  
+  Matrix ainv_jt(ndof, 3), lambda_inv(3, 3);
+  double const t0(now());
+  for (int ii(0); ii < niter; ++ii) {
+    ainv_jt = (ainv * jac.transpose()).lazy();
+    lambda_inv = (jac * ainv_jt).lazy();
+  }
+  double const dense_us(1e6 * (now() - t0) / niter);
+  double const check(lambda_inv.sum());
+  
+  double const t1(now());
+  for (int ii(0); ii < niter; ++ii) {
+    sparse.gather(jac);
+    computeSparseAinvJt(sparse, ainv, ainv_jt);
+    computeSparseLambdaInverse(sparse, ainv_jt, lambda_inv);
+  }
+  double const sparse_us(1e6 * (now() - t1) / niter);
+  
+  cout << "  " << ndof << "\t  " << nsupport
+       << "\t  " << dense_us << "\t  " << sparse_us
+       << "\t  " << dense_us / sparse_us
+       << "\t  " << fabs(check - lambda_inv.sum()) << "\n";
+  
+  delete model;
+}
+
+
+int main(int argc, char ** argv)
+{
+  int niter(20000);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-n" == opt) {
+      is >> niter;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -n niter)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  cout << "# " << niter << " iterations per run\n"
+       << "# ndof  nsupport  dense[us]  sparse[us]  speedup  |diff|\n";
+  bench(10, 9, niter);
+  bench(20, 9, niter);
+  bench(38, 9, niter);
+  bench(80, 9, niter);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file dumpParameterLog.cpp
+   \brief Convert binary ParameterRingLog files to the text format
+   of ParameterLog::writeFiles().
+*/
+
+#include <opspace/ParameterRingLog.hpp>
+#include <iostream>
+#include <err.h>
+#include <stdlib.h>
+
+using namespace opspace;
+using namespace std;
+
+
+int main(int argc, char ** argv)
+{
+  if ((argc < 2) || (argc > 3)) {
+    errx(EXIT_FAILURE, "usage: %s logfile [prefix]", argv[0]);
+  }
+  string const filename(argv[1]);
+  string prefix(filename);
+  if (argc > 2) {
+    prefix = argv[2];
+  }
+  else {
+    string::size_type const dot(prefix.rfind('.'));
+    if ((string::npos != dot) && (string::npos == prefix.find('/', dot))) {
+      prefix.erase(dot);
+    }
+  }
+  
+  Status const st(convertParameterLog(filename, prefix, &cout));
+  if ( ! st) {
+    errx(EXIT_FAILURE, "%s", st.errstr.c_str());
+  }
+}
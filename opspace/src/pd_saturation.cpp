@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2011 The Board of Trustees of The Leland Stanford Junior University. All rights reserved.
+ *
+ * Author: Roland Philippsen
+ *         http://cs.stanford.edu/group/manips/
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+#include <opspace/pd_saturation.hpp>
+#include <cmath>
+
+
+namespace opspace {
+  
+  namespace {
+    
+    // Velocity limits at or below this get treated as "no limit",
+    // just like gains, to avoid divisions by zero.
+    double const min_limit(1e-4);
+    
+    
+    // The kernels are templates on the dimension: fixed_ndim > 0
+    // yields a fully unrolled instance, zero means the ndim
+    // argument. The __restrict__ qualifiers tell the compiler that
+    // the outputs do not alias the inputs, so it does not have to add
+    // runtime overlap checks around the vectorized loops (which it
+    // gives up on for this many arrays). GCC only honors them on
+    // function parameters, hence the long argument lists.
+    
+#define PD_KERNEL_ARGS						\
+    size_t ndim_arg,						\
+      double const * __restrict__ goalpos,			\
+      double const * __restrict__ curpos,			\
+      double const * __restrict__ goalvel,			\
+      double const * __restrict__ curvel,			\
+      double const * __restrict__ kp,				\
+      double const * __restrict__ kd,				\
+      double const * __restrict__ maxvel,			\
+      double * __restrict__ errpos,				\
+      double * __restrict__ errvel,				\
+      double * __restrict__ command
+    
+#define PD_KERNEL_CALL(kernel, pd)					\
+    kernel((pd).ndim, (pd).goalpos, (pd).curpos, (pd).goalvel, (pd).curvel, \
+	   (pd).kp, (pd).kd, (pd).maxvel, (pd).errpos, (pd).errvel, (pd).command)
+    
+    
+    template<size_t fixed_ndim>
+    void saturate_off(PD_KERNEL_ARGS)
+    {
+      size_t const ndim(fixed_ndim > 0 ? fixed_ndim : ndim_arg);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	double const ep(goalpos[ii] - curpos[ii]);
+	double const ev(goalvel[ii] - curvel[ii]);
+	errpos[ii] = ep;
+	errvel[ii] = ev;
+	command[ii] = kp[ii] * ep + kd[ii] * ev;
+      }
+    }
+    
+    
+    template<size_t fixed_ndim>
+    void saturate_component_wise(PD_KERNEL_ARGS)
+    {
+      size_t const ndim(fixed_ndim > 0 ? fixed_ndim : ndim_arg);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	double const ep(goalpos[ii] - curpos[ii]);
+	double const ev(goalvel[ii] - curvel[ii]);
+	errpos[ii] = ep;
+	errvel[ii] = ev;
+	// Dividing kp * ep by its saturation |kp * ep / maxvel / kd|
+	// amounts to clamping it to +/- maxvel * kd.
+	bool const limited((maxvel[ii] > min_limit) & (kd[ii] > min_limit));
+	double const limit(limited ? maxvel[ii] * kd[ii] : HUGE_VAL);
+	double cc(kp[ii] * ep);
+	cc = (cc > limit) ? limit : cc;
+	cc = (cc < -limit) ? -limit : cc;
+	command[ii] = cc + kd[ii] * ev;
+      }
+    }
+    
+    
+    template<size_t fixed_ndim>
+    void saturate_max_component(PD_KERNEL_ARGS)
+    {
+      size_t const ndim(fixed_ndim > 0 ? fixed_ndim : ndim_arg);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	double const ep(goalpos[ii] - curpos[ii]);
+	errpos[ii] = ep;
+	errvel[ii] = goalvel[ii] - curvel[ii];
+	command[ii] = kp[ii] * ep;
+      }
+      
+      // Kept separate because GCC does not vectorize IEEE max
+      // reductions (not without -ffinite-math-only), but it still
+      // compiles to branch-free maxsd. Unlimited components divide
+      // by infinity, which yields zero.
+      double saturation(0);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	bool const limited((maxvel[ii] > min_limit) & (kd[ii] > min_limit));
+	double const limit(limited ? maxvel[ii] * kd[ii] : HUGE_VAL);
+	double const sat(fabs(command[ii]) / limit);
+	saturation = (sat > saturation) ? sat : saturation;
+      }
+      
+      double const scale((saturation > 1.0) ? 1.0 / saturation : 1.0);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	command[ii] = scale * command[ii] + kd[ii] * errvel[ii];
+      }
+    }
+    
+    
+    template<size_t fixed_ndim>
+    void saturate_norm(PD_KERNEL_ARGS)
+    {
+      size_t const ndim(fixed_ndim > 0 ? fixed_ndim : ndim_arg);
+      double sqnorm(0);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	double const ep(goalpos[ii] - curpos[ii]);
+	errpos[ii] = ep;
+	errvel[ii] = goalvel[ii] - curvel[ii];
+	sqnorm += ep * ep;
+      }
+      
+      double const norm(fabs(kp[0]) * sqrt(sqnorm));
+      bool const limited((maxvel[0] > min_limit) && (kd[0] > min_limit));
+      double const limit(maxvel[0] * kd[0]);
+      double const kp_scaled((limited && (norm > limit)) ? kp[0] * limit / norm : kp[0]);
+      double const kd_norm(kd[0]);
+      for (size_t ii(0); ii < ndim; ++ii) {
+	command[ii] = kp_scaled * errpos[ii] + kd_norm * errvel[ii];
+      }
+    }
+    
+  }
+  
+  
+  void pdSaturateOff(pd_kernel_s const & pd)
+  {
+    if (3 == pd.ndim) {
+      PD_KERNEL_CALL(saturate_off<3>, pd);
+    }
+    else {
+      PD_KERNEL_CALL(saturate_off<0>, pd);
+    }
+  }
+  
+  
+  void pdSaturateComponentWise(pd_kernel_s const & pd)
+  {
+    if (3 == pd.ndim) {
+      PD_KERNEL_CALL(saturate_component_wise<3>, pd);
+    }
+    else {
+      PD_KERNEL_CALL(saturate_component_wise<0>, pd);
+    }
+  }
+  
+  
+  void pdSaturateMaxComponent(pd_kernel_s const & pd)
+  {
+    if (3 == pd.ndim) {
+      PD_KERNEL_CALL(saturate_max_component<3>, pd);
+    }
+    else {
+      PD_KERNEL_CALL(saturate_max_component<0>, pd);
+    }
+  }
+  
+  
+  void pdSaturateNorm(pd_kernel_s const & pd)
+  {
+    if (3 == pd.ndim) {
+      PD_KERNEL_CALL(saturate_norm<3>, pd);
+    }
+    else {
+      PD_KERNEL_CALL(saturate_norm<0>, pd);
+    }
+  }
+  
+}
@@ -26,11 +26,132 @@
 #include <opspace/pseudo_inverse.hpp>
 #include <Eigen/LU>
 #include <Eigen/SVD>
+#include <Eigen/Cholesky>
+#include <Eigen/QR>
+#include <cmath>
 
 using namespace std;
 
 namespace opspace {
 
+  namespace {
+    
+    /**
+       Lower bound on the smallest eigenvalue of a positive definite
+       matrix, given its inverse: the infinity norm of the inverse
+       bounds its spectral radius from above.
+    */
+    template<typename matrix_t>
+    double min_eigenvalue_bound(matrix_t const & inv)
+    {
+      double maxrow(0);
+      for (int ii(0); ii < inv.rows(); ++ii) {
+	double row(0);
+	for (int jj(0); jj < inv.cols(); ++jj) {
+	  row += fabs(inv.coeff(ii, jj));
+	}
+	if (row > maxrow) {
+	  maxrow = row;
+	}
+      }
+      if (maxrow <= 0) {
+	return 0;
+      }
+      return 1.0 / maxrow;
+    }
+    
+    
+    template<typename rhs_t>
+    void forward_substitute(Matrix const & lower, rhs_t & rhs)
+    {
+      int const nn(lower.rows());
+      for (int col(0); col < rhs.cols(); ++col) {
+	for (int ii(0); ii < nn; ++ii) {
+	  double val(rhs.coeff(ii, col));
+	  for (int kk(0); kk < ii; ++kk) {
+	    val -= lower.coeff(ii, kk) * rhs.coeff(kk, col);
+	  }
+	  rhs.coeffRef(ii, col) = val / lower.coeff(ii, ii);
+	}
+      }
+    }
+    
+    
+    template<typename rhs_t>
+    void back_substitute(Matrix const & lower, rhs_t & rhs)
+    {
+      int const nn(lower.rows());
+      for (int col(0); col < rhs.cols(); ++col) {
+	for (int ii(nn - 1); ii >= 0; --ii) {
+	  double val(rhs.coeff(ii, col));
+	  for (int kk(ii + 1); kk < nn; ++kk) {
+	    val -= lower.coeff(kk, ii) * rhs.coeff(kk, col);
+	  }
+	  rhs.coeffRef(ii, col) = val / lower.coeff(ii, ii);
+	}
+      }
+    }
+    
+    
+    template<typename matrix_t, typename vector_t>
+    void symmetric_pinv(matrix_t const & matrix,
+			double sigmaThreshold,
+			matrix_t & invMatrix,
+			vector_t * opt_sigmaOut)
+    {
+      int const nn(matrix.rows());
+      invMatrix.resize(nn, nn);
+      
+      if (opt_sigmaOut) {
+	// The eigenvalues are needed anyway, and computing them without
+	// eigenvectors is much cheaper than a full decomposition. They
+	// also tell us exactly whether the Cholesky path is valid.
+	Eigen::SelfAdjointEigenSolver<matrix_t> eig(matrix, false);
+	opt_sigmaOut->resize(nn);
+	for (int ii(0); ii < nn; ++ii) {
+	  opt_sigmaOut->coeffRef(ii) = eig.eigenvalues().coeff(nn - 1 - ii);
+	}
+	if (opt_sigmaOut->coeff(nn - 1) > sigmaThreshold) {
+	  Eigen::LLT<matrix_t> llt(matrix);
+	  if (llt.isPositiveDefinite()) {
+	    invMatrix.setIdentity();
+	    llt.solveInPlace(invMatrix);
+	    return;
+	  }
+	}
+      }
+      else {
+	Eigen::LLT<matrix_t> llt(matrix);
+	if (llt.isPositiveDefinite()) {
+	  invMatrix.setIdentity();
+	  llt.solveInPlace(invMatrix);
+	  if (min_eigenvalue_bound(invMatrix) > sigmaThreshold) {
+	    return;
+	  }
+	}
+      }
+      
+      // Rank deficient or badly conditioned: threshold the eigenvalues
+      // the same way pseudoInverse() thresholds the singular values.
+      Eigen::SelfAdjointEigenSolver<matrix_t> eig(matrix);
+      invMatrix.setZero();
+      for (int kk(0); kk < nn; ++kk) {
+	double const ev(eig.eigenvalues().coeff(kk));
+	if (ev > sigmaThreshold) {
+	  double const scale(1.0 / ev);
+	  for (int ii(0); ii < nn; ++ii) {
+	    double const vi(scale * eig.eigenvectors().coeff(ii, kk));
+	    for (int jj(0); jj < nn; ++jj) {
+	      invMatrix.coeffRef(ii, jj) += vi * eig.eigenvectors().coeff(jj, kk);
+	    }
+	  }
+	}
+      }
+    }
+    
+  }
+  
+  
   void pseudoInverse(Matrix const & matrix,
 		     double sigmaThreshold,
 		     Matrix & invMatrix,
@@ -68,4 +189,117 @@ namespace opspace {
     }
   }
   
+  
+  void symmetricPseudoInverse(Matrix const & matrix,
+			      double sigmaThreshold,
+			      Matrix & invMatrix,
+			      Vector * opt_sigmaOut)
+  {
+    if ((1 == matrix.rows()) && (1 == matrix.cols())) {
+      // same workaround for Eigen2 as in pseudoInverse()
+      pseudoInverse(matrix, sigmaThreshold, invMatrix, opt_sigmaOut);
+      return;
+    }
+    symmetric_pinv(matrix, sigmaThreshold, invMatrix, opt_sigmaOut);
+  }
+  
+  
+  bool choleskyFactor(Matrix const & matrix, Matrix & lower)
+  {
+    int const nn(matrix.rows());
+    if ((lower.rows() != nn) || (lower.cols() != nn)) {
+      lower.resize(nn, nn);
+    }
+    for (int jj(0); jj < nn; ++jj) {
+      double diag(matrix.coeff(jj, jj));
+      for (int kk(0); kk < jj; ++kk) {
+	diag -= lower.coeff(jj, kk) * lower.coeff(jj, kk);
+      }
+      if (diag <= 0) {
+	return false;
+      }
+      diag = sqrt(diag);
+      lower.coeffRef(jj, jj) = diag;
+      for (int ii(jj + 1); ii < nn; ++ii) {
+	double val(matrix.coeff(ii, jj));
+	for (int kk(0); kk < jj; ++kk) {
+	  val -= lower.coeff(ii, kk) * lower.coeff(jj, kk);
+	}
+	lower.coeffRef(ii, jj) = val / diag;
+      }
+    }
+    return true;
+  }
+  
+  
+  void choleskyForwardSubstitute(Matrix const & lower, Vector & rhs)
+  {
+    forward_substitute(lower, rhs);
+  }
+  
+  
+  void choleskyForwardSubstitute(Matrix const & lower, Matrix & rhs)
+  {
+    forward_substitute(lower, rhs);
+  }
+  
+  
+  void choleskyBackSubstitute(Matrix const & lower, Vector & rhs)
+  {
+    back_substitute(lower, rhs);
+  }
+  
+  
+  void choleskyBackSubstitute(Matrix const & lower, Matrix & rhs)
+  {
+    back_substitute(lower, rhs);
+  }
+  
+  
+  bool symmetricPseudoInverse(Matrix const & matrix,
+			      double sigmaThreshold,
+			      Matrix & invMatrix,
+			      Matrix & workspace)
+  {
+    int const nn(matrix.rows());
+    if ((workspace.rows() != nn) || (workspace.cols() != nn)) {
+      workspace.resize(nn, nn);
+    }
+    if ((invMatrix.rows() != nn) || (invMatrix.cols() != nn)) {
+      invMatrix.resize(nn, nn);
+    }
+    
+    if ( ! choleskyFactor(matrix, workspace)) {
+      symmetricPseudoInverse(matrix, sigmaThreshold, invMatrix, 0);
+      return false;
+    }
+    invMatrix.setIdentity();
+    choleskyForwardSubstitute(workspace, invMatrix);
+    choleskyBackSubstitute(workspace, invMatrix);
+    
+    if (min_eigenvalue_bound(invMatrix) > sigmaThreshold) {
+      return true;
+    }
+    symmetricPseudoInverse(matrix, sigmaThreshold, invMatrix, 0);
+    return false;
+  }
+  
+  
+  void symmetricPseudoInverse(Eigen::Matrix3d const & matrix,
+			      double sigmaThreshold,
+			      Eigen::Matrix3d & invMatrix,
+			      Eigen::Vector3d * opt_sigmaOut)
+  {
+    symmetric_pinv(matrix, sigmaThreshold, invMatrix, opt_sigmaOut);
+  }
+  
+  
+  void symmetricPseudoInverse(Eigen::Matrix<double, 6, 6> const & matrix,
+			      double sigmaThreshold,
+			      Eigen::Matrix<double, 6, 6> & invMatrix,
+			      Eigen::Matrix<double, 6, 1> * opt_sigmaOut)
+  {
+    symmetric_pinv(matrix, sigmaThreshold, invMatrix, opt_sigmaOut);
+  }
+  
 }
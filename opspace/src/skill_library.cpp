@@ -53,25 +53,32 @@ namespace opspace {
   
   
   Status GenericSkill::
-  update(Model const & model)
+  prepare(Model const & model)
   {
-    Status st;
-    if ( task_table_.empty()) {
-      st.ok = false;
-      st.errstr = "empty task table, did you assign any? did you forget to init()?";
+    Status const st(Skill::prepare(model));
+    if ( ! st) {
+      return st;
     }
-    else {
-      for (size_t ii(0); ii < task_table_.size(); ++ii) {
-	st = task_table_[ii]->update(model);
-	if ( ! st) {
-	  return st;
-	}
+    if (task_table_.empty()) {
+      for (size_t ii(0); ii < slot_->getNInstances(); ++ii) {
+	task_table_.push_back(slot_->getInstance(ii).get());
       }
     }
     return st;
   }
   
   
+  RTStatus GenericSkill::
+  update(Model const & model)
+  {
+    if ( task_table_.empty()) {
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED,
+		      "empty task table, did you assign any? did you forget to init()?");
+    }
+    return updateTasks(model, task_table_);
+  }
+  
+  
   Skill::task_table_t const * GenericSkill::
   getTaskTable()
   {
@@ -102,23 +109,33 @@ namespace opspace {
     if ( ! st) {
       return st;
     }
-    task_table_.push_back(eepos_);
-    task_table_.push_back(posture_);
+    if (task_table_.empty()) {
+      task_table_.push_back(eepos_);
+      task_table_.push_back(posture_);
+    }
     return st;
   }
   
   
   Status TaskPostureSkill::
-  update(Model const & model)
+  prepare(Model const & model)
   {
-    for (size_t ii(0); ii < task_table_.size(); ++ii) {
-      Status const st(task_table_[ii]->update(model));
-      if ( ! st) {
-	return st;
-      }
+    Status st(Skill::prepare(model));
+    if ( ! st) {
+      return st;
     }
-    Status ok;
-    return ok;
+    if (task_table_.empty()) {
+      task_table_.push_back(eepos_);
+      task_table_.push_back(posture_);
+    }
+    return st;
+  }
+  
+  
+  RTStatus TaskPostureSkill::
+  update(Model const & model)
+  {
+    return updateTasks(model, task_table_);
   }
   
   
@@ -129,18 +146,18 @@ namespace opspace {
   }
   
   
-  Status TaskPostureSkill::
+  RTStatus TaskPostureSkill::
   checkJStarSV(Task const * task, Vector const & sv)
   {
     if (task == eepos_) {
       if (sv.rows() != 3) {
-	return Status(false, "eepos dimension mismatch");
+	return RTStatus(jspace::STATUS_INVALID_DIMENSION, "eepos dimension mismatch");
       }
       if (sv[2] < eepos_->getSigmaThreshold()) {
-	return Status(false, "singular eepos");
+	return RTStatus(jspace::STATUS_NUMERIC_ERROR, "singular eepos");
       }
     }
-    Status ok;
+    RTStatus ok;
     return ok;
   }
 
@@ -161,23 +178,33 @@ namespace opspace {
     if ( ! st) {
       return st;
     }
-    task_table_.push_back(eepos_);
-    task_table_.push_back(posture_);
+    if (task_table_.empty()) {
+      task_table_.push_back(eepos_);
+      task_table_.push_back(posture_);
+    }
     return st;
   }
   
   
   Status TaskPostureTrjSkill::
-  update(Model const & model)
+  prepare(Model const & model)
   {
-    for (size_t ii(0); ii < task_table_.size(); ++ii) {
-      Status const st(task_table_[ii]->update(model));
-      if ( ! st) {
-	return st;
-      }
+    Status st(Skill::prepare(model));
+    if ( ! st) {
+      return st;
     }
-    Status ok;
-    return ok;
+    if (task_table_.empty()) {
+      task_table_.push_back(eepos_);
+      task_table_.push_back(posture_);
+    }
+    return st;
+  }
+  
+  
+  RTStatus TaskPostureTrjSkill::
+  update(Model const & model)
+  {
+    return updateTasks(model, task_table_);
   }
   
   
@@ -188,18 +215,18 @@ namespace opspace {
   }
   
   
-  Status TaskPostureTrjSkill::
+  RTStatus TaskPostureTrjSkill::
   checkJStarSV(Task const * task, Vector const & sv)
   {
     if (task == eepos_) {
       if (sv.rows() != 3) {
-	return Status(false, "eepos dimension mismatch");
+	return RTStatus(jspace::STATUS_INVALID_DIMENSION, "eepos dimension mismatch");
       }
       if (sv[2] < eepos_->getSigmaThreshold()) {
-	return Status(false, "singular eepos");
+	return RTStatus(jspace::STATUS_NUMERIC_ERROR, "singular eepos");
       }
     }
-    Status ok;
+    RTStatus ok;
     return ok;
   }
   
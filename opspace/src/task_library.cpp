@@ -25,10 +25,33 @@
 
 #include <opspace/task_library.hpp>
 #include <opspace/TypeIOTGCursor.hpp>
+#include <opspace/pd_saturation.hpp>
 
 using jspace::pretty_print;
 
 namespace opspace {
+  
+  
+  // Keep the SparseJacobian of a Cartesian task in sync with its
+  // dense jacobian. Looking up the supporting DOF allocates, so it
+  // only happens when the end effector node changes, which normally
+  // means in init() or prepare(). On failure, sparse_node gets
+  // cleared and the task falls back to the dense Jacobian.
+  static void gather_sparse_jacobian(Model const & model,
+				     taoDNode const * node,
+				     Matrix const & jacobian,
+				     taoDNode const * & sparse_node,
+				     SparseJacobian & sparse)
+  {
+    if (sparse_node != node) {
+      sparse_node = 0;
+      if ( ! sparse.init(model, node, jacobian.rows())) {
+	return;
+      }
+      sparse_node = node;
+    }
+    sparse.gather(jacobian);
+  }
 
 
   PDTask::
@@ -85,10 +108,8 @@ namespace opspace {
   
   
   Status PDTask::
-  initPDTask(Vector const & initpos)
+  preparePDTask(size_t ndim)
   {
-    int const ndim(initpos.rows());
-    
     if (SATURATION_NORM == saturation_policy_) {
       if (1 != kp_.rows()) {
 	return Status(false, "kp must be one-dimensional for SATURATION_NORM policy");
@@ -127,11 +148,18 @@ namespace opspace {
       }
     }
     
-    goalpos_ = initpos;
-    goalvel_ = Vector::Zero(ndim);
-    errpos_ = Vector::Zero(ndim);
-    errvel_ = Vector::Zero(ndim);
-    initialized_ = true;
+    if (ndim != goalpos_.rows()) {
+      goalpos_.resize(ndim);
+    }
+    if (ndim != goalvel_.rows()) {
+      goalvel_.resize(ndim);
+    }
+    if (ndim != errpos_.rows()) {
+      errpos_.resize(ndim);
+    }
+    if (ndim != errvel_.rows()) {
+      errvel_.resize(ndim);
+    }
     
     Status ok;
     return ok;
@@ -139,65 +167,71 @@ namespace opspace {
   
   
   Status PDTask::
+  initPDTask(Vector const & initpos)
+  {
+    Status const st(preparePDTask(initpos.rows()));
+    if ( ! st) {
+      return st;
+    }
+    
+    goalpos_ = initpos;
+    goalvel_.setZero();
+    errpos_.setZero();
+    errvel_.setZero();
+    initialized_ = true;
+    
+    return st;
+  }
+  
+  
+  RTStatus PDTask::
   computePDCommand(Vector const & curpos,
 		   Vector const & curvel,
 		   Vector & command)
   {
-    Status st;
+    RTStatus st;
     if ( ! initialized_) {
-      st.ok = false;
-      st.errstr = "not initialized";
-      return st;
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "not initialized");
     }
     
-    errpos_ = goalpos_ - curpos;
-    errvel_ = goalvel_ - curvel;
-    
-    if (SATURATION_NORM == saturation_policy_) {
-      command = kp_[0] * errpos_;
-      if ((maxvel_[0] > 1e-4) && (kd_[0] > 1e-4)) { // beware of div by zero
-	double const sat(command.norm() / maxvel_[0] / kd_[0]);
-	if (sat > 1.0) {
-	  command /= sat;
-	}
-      }
-      command += kd_[0] * errvel_;
-      return st;
-    }    
-    
-    command = kp_.cwise() * errpos_;
-    
-    if (SATURATION_COMPONENT_WISE == saturation_policy_) {
-      for (int ii(0); ii < command.rows(); ++ii) {
-	if ((maxvel_[ii] > 1e-4) && (kd_[ii] > 1e-4)) { // beware of div by zero
-	  double const sat(fabs((command[ii] / maxvel_[ii]) / kd_[ii]));
-	  if (sat > 1.0) {
-	    command[ii] /= sat;
-	  }
-	}
-      }
+    size_t const ndim(goalpos_.rows());
+    if ((static_cast<size_t>(curpos.rows()) != ndim)
+	|| (static_cast<size_t>(curvel.rows()) != ndim)) {
+      return RTStatus(jspace::STATUS_INVALID_DIMENSION, "invalid position or velocity dimension");
     }
-    
-    else if (SATURATION_MAX_COMPONENT == saturation_policy_) {
-      double saturation(0.0);
-      for (int ii(0); ii < command.rows(); ++ii) {
-	if ((maxvel_[ii] > 1e-4) && (kd_[ii] > 1e-4)) { // beware of div by zero
-	  double const sat(fabs((command[ii] / maxvel_[ii]) / kd_[ii]));
-	  if (sat > saturation) {
-	    saturation = sat;
-	  }
-	}
-      }
-      if (saturation > 1.0) {
-	command /= saturation;
-      }
+    if (static_cast<size_t>(command.rows()) != ndim) {
+      command.resize(ndim);
     }
     
-    // else (...) : other saturation policies would go here. For now
-    // we silently assume that any other value of saturation_policy
-    // means SATURATION_OFF.
+    pd_kernel_s pd;
+    pd.ndim = ndim;
+    pd.goalpos = goalpos_.data();
+    pd.curpos = curpos.data();
+    pd.goalvel = goalvel_.data();
+    pd.curvel = curvel.data();
+    pd.kp = kp_.data();
+    pd.kd = kd_.data();
+    pd.maxvel = maxvel_.data();
+    pd.errpos = errpos_.data();
+    pd.errvel = errvel_.data();
+    pd.command = command.data();
     
-    command += kd_.cwise() * errvel_;
+    switch (saturation_policy_) {
+    case SATURATION_COMPONENT_WISE:
+      pdSaturateComponentWise(pd);
+      break;
+    case SATURATION_MAX_COMPONENT:
+      pdSaturateMaxComponent(pd);
+      break;
+    case SATURATION_NORM:
+      pdSaturateNorm(pd);
+      break;
+    default:
+      // other saturation policies would go here. For now we silently
+      // assume that any other value of saturation_policy means
+      // SATURATION_OFF.
+      pdSaturateOff(pd);
+    }
     
     return st;
   }
@@ -314,12 +348,12 @@ namespace opspace {
   }
   
   
-  Status DraftPIDTask::
+  RTStatus DraftPIDTask::
   computeDraftPIDCommand(Vector const & curpos,
 			 Vector const & curvel,
 			 Vector & command)
   {
-    Status st(computePDCommand(curpos, curvel, command));
+    RTStatus st(computePDCommand(curpos, curvel, command));
     if ( ! st) {
       return st;
     }
@@ -372,7 +406,7 @@ namespace opspace {
   }
   
   
-  Status DraftPIDTask::
+  RTStatus DraftPIDTask::
   update(Model const & model)
   {
     actual_ = model.getState().position_;
@@ -404,10 +438,15 @@ namespace opspace {
     : PDTask(name, PDTask::SATURATION_NORM),
       end_effector_name_(""),
       control_point_(Vector::Zero(3)),
-      end_effector_node_(0)
+      end_effector_node_(0),
+      jacobian_cache_hits_(0),
+      jacobian_cache_misses_(0),
+      sparse_node_(0)
   {
     declareParameter("end_effector", &end_effector_name_, PARAMETER_FLAG_NOLOG);
     declareParameter("control_point", &control_point_, PARAMETER_FLAG_NOLOG);
+    declareParameter("jacobian_cache_hits", &jacobian_cache_hits_, PARAMETER_FLAG_NOLOG);
+    declareParameter("jacobian_cache_misses", &jacobian_cache_misses_, PARAMETER_FLAG_NOLOG);
   }
   
   
@@ -429,18 +468,33 @@ namespace opspace {
   
   
   Status CartPosTask::
-  update(Model const & model)
+  prepare(Model const & model)
   {
-    end_effector_node_ = updateActual(model);
+    if (end_effector_name_.empty()) {
+      return Status(false, "no end_effector");
+    }
+    if (3 != control_point_.rows()) {
+      return Status(false, "control_point must have 3 dimensions");
+    }
+    end_effector_node_ = model.getNodeByName(end_effector_name_);
     if ( ! end_effector_node_) {
       return Status(false, "invalid end_effector");
     }
-    
-    Matrix Jfull;
-    if ( ! model.computeJacobian(end_effector_node_, actual_[0], actual_[1], actual_[2], Jfull)) {
-      return Status(false, "failed to compute Jacobian (unsupported joint type?)");
+    actual_.resize(3);
+    jacobian_.resize(3, model.getNDOF());
+    gather_sparse_jacobian(model, end_effector_node_, jacobian_, sparse_node_, sparse_jacobian_);
+    return preparePDTask(3);
+  }
+  
+  
+  RTStatus CartPosTask::
+  update(Model const & model)
+  {
+    end_effector_node_ = updateActual(model);
+    if ( ! end_effector_node_) {
+      return RTStatus(jspace::STATUS_FAILED,
+		      "invalid end_effector or failed to compute Jacobian (unsupported joint type?)");
     }
-    jacobian_ = Jfull.block(0, 0, 3, Jfull.cols());
     
     return computePDCommand(actual_,
 			    jacobian_ * model.getState().velocity_,
@@ -467,17 +521,34 @@ namespace opspace {
     }
     if (end_effector_node_) {
       jspace::Transform ee_transform;
-      model.computeGlobalFrame(end_effector_node_,
-			       control_point_[0],
-			       control_point_[1],
-			       control_point_[2],
-			       ee_transform);
+      bool hit;
+      if ( ! model.getCachedFrameJacobian(end_effector_node_, control_point_,
+					  ee_transform, &jacobian_, 0, &hit)) {
+	return 0;
+      }
+      if (hit) {
+	++jacobian_cache_hits_;
+      }
+      else {
+	++jacobian_cache_misses_;
+      }
       actual_ = ee_transform.translation();
+      gather_sparse_jacobian(model, end_effector_node_, jacobian_, sparse_node_, sparse_jacobian_);
     }
     return end_effector_node_;
   }
   
   
+  SparseJacobian const * CartPosTask::
+  getSparseJacobian() const
+  {
+    if (sparse_node_ && (sparse_node_ == end_effector_node_)) {
+      return &sparse_jacobian_;
+    }
+    return 0;
+  }
+  
+  
   JPosTask::
   JPosTask(std::string const & name)
     : PDTask(name, PDTask::SATURATION_COMPONENT_WISE)
@@ -495,6 +566,16 @@ namespace opspace {
   
   
   Status JPosTask::
+  prepare(Model const & model)
+  {
+    size_t const ndof(model.getNDOF());
+    jacobian_ = Matrix::Identity(ndof, ndof);
+    actual_.resize(ndof);
+    return preparePDTask(ndof);
+  }
+  
+  
+  RTStatus JPosTask::
   update(Model const & model)
   {
     actual_ = model.getState().position_;
@@ -547,14 +628,12 @@ namespace opspace {
   }
   
   
-  Status SelectedJointPostureTask::
+  RTStatus SelectedJointPostureTask::
   update(Model const & model)
   {
-    Status st;
+    RTStatus st;
     if ( ! initialized_) {
-      st.ok = false;
-      st.errstr = "not initialized";
-      return st;
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "not initialized");
     }
     Vector vel(actual_.rows());
     for (size_t ii(0); ii < active_joints_.size(); ++ii) {
@@ -610,9 +689,9 @@ namespace opspace {
   
   
   Status TrajectoryTask::
-  initTrajectoryTask(Vector const & initpos)
+  prepareTrajectoryTask(size_t ndim)
   {
-    Status st(initPDTask(initpos));
+    Status st(preparePDTask(ndim));
     if ( ! st) {
       return st;
     }
@@ -623,7 +702,6 @@ namespace opspace {
       return st;
     }
     
-    int const ndim(initpos.rows());
     if (ndim != maxacc_.rows()) {
       if ((ndim != 1) && (1 == maxacc_.rows())) {
 	maxacc_ = maxacc_[0] * Vector::Ones(ndim);
@@ -634,7 +712,7 @@ namespace opspace {
     }
     
     if (cursor_) {
-      if (cursor_->dt_seconds_ != dt_seconds_) {
+      if ((cursor_->dt_seconds_ != dt_seconds_) || (cursor_->ndof_ != ndim)) {
 	delete cursor_;
 	cursor_ = 0;
       }
@@ -642,13 +720,35 @@ namespace opspace {
     if ( ! cursor_) {
       cursor_ = new TypeIOTGCursor(ndim, dt_seconds_);
     }
+    if (ndim != trjgoal_.rows()) {
+      trjgoal_.resize(ndim);
+    }
+    if (ndim != qh_maxvel_.rows()) {
+      qh_maxvel_.resize(ndim);
+    }
+    
+    return st;
+  }
+  
+  
+  Status TrajectoryTask::
+  initTrajectoryTask(Vector const & initpos)
+  {
+    Status st(prepareTrajectoryTask(initpos.rows()));
+    if ( ! st) {
+      return st;
+    }
+    st = initPDTask(initpos);
+    if ( ! st) {
+      return st;
+    }
     
     trjgoal_ = initpos;
     cursor_->position() = initpos;
-    cursor_->velocity() = Vector::Zero(ndim);
+    cursor_->velocity().setZero();
     
     if (SATURATION_NORM == saturation_policy_) {
-      qh_maxvel_ = maxvel_[0] * Vector::Ones(ndim);
+      qh_maxvel_.setConstant(maxvel_[0]);
     }
     else {
       qh_maxvel_ = maxvel_;
@@ -658,21 +758,19 @@ namespace opspace {
   }
   
   
-  Status TrajectoryTask::
+  RTStatus TrajectoryTask::
   computeTrajectoryCommand(Vector const & curpos,
 			   Vector const & curvel,
 			   Vector & command)
   {
     if ( ! cursor_) {
-      return Status(false, "not initialized");
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "not initialized");
     }
     
     int const trjstatus(cursor_->next(qh_maxvel_, maxacc_, trjgoal_));
     if (0 > trjstatus) {
-      std::ostringstream msg;
-      msg << "trajectory generation error code "
-	  << trjstatus << ": " << otg_errstr(trjstatus);
-      return Status(false, msg.str());
+      return RTStatus::fail(jspace::STATUS_NUMERIC_ERROR, "trajectory generation error",
+			    "code %d: %s", trjstatus, otg_errstr(trjstatus));
     }
     
     goalpos_ = cursor_->position();
@@ -682,6 +780,25 @@ namespace opspace {
   }
   
   
+  Status TrajectoryTask::
+  previewTrajectory(TypeIOTGTrajectory & trajectory)
+  {
+    if ( ! cursor_) {
+      return Status(false, "not initialized");
+    }
+    
+    int const trjstatus(cursor_->preview(qh_maxvel_, maxacc_, trjgoal_, trajectory));
+    if (0 > trjstatus) {
+      std::ostringstream msg;
+      msg << "trajectory preview error code "
+	  << trjstatus << ": " << otg_errstr(trjstatus);
+      return Status(false, msg.str());
+    }
+    
+    return Status();
+  }
+  
+  
   Status TrajectoryTask::
   check(double const * param, double value) const
   {
@@ -758,10 +875,15 @@ namespace opspace {
   CartPosTrjTask(std::string const & name)
     : TrajectoryTask(name, PDTask::SATURATION_NORM),
       end_effector_id_(-1),
-      control_point_(Vector::Zero(3))
+      control_point_(Vector::Zero(3)),
+      jacobian_cache_hits_(0),
+      jacobian_cache_misses_(0),
+      sparse_node_(0)
   {
     declareParameter("end_effector_id", &end_effector_id_, PARAMETER_FLAG_NOLOG);
     declareParameter("control_point", &control_point_, PARAMETER_FLAG_NOLOG);
+    declareParameter("jacobian_cache_hits", &jacobian_cache_hits_, PARAMETER_FLAG_NOLOG);
+    declareParameter("jacobian_cache_misses", &jacobian_cache_misses_, PARAMETER_FLAG_NOLOG);
   }
   
   
@@ -782,18 +904,33 @@ namespace opspace {
   
   
   Status CartPosTrjTask::
+  prepare(Model const & model)
+  {
+    if (0 > end_effector_id_) {
+      return Status(false, "you did not (correctly) set end_effector_id");
+    }
+    if (3 != control_point_.rows()) {
+      return Status(false, "control_point needs to be three dimensional");
+    }
+    if (0 == model.getNode(end_effector_id_)) {
+      return Status(false, "invalid end_effector_id");
+    }
+    actual_.resize(3);
+    jacobian_.resize(3, model.getNDOF());
+    gather_sparse_jacobian(model, model.getNode(end_effector_id_), jacobian_,
+			   sparse_node_, sparse_jacobian_);
+    return prepareTrajectoryTask(3);
+  }
+  
+  
+  RTStatus CartPosTrjTask::
   update(Model const & model)
   {
     taoDNode const * ee_node(updateActual(model));
     if (0 == ee_node) {
-      return Status(false, "updateActual() failed, did you specify a valid end_effector_id?");
-    }
-    
-    Matrix Jfull;
-    if ( ! model.computeJacobian(ee_node, actual_[0], actual_[1], actual_[2], Jfull)) {
-      return Status(false, "failed to compute Jacobian (unsupported joint type?)");
+      return RTStatus(jspace::STATUS_FAILED,
+		      "updateActual() failed, did you specify a valid end_effector_id?");
     }
-    jacobian_ = Jfull.block(0, 0, 3, Jfull.cols());
     
     return computeTrajectoryCommand(actual_,
 				    jacobian_ * model.getState().velocity_,
@@ -807,17 +944,34 @@ namespace opspace {
     taoDNode * ee_node(model.getNode(end_effector_id_));
     if (ee_node) {
       jspace::Transform ee_transform;
-      model.computeGlobalFrame(ee_node,
-			       control_point_[0],
-			       control_point_[1],
-			       control_point_[2],
-			       ee_transform);
+      bool hit;
+      if ( ! model.getCachedFrameJacobian(ee_node, control_point_,
+					  ee_transform, &jacobian_, 0, &hit)) {
+	return 0;
+      }
+      if (hit) {
+	++jacobian_cache_hits_;
+      }
+      else {
+	++jacobian_cache_misses_;
+      }
       actual_ = ee_transform.translation();
+      gather_sparse_jacobian(model, ee_node, jacobian_, sparse_node_, sparse_jacobian_);
+    }
+    else {
+      sparse_node_ = 0;
     }
     return ee_node;
   }
   
   
+  SparseJacobian const * CartPosTrjTask::
+  getSparseJacobian() const
+  {
+    return sparse_node_ ? &sparse_jacobian_ : 0;
+  }
+  
+  
   JPosTrjTask::
   JPosTrjTask(std::string const & name)
     : TrajectoryTask(name, PDTask::SATURATION_COMPONENT_WISE)
@@ -835,6 +989,16 @@ namespace opspace {
   
   
   Status JPosTrjTask::
+  prepare(Model const & model)
+  {
+    size_t const ndof(model.getNDOF());
+    jacobian_ = Matrix::Identity(ndof, ndof);
+    actual_.resize(ndof);
+    return prepareTrajectoryTask(ndof);
+  }
+  
+  
+  RTStatus JPosTrjTask::
   update(Model const & model)
   {
     actual_ = model.getState().position_;
@@ -856,7 +1020,8 @@ namespace opspace {
   JointLimitTask::
   JointLimitTask(std::string const & name)
     : Task(name),
-      dt_seconds_(-1)
+      dt_seconds_(-1),
+      cursor_(0)
   {
     declareParameter("dt_seconds", &dt_seconds_, PARAMETER_FLAG_NOLOG);
     declareParameter("upper_stop_deg", &upper_stop_deg_, PARAMETER_FLAG_NOLOG);
@@ -873,9 +1038,7 @@ namespace opspace {
   JointLimitTask::
   ~JointLimitTask()
   {
-    for (size_t ii(0); ii < cursor_.size(); ++ii) {
-      delete cursor_[ii];
-    }
+    delete cursor_;
   }
   
   
@@ -889,9 +1052,9 @@ namespace opspace {
 	}
       }
     }
-    if ( ! cursor_.empty()) {	// we are initialized
+    if (cursor_) {		// we are initialized
       if ((param == &kp_) || (param == &kd_) || (param == &maxvel_) || (param == &maxacc_)) {
-	if (cursor_.size() != value.rows()) {
+	if (cursor_->ndof_ != value.rows()) {
 	  return Status(false, "invalid dimension");
 	}
       }
@@ -911,12 +1074,11 @@ namespace opspace {
   
   
   Status JointLimitTask::
-  init(Model const & model)
+  checkDimensions(size_t ndof) const
   {
     if (dt_seconds_ <= 0) {
       return Status(false, "dt_seconds must be positive");
     }
-    size_t const ndof(model.getNDOF());
     if (upper_stop_deg_.rows() != ndof) {
       return Status(false, "upper_stop dimension mismatch");
     }
@@ -941,41 +1103,95 @@ namespace opspace {
     if (kd_.rows() != ndof) {
       return Status(false, "kd dimension mismatch");
     }
+    Status ok;
+    return ok;
+  }
+  
+  
+  Status JointLimitTask::
+  prepare(Model const & model)
+  {
+    size_t const ndof(model.getNDOF());
+    Status const st(checkDimensions(ndof));
+    if ( ! st) {
+      return st;
+    }
+    prepareCursor(ndof);
+    upper_stop_.resize(ndof);
+    upper_trigger_.resize(ndof);
+    lower_stop_.resize(ndof);
+    lower_trigger_.resize(ndof);
+    goal_.resize(ndof);
+    return st;
+  }
+  
+  
+  void JointLimitTask::
+  prepareCursor(size_t ndof)
+  {
+    if (cursor_) {
+      if ((cursor_->dt_seconds_ != dt_seconds_) || (cursor_->ndof_ != ndof)) {
+	delete cursor_;
+	cursor_ = 0;
+      }
+    }
+    if ( ! cursor_) {
+      cursor_ = new TypeIOTGUnsyncCursor(ndof, dt_seconds_);
+    }
+    cursor_->selection().setConstant(false);
+  }
+  
+  
+  Status JointLimitTask::
+  init(Model const & model)
+  {
+    size_t const ndof(model.getNDOF());
+    Status const st(checkDimensions(ndof));
+    if ( ! st) {
+      return st;
+    }
     
     upper_stop_ = M_PI * upper_stop_deg_ / 180.0;
     upper_trigger_ = M_PI * upper_trigger_deg_ / 180.0;
     lower_stop_ = M_PI * lower_stop_deg_ / 180.0;
     lower_trigger_ = M_PI * lower_trigger_deg_ / 180.0;
     
-    cursor_.assign(ndof, 0);
+    prepareCursor(ndof);
     goal_ = Vector::Zero(ndof);
     jacobian_.resize(0, 0);
     
     // builds/updates jacobian, initializes cursors and goals, set actual_
     updateState(model);
     
-    Status ok;
-    return ok;
+    return st;
   }
   
   
-  Status JointLimitTask::
+  RTStatus JointLimitTask::
   update(Model const & model)
   {
-    if (dt_seconds_ <= 0) {
-      return Status(false, "not initialized");
+    if ((dt_seconds_ <= 0) || ( ! cursor_)) {
+      return RTStatus(jspace::STATUS_NOT_INITIALIZED, "not initialized");
     }
     
     updateState(model);
     command_.resize(jacobian_.rows());
-    size_t task_index(0);
+    if (0 == jacobian_.rows()) {
+      RTStatus ok;
+      return ok;
+    }
     
-    for (size_t joint_index(0); joint_index < cursor_.size(); ++joint_index) {
-      if (cursor_[joint_index]) {
-	if (0 > cursor_[joint_index]->next(maxvel_[joint_index], maxacc_[joint_index], goal_[joint_index])) {
-	  return Status(false, "trajectory generation error");
-	}
-	double com(kp_[joint_index] * (cursor_[joint_index]->position()[0] - actual_[task_index]));
+    int const trjstatus(cursor_->next(maxvel_, maxacc_, goal_));
+    if (0 > trjstatus) {
+      return RTStatus::fail(jspace::STATUS_NUMERIC_ERROR, "trajectory generation error",
+			    "code %d: %s", trjstatus, otg_errstr(trjstatus));
+    }
+    
+    TypeIOTGUnsyncCursor::boolvec_t const & active(cursor_->selection());
+    size_t task_index(0);
+    for (size_t joint_index(0); joint_index < cursor_->ndof_; ++joint_index) {
+      if (active[joint_index]) {
+	double com(kp_[joint_index] * (cursor_->position()[joint_index] - actual_[task_index]));
 	if ((maxvel_[joint_index] > 1e-4) && (kd_[joint_index] > 1e-4)) {
 	  double const sat(fabs((com / maxvel_[joint_index]) / kd_[joint_index]));
 	  if (sat > 1.0) {
@@ -984,12 +1200,12 @@ namespace opspace {
 	}
 	command_[task_index]
 	  = com
-	  + kd_[joint_index] * (cursor_[joint_index]->velocity()[0] - model.getState().velocity_[joint_index]);
+	  + kd_[joint_index] * (cursor_->velocity()[joint_index] - model.getState().velocity_[joint_index]);
 	++task_index;
       }
     }
     
-    Status ok;
+    RTStatus ok;
     return ok;
   }
   
@@ -999,29 +1215,30 @@ namespace opspace {
   {
     size_t const ndof(model.getNDOF());
     Vector const & jpos(model.getState().position_);
+    TypeIOTGUnsyncCursor::boolvec_t & active(cursor_->selection());
     bool dimension_changed(false);
     size_t task_dimension(0);
     
     for (size_t ii(0); ii < ndof; ++ii) {
-      if (cursor_[ii]) {
+      if (active[ii]) {
 	++task_dimension;
       }
       else {
 	if (jpos[ii] > upper_trigger_[ii]) {
 	  ++task_dimension;
 	  dimension_changed = true;
-	  cursor_[ii] = new TypeIOTGCursor(1, dt_seconds_);
-	  cursor_[ii]->position()[0] = jpos[ii];
-	  cursor_[ii]->velocity()[0] = model.getState().velocity_[ii];
+	  active[ii] = true;
+	  cursor_->position()[ii] = jpos[ii];
+	  cursor_->velocity()[ii] = model.getState().velocity_[ii];
 	  goal_[ii] = upper_stop_[ii];
 	}
 	else if (jpos[ii] < lower_trigger_[ii]) {
 	  ++task_dimension;
 	  dimension_changed = true;
-          cursor_[ii] = new TypeIOTGCursor(1, dt_seconds_);
-          cursor_[ii]->position()[0] = jpos[ii];
-          cursor_[ii]->velocity()[0] = model.getState().velocity_[ii];
-          goal_[ii] = lower_stop_[ii];
+	  active[ii] = true;
+	  cursor_->position()[ii] = jpos[ii];
+	  cursor_->velocity()[ii] = model.getState().velocity_[ii];
+	  goal_[ii] = lower_stop_[ii];
 	}
       }
     }
@@ -1030,7 +1247,7 @@ namespace opspace {
       jacobian_ = Matrix::Zero(task_dimension, ndof);
       size_t task_index(0);
       for (size_t joint_index(0); joint_index < ndof; ++joint_index) {
-	if (cursor_[joint_index]) {
+	if (active[joint_index]) {
 	  jacobian_.coeffRef(task_index, joint_index) = 1.0;
 	  ++task_index;
 	}
@@ -1040,7 +1257,7 @@ namespace opspace {
     actual_.resize(task_dimension);
     size_t task_index(0);
     for (size_t joint_index(0); joint_index < ndof; ++joint_index) {
-      if (cursor_[joint_index]) {
+      if (active[joint_index]) {
 	actual_[task_index] = jpos[joint_index];
 	++task_index;
       }
@@ -1057,7 +1274,7 @@ namespace opspace {
       os << title << "\n";
     }
     os << prefix << "joint limit task: `" << instance_name_ << "'\n";
-    if (cursor_.empty()) {
+    if ( ! cursor_) {
       os << prefix << "  NOT INITIALIZED\n";
     }
     pretty_print(actual_, os, prefix + "  actual", prefix + "    ");
@@ -1072,13 +1289,17 @@ namespace opspace {
       end_effector_id_(-1),
       kp_(50),
       kd_(5),
-      maxvel_(0.5)
+      maxvel_(0.5),
+      jacobian_cache_hits_(0),
+      jacobian_cache_misses_(0)
   {
     declareParameter("end_effector_id", &end_effector_id_, PARAMETER_FLAG_NOLOG);
     declareParameter("kp", &kp_, PARAMETER_FLAG_NOLOG);
     declareParameter("kd", &kd_, PARAMETER_FLAG_NOLOG);
     declareParameter("maxvel", &maxvel_, PARAMETER_FLAG_NOLOG);
     declareParameter("eepos", &eepos_);
+    declareParameter("jacobian_cache_hits", &jacobian_cache_hits_, PARAMETER_FLAG_NOLOG);
+    declareParameter("jacobian_cache_misses", &jacobian_cache_misses_, PARAMETER_FLAG_NOLOG);
   }
   
   
@@ -1108,18 +1329,17 @@ namespace opspace {
     }
     
     jspace::Transform ee_transform;
-    model.computeGlobalFrame(ee_node, Vector::Zero(3), ee_transform);
-    Matrix Jfull;
-    eepos_ = ee_transform.translation();
-    if ( ! model.computeJacobian(ee_node,
-				 eepos_[0],
-				 eepos_[1],
-				 eepos_[2],
-				 Jfull)) {
+    bool hit;
+    if ( ! model.getCachedFrameJacobian(ee_node, 0.0, 0.0, 0.0, ee_transform, 0, &jacobian_, &hit)) {
       return 0;
     }
-    
-    jacobian_ = Jfull.block(3, 0, 3, Jfull.cols());
+    if (hit) {
+      ++jacobian_cache_hits_;
+    }
+    else {
+      ++jacobian_cache_misses_;
+    }
+    eepos_ = ee_transform.translation();
     
     actual_x_ = ee_transform.linear().block(0, 0, 3, 1);
     actual_y_ = ee_transform.linear().block(0, 1, 3, 1);
@@ -1136,11 +1356,11 @@ namespace opspace {
   }
   
   
-  Status OrientationTask::
+  RTStatus OrientationTask::
   update(Model const & model)
   {
     if ( ! updateActual(model)) {
-      return Status(false, "invalid end effector ID");
+      return RTStatus(jspace::STATUS_FAILED, "invalid end effector ID");
     }
     delta_ = actual_x_.cross(goal_x_) + actual_y_.cross(goal_y_) + actual_z_.cross(goal_z_);
     delta_ *= -0.5;
@@ -1155,7 +1375,7 @@ namespace opspace {
     
     command_ -= velocity_ * kd_;
     
-    Status ok;
+    RTStatus ok;
     return ok;
   }
   
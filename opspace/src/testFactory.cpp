@@ -24,6 +24,9 @@
 #include <opspace/Factory.hpp>
 #include <opspace/parse_yaml.hpp>
 #include <stdexcept>
+#include <fstream>
+#include <stdio.h>
+#include <unistd.h>
 
 using namespace opspace;
 using boost::shared_ptr;
@@ -148,6 +151,221 @@ TEST (parse, tasks_and_skills)
 }
 
 
+namespace {
+  
+  class UnregisteredTask : public Task {
+  public:
+    UnregisteredTask(): Task("unregistered") {}
+    virtual Status init(Model const & model) { return Status(); }
+    virtual RTStatus update(Model const & model) { return RTStatus(); }
+  };
+  
+  class AppendableFactory : public Factory {
+  public:
+    void appendTask(shared_ptr<Task> task) { task_table_.push_back(task); }
+  };
+  
+  void put_u32(std::ostream & os, uint32_t value)
+  {
+    os.write(reinterpret_cast<char const *>(&value), sizeof(value));
+  }
+  
+  void put_string(std::ostream & os, string const & value)
+  {
+    put_u32(os, value.size());
+    os << value;
+  }
+  
+  bool file_exists(string const & filename)
+  {
+    return 0 == access(filename.c_str(), F_OK);
+  }
+  
+}
+
+
+TEST (parse, snapshot)
+{
+  static char * const yaml_string =
+    "- tasks:\n"
+    "  - type: opspace::CartPosTrjTask\n"
+    "    name: eepos\n"
+    "    end_effector_id: 42\n"
+    "    dt_seconds: 0.002\n"
+    "    kp: [ 100.0 ]\n"
+    "    kd: [  20.0 ]\n"
+    "    maxvel: [ 0.5 ]\n"
+    "    maxacc: [ 1.5 ]\n"
+    "  - type: opspace::JPosTrjTask\n"
+    "    name: posture\n"
+    "    dt_seconds: 0.002\n"
+    "    kp: [ 400.0, 400.0, 100.0 ]\n"
+    "    kd: [  40.0,  40.0,  20.0 ]\n"
+    "    maxvel: [ 3.1416 ]\n"
+    "    maxacc: [ 6.2832 ]\n"
+    "- skills:\n"
+    "  - type: opspace::TaskPostureTrjSkill\n"
+    "    name: tpb\n"
+    "    slots:\n"
+    "      eepos: eepos\n"
+    "      posture: posture\n";
+  
+  char yaml_filename[] = "/tmp/testFactory-yaml-XXXXXX";
+  char snap_filename[] = "/tmp/testFactory-snap-XXXXXX";
+  int const yaml_fd(mkstemp(yaml_filename));
+  int const snap_fd(mkstemp(snap_filename));
+  ASSERT_LE (0, yaml_fd);
+  ASSERT_LE (0, snap_fd);
+  close(yaml_fd);
+  close(snap_fd);
+  unlink(snap_filename);
+  {
+    std::ofstream os(yaml_filename);
+    os << yaml_string;
+  }
+  
+  Factory::setDebugStream(&cout);
+  bool rebuilt(false);
+  
+  Factory parsed;
+  Status st(parsed.parseFileCached(yaml_filename, snap_filename, &rebuilt));
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_TRUE (rebuilt) << "first call should parse the YAML file";
+  
+  Factory cached;
+  st = cached.parseFileCached(yaml_filename, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_FALSE (rebuilt) << "second call should load the snapshot";
+  
+  ASSERT_EQ (parsed.getTaskTable().size(), cached.getTaskTable().size());
+  ASSERT_EQ (parsed.getSkillTable().size(), cached.getSkillTable().size());
+  for (size_t ii(0); ii < parsed.getTaskTable().size(); ++ii) {
+    Task const & pt(*parsed.getTaskTable()[ii]);
+    Task const & ct(*cached.getTaskTable()[ii]);
+    EXPECT_EQ (pt.getName(), ct.getName());
+    EXPECT_EQ (Factory::findTaskType(pt), Factory::findTaskType(ct));
+    ASSERT_EQ (pt.getNParameters(), ct.getNParameters());
+    for (size_t jj(0); jj < pt.getNParameters(); ++jj) {
+      ostringstream pdump, cdump;
+      pt.getParameter(jj)->dump(pdump, "");
+      ct.getParameter(jj)->dump(cdump, "");
+      EXPECT_EQ (pdump.str(), cdump.str()) << "task " << pt.getName();
+    }
+  }
+  EXPECT_EQ ("opspace::CartPosTrjTask", Factory::findTaskType(*cached.getTaskTable()[0]));
+  
+  shared_ptr<Skill> skill(cached.findSkill("tpb"));
+  ASSERT_TRUE (skill);
+  EXPECT_EQ ("opspace::TaskPostureTrjSkill", Factory::findSkillType(*skill));
+  shared_ptr<TaskSlotAPI> slot(skill->lookupSlot("posture"));
+  ASSERT_TRUE (slot);
+  ASSERT_EQ (1, slot->getNInstances());
+  EXPECT_EQ (cached.findTask("posture"), slot->getInstance(0));
+  
+  // editing the YAML file makes the snapshot stale
+  {
+    std::ofstream os(yaml_filename, std::ios::app);
+    os << "      # edited\n";
+  }
+  Factory edited;
+  st = edited.parseFileCached(yaml_filename, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_TRUE (rebuilt) << "stale snapshot should have been rebuilt";
+  Factory reloaded;
+  st = reloaded.parseFileCached(yaml_filename, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_FALSE (rebuilt) << "rebuilt snapshot should be used";
+  
+  uint64_t key;
+  st = Factory::hashSource(yaml_filename, key);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  Factory mismatch;
+  st = mismatch.loadSnapshot(snap_filename, key + 1);
+  EXPECT_FALSE (st.ok) << "loading with the wrong key should fail";
+  EXPECT_TRUE (mismatch.getTaskTable().empty());
+  
+  // editing a dependency makes the snapshot stale as well
+  char dep_filename[] = "/tmp/testFactory-dep-XXXXXX";
+  int const dep_fd(mkstemp(dep_filename));
+  ASSERT_LE (0, dep_fd);
+  close(dep_fd);
+  vector<string> dependencies(1, dep_filename);
+  Factory with_dep;
+  st = with_dep.parseFileCached(yaml_filename, dependencies, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_TRUE (rebuilt) << "adding a dependency should change the key";
+  {
+    std::ofstream os(dep_filename);
+    os << "<robot/>\n";
+  }
+  Factory dep_edited;
+  st = dep_edited.parseFileCached(yaml_filename, dependencies, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_TRUE (rebuilt) << "editing a dependency should rebuild the snapshot";
+  Factory dep_reloaded;
+  st = dep_reloaded.parseFileCached(yaml_filename, dependencies, snap_filename, &rebuilt);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_FALSE (rebuilt) << "rebuilt snapshot should be used";
+  
+  // a failed save leaves the previous snapshot and no temporary file
+  vector<string> sources(1, yaml_filename);
+  sources.push_back(dep_filename);
+  uint64_t dep_key;
+  st = Factory::hashSources(sources, dep_key);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  AppendableFactory broken;
+  broken.appendTask(shared_ptr<Task>(new UnregisteredTask()));
+  st = broken.saveSnapshot(snap_filename, dep_key + 1);
+  EXPECT_FALSE (st.ok) << "saving an unregistered task type should fail";
+  Factory survivor;
+  st = survivor.loadSnapshot(snap_filename, dep_key);
+  EXPECT_TRUE (st.ok) << "previous snapshot should survive a failed save: " << st.errstr;
+  ostringstream tmpname;
+  tmpname << snap_filename << ".tmp." << getpid();
+  EXPECT_FALSE (file_exists(tmpname.str())) << "temporary file should be removed";
+  
+  // absurd lengths in a snapshot with a valid key are rejected
+  // instead of being allocated, and the YAML gets parsed again
+  string header;
+  {
+    std::ifstream is(snap_filename, std::ios::binary);
+    ostringstream os;
+    os << is.rdbuf();
+    header = os.str().substr(0, 24); // magic, byte order, version, key
+  }
+  static uint32_t const huge(0xfffffff0);
+  for (int corrupt_string(0); corrupt_string <= 1; ++corrupt_string) {
+    {
+      std::ofstream os(snap_filename, std::ios::binary | std::ios::trunc);
+      os << header;
+      put_u32(os, 1);		// one task
+      put_string(os, "opspace::JPosTrjTask");
+      put_string(os, "posture");
+      put_u32(os, 1);		// with one parameter
+      if (corrupt_string) {
+	put_u32(os, huge);
+      }
+      else {
+	put_string(os, "kp");
+	put_u32(os, PARAMETER_TYPE_VECTOR);
+	put_u32(os, huge);
+      }
+    }
+    Factory corrupt;
+    st = corrupt.loadSnapshot(snap_filename, dep_key);
+    EXPECT_FALSE (st.ok) << "corrupt " << (corrupt_string ? "string" : "vector") << " length";
+    EXPECT_TRUE (corrupt.getTaskTable().empty());
+    st = corrupt.parseFileCached(yaml_filename, dependencies, snap_filename, &rebuilt);
+    ASSERT_TRUE (st.ok) << st.errstr;
+    EXPECT_TRUE (rebuilt) << "corrupt snapshot should have been rebuilt";
+  }
+  
+  unlink(dep_filename);
+  unlink(yaml_filename);
+  unlink(snap_filename);
+}
+
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
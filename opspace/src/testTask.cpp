@@ -23,8 +23,22 @@
 #include <opspace/task_library.hpp>
 #include <opspace/skill_library.hpp>
 #include <opspace/ClassicTaskPostureController.hpp>
+#include <opspace/HierarchicalController.hpp>
+#include <opspace/QPController.hpp>
+#include <opspace/pseudo_inverse.hpp>
+#include <opspace/SparseJacobian.hpp>
+#include <opspace/TypeIOTGCursor.hpp>
+#include <opspace/pd_saturation.hpp>
+#include <opspace/ParameterRingLog.hpp>
+#include <opspace/Telemetry.hpp>
 #include <jspace/test/model_library.hpp>
+#include <tao/utility/TaoDeThreadPool.h>
+#include <fstream>
 #include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using jspace::Model;
 using jspace::State;
@@ -263,6 +277,1582 @@ TEST (controller, odd_full)
 
 
 
+namespace {
+  
+  class SVCheckSkill : public GenericSkill {
+  public:
+    SVCheckSkill(): GenericSkill("sv_check"), reject_(0) {}
+    
+    virtual RTStatus checkJStarSV(Task const * task, Vector const & sv) {
+      checked_.push_back(task);
+      sv_.push_back(sv);
+      if (task == reject_) {
+	return RTStatus(jspace::STATUS_FAILED, "rejected");
+      }
+      RTStatus ok;
+      return ok;
+    }
+    
+    Task const * reject_;
+    vector<Task const *> checked_;
+    vector<Vector> sv_;
+  };
+  
+}
+
+
+TEST (controller, hierarchical)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    ASSERT_EQ (6, ndof) << "this test assumes a 6-DOF robot";
+    Matrix ainv;
+    Vector gg;
+    ASSERT_TRUE (puma->getInverseMassInertia(ainv)) << "failed to get inverse mass inertia";
+    ASSERT_TRUE (puma->getGravity(gg)) << "failed to get gravity";
+    
+    // Three levels which overlap on joint 1, so the second level can
+    // only achieve its command on joints 2 and 3, and the posture task
+    // only on joints 4 and 5.
+    Vector sel(Vector::Zero(ndof));
+    sel[0] = 1;
+    sel[1] = 1;
+    shared_ptr<Task> first(create_sel_jp_task("first", sel));
+    sel = Vector::Zero(ndof);
+    sel[1] = 1;
+    sel[2] = 1;
+    sel[3] = 1;
+    shared_ptr<Task> second(create_sel_jp_task("second", sel));
+    shared_ptr<Task> posture(create_sel_jp_task("posture", Vector::Ones(ndof)));
+    
+    SVCheckSkill skill;
+    skill.appendTask(first);
+    skill.appendTask(second);
+    skill.appendTask(posture);
+    HierarchicalController ctrl("ctrl");
+    
+    Status st(skill.init(*puma));
+    ASSERT_TRUE (st.ok) << "failed to init skill: " << st.errstr;
+    st = ctrl.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init controller: " << st.errstr;
+    Vector gamma;
+    st = ctrl.computeCommand(*puma, skill, gamma);
+    ASSERT_TRUE (st.ok) << "failed to compute command: " << st.errstr;
+    
+    ASSERT_EQ (3, skill.checked_.size());
+    EXPECT_EQ (first.get(), skill.checked_[0]);
+    EXPECT_EQ (second.get(), skill.checked_[1]);
+    EXPECT_EQ (posture.get(), skill.checked_[2]);
+    EXPECT_EQ (2, skill.sv_[0].rows());
+    EXPECT_EQ (3, skill.sv_[1].rows());
+    EXPECT_EQ (6, skill.sv_[2].rows());
+    
+    Vector const qddot(ainv * (gamma - gg));
+    Vector expected(ndof);
+    expected[0] = first->getCommand()[0];
+    expected[1] = first->getCommand()[1];
+    expected[2] = second->getCommand()[1];
+    expected[3] = second->getCommand()[2];
+    expected[4] = posture->getCommand()[4];
+    expected[5] = posture->getCommand()[5];
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_NEAR (expected[ii], qddot[ii], 1e-6 * (1 + fabs(expected[ii]))) << "joint " << ii;
+    }
+    
+    // running it again must give the same answer
+    Vector gamma2;
+    st = ctrl.computeCommand(*puma, skill, gamma2);
+    ASSERT_TRUE (st.ok) << "failed to compute command again: " << st.errstr;
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_EQ (gamma[ii], gamma2[ii]) << "joint " << ii;
+    }
+    
+    skill.reject_ = second.get();
+    st = ctrl.computeCommand(*puma, skill, gamma2);
+    EXPECT_FALSE (st.ok) << "checkJStarSV rejection should have aborted computeCommand";
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+namespace {
+  
+  class FixedTask : public Task {
+  public:
+    FixedTask(std::string const & name, Matrix const & jacobian, Vector const & command)
+      : Task(name), jacobian0_(jacobian), command0_(command) {}
+    
+    virtual Status init(Model const & model) {
+      jacobian_ = jacobian0_;
+      command_ = command0_;
+      actual_ = Vector::Zero(command0_.rows());
+      Status ok;
+      return ok;
+    }
+    
+    virtual RTStatus update(Model const & model) {
+      RTStatus ok;
+      return ok;
+    }
+    
+    Matrix jacobian0_;
+    Vector command0_;
+  };
+  
+}
+
+
+#ifdef __GLIBC__
+
+// Interpose the C allocator so that we can count every heap
+// allocation made while armed (Eigen goes through malloc() directly,
+// and operator new ends up there as well). The real allocator remains
+// reachable through the glibc-internal entry points.
+
+extern "C" {
+  void * __libc_malloc(size_t size);
+  void * __libc_calloc(size_t nmemb, size_t size);
+  void * __libc_realloc(void * ptr, size_t size);
+  void * __libc_memalign(size_t alignment, size_t size);
+}
+
+static bool count_malloc(false);
+static size_t n_malloc(0);
+
+extern "C" void * malloc(size_t size) __THROW
+{
+  if (count_malloc) {
+    ++n_malloc;
+  }
+  return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t nmemb, size_t size) __THROW
+{
+  if (count_malloc) {
+    ++n_malloc;
+  }
+  return __libc_calloc(nmemb, size);
+}
+
+extern "C" void * realloc(void * ptr, size_t size) __THROW
+{
+  if (count_malloc) {
+    ++n_malloc;
+  }
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void ** ptr, size_t alignment, size_t size) __THROW
+{
+  if (count_malloc) {
+    ++n_malloc;
+  }
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr ? 0 : ENOMEM;
+}
+
+
+TEST (controller, classic_no_alloc)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    Matrix ainv;
+    Vector gg;
+    ASSERT_TRUE (puma->getInverseMassInertia(ainv)) << "failed to get inverse mass inertia";
+    ASSERT_TRUE (puma->getGravity(gg)) << "failed to get gravity";
+    
+    Matrix jac(Matrix::Zero(3, ndof));
+    Vector cmd(3);
+    for (size_t ii(0); ii < 3; ++ii) {
+      jac.coeffRef(ii, ii) = 1.0;
+      jac.coeffRef(ii, ii + 1) = 0.5;
+      cmd[ii] = 0.1 * (ii + 1);
+    }
+    Vector pcmd(ndof);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      pcmd[ii] = 0.3 - 0.1 * ii;
+    }
+    
+    GenericSkill gb("gb");
+    gb.appendTask(shared_ptr<Task>(new FixedTask("task", jac, cmd)));
+    gb.appendTask(shared_ptr<Task>(new FixedTask("posture", Matrix::Identity(ndof, ndof), pcmd)));
+    ClassicTaskPostureController ctrl("ctrl");
+    Status st(gb.init(*puma));
+    ASSERT_TRUE (st.ok) << "failed to init skill: " << st.errstr;
+    st = ctrl.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init controller: " << st.errstr;
+    
+    // the first tick is allowed to size the task-space buffers
+    Vector gamma;
+    st = ctrl.computeCommand(*puma, gb, gamma);
+    ASSERT_TRUE (st.ok) << "failed to compute command: " << st.errstr;
+    
+    n_malloc = 0;
+    count_malloc = true;
+    RTStatus rst;
+    for (size_t ii(0); ii < 100; ++ii) {
+      rst = ctrl.computeCommand(*puma, gb, gamma);
+      if ( ! rst) {
+	break;
+      }
+    }
+    count_malloc = false;
+    ASSERT_TRUE (rst) << "failed to compute command: " << rst.toStatus().errstr;
+    EXPECT_EQ (0, n_malloc) << "heap allocations in steady-state computeCommand()";
+    
+    Matrix lambda;
+    pseudoInverse(jac * ainv * jac.transpose(), 1e-2, lambda);
+    Matrix const jbar(ainv * jac.transpose() * lambda);
+    Matrix const nullspace(Matrix::Identity(ndof, ndof) - jac.transpose() * jbar.transpose());
+    Vector const expected(jac.transpose() * lambda * cmd + nullspace * pcmd + gg);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_NEAR (expected[ii], gamma[ii], 1e-9 * (1 + fabs(expected[ii]))) << "joint " << ii;
+    }
+    
+    // the explicit nullspace projector is only formed on request
+    Parameter * ns_param(ctrl.lookupParameter("nullspace", PARAMETER_TYPE_MATRIX));
+    ASSERT_NE ((void*)0, ns_param) << "failed to retrieve nullspace parameter";
+    EXPECT_EQ (0, ns_param->getMatrix()->rows()) << "nullspace should not have been computed";
+    Parameter * dbg_param(ctrl.lookupParameter("debug_nullspace", PARAMETER_TYPE_INTEGER));
+    ASSERT_NE ((void*)0, dbg_param) << "failed to retrieve debug_nullspace parameter";
+    st = dbg_param->set(1);
+    ASSERT_TRUE (st.ok) << "failed to set debug_nullspace: " << st.errstr;
+    st = ctrl.computeCommand(*puma, gb, gamma);
+    ASSERT_TRUE (st.ok) << "failed to compute command: " << st.errstr;
+    Matrix const & ns(*ns_param->getMatrix());
+    ASSERT_EQ (ndof, ns.rows());
+    ASSERT_EQ (ndof, ns.cols());
+    for (size_t ii(0); ii < ndof; ++ii) {
+      for (size_t jj(0); jj < ndof; ++jj) {
+	EXPECT_NEAR (nullspace.coeff(ii, jj), ns.coeff(ii, jj), 1e-9) << "nullspace " << ii << " " << jj;
+      }
+    }
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+
+TEST (status, rt_status)
+{
+  RTStatus ok;
+  EXPECT_TRUE (ok);
+  EXPECT_TRUE (ok.toStatus().ok);
+  
+  RTStatus const plain(jspace::STATUS_NOT_INITIALIZED, "not initialized");
+  EXPECT_FALSE (plain);
+  Status st(plain);
+  EXPECT_FALSE (st.ok);
+  EXPECT_EQ ("not initialized", st.errstr);
+  
+  RTStatus const inner(RTStatus::fail(jspace::STATUS_INVALID_DIMENSION, "bad size", "task `%s'", "eepos"));
+  RTStatus const outer(RTStatus::fail(inner.code, inner.message, "%s at tick %d", inner.context, 42));
+  EXPECT_EQ (jspace::STATUS_INVALID_DIMENSION, outer.code);
+  EXPECT_EQ ("bad size: task `eepos'", inner.toStatus().errstr);
+  EXPECT_EQ ("bad size: task `eepos' at tick 42", outer.toStatus().errstr);
+  
+  RTStatus const converted(Status(false, "legacy failure"));
+  EXPECT_EQ (jspace::STATUS_FAILED, converted.code);
+  EXPECT_EQ ("legacy failure", converted.toStatus().errstr);
+  EXPECT_TRUE (RTStatus(Status()));
+  
+  try {
+    Model * puma(get_puma());
+    JPosTask jpos("jpos");
+    jpos.update(*puma);		// sizes actual_
+    
+    n_malloc = 0;
+    count_malloc = true;
+    RTStatus rst;
+    for (size_t ii(0); ii < 10; ++ii) {
+      rst = jpos.update(*puma);
+      if ( ! rst) {
+	rst = RTStatus::fail(rst.code, rst.message, "task `%s' tick %d", jpos.getName().c_str(), int(ii));
+      }
+    }
+    count_malloc = false;
+    EXPECT_EQ (0, n_malloc) << "heap allocations on RTStatus failure path";
+    EXPECT_EQ (jspace::STATUS_NOT_INITIALIZED, rst.code);
+    EXPECT_EQ ("not initialized: task `jpos' tick 9", rst.toStatus().errstr);
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+#endif // __GLIBC__
+
+
+namespace {
+  
+  class CountingTask : public Task {
+  public:
+    CountingTask(std::string const & name, bool fail)
+      : Task(name), fail_(fail), count_(0) {}
+    
+    virtual Status init(Model const & model) {
+      Status ok;
+      return ok;
+    }
+    
+    virtual RTStatus update(Model const & model) {
+      ++count_;
+      if (fail_) {
+	return RTStatus::fail(jspace::STATUS_FAILED, "", "%s", instance_name_.c_str());
+      }
+      RTStatus ok;
+      return ok;
+    }
+    
+    bool fail_;
+    int count_;
+  };
+  
+}
+
+
+TEST (skill, parallel_update)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    
+    // the same eight tasks, once updated sequentially and once in parallel
+    GenericSkill serial("serial");
+    GenericSkill parallel("parallel");
+    vector<shared_ptr<Task> > serial_tasks, parallel_tasks;
+    for (size_t ii(0); ii < 8; ++ii) {
+      Vector sel(Vector::Zero(ndof));
+      sel[ii % ndof] = 1;
+      sel[(ii + 3) % ndof] = 1;
+      serial_tasks.push_back(create_sel_jp_task("serial", sel));
+      parallel_tasks.push_back(create_sel_jp_task("parallel", sel));
+      serial.appendTask(serial_tasks.back());
+      parallel.appendTask(parallel_tasks.back());
+    }
+    Status st(serial.init(*puma));
+    ASSERT_TRUE (st.ok) << "failed to init serial skill: " << st.errstr;
+    st = parallel.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init parallel skill: " << st.errstr;
+    
+    for (int spin(0); spin <= 1; ++spin) {
+      deThreadPool pool(3, spin);
+      parallel.setThreadPool(&pool);
+      st = serial.update(*puma);
+      ASSERT_TRUE (st.ok) << "serial update failed: " << st.errstr;
+      st = parallel.update(*puma);
+      ASSERT_TRUE (st.ok) << "parallel update failed: " << st.errstr;
+      for (size_t ii(0); ii < serial_tasks.size(); ++ii) {
+	Vector const & cs(serial_tasks[ii]->getCommand());
+	Vector const & cp(parallel_tasks[ii]->getCommand());
+	ASSERT_EQ (cs.rows(), cp.rows()) << "task " << ii;
+	for (int jj(0); jj < cs.rows(); ++jj) {
+	  EXPECT_EQ (cs[jj], cp[jj]) << "task " << ii << " spin " << spin;
+	}
+      }
+      parallel.setThreadPool(0);
+    }
+    
+    // all tasks get updated, and the first failure in table order
+    // gets reported regardless of which thread finished first
+    GenericSkill failing("failing");
+    vector<shared_ptr<CountingTask> > counting;
+    for (size_t ii(0); ii < 6; ++ii) {
+      ostringstream name;
+      name << "task" << ii;
+      counting.push_back(shared_ptr<CountingTask>(new CountingTask(name.str(), (2 == ii) || (4 == ii))));
+      failing.appendTask(counting.back());
+    }
+    st = failing.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init failing skill: " << st.errstr;
+    deThreadPool pool(4, 1);
+    failing.setThreadPool(&pool);
+    for (size_t tick(0); tick < 50; ++tick) {
+      st = failing.update(*puma);
+      EXPECT_FALSE (st.ok);
+      EXPECT_EQ ("task2", st.errstr);
+    }
+    for (size_t ii(0); ii < counting.size(); ++ii) {
+      EXPECT_EQ (50, counting[ii]->count_) << "task " << ii;
+    }
+    failing.setThreadPool(0);
+    
+    // the worker of a two-thread pool runs all odd tasks, and formats
+    // more contexts than its RTStatus buffers can hold before the
+    // servo thread gets to see the first failure
+    GenericSkill crowded("crowded");
+    for (size_t ii(0); ii < 12; ++ii) {
+      ostringstream name;
+      name << "odd" << ii;
+      crowded.appendTask(shared_ptr<CountingTask>(new CountingTask(name.str(), 1 == ii % 2)));
+    }
+    st = crowded.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init crowded skill: " << st.errstr;
+    RTStatus rst;
+    {
+      deThreadPool crowded_pool(2, 1);
+      crowded.setThreadPool(&crowded_pool);
+      rst = crowded.update(*puma);
+      crowded.setThreadPool(0);
+    }
+    // the pool threads are gone, the context must still be valid
+    EXPECT_FALSE (rst);
+    ASSERT_NE ((void*)0, rst.context);
+    EXPECT_STREQ ("odd1", rst.context);
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+static Status set_vector_param(ParameterReflection & obj, string const & name, Vector const & value)
+{
+  Parameter * param(obj.lookupParameter(name, PARAMETER_TYPE_VECTOR));
+  if ( ! param) {
+    return Status(false, "no vector parameter `" + name + "'");
+  }
+  return param->set(value);
+}
+
+
+namespace {
+  
+  struct prepare_arg_s {
+    SkillSwitch * sw;
+    Model const * model;
+    shared_ptr<Skill> skill;
+    Status st;
+  };
+  
+  void * prepare_thread(void * arg)
+  {
+    prepare_arg_s * pa(static_cast<prepare_arg_s*>(arg));
+    pa->st = pa->sw->prepare(*pa->model, pa->skill);
+    return 0;
+  }
+  
+}
+
+
+TEST (skill, switch)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    
+    shared_ptr<GenericSkill> first(new GenericSkill("first"));
+    shared_ptr<JPosTask> jpos(new JPosTask("jpos"));
+    jpos->quickSetup(100.0 * Vector::Ones(ndof), 20.0 * Vector::Ones(ndof), Vector::Ones(ndof));
+    first->appendTask(jpos);
+    
+    SkillSwitch sw;
+    EXPECT_EQ ((void*)0, sw.getActive());
+    Status st(sw.prepare(*puma, first));
+    ASSERT_TRUE (st.ok) << "failed to prepare first skill: " << st.errstr;
+    EXPECT_TRUE (sw.isPending());
+    st = sw.tick(*puma);
+    ASSERT_TRUE (st.ok) << "failed to switch to first skill: " << st.errstr;
+    EXPECT_EQ (first.get(), sw.getActive());
+    EXPECT_FALSE (sw.isPending());
+    
+    // the second skill has a Cartesian task, a posture trajectory,
+    // and joint limits, which all allocate during a plain init()
+    shared_ptr<GenericSkill> second(new GenericSkill("second"));
+    shared_ptr<CartPosTask> eepos(new CartPosTask("eepos"));
+    eepos->quickSetup(100.0 * Vector::Ones(1), 20.0 * Vector::Ones(1), Vector::Ones(1),
+		      puma->getNodeName(ndof - 1), Vector::Zero(3));
+    second->appendTask(eepos);
+    shared_ptr<JointLimitTask> jlimit(new JointLimitTask("jlimit"));
+    Parameter * param(jlimit->lookupParameter("dt_seconds", PARAMETER_TYPE_REAL));
+    ASSERT_NE ((void*)0, param);
+    ASSERT_TRUE (param->set(0.01).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "upper_stop_deg", 170.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "upper_trigger_deg", 160.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "lower_stop_deg", -170.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "lower_trigger_deg", -160.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "kp", 100.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "kd", 20.0 * Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "maxvel", Vector::Ones(ndof)).ok);
+    ASSERT_TRUE (set_vector_param(*jlimit, "maxacc", 2.0 * Vector::Ones(ndof)).ok);
+    second->appendTask(jlimit);
+    shared_ptr<JPosTrjTask> posture(new JPosTrjTask("posture"));
+    posture->quickSetup(0.01, 100.0, 20.0, 1.0, 2.0);
+    second->appendTask(posture);
+    
+    st = sw.prepare(*puma, second);
+    ASSERT_TRUE (st.ok) << "failed to prepare second skill: " << st.errstr;
+    EXPECT_FALSE (sw.prepare(*puma, second).ok) << "prepare() should refuse while a skill is pending";
+    EXPECT_EQ (first.get(), sw.getActive());
+    
+    // Make sure the Jacobian cache has an entry it can recycle for
+    // the end effector, then move the robot a bit. The switch should
+    // not allocate, and the new tasks should start from the new
+    // state.
+    jspace::Transform ee_transform;
+    Matrix Jv;
+    ASSERT_TRUE (puma->getCachedFrameJacobian(puma->getNode(ndof - 1), 0.0, 0.0, 0.0,
+					      ee_transform, &Jv, 0));
+    State state(puma->getState());
+    state.position_[0] += 0.05;
+    puma->update(state);
+    
+#ifdef __GLIBC__
+    n_malloc = 0;
+    count_malloc = true;
+    st = sw.tick(*puma);
+    count_malloc = false;
+    ASSERT_TRUE (st.ok) << "failed to switch to second skill: " << st.errstr;
+    EXPECT_EQ (0, n_malloc) << "switching to a prepared skill should not allocate";
+#else
+    st = sw.tick(*puma);
+    ASSERT_TRUE (st.ok) << "failed to switch to second skill: " << st.errstr;
+#endif
+    EXPECT_EQ (second.get(), sw.getActive());
+    
+    Parameter const * trjgoal(posture->lookupParameter("trjgoal", PARAMETER_TYPE_VECTOR));
+    ASSERT_NE ((void*)0, trjgoal);
+    Parameter const * goalpos(eepos->lookupParameter("goalpos", PARAMETER_TYPE_VECTOR));
+    ASSERT_NE ((void*)0, goalpos);
+    st = sw.getActive()->update(*puma);
+    ASSERT_TRUE (st.ok) << "update after switch failed: " << st.errstr;
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_EQ (state.position_[ii], (*trjgoal->getVector())[ii]);
+    }
+    for (size_t ii(0); ii < 3; ++ii) {
+      EXPECT_EQ (eepos->getActual()[ii], (*goalpos->getVector())[ii]);
+    }
+    
+    // for comparison, initializing an unprepared skill does allocate
+    shared_ptr<GenericSkill> third(new GenericSkill("third"));
+    shared_ptr<JPosTrjTask> posture3(new JPosTrjTask("posture3"));
+    posture3->quickSetup(0.01, 100.0, 20.0, 1.0, 2.0);
+    third->appendTask(posture3);
+#ifdef __GLIBC__
+    n_malloc = 0;
+    count_malloc = true;
+    st = third->init(*puma);
+    count_malloc = false;
+    ASSERT_TRUE (st.ok) << "failed to init third skill: " << st.errstr;
+    EXPECT_LT (0, n_malloc);
+#else
+    st = third->init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init third skill: " << st.errstr;
+#endif
+    
+    // prepare the first skill again from another thread while the
+    // servo keeps ticking, and switch back to it
+    prepare_arg_s pa;
+    pa.sw = &sw;
+    pa.model = puma;
+    pa.skill = first;
+    pthread_t thread;
+    ASSERT_EQ (0, pthread_create(&thread, 0, prepare_thread, &pa));
+    size_t tick(0);
+    for (/**/; (tick < 100000) && (sw.getActive() != first.get()); ++tick) {
+      state.position_[1] += 1e-6;
+      puma->update(state);
+      st = sw.tick(*puma);
+      ASSERT_TRUE (st.ok) << "tick " << tick << " failed: " << st.errstr;
+      st = sw.getActive()->update(*puma);
+      ASSERT_TRUE (st.ok) << "tick " << tick << " update failed: " << st.errstr;
+      if (sw.getActive() != first.get()) {
+	sched_yield();
+      }
+    }
+    pthread_join(thread, 0);
+    ASSERT_TRUE (pa.st.ok) << "failed to prepare first skill from another thread: " << pa.st.errstr;
+    if (sw.isPending()) {
+      st = sw.tick(*puma);
+      ASSERT_TRUE (st.ok) << "failed to switch back to first skill: " << st.errstr;
+    }
+    EXPECT_EQ (first.get(), sw.getActive());
+    Parameter const * jgoal(jpos->lookupParameter("goalpos", PARAMETER_TYPE_VECTOR));
+    ASSERT_NE ((void*)0, jgoal);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_EQ (puma->getState().position_[ii], (*jgoal->getVector())[ii]);
+    }
+    
+    // the tasks of the active skill must not get prepared again,
+    // neither through that skill nor through another one
+    EXPECT_FALSE (sw.prepare(*puma, first).ok) << "prepare() should refuse the active skill";
+    shared_ptr<GenericSkill> fourth(new GenericSkill("fourth"));
+    fourth->appendTask(posture3);
+    fourth->appendTask(jpos);
+    st = sw.prepare(*puma, fourth);
+    EXPECT_FALSE (st.ok) << "prepare() should refuse a skill which shares tasks with the active one";
+    EXPECT_NE (string::npos, st.errstr.find("jpos")) << st.errstr;
+    EXPECT_FALSE (sw.isPending());
+    EXPECT_EQ (first.get(), sw.getActive());
+    st = sw.prepare(*puma, second);
+    ASSERT_TRUE (st.ok) << "failed to prepare second skill again: " << st.errstr;
+    st = sw.tick(*puma);
+    ASSERT_TRUE (st.ok) << "failed to switch to second skill again: " << st.errstr;
+    EXPECT_EQ (second.get(), sw.getActive());
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+TEST (parameter, handles)
+{
+  shared_ptr<JPosTask> jpos(new JPosTask("jpos"));
+  parameter_lookup_t const & table(jpos->getParameterTable());
+  EXPECT_EQ (table.size(), jpos->getNParameters());
+  for (parameter_lookup_t::const_iterator ii(table.begin()); ii != table.end(); ++ii) {
+    int const handle(jpos->getParameterHandle(ii->first));
+    ASSERT_LE (0, handle) << ii->first;
+    EXPECT_EQ (ii->second, jpos->getParameter(handle)) << ii->first;
+  }
+  EXPECT_EQ (-1, jpos->getParameterHandle("no_such_parameter"));
+  
+  ReflectionRegistry reg;
+  reg.add(jpos);
+  int const kp(reg.compileParameter("task", "jpos", "kp", PARAMETER_TYPE_VECTOR));
+  int const kd(reg.compileParameter("task", "jpos", "kd"));
+  ASSERT_LE (0, kp);
+  ASSERT_LE (0, kd);
+  EXPECT_NE (kp, kd);
+  EXPECT_EQ (kp, reg.compileParameter("task", "jpos", "kp"));
+  EXPECT_EQ (jpos->lookupParameter("kp"), reg.getParameter(kp));
+  EXPECT_EQ (jpos->lookupParameter("kd"), reg.getParameter(kd));
+  EXPECT_EQ (-1, reg.compileParameter("task", "jpos", "kp", PARAMETER_TYPE_REAL));
+  EXPECT_EQ (-1, reg.compileParameter("task", "nobody", "kp"));
+}
+
+
+struct tune_arg_s {
+  ParameterStage * stage;
+  Parameter * kp;
+  Parameter * kd;
+  size_t ndof;
+  size_t nbatches;
+};
+
+
+static void * tune_thread(void * arg)
+{
+  tune_arg_s * ta(reinterpret_cast<tune_arg_s*>(arg));
+  Vector gain(ta->ndof);
+  for (size_t batch(1); batch <= ta->nbatches; /**/) {
+    gain.setConstant(batch);
+    if (ta->stage->stage(ta->kp, gain) && ta->stage->stage(ta->kd, gain)) {
+      ta->stage->commit();
+      ++batch;
+    }
+    else {
+      ta->stage->discard();
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+
+TEST (parameter, stage)
+{
+  size_t const ndof(3);
+  shared_ptr<JPosTask> jpos(new JPosTask("jpos"));
+  jpos->quickSetup(Vector::Ones(ndof), Vector::Ones(ndof), Vector::Ones(ndof));
+  Parameter * kp(jpos->getParameter(jpos->getParameterHandle("kp")));
+  Parameter * kd(jpos->getParameter(jpos->getParameterHandle("kd")));
+  Parameter * errpos(jpos->getParameter(jpos->getParameterHandle("errpos")));
+  
+  ParameterStage stage(4);
+  EXPECT_FALSE (stage.stage(kp, 1.0).ok) << "type mismatch should have been caught";
+  EXPECT_FALSE (stage.stage(0, Vector(Vector::Ones(ndof))).ok) << "null parameter should have been caught";
+  
+  // nothing happens before commit() and apply()
+  ASSERT_TRUE (stage.stage(kp, Vector(2.0 * Vector::Ones(ndof))).ok);
+  ASSERT_TRUE (stage.stage(kd, Vector(-1.0 * Vector::Ones(ndof))).ok);
+  ASSERT_TRUE (stage.apply().ok);
+  EXPECT_EQ (1.0, (*kp->getVector())[0]);
+  stage.commit();
+  EXPECT_EQ (1.0, (*kp->getVector())[0]);
+  
+  // the check() still runs, and rejected values do not block the rest
+  Status st(stage.apply());
+  EXPECT_FALSE (st.ok) << "negative kd should have been rejected";
+  EXPECT_EQ (0, st.errstr.find("kd")) << st.errstr;
+  EXPECT_EQ (2.0, (*kp->getVector())[0]);
+  EXPECT_EQ (1.0, (*kd->getVector())[0]);
+  EXPECT_EQ (1, stage.getNApplied());
+  EXPECT_EQ (1, stage.getNRejected());
+  ASSERT_TRUE (stage.stage(errpos, Vector(Vector::Zero(ndof))).ok);
+  stage.commit();
+  EXPECT_FALSE (stage.apply().ok) << "errpos is read-only";
+  
+  // discarded values never show up
+  ASSERT_TRUE (stage.stage(kp, Vector(3.0 * Vector::Ones(ndof))).ok);
+  stage.discard();
+  stage.commit();
+  ASSERT_TRUE (stage.apply().ok);
+  EXPECT_EQ (2.0, (*kp->getVector())[0]);
+  
+  // the queue is bounded, and applying same-sized values is allocation-free
+  for (size_t ii(0); ii < 4; ++ii) {
+    ASSERT_TRUE (stage.stage(kp, Vector((4.0 + ii) * Vector::Ones(ndof))).ok) << "ii " << ii;
+  }
+  EXPECT_FALSE (stage.stage(kp, Vector(8.0 * Vector::Ones(ndof))).ok) << "queue should be full";
+  stage.commit();
+#ifdef __GLIBC__
+  n_malloc = 0;
+  count_malloc = true;
+  st = stage.apply();
+  count_malloc = false;
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_EQ (0, n_malloc);
+#else
+  st = stage.apply();
+  ASSERT_TRUE (st.ok) << st.errstr;
+#endif
+  EXPECT_EQ (7.0, (*kp->getVector())[0]);
+  
+  // concurrent tuning: kp and kd always change together
+  Vector const zero(Vector::Zero(ndof));
+  ASSERT_TRUE (stage.stage(kp, zero).ok);
+  ASSERT_TRUE (stage.stage(kd, zero).ok);
+  stage.commit();
+  ASSERT_TRUE (stage.apply().ok);
+  tune_arg_s ta;
+  ta.stage = &stage;
+  ta.kp = kp;
+  ta.kd = kd;
+  ta.ndof = ndof;
+  ta.nbatches = 1000;
+  pthread_t thread;
+  ASSERT_EQ (0, pthread_create(&thread, 0, tune_thread, &ta));
+  double prev(0);
+  size_t tick(0);
+  bool consistent(true);
+  for (/**/; (tick < 1000000) && (prev < ta.nbatches); ++tick) {
+    // keep draining on failure, so that the tuning thread can finish
+    bool ok(stage.apply() && ((*kp->getVector())[0] >= prev));
+    prev = (*kp->getVector())[0];
+    for (size_t ii(0); ii < ndof; ++ii) {
+      ok = ok && (prev == (*kp->getVector())[ii]) && (prev == (*kd->getVector())[ii]);
+    }
+    if (consistent && ! ok) {
+      consistent = false;
+      ADD_FAILURE () << "inconsistent gains at tick " << tick;
+    }
+    sched_yield();
+  }
+  pthread_join(thread, 0);
+  ASSERT_TRUE (stage.apply().ok);
+  EXPECT_EQ (ta.nbatches, (*kp->getVector())[0]);
+  EXPECT_EQ (ta.nbatches, (*kd->getVector())[0]);
+}
+
+
+class LogTestReflection
+  : public ParameterReflection
+{
+public:
+  explicit LogTestReflection(parameter_flags_t string_flags = PARAMETER_FLAG_DEFAULT)
+    : ParameterReflection("test", "log"),
+      integer_(0),
+      real_(0),
+      vector_(Vector::Zero(3)),
+      matrix_(Matrix::Zero(2, 3)),
+      nolog_(0)
+  {
+    declareParameter("integer", &integer_);
+    declareParameter("string", &string_, string_flags);
+    declareParameter("real", &real_);
+    declareParameter("vector", &vector_);
+    declareParameter("matrix", &matrix_);
+    declareParameter("nolog", &nolog_, PARAMETER_FLAG_NOLOG);
+  }
+  
+  void set(int tick)
+  {
+    integer_ = tick;
+    ostringstream os;
+    os << "tick_" << tick;
+    string_ = os.str();
+    real_ = 0.1 * tick;
+    for (int ii(0); ii < vector_.rows(); ++ii) {
+      vector_[ii] = tick + 0.25 * ii;
+    }
+    for (int ii(0); ii < matrix_.rows(); ++ii) {
+      for (int jj(0); jj < matrix_.cols(); ++jj) {
+	matrix_.coeffRef(ii, jj) = tick - 10.0 * ii + 0.5 * jj;
+      }
+    }
+    nolog_ = tick;
+  }
+  
+  int integer_;
+  string string_;
+  double real_;
+  Vector vector_;
+  Matrix matrix_;
+  double nolog_;
+};
+
+
+static string slurp(string const & filename)
+{
+  ifstream is(filename.c_str());
+  ostringstream os;
+  os << is.rdbuf();
+  return os.str();
+}
+
+
+struct ring_producer_s {
+  ParameterRingLog * ring;
+  int volatile stop;
+  long long volatile nticks;
+};
+
+
+static void * ring_producer_thread(void * arg)
+{
+  ring_producer_s * producer(static_cast<ring_producer_s*>(arg));
+  for (long long tick(0); ! producer->stop; ++tick) {
+    producer->ring->update(tick);
+    producer->nticks = tick + 1;
+    usleep(10);
+  }
+  return 0;
+}
+
+
+TEST (parameter, ring_log)
+{
+  char tmpdir[] = "/tmp/testTask-XXXXXX";
+  ASSERT_NE ((char*) 0, mkdtemp(tmpdir));
+  string const dir(tmpdir);
+  
+  LogTestReflection obj;
+  ParameterLog reference("log", obj.getParameterTable());
+  ParameterRingLog ring("log", obj.getParameterTable(), 6);
+  EXPECT_EQ (8, ring.getCapacity());
+  EXPECT_EQ (5, ring.getColumns().size()) << "the nolog parameter should have been skipped";
+  
+  // records made before open() get written as well
+  obj.set(0);
+  reference.update(0);
+  ring.update(0);
+  Status st(ring.open(dir + "/ring.log", 1000));
+  ASSERT_TRUE (st.ok) << st.errstr;
+  
+  size_t const nticks(100);
+  for (size_t tick(1); tick < nticks; ++tick) {
+    obj.set(tick);
+    reference.update(tick);
+#ifdef __GLIBC__
+    n_malloc = 0;
+    count_malloc = true;
+    ring.update(tick);
+    count_malloc = false;
+    EXPECT_EQ (0, n_malloc) << "tick " << tick;
+#else
+    ring.update(tick);
+#endif
+    if (0 == tick % 4) {
+      ring.flush();
+    }
+  }
+  st = ring.close();
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_EQ (0, ring.getNDropped());
+  EXPECT_EQ (0, ring.getNMismatched());
+  EXPECT_EQ (nticks, ring.getNWritten());
+  
+  reference.writeFiles(dir + "/text", 0);
+  st = convertParameterLog(dir + "/ring.log", dir + "/binary", 0);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  static char const * names[] = { "integer", "string", "real", "vector", "matrix", 0 };
+  for (char const ** name(names); *name; ++name) {
+    string const text(dir + "/text-log-" + *name + ".dump");
+    string const binary(dir + "/binary-log-" + *name + ".dump");
+    string const expected(slurp(text));
+    EXPECT_LT (0, expected.size()) << text;
+    EXPECT_EQ (expected, slurp(binary)) << *name;
+    unlink(text.c_str());
+    unlink(binary.c_str());
+  }
+  unlink((dir + "/ring.log").c_str());
+  
+  // flush() returns while update() keeps adding records
+  ParameterRingLog busy("log", obj.getParameterTable(), 64);
+  st = busy.open(dir + "/busy.log", 100);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  ring_producer_s producer;
+  producer.ring = &busy;
+  producer.stop = 0;
+  producer.nticks = 0;
+  pthread_t thread;
+  ASSERT_EQ (0, pthread_create(&thread, 0, ring_producer_thread, &producer));
+  while (producer.nticks < 10) {
+    usleep(100);
+  }
+  for (size_t ii(0); ii < 20; ++ii) {
+    busy.flush();
+  }
+  producer.stop = 1;
+  pthread_join(thread, 0);
+  st = busy.close();
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_LT (0, busy.getNWritten());
+  unlink((dir + "/busy.log").c_str());
+  
+  rmdir(tmpdir);
+  EXPECT_FALSE (convertParameterLog(dir + "/ring.log", dir + "/binary", 0).ok);
+  
+  // without a flushing thread the ring fills up and drops records,
+  // and resized vectors get recorded as NaN
+  ParameterRingLog full("log", obj.getParameterTable(), 4);
+  full.update(0);
+  obj.vector_ = Vector::Ones(4);
+  full.update(1);
+  EXPECT_EQ (1, full.getNMismatched());
+  for (size_t tick(2); tick < 6; ++tick) {
+    full.update(tick);
+  }
+  EXPECT_EQ (2, full.getNDropped());
+}
+
+
+TEST (parameter, log_modes)
+{
+  LogTestReflection obj(PARAMETER_FLAG_LOG_CHANGES);
+  ParameterLog log("log", obj.getParameterTable());
+  EXPECT_TRUE (log.setDecimation("real", 5).ok);
+  EXPECT_TRUE (log.setChangeOnly("integer", true).ok);
+  EXPECT_FALSE (log.setDecimation("real", 0).ok);
+  EXPECT_FALSE (log.setDecimation("nolog", 2).ok) << "nolog parameters are not in the log";
+  EXPECT_FALSE (log.setChangeOnly("no_such_parameter", true).ok);
+  
+  for (int tick(0); tick < 20; ++tick) {
+    obj.set(tick);
+    obj.integer_ = tick / 4;
+    obj.string_ = (tick < 10) ? "low" : "high";
+    log.update(100 + tick);
+  }
+  EXPECT_EQ (20, log.timestamp.size());
+  ASSERT_EQ (1, log.intlog.size());
+  ASSERT_EQ (5, log.intlog[0].log.size());
+  ASSERT_EQ (1, log.strlog.size());
+  ASSERT_EQ (2, log.strlog[0].log.size()) << "string should have been change-only by flag";
+  EXPECT_EQ ("low", log.strlog[0].log[0]);
+  EXPECT_EQ ("high", log.strlog[0].log[1]);
+  EXPECT_EQ (100, log.strlog[0].timestamp[0]);
+  EXPECT_EQ (110, log.strlog[0].timestamp[1]);
+  ASSERT_EQ (1, log.reallog.size());
+  ASSERT_EQ (4, log.reallog[0].log.size());
+  ASSERT_EQ (1, log.veclog.size());
+  EXPECT_EQ (20, log.veclog[0].log.size());
+  for (int ii(0); ii < 5; ++ii) {
+    EXPECT_EQ (ii, log.intlog[0].log[ii]);
+    EXPECT_EQ (100 + 4 * ii, log.intlog[0].timestamp[ii]);
+  }
+  for (int ii(0); ii < 4; ++ii) {
+    EXPECT_EQ (0.1 * 5 * ii, log.reallog[0].log[ii]);
+    EXPECT_EQ (100 + 5 * ii, log.reallog[0].timestamp[ii]);
+  }
+  
+  char tmpdir[] = "/tmp/testTask-XXXXXX";
+  ASSERT_NE ((char*) 0, mkdtemp(tmpdir));
+  string const dir(tmpdir);
+  log.writeFiles(dir + "/modes", 0);
+  string const fn(dir + "/modes-log-string.dump");
+  EXPECT_EQ ("# name: log\n# parameter: string\n# type: string\n# size: 2\n100   low\n110   high\n",
+	     slurp(fn));
+  static char const * names[] = { "integer", "string", "real", "vector", "matrix", 0 };
+  for (char const ** name(names); *name; ++name) {
+    unlink((dir + "/modes-log-" + *name + ".dump").c_str());
+  }
+  
+  // black box: keeps the last 8 records and dumps them on failure
+  ParameterRingLog ring("log", obj.getParameterTable(), 8);
+  string const bbfn(dir + "/blackbox.log");
+  Status st(ring.openBlackBox(bbfn, 1000));
+  ASSERT_TRUE (st.ok) << st.errstr;
+  for (int tick(0); tick < 30; ++tick) {
+    obj.set(tick);
+#ifdef __GLIBC__
+    n_malloc = 0;
+    count_malloc = true;
+    ring.update(tick);
+    ring.triggerOnFailure(Status(tick != 20, "boom"));
+    count_malloc = false;
+    if (tick != 20) {
+      EXPECT_EQ (0, n_malloc) << "tick " << tick;
+    }
+#else
+    ring.update(tick);
+    ring.triggerOnFailure(Status(tick != 20, "boom"));
+#endif
+    EXPECT_EQ (tick >= 20, ring.isTriggered()) << "tick " << tick;
+  }
+  EXPECT_EQ (9, ring.getNDropped()) << "updates after the trigger should have been dropped";
+  for (size_t ii(0); ( ! ring.isDumped()) && (ii < 1000); ++ii) {
+    usleep(1000);
+  }
+  EXPECT_TRUE (ring.isDumped());
+  st = ring.close();
+  ASSERT_TRUE (st.ok) << st.errstr;
+  st = convertParameterLog(bbfn, dir + "/bb", 0);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  string expected("# name: log\n# parameter: real\n# type: real\n# size: 8\n");
+  for (int tick(13); tick <= 20; ++tick) {
+    ostringstream os;
+    os << tick << "   " << 0.1 * tick << "\n";
+    expected += os.str();
+  }
+  EXPECT_EQ (expected, slurp(dir + "/bb-log-real.dump"));
+  
+  // a trigger from another thread freezes after the next update
+  ParameterRingLog manual("log", obj.getParameterTable(), 4);
+  st = manual.openBlackBox(bbfn, 1000);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  manual.update(0);
+  manual.flush();		// returns right away while armed
+  manual.trigger();
+  EXPECT_FALSE (manual.isTriggered());
+  manual.update(1);
+  EXPECT_TRUE (manual.isTriggered());
+  manual.update(2);
+  manual.flush();		// waits for the dump
+  EXPECT_TRUE (manual.isDumped());
+  manual.flush();
+  st = manual.close();
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_EQ (1, manual.getNDropped());
+  
+  // the ring log decimates whole records
+  ParameterRingLog decimated("log", obj.getParameterTable(), 8);
+  EXPECT_FALSE (decimated.setDecimation(0).ok);
+  ASSERT_TRUE (decimated.setDecimation(3).ok);
+  string const decfn(dir + "/decimated.log");
+  st = decimated.open(decfn, 1000);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  for (int tick(0); tick < 10; ++tick) {
+    obj.set(tick);
+    decimated.update(tick);
+  }
+  st = decimated.close();
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_EQ (4, decimated.getNWritten());
+  EXPECT_EQ (0, decimated.getNDropped());
+  st = convertParameterLog(decfn, dir + "/dec", 0);
+  ASSERT_TRUE (st.ok) << st.errstr;
+  expected = "# name: log\n# parameter: real\n# type: real\n# size: 4\n";
+  for (int tick(0); tick < 10; tick += 3) {
+    ostringstream os;
+    os << tick << "   " << 0.1 * tick << "\n";
+    expected += os.str();
+  }
+  EXPECT_EQ (expected, slurp(dir + "/dec-log-real.dump"));
+  unlink(decfn.c_str());
+  
+  for (char const ** name(names); *name; ++name) {
+    unlink((dir + "/bb-log-" + *name + ".dump").c_str());
+    unlink((dir + "/dec-log-" + *name + ".dump").c_str());
+  }
+  unlink(bbfn.c_str());
+  rmdir(tmpdir);
+}
+
+
+struct telemetry_arg_s {
+  string shm_name;
+  bool volatile stop;
+  size_t nread;
+  size_t ninconsistent;
+};
+
+
+static void * telemetry_thread(void * arg)
+{
+  telemetry_arg_s * ta(reinterpret_cast<telemetry_arg_s*>(arg));
+  TelemetryReader reader;
+  if ( ! reader.attach(ta->shm_name)) {
+    ++ta->ninconsistent;
+    return 0;
+  }
+  int const iint(reader.findEntry("test", "log", "integer"));
+  int const ireal(reader.findEntry("test", "log", "real"));
+  int const ivec(reader.findEntry("test", "log", "vector"));
+  int const imx(reader.findEntry("test", "log", "matrix"));
+  Vector vv;
+  Matrix mm;
+  while ( ! ta->stop) {
+    if (reader.update()) {
+      int integer;
+      double real;
+      reader.getInteger(iint, integer);
+      reader.getReal(ireal, real);
+      reader.getVector(ivec, vv);
+      reader.getMatrix(imx, mm);
+      ++ta->nread;
+      if ((reader.getTimestamp() != integer) || (0.1 * integer != real)
+	  || (integer != vv[0]) || (integer != mm.coeff(0, 0))) {
+	++ta->ninconsistent;
+      }
+    }
+    sched_yield();
+  }
+  return 0;
+}
+
+
+TEST (parameter, telemetry)
+{
+  ostringstream shm_name;
+  shm_name << "/testTask-telemetry-" << getpid();
+  
+  shared_ptr<LogTestReflection> obj(new LogTestReflection());
+  shared_ptr<JPosTask> jpos(new JPosTask("jpos"));
+  ReflectionRegistry reg;
+  reg.add(obj);
+  reg.add(jpos);
+  ReflectionRegistry::enumeration_t enumeration;
+  reg.enumerate(enumeration);
+  
+  TelemetryPublisher publisher;
+  Status st(publisher.open(shm_name.str(), reg));
+  ASSERT_TRUE (st.ok) << st.errstr;
+  EXPECT_EQ (enumeration.size(), publisher.getNEntries());
+  
+  TelemetryReader reader;
+  st = reader.attach(shm_name.str());
+  ASSERT_TRUE (st.ok) << st.errstr;
+  ASSERT_EQ (enumeration.size(), reader.getNEntries());
+  int const iint(reader.findEntry("test", "log", "integer"));
+  int const istr(reader.findEntry("test", "log", "string"));
+  int const ireal(reader.findEntry("test", "log", "real"));
+  int const ivec(reader.findEntry("test", "log", "vector"));
+  int const imx(reader.findEntry("test", "log", "matrix"));
+  ASSERT_LE (0, iint);
+  ASSERT_LE (0, istr);
+  ASSERT_LE (0, ireal);
+  ASSERT_LE (0, ivec);
+  ASSERT_LE (0, imx);
+  EXPECT_LE (0, reader.findEntry("task", "jpos", "kp"));
+  EXPECT_EQ (-1, reader.findEntry("task", "jpos", "no_such_parameter"));
+  EXPECT_EQ (3, reader.getEntry(ivec).rows);
+  EXPECT_EQ (2, reader.getEntry(imx).rows);
+  EXPECT_EQ (3, reader.getEntry(imx).cols);
+  
+  obj->set(7);
+#ifdef __GLIBC__
+  n_malloc = 0;
+  count_malloc = true;
+  publisher.publish(7);
+  count_malloc = false;
+  EXPECT_EQ (0, n_malloc);
+#else
+  publisher.publish(7);
+#endif
+  ASSERT_TRUE (reader.update());
+  EXPECT_EQ (7, reader.getTimestamp());
+  EXPECT_EQ (2, reader.getSequence());
+  int integer;
+  string str;
+  double real;
+  Vector vv;
+  Matrix mm;
+  ASSERT_TRUE (reader.getInteger(iint, integer));
+  ASSERT_TRUE (reader.getString(istr, str));
+  ASSERT_TRUE (reader.getReal(ireal, real));
+  ASSERT_TRUE (reader.getVector(ivec, vv));
+  ASSERT_TRUE (reader.getMatrix(imx, mm));
+  EXPECT_FALSE (reader.getReal(iint, real)) << "type mismatch should have been caught";
+  EXPECT_EQ (obj->integer_, integer);
+  EXPECT_EQ (obj->string_, str);
+  EXPECT_EQ (obj->real_, real);
+  ASSERT_EQ (3, vv.rows());
+  for (int ii(0); ii < 3; ++ii) {
+    EXPECT_EQ (obj->vector_[ii], vv[ii]);
+  }
+  ASSERT_EQ (2, mm.rows());
+  ASSERT_EQ (3, mm.cols());
+  for (int ii(0); ii < 2; ++ii) {
+    for (int jj(0); jj < 3; ++jj) {
+      EXPECT_EQ (obj->matrix_.coeff(ii, jj), mm.coeff(ii, jj));
+    }
+  }
+  
+  obj->vector_ = Vector::Ones(4);
+  publisher.publish(8);
+  EXPECT_EQ (1, publisher.getNMismatched());
+  ASSERT_TRUE (reader.update());
+  ASSERT_TRUE (reader.getVector(ivec, vv));
+  EXPECT_NE (vv[0], vv[0]) << "resized vector should have been published as NaN";
+  obj->vector_ = Vector::Zero(3);
+  
+  // a concurrent reader never sees a half-written snapshot
+  telemetry_arg_s ta;
+  ta.shm_name = shm_name.str();
+  ta.stop = false;
+  ta.nread = 0;
+  ta.ninconsistent = 0;
+  pthread_t thread;
+  ASSERT_EQ (0, pthread_create(&thread, 0, telemetry_thread, &ta));
+  for (size_t tick(0); (tick < 100000) && (ta.nread < 1000); ++tick) {
+    obj->set(tick);
+    publisher.publish(tick);
+    if (0 == tick % 16) {
+      sched_yield();
+    }
+  }
+  ta.stop = true;
+  pthread_join(thread, 0);
+  EXPECT_LT (0, ta.nread);
+  EXPECT_EQ (0, ta.ninconsistent);
+  
+  // corrupt layouts get rejected instead of being read out of bounds
+  int const fd(shm_open(shm_name.str().c_str(), O_RDWR, 0));
+  ASSERT_LE (0, fd) << strerror(errno);
+  struct stat sb;
+  ASSERT_EQ (0, fstat(fd, &sb));
+  void * segment(mmap(0, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  close(fd);
+  ASSERT_NE (MAP_FAILED, segment);
+  telemetry_header_s * header(static_cast<telemetry_header_s *>(segment));
+  telemetry_entry_s * schema(reinterpret_cast<telemetry_entry_s *>
+			     (static_cast<char *>(segment) + header->schema_offset));
+  TelemetryReader corrupt;
+  uint32_t const offset(schema[ivec].offset);
+  schema[ivec].offset = header->data_size - sizeof(double);
+  EXPECT_FALSE (corrupt.attach(shm_name.str()).ok) << "vector beyond the data block";
+  schema[ivec].offset = 0xfffffff0;
+  EXPECT_FALSE (corrupt.attach(shm_name.str()).ok) << "offset wrapping around";
+  schema[ivec].offset = offset;
+  schema[imx].rows = 1000;
+  EXPECT_FALSE (corrupt.attach(shm_name.str()).ok) << "matrix shape not matching its size";
+  schema[imx].rows = 2;
+  uint32_t const data_size(header->data_size);
+  header->data_size = 0xffffffff;
+  EXPECT_FALSE (corrupt.attach(shm_name.str()).ok) << "data block beyond the segment";
+  header->data_size = data_size;
+  uint32_t const nentries(header->nentries);
+  header->nentries = 0x10000000;
+  EXPECT_FALSE (corrupt.attach(shm_name.str()).ok) << "schema overlapping the data block";
+  header->nentries = nentries;
+  st = corrupt.attach(shm_name.str());
+  EXPECT_TRUE (st.ok) << "restored segment should be accepted: " << st.errstr;
+  corrupt.detach();
+  munmap(segment, sb.st_size);
+  
+  publisher.close();
+  reader.detach();
+  EXPECT_FALSE (reader.attach(shm_name.str()).ok) << "segment should have been unlinked";
+}
+
+
+TEST (task, jacobian_cache)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    size_t const ee_id(ndof - 1);
+    
+    // position and orientation of the same end effector share one
+    // cache entry per tick: the position tasks fill in the linear
+    // half and the orientation task the angular one, so the second
+    // position task gets a hit
+    shared_ptr<CartPosTask> pos(new CartPosTask("pos"));
+    pos->quickSetup(100.0 * Vector::Ones(1), 20.0 * Vector::Ones(1), Vector::Ones(1),
+		    puma->getNodeName(ee_id), Vector::Zero(3));
+    shared_ptr<CartPosTask> pos2(new CartPosTask("pos2"));
+    pos2->quickSetup(50.0 * Vector::Ones(1), 10.0 * Vector::Ones(1), Vector::Ones(1),
+		    puma->getNodeName(ee_id), Vector::Zero(3));
+    shared_ptr<OrientationTask> ori(new OrientationTask("ori"));
+    Parameter * param(ori->lookupParameter("end_effector_id", PARAMETER_TYPE_INTEGER));
+    ASSERT_NE ((void*)0, param) << "failed to get end_effector_id param";
+    Status st(param->set(int(ee_id)));
+    ASSERT_TRUE (st.ok) << "failed to set end_effector_id: " << st.errstr;
+    
+    GenericSkill gb("gb");
+    gb.appendTask(pos);
+    gb.appendTask(ori);
+    gb.appendTask(pos2);
+    st = gb.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init generic skill: " << st.errstr;
+    
+    Parameter const * pos_hits(pos->lookupParameter("jacobian_cache_hits", PARAMETER_TYPE_INTEGER));
+    Parameter const * pos_misses(pos->lookupParameter("jacobian_cache_misses", PARAMETER_TYPE_INTEGER));
+    Parameter const * ori_hits(ori->lookupParameter("jacobian_cache_hits", PARAMETER_TYPE_INTEGER));
+    Parameter const * ori_misses(ori->lookupParameter("jacobian_cache_misses", PARAMETER_TYPE_INTEGER));
+    Parameter const * pos2_hits(pos2->lookupParameter("jacobian_cache_hits", PARAMETER_TYPE_INTEGER));
+    Parameter const * pos2_misses(pos2->lookupParameter("jacobian_cache_misses", PARAMETER_TYPE_INTEGER));
+    ASSERT_NE ((void*)0, pos_hits);
+    ASSERT_NE ((void*)0, pos_misses);
+    ASSERT_NE ((void*)0, ori_hits);
+    ASSERT_NE ((void*)0, ori_misses);
+    ASSERT_NE ((void*)0, pos2_hits);
+    ASSERT_NE ((void*)0, pos2_misses);
+    
+    State state(puma->getState());
+    deThreadPool pool(2);
+    for (size_t tick(0); tick < 10; ++tick) {
+      gb.setThreadPool((tick % 2) ? &pool : 0);
+      state.position_[1] += 0.01;
+      puma->update(state);
+      int const hits(*pos_hits->getInteger() + *ori_hits->getInteger() + *pos2_hits->getInteger());
+      int const misses(*pos_misses->getInteger() + *ori_misses->getInteger() + *pos2_misses->getInteger());
+      size_t const model_hits(puma->getJacobianCacheHits());
+      size_t const model_misses(puma->getJacobianCacheMisses());
+      st = gb.update(*puma);
+      ASSERT_TRUE (st.ok) << "update failed: " << st.errstr;
+      
+      // setState() invalidated the cache, so the first query for
+      // each half misses. In parallel, tasks can race for the same
+      // entry.
+      int const dhits(*pos_hits->getInteger() + *ori_hits->getInteger() + *pos2_hits->getInteger() - hits);
+      int const dmisses(*pos_misses->getInteger() + *ori_misses->getInteger() + *pos2_misses->getInteger() - misses);
+      EXPECT_EQ (3, dhits + dmisses) << "tick " << tick;
+      EXPECT_LE (2, dmisses) << "tick " << tick;
+      if (0 == tick % 2) {
+	EXPECT_EQ (2, dmisses) << "tick " << tick;
+      }
+      EXPECT_EQ (dhits, puma->getJacobianCacheHits() - model_hits) << "tick " << tick;
+      EXPECT_EQ (dmisses, puma->getJacobianCacheMisses() - model_misses) << "tick " << tick;
+      
+      Matrix Jfull;
+      jspace::Transform ee_transform;
+      ASSERT_TRUE (puma->computeGlobalFrame(puma->getNode(ee_id), 0.0, 0.0, 0.0, ee_transform));
+      ASSERT_TRUE (puma->computeJacobian(puma->getNode(ee_id), ee_transform.translation(), Jfull));
+      for (size_t ii(0); ii < 3; ++ii) {
+	EXPECT_EQ (ee_transform.translation()[ii], pos->getActual()[ii]) << "tick " << tick;
+	for (size_t jj(0); jj < ndof; ++jj) {
+	  EXPECT_EQ (Jfull(ii, jj), pos->getJacobian()(ii, jj)) << "tick " << tick;
+	  EXPECT_EQ (Jfull(ii, jj), pos2->getJacobian()(ii, jj)) << "tick " << tick;
+	  EXPECT_EQ (Jfull(ii + 3, jj), ori->getJacobian()(ii, jj)) << "tick " << tick;
+	}
+      }
+    }
+    gb.setThreadPool(0);
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+TEST (sparse_jacobian, task_inertia)
+{
+  Model * fork(0);
+  try {
+    fork = jspace::test::create_fork_4R_model();
+    State state(fork->getNDOF(), fork->getNDOF(), 0);
+    for (size_t ii(0); ii < fork->getNDOF(); ++ii) {
+      state.position_[ii] = 0.3 * ii - 0.4;
+      state.velocity_[ii] = 0.1 * ii + 0.2;
+    }
+    fork->update(state);
+    Model * models[] = { get_puma(), fork };
+    
+    for (size_t imodel(0); imodel < 2; ++imodel) {
+      Model const & model(*models[imodel]);
+      size_t const ndof(model.getNDOF());
+      Matrix ainv;
+      ASSERT_TRUE (model.getInverseMassInertia(ainv));
+      
+      for (size_t inode(0); inode < model.getNNodes(); ++inode) {
+	taoDNode const * node(model.getNode(inode));
+	Matrix jac;
+	ASSERT_TRUE (model.computeJacobian(node, jac));
+	
+	SparseJacobian sparse;
+	Status st(sparse.init(model, node, 6));
+	ASSERT_TRUE (st.ok) << "model " << imodel << " node " << inode << ": " << st.errstr;
+	vector<size_t> const & dof(sparse.getDOF());
+	ASSERT_LE (dof.size(), ndof);
+	
+	// columns of non-supporting DOF really are zero
+	vector<bool> support(ndof, false);
+	for (size_t kk(0); kk < dof.size(); ++kk) {
+	  support[dof[kk]] = true;
+	}
+	for (size_t jj(0); jj < ndof; ++jj) {
+	  if ( ! support[jj]) {
+	    for (size_t ii(0); ii < 6; ++ii) {
+	      EXPECT_EQ (0.0, jac(ii, jj)) << "model " << imodel << " node " << inode << " dof " << jj;
+	    }
+	  }
+	}
+	
+	sparse.gather(jac);
+	Matrix dense;
+	sparse.scatter(dense);
+	for (size_t ii(0); ii < 6; ++ii) {
+	  for (size_t jj(0); jj < ndof; ++jj) {
+	    EXPECT_EQ (jac(ii, jj), dense(ii, jj));
+	  }
+	}
+	
+	Matrix const ainv_jt_want(ainv * jac.transpose());
+	Matrix const lambda_inv_want(jac * ainv_jt_want);
+	Matrix ainv_jt, lambda_inv;
+	computeSparseAinvJt(sparse, ainv, ainv_jt);
+	computeSparseLambdaInverse(sparse, ainv_jt, lambda_inv);
+	ASSERT_EQ (ndof, ainv_jt.rows());
+	ASSERT_EQ (6, ainv_jt.cols());
+	ASSERT_EQ (6, lambda_inv.rows());
+	ASSERT_EQ (6, lambda_inv.cols());
+	for (size_t ii(0); ii < ndof; ++ii) {
+	  for (size_t jj(0); jj < 6; ++jj) {
+	    EXPECT_NEAR (ainv_jt_want(ii, jj), ainv_jt(ii, jj), 1e-12 * (1 + fabs(ainv_jt_want(ii, jj))))
+	      << "model " << imodel << " node " << inode;
+	  }
+	}
+	for (size_t ii(0); ii < 6; ++ii) {
+	  for (size_t jj(0); jj < 6; ++jj) {
+	    EXPECT_NEAR (lambda_inv_want(ii, jj), lambda_inv(ii, jj), 1e-12 * (1 + fabs(lambda_inv_want(ii, jj))))
+	      << "model " << imodel << " node " << inode;
+	  }
+	}
+	
+	Vector const & qd(model.getState().velocity_);
+	Vector const xd_want(jac * qd);
+	Vector xd;
+	EXPECT_TRUE (sparse.multiply(qd, xd));
+	Vector ff(6);
+	for (size_t ii(0); ii < 6; ++ii) {
+	  ff[ii] = 1.0 - 0.3 * ii;
+	}
+	Vector const tau_want(jac.transpose() * ff);
+	Vector tau;
+	EXPECT_TRUE (sparse.multiplyTranspose(ff, tau));
+	ASSERT_EQ (6, xd.size());
+	ASSERT_EQ (ndof, tau.size());
+	for (size_t ii(0); ii < 6; ++ii) {
+	  EXPECT_NEAR (xd_want[ii], xd[ii], 1e-12 * (1 + fabs(xd_want[ii])));
+	}
+	for (size_t ii(0); ii < ndof; ++ii) {
+	  EXPECT_NEAR (tau_want[ii], tau[ii], 1e-12 * (1 + fabs(tau_want[ii])));
+	}
+	
+	// wrong-sized inputs are rejected instead of read out of bounds
+	Vector const short_qd(Vector::Zero(ndof - 1));
+	EXPECT_EQ (jspace::STATUS_INVALID_DIMENSION, sparse.multiply(short_qd, xd).code);
+	Vector const short_ff(Vector::Zero(5));
+	EXPECT_EQ (jspace::STATUS_INVALID_DIMENSION, sparse.multiplyTranspose(short_ff, tau).code);
+      }
+    }
+    
+    vector<size_t> unsorted;
+    unsorted.push_back(2);
+    unsorted.push_back(1);
+    SparseJacobian sparse;
+    EXPECT_FALSE (sparse.init(unsorted, 3, 3).ok);
+    unsorted[0] = 0;
+    unsorted[1] = 3;
+    EXPECT_FALSE (sparse.init(unsorted, 3, 3).ok);
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+  delete fork;
+}
+
+
+namespace {
+  
+  // Hides the SparseJacobian from the controllers, which then take
+  // the dense path.
+  class DenseCartPosTask
+    : public CartPosTask
+  {
+  public:
+    explicit DenseCartPosTask(std::string const & name) : CartPosTask(name) {}
+    virtual SparseJacobian const * getSparseJacobian() const { return 0; }
+  };
+  
+}
+
+
+TEST (sparse_jacobian, controllers)
+{
+  Model * fork(0);
+  try {
+    fork = jspace::test::create_fork_4R_model();
+    size_t const ndof(fork->getNDOF());
+    State state(ndof, ndof, 0);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      state.position_[ii] = 0.3 * ii - 0.4;
+      state.velocity_[ii] = 0.1 * ii + 0.2;
+    }
+    fork->update(state);
+    
+    bool some_sparse(false);
+    for (size_t inode(0); inode < fork->getNNodes(); ++inode) {
+      if (fork->getNodeName(inode).empty()) {
+	continue;		// CartPosTask looks up end effectors by name
+      }
+      shared_ptr<CartPosTask> task[2];
+      task[0].reset(new CartPosTask("sparse"));
+      task[1].reset(new DenseCartPosTask("dense"));
+      Vector gamma[2][2];
+      for (size_t it(0); it < 2; ++it) {
+	task[it]->quickSetup(100.0 * Vector::Ones(1), 20.0 * Vector::Ones(1), Vector::Ones(1),
+			     fork->getNodeName(inode), Vector::Zero(3));
+	shared_ptr<JPosTask> posture(new JPosTask("posture"));
+	posture->quickSetup(10.0 * Vector::Ones(ndof), 2.0 * Vector::Ones(ndof), Vector::Ones(ndof));
+	GenericSkill skill("skill");
+	skill.appendTask(task[it]);
+	skill.appendTask(posture);
+	Status st(skill.init(*fork));
+	ASSERT_TRUE (st.ok) << "node " << inode << ": " << st.errstr;
+	
+	// move the goal so that the task command is not zero
+	Vector goal(task[it]->getActual());
+	goal[0] += 0.1;
+	ASSERT_TRUE (set_vector_param(*task[it], "goalpos", goal).ok);
+	st = skill.update(*fork);
+	ASSERT_TRUE (st.ok) << "node " << inode << ": " << st.errstr;
+	
+	ClassicTaskPostureController classic("classic");
+	HierarchicalController hierarchical("hierarchical");
+	Controller * ctrl[] = { &classic, &hierarchical };
+	for (size_t ic(0); ic < 2; ++ic) {
+	  st = ctrl[ic]->init(*fork);
+	  ASSERT_TRUE (st.ok) << "node " << inode << ": " << st.errstr;
+	  st = ctrl[ic]->computeCommand(*fork, skill, gamma[it][ic]);
+	  ASSERT_TRUE (st.ok) << "node " << inode << ": " << st.errstr;
+	}
+      }
+      
+      SparseJacobian const * sparse(task[0]->getSparseJacobian());
+      ASSERT_NE ((void*)0, sparse) << "node " << inode;
+      EXPECT_EQ ((void*)0, task[1]->getSparseJacobian());
+      if (sparse->getDOF().size() < ndof) {
+	some_sparse = true;
+      }
+      for (size_t ic(0); ic < 2; ++ic) {
+	ASSERT_EQ (ndof, gamma[0][ic].size());
+	ASSERT_EQ (ndof, gamma[1][ic].size());
+	for (size_t ii(0); ii < ndof; ++ii) {
+	  EXPECT_NEAR (gamma[1][ic][ii], gamma[0][ic][ii], 1e-9 * (1 + fabs(gamma[1][ic][ii])))
+	    << "node " << inode << " controller " << ic << " dof " << ii;
+	}
+      }
+    }
+    EXPECT_TRUE (some_sparse) << "the fork should have nodes supported by a subset of its DOF";
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+  delete fork;
+}
+
+
 TEST (task, jlimit)
 {
   shared_ptr<JointLimitTask> jlimit(new JointLimitTask("jlimit"));
@@ -366,6 +1956,558 @@ TEST (task, jlimit)
 }
 
 
+TEST (otg, cached_cursor)
+{
+  size_t const ndof(3);
+  double const dt(0.01);
+  TypeIOTGCursor cached(ndof, dt);
+  TypeIOTGCursor fresh(ndof, dt);
+  fresh.setCaching(false);
+  
+  Vector maxvel(ndof), maxacc(ndof), goal(ndof);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    maxvel[ii] = 0.5 + 0.1 * ii;
+    maxacc[ii] = 1.5 - 0.2 * ii;
+    goal[ii] = 0.3 * ii - 0.4;
+    cached.position()[ii] = fresh.position()[ii] = 0.1 * ii;
+    cached.velocity()[ii] = fresh.velocity()[ii] = 0.05 - 0.1 * ii;
+  }
+  
+  size_t nreplanned(0);
+  for (size_t tick(0); tick < 800; ++tick) {
+    if (200 == tick) {
+      goal[1] += 0.2;		// a changed goal must trigger replanning
+    }
+    if (400 == tick) {		// so must re-anchoring the cursor
+      cached.position()[0] = fresh.position()[0] = 0.7;
+      cached.velocity()[0] = fresh.velocity()[0] = 0.0;
+    }
+    int const cres(cached.next(maxvel, maxacc, goal));
+    int const fres(fresh.next(maxvel, maxacc, goal));
+    ASSERT_LE (0, cres) << "tick " << tick << ": " << otg_errstr(cres);
+    ASSERT_LE (0, fres) << "tick " << tick << ": " << otg_errstr(fres);
+    EXPECT_TRUE (fresh.replanned());
+    if ((0 == tick) || (200 == tick) || (400 == tick)) {
+      EXPECT_TRUE (cached.replanned()) << "tick " << tick;
+    }
+    if (cached.replanned()) {
+      ++nreplanned;
+    }
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_NEAR (fresh.position()[ii], cached.position()[ii], 1e-6) << "tick " << tick << " dof " << ii;
+      EXPECT_NEAR (fresh.velocity()[ii], cached.velocity()[ii], 1e-6) << "tick " << tick << " dof " << ii;
+    }
+  }
+  EXPECT_EQ (3, nreplanned);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    EXPECT_NEAR (goal[ii], cached.position()[ii], 1e-9) << "dof " << ii;
+    EXPECT_NEAR (0.0, cached.velocity()[ii], 1e-9) << "dof " << ii;
+  }
+}
+
+
+TEST (otg, unsync_cursor)
+{
+  // Each DOF exercises a different profile shape: trapezoid,
+  // triangle, initial velocity above maxvel, moving away from the
+  // goal, overshooting, already at rest on the goal, and a DOF which
+  // is not selected.
+  static double const pos0[] = { 0.0,  0.0,  0.0,  0.3, -0.2,  0.4,  1.0 };
+  static double const vel0[] = { 0.0,  0.2,  1.5, -0.4,  0.9,  0.0, -0.3 };
+  static double const goal[] = { 2.0, -0.1,  0.5,  0.8,  0.0,  0.4,  0.0 };
+  static double const vmax[] = { 0.5,  0.6,  0.7,  0.8,  0.9,  1.0,  1.1 };
+  static double const amax[] = { 1.0,  1.5,  2.0,  0.5,  1.2,  2.5,  3.0 };
+  size_t const ndof(sizeof(pos0) / sizeof(*pos0));
+  double const dt(0.01);
+  
+  TypeIOTGUnsyncCursor fused(ndof, dt);
+  vector<shared_ptr<TypeIOTGCursor> > single;
+  Vector maxvel(ndof), maxacc(ndof), pgoal(ndof);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    fused.position()[ii] = pos0[ii];
+    fused.velocity()[ii] = vel0[ii];
+    maxvel[ii] = vmax[ii];
+    maxacc[ii] = amax[ii];
+    pgoal[ii] = goal[ii];
+    single.push_back(shared_ptr<TypeIOTGCursor>(new TypeIOTGCursor(1, dt)));
+    single[ii]->setCaching(false);
+    single[ii]->position()[0] = pos0[ii];
+    single[ii]->velocity()[0] = vel0[ii];
+  }
+  fused.selection()[ndof - 1] = false;
+  
+  int fres(TypeIOTG::OTG_WORKING);
+  for (size_t tick(0); tick < 600; ++tick) {
+    fres = fused.next(maxvel, maxacc, pgoal);
+    ASSERT_LE (0, fres) << "tick " << tick << ": " << otg_errstr(fres);
+    for (size_t ii(0); ii < ndof - 1; ++ii) {
+      int const sres(single[ii]->next(vmax[ii], amax[ii], goal[ii]));
+      ASSERT_LE (0, sres) << "tick " << tick << " dof " << ii << ": " << otg_errstr(sres);
+      EXPECT_NEAR (single[ii]->position()[0], fused.position()[ii], 1e-9) << "tick " << tick << " dof " << ii;
+      EXPECT_NEAR (single[ii]->velocity()[0], fused.velocity()[ii], 1e-9) << "tick " << tick << " dof " << ii;
+    }
+  }
+  EXPECT_EQ (TypeIOTG::OTG_FINAL_STATE_REACHED, fres);
+  for (size_t ii(0); ii < ndof - 1; ++ii) {
+    EXPECT_EQ (goal[ii], fused.position()[ii]) << "dof " << ii;
+    EXPECT_EQ (0.0, fused.velocity()[ii]) << "dof " << ii;
+  }
+  EXPECT_EQ (pos0[ndof - 1], fused.position()[ndof - 1]) << "unselected DOF must not move";
+  EXPECT_EQ (vel0[ndof - 1], fused.velocity()[ndof - 1]) << "unselected DOF must not move";
+  
+  maxacc[0] = 0.0;
+  EXPECT_EQ (TypeIOTG::OTG_MAX_ACCELERATION_ERROR, fused.next(maxvel, maxacc, pgoal));
+  maxacc[0] = amax[0];
+  maxvel[ndof - 1] = 0.0;	// not selected, hence not checked
+  EXPECT_EQ (TypeIOTG::OTG_FINAL_STATE_REACHED, fused.next(maxvel, maxacc, pgoal));
+}
+
+
+TEST (otg, preview)
+{
+  size_t const ndof(3);
+  size_t const nsamples(400);
+  double const dt(0.01);
+  TypeIOTGCursor cursor(ndof, dt);
+  TypeIOTGCursor reference(ndof, dt);
+  
+  Vector maxvel(ndof), maxacc(ndof), goal(ndof);
+  for (size_t ii(0); ii < ndof; ++ii) {
+    maxvel[ii] = 0.5 + 0.1 * ii;
+    maxacc[ii] = 1.5 - 0.2 * ii;
+    goal[ii] = 0.3 * ii - 0.4;
+    cursor.position()[ii] = reference.position()[ii] = 0.1 * ii;
+    cursor.velocity()[ii] = reference.velocity()[ii] = 0.05 - 0.1 * ii;
+  }
+  
+  // Preview partway along the trajectory, so that the cached
+  // trajectory of the cursor is already in use.
+  for (size_t tick(0); tick < 10; ++tick) {
+    ASSERT_LE (0, cursor.next(maxvel, maxacc, goal));
+    ASSERT_LE (0, reference.next(maxvel, maxacc, goal));
+  }
+  
+  TypeIOTGTrajectory trj;
+  int const pres(cursor.preview(maxvel, maxacc, goal, trj));
+  ASSERT_EQ (TypeIOTG::OTG_WORKING, pres) << otg_errstr(pres);
+  ASSERT_EQ (ndof, trj.getNDOF());
+  EXPECT_LT (0.0, trj.getDuration());
+  EXPECT_GT (nsamples * dt, trj.getDuration());
+  for (size_t jj(0); jj < ndof; ++jj) {
+    size_t const nseg(trj.getNSegments(jj));
+    ASSERT_LT (0, nseg) << "dof " << jj;
+    EXPECT_EQ (0.0, trj.getSegment(jj, 0).t_begin) << "dof " << jj;
+    for (size_t kk(1); kk < nseg; ++kk) {
+      otg_segment_s const & prev(trj.getSegment(jj, kk - 1));
+      otg_segment_s const & seg(trj.getSegment(jj, kk));
+      EXPECT_EQ (prev.t_end, seg.t_begin) << "dof " << jj << " segment " << kk;
+      double const tau(seg.t_begin - prev.t_begin);
+      EXPECT_NEAR (prev.position + tau * (prev.velocity + 0.5 * prev.acceleration * tau),
+		   seg.position, 1e-9) << "dof " << jj << " segment " << kk;
+      EXPECT_NEAR (prev.velocity + prev.acceleration * tau,
+		   seg.velocity, 1e-9) << "dof " << jj << " segment " << kk;
+    }
+    EXPECT_EQ (numeric_limits<double>::infinity(), trj.getSegment(jj, nseg - 1).t_end) << "dof " << jj;
+  }
+  
+  vector<double> pos(ndof * nsamples), vel(ndof * nsamples);
+  trj.sample(dt, dt, nsamples, &pos[0], &vel[0]);
+  Matrix mpos, mvel;
+  trj.sample(dt, dt, nsamples, mpos, mvel);
+  ASSERT_EQ (nsamples, mpos.rows());
+  ASSERT_EQ (ndof, mpos.cols());
+  
+  for (size_t ii(0); ii < nsamples; ++ii) {
+    ASSERT_LE (0, cursor.next(maxvel, maxacc, goal));
+    EXPECT_FALSE (cursor.replanned()) << "preview must not invalidate the cached trajectory";
+    ASSERT_LE (0, reference.next(maxvel, maxacc, goal));
+    for (size_t jj(0); jj < ndof; ++jj) {
+      EXPECT_EQ (reference.position()[jj], cursor.position()[jj]) << "sample " << ii << " dof " << jj;
+      EXPECT_NEAR (cursor.position()[jj], pos[jj * nsamples + ii], 1e-9) << "sample " << ii << " dof " << jj;
+      EXPECT_NEAR (cursor.velocity()[jj], vel[jj * nsamples + ii], 1e-9) << "sample " << ii << " dof " << jj;
+      EXPECT_EQ (pos[jj * nsamples + ii], mpos.coeff(ii, jj)) << "sample " << ii << " dof " << jj;
+      EXPECT_EQ (vel[jj * nsamples + ii], mvel.coeff(ii, jj)) << "sample " << ii << " dof " << jj;
+    }
+  }
+  
+  CartPosTrjTask uninitialized("uninitialized");
+  EXPECT_FALSE (uninitialized.previewTrajectory(trj).ok);
+}
+
+
+static Matrix create_psd(size_t dim, size_t rank, double offset)
+{
+  Matrix bb(dim, rank);
+  for (size_t ii(0); ii < dim; ++ii) {
+    for (size_t jj(0); jj < rank; ++jj) {
+      bb.coeffRef(ii, jj) = sin(1.3 * ii + 0.7 * jj + 0.2) + 0.1 * jj;
+    }
+  }
+  Matrix mm(bb * bb.transpose());
+  for (size_t ii(0); ii < dim; ++ii) {
+    mm.coeffRef(ii, ii) += offset;
+  }
+  return mm;
+}
+
+
+static void expect_same_pinv(Matrix const & mm, double sigma_threshold)
+{
+  Matrix inv_svd, inv_sym, inv_sym_nosv;
+  Vector sv_svd, sv_sym;
+  pseudoInverse(mm, sigma_threshold, inv_svd, &sv_svd);
+  symmetricPseudoInverse(mm, sigma_threshold, inv_sym, &sv_sym);
+  symmetricPseudoInverse(mm, sigma_threshold, inv_sym_nosv, 0);
+  ASSERT_EQ (sv_svd.rows(), sv_sym.rows());
+  for (int ii(0); ii < sv_svd.rows(); ++ii) {
+    EXPECT_NEAR (sv_svd[ii], sv_sym[ii], 1e-9) << "sv[" << ii << "]";
+  }
+  ASSERT_EQ (inv_svd.rows(), inv_sym.rows());
+  ASSERT_EQ (inv_svd.cols(), inv_sym.cols());
+  for (int ii(0); ii < inv_svd.rows(); ++ii) {
+    for (int jj(0); jj < inv_svd.cols(); ++jj) {
+      double const tol(1e-7 * (1 + fabs(inv_svd.coeff(ii, jj))));
+      EXPECT_NEAR (inv_svd.coeff(ii, jj), inv_sym.coeff(ii, jj), tol) << "[" << ii << "][" << jj << "]";
+      EXPECT_NEAR (inv_svd.coeff(ii, jj), inv_sym_nosv.coeff(ii, jj), tol) << "[" << ii << "][" << jj << "]";
+    }
+  }
+}
+
+
+TEST (pseudo_inverse, symmetric)
+{
+  // well conditioned, takes the Cholesky path
+  expect_same_pinv(create_psd(5, 5, 0.1), 1e-3);
+  // rank deficient, takes the eigendecomposition path
+  expect_same_pinv(create_psd(5, 2, 0.0), 1e-3);
+  // full rank, but one eigenvalue below the threshold
+  expect_same_pinv(create_psd(4, 3, 5e-4), 1e-3);
+  // the 1x1 special case
+  expect_same_pinv(create_psd(1, 1, 0.0), 1e-3);
+  expect_same_pinv(Matrix::Zero(1, 1), 1e-3);
+}
+
+
+TEST (pseudo_inverse, symmetric_fixed_size)
+{
+  for (size_t rank(1); rank <= 6; ++rank) {
+    Matrix const mm(create_psd(6, rank, 0));
+    Matrix inv;
+    Vector sv;
+    symmetricPseudoInverse(mm, 1e-3, inv, &sv);
+    
+    Eigen::Matrix<double, 6, 6> mm6(mm), inv6;
+    Eigen::Matrix<double, 6, 1> sv6;
+    symmetricPseudoInverse(mm6, 1e-3, inv6, &sv6);
+    for (int ii(0); ii < 6; ++ii) {
+      EXPECT_NEAR (sv[ii], sv6[ii], 1e-9) << "rank " << rank;
+      for (int jj(0); jj < 6; ++jj) {
+	EXPECT_NEAR (inv.coeff(ii, jj), inv6.coeff(ii, jj), 1e-7 * (1 + fabs(inv.coeff(ii, jj))))
+	  << "rank " << rank;
+      }
+    }
+    
+    Matrix const m3(mm.block(0, 0, 3, 3));
+    symmetricPseudoInverse(m3, 1e-3, inv, &sv);
+    Eigen::Matrix3d mm3(m3), inv3;
+    Eigen::Vector3d sv3;
+    symmetricPseudoInverse(mm3, 1e-3, inv3, &sv3);
+    for (int ii(0); ii < 3; ++ii) {
+      EXPECT_NEAR (sv[ii], sv3[ii], 1e-9) << "rank " << rank;
+      for (int jj(0); jj < 3; ++jj) {
+	EXPECT_NEAR (inv.coeff(ii, jj), inv3.coeff(ii, jj), 1e-7 * (1 + fabs(inv.coeff(ii, jj))))
+	  << "rank " << rank;
+      }
+    }
+  }
+}
+
+
+TEST (qp, box)
+{
+  // min |x - a|^2 subject to lo <= x <= hi has the solution clamp(a)
+  size_t const nn(5);
+  Matrix hh(2 * Matrix::Identity(nn, nn));
+  Vector aa(nn), ff(nn), lo(nn), hi(nn);
+  Matrix cc(Matrix::Zero(2 * nn, nn));
+  Vector dd(2 * nn);
+  for (size_t ii(0); ii < nn; ++ii) {
+    aa[ii] = 2.0 * ii - 4.0;
+    lo[ii] = -1.0;
+    hi[ii] = 1.5;
+    cc.coeffRef(2 * ii, ii) = 1;
+    cc.coeffRef(2 * ii + 1, ii) = -1;
+    dd[2 * ii] = hi[ii];
+    dd[2 * ii + 1] = -lo[ii];
+  }
+  ff = -2 * aa;
+  
+  ActiveSetQP qp;
+  Vector xx;
+  Status st(qp.solve(hh, ff, cc, dd, xx));
+  ASSERT_TRUE (st.ok) << "QP failed: " << st.errstr;
+  for (size_t ii(0); ii < nn; ++ii) {
+    double const expected(std::max(lo[ii], std::min(hi[ii], aa[ii])));
+    EXPECT_NEAR (expected, xx[ii], 1e-9) << "x[" << ii << "]";
+  }
+  EXPECT_EQ (4, qp.getNActive());
+  
+  // same problem again: the warm start is exact
+  st = qp.solve(hh, ff, cc, dd, xx);
+  ASSERT_TRUE (st.ok) << "QP failed: " << st.errstr;
+  EXPECT_EQ (1, qp.getNIterations());
+  
+  // infeasible bounds
+  dd[0] = -2;
+  st = qp.solve(hh, ff, cc, dd, xx);
+  EXPECT_FALSE (st.ok) << "infeasible QP should have failed";
+}
+
+
+TEST (qp, kkt)
+{
+  size_t const nn(6);
+  size_t const mm(10);
+  Matrix const hh(create_psd(nn, nn, 0.5));
+  Vector ff(nn);
+  Matrix cc(mm, nn);
+  Vector dd(mm);
+  for (size_t ii(0); ii < nn; ++ii) {
+    ff[ii] = sin(3.0 * ii + 1.0);
+  }
+  // constraints built around a known feasible point, some of them
+  // passing right through it
+  Vector feasible(nn);
+  for (size_t jj(0); jj < nn; ++jj) {
+    feasible[jj] = 0.2 * cos(1.1 * jj);
+  }
+  for (size_t ii(0); ii < mm; ++ii) {
+    for (size_t jj(0); jj < nn; ++jj) {
+      cc.coeffRef(ii, jj) = sin(0.7 * ii * jj + 0.4 * ii + 1.3 * jj * jj);
+    }
+    dd[ii] = cc.row(ii).dot(feasible) + 0.05 * (ii % 3);
+  }
+  
+  ActiveSetQP qp;
+  Vector xx;
+  for (size_t pass(0); pass < 2; ++pass) {
+    Status const st(qp.solve(hh, ff, cc, dd, xx));
+    ASSERT_TRUE (st.ok) << "QP failed: " << st.errstr;
+    Vector const & lambda(qp.getMultipliers());
+    Vector const grad(hh * xx + ff + cc.transpose() * lambda);
+    for (size_t jj(0); jj < nn; ++jj) {
+      EXPECT_NEAR (0, grad[jj], 1e-9) << "stationarity " << jj;
+    }
+    Vector const slack(dd - cc * xx);
+    for (size_t ii(0); ii < mm; ++ii) {
+      EXPECT_GE (slack[ii], -1e-9) << "primal feasibility " << ii;
+      EXPECT_GE (lambda[ii], 0) << "dual feasibility " << ii;
+      EXPECT_NEAR (0, lambda[ii] * slack[ii], 1e-9) << "complementarity " << ii;
+    }
+    EXPECT_GT (qp.getNActive(), 0) << "test should have some active constraints";
+  }
+  EXPECT_EQ (1, qp.getNIterations()) << "warm start should have been exact";
+}
+
+
+TEST (controller, qp)
+{
+  try {
+    Model * puma(get_puma());
+    size_t const ndof(puma->getNDOF());
+    Matrix aa;
+    Vector gg;
+    ASSERT_TRUE (puma->getMassInertia(aa)) << "failed to get mass inertia";
+    ASSERT_TRUE (puma->getGravity(gg)) << "failed to get gravity";
+    
+    shared_ptr<Task> posture(create_sel_jp_task("posture", Vector::Ones(ndof)));
+    GenericSkill skill("skill");
+    skill.appendTask(posture);
+    Status st(skill.init(*puma));
+    ASSERT_TRUE (st.ok) << "failed to init skill: " << st.errstr;
+    
+    // without limits, this is plain inverse dynamics (up to the
+    // regularization)
+    QPController ctrl("ctrl");
+    st = ctrl.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init controller: " << st.errstr;
+    Vector gamma;
+    st = ctrl.computeCommand(*puma, skill, gamma);
+    ASSERT_TRUE (st.ok) << "failed to compute command: " << st.errstr;
+    Vector const free_gamma(aa * posture->getCommand() + gg);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_NEAR (free_gamma[ii], gamma[ii], 1e-4 * (1 + fabs(free_gamma[ii]))) << "joint " << ii;
+    }
+    
+    // torque limits that cut the dynamic part of every joint in half
+    Vector taumax(ndof);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      taumax[ii] = fabs(gg[ii]) + 0.5 * fabs(free_gamma[ii] - gg[ii]);
+    }
+    Parameter * param(ctrl.lookupParameter("taumax", PARAMETER_TYPE_VECTOR));
+    ASSERT_NE ((void*)0, param) << "failed to retrieve taumax parameter";
+    st = param->set(taumax);
+    ASSERT_TRUE (st.ok) << "failed to set taumax: " << st.errstr;
+    st = ctrl.init(*puma);
+    ASSERT_TRUE (st.ok) << "failed to init controller: " << st.errstr;
+    for (size_t tick(0); tick < 3; ++tick) {
+      st = ctrl.computeCommand(*puma, skill, gamma);
+      ASSERT_TRUE (st.ok) << "failed to compute command: " << st.errstr;
+    }
+    bool saturated(false);
+    for (size_t ii(0); ii < ndof; ++ii) {
+      EXPECT_LE (fabs(gamma[ii]), taumax[ii] + 1e-6) << "joint " << ii;
+      if (fabs(gamma[ii]) > taumax[ii] - 1e-6) {
+	saturated = true;
+      }
+    }
+    EXPECT_TRUE (saturated) << "some torque limit should be active";
+    param = ctrl.lookupParameter("iterations", PARAMETER_TYPE_INTEGER);
+    ASSERT_NE ((void*)0, param) << "failed to retrieve iterations parameter";
+    EXPECT_EQ (1, *param->getInteger()) << "warm start should have been exact";
+  }
+  catch (exception const & ee) {
+    ADD_FAILURE () << "exception " << ee.what();
+  }
+}
+
+
+namespace {
+  
+  // Same order as the protected PDTask::saturation_policy_t.
+  enum {
+    PD_OFF,
+    PD_COMPONENT_WISE,
+    PD_MAX_COMPONENT,
+    PD_NORM
+  };
+  
+  // The per-component loops which PDTask::computePDCommand() used
+  // before it switched to the pd_saturation kernels.
+  void reference_pd(int policy, size_t ndim,
+		    Vector const & goalpos, Vector const & curpos,
+		    Vector const & goalvel, Vector const & curvel,
+		    Vector const & kp, Vector const & kd, Vector const & maxvel,
+		    Vector & command)
+  {
+    Vector const errpos(goalpos - curpos);
+    Vector const errvel(goalvel - curvel);
+    if (PD_NORM == policy) {
+      command = kp[0] * errpos;
+      if ((maxvel[0] > 1e-4) && (kd[0] > 1e-4)) {
+	double const sat(command.norm() / maxvel[0] / kd[0]);
+	if (sat > 1.0) {
+	  command /= sat;
+	}
+      }
+      command += kd[0] * errvel;
+      return;
+    }
+    command = kp.cwise() * errpos;
+    double saturation(0.0);
+    for (size_t ii(0); ii < ndim; ++ii) {
+      if ((maxvel[ii] > 1e-4) && (kd[ii] > 1e-4)) {
+	double const sat(fabs((command[ii] / maxvel[ii]) / kd[ii]));
+	if (PD_COMPONENT_WISE == policy) {
+	  if (sat > 1.0) {
+	    command[ii] /= sat;
+	  }
+	}
+	else if (sat > saturation) {
+	  saturation = sat;
+	}
+      }
+    }
+    if ((PD_MAX_COMPONENT == policy) && (saturation > 1.0)) {
+      command /= saturation;
+    }
+    command += kd.cwise() * errvel;
+  }
+  
+}
+
+
+TEST (task, pd_saturation)
+{
+  static int const policy[] = {
+    PD_OFF,
+    PD_COMPONENT_WISE,
+    PD_MAX_COMPONENT,
+    PD_NORM
+  };
+  static size_t const dims[] = { 1, 3, 7, 38 };
+  
+  for (size_t idim(0); idim < sizeof(dims) / sizeof(*dims); ++idim) {
+    size_t const ndim(dims[idim]);
+    Vector goalpos(ndim), curpos(ndim), goalvel(ndim), curvel(ndim);
+    Vector kp(ndim), kd(ndim), maxvel(ndim);
+    for (size_t ii(0); ii < ndim; ++ii) {
+      goalpos[ii] = 2.0 * sin(0.7 * ii + 0.3);
+      curpos[ii] = cos(1.3 * ii);
+      goalvel[ii] = 0.1 * ii;
+      curvel[ii] = -0.5 * sin(0.9 * ii);
+      kp[ii] = 100.0 + 10.0 * ii;
+      kd[ii] = 20.0 + ii;
+      maxvel[ii] = 0.05 + 0.3 * (ii % 4);
+      if (2 == ii % 5) {
+	// close enough to the goal to stay below the limit
+	curpos[ii] = goalpos[ii] - 1e-3;
+      }
+    }
+    // Mix in components which must never get saturated: a zero kd, a
+    // zero maxvel, and (for the norm policy) a tiny maxvel. Not on
+    // the first component for ndim > 1, it drives the norm policy.
+    if (ndim > 3) {
+      kd[1] = 0.0;
+      maxvel[2] = 0.0;
+      maxvel[3] = 1e-5;
+    }
+    
+    for (size_t ipol(0); ipol < sizeof(policy) / sizeof(*policy); ++ipol) {
+      Vector expected;
+      reference_pd(policy[ipol], ndim, goalpos, curpos, goalvel, curvel,
+		   kp, kd, maxvel, expected);
+      
+      Vector errpos(ndim), errvel(ndim), command(ndim);
+      pd_kernel_s pd;
+      pd.ndim = ndim;
+      pd.goalpos = goalpos.data();
+      pd.curpos = curpos.data();
+      pd.goalvel = goalvel.data();
+      pd.curvel = curvel.data();
+      pd.kp = kp.data();
+      pd.kd = kd.data();
+      pd.maxvel = maxvel.data();
+      pd.errpos = errpos.data();
+      pd.errvel = errvel.data();
+      pd.command = command.data();
+      switch (policy[ipol]) {
+      case PD_COMPONENT_WISE:
+	pdSaturateComponentWise(pd);
+	break;
+      case PD_MAX_COMPONENT:
+	pdSaturateMaxComponent(pd);
+	break;
+      case PD_NORM:
+	pdSaturateNorm(pd);
+	break;
+      default:
+	pdSaturateOff(pd);
+      }
+      
+      for (size_t ii(0); ii < ndim; ++ii) {
+	EXPECT_DOUBLE_EQ (goalpos[ii] - curpos[ii], errpos[ii])
+	  << "policy " << policy[ipol] << " ndim " << ndim << " component " << ii;
+	EXPECT_DOUBLE_EQ (goalvel[ii] - curvel[ii], errvel[ii])
+	  << "policy " << policy[ipol] << " ndim " << ndim << " component " << ii;
+	EXPECT_NEAR (expected[ii], command[ii], 1e-12 * (1.0 + fabs(expected[ii])))
+	  << "policy " << policy[ipol] << " ndim " << ndim << " component " << ii;
+      }
+    }
+  }
+}
+
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -44,11 +44,141 @@ public:
 	deVector3 g;
 };
 
+class taoABTraversalData
+{
+public:
+	deMatrix6 Ia;
+	deVector3 WxV;
+	deVector3 g;
+	deFloat E;
+};
+
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
+taoABTraversal::taoABTraversal()
+	: _size(0), _capacity(0), _node(NULL), _parent(NULL), _postorder(NULL), _data(NULL)
+{
+}
+
+taoABTraversal::taoABTraversal(taoDNode* root)
+	: _size(0), _capacity(0), _node(NULL), _parent(NULL), _postorder(NULL), _data(NULL)
+{
+	build(root);
+}
+
+taoABTraversal::~taoABTraversal()
+{
+	delete[] _node;
+	delete[] _parent;
+	delete[] _postorder;
+	delete[] _data;
+}
+
+taoABTraversalData* taoABTraversal::data(const deInt i) const
+{
+	return _data + i + 1;
+}
+
+void taoABTraversal::build(taoDNode* root)
+{
+	deInt size = 1;
+	taoDNode* n = root;
+	for (;;)
+	{
+		if (n->getDChild())
+		{
+			n = n->getDChild();
+			size++;
+			continue;
+		}
+		while (n != root && !n->getDSibling())
+			n = n->getDParent();
+		if (n == root)
+			break;
+		n = n->getDSibling();
+		size++;
+	}
+
+	if (size > _capacity)
+	{
+		delete[] _node;
+		delete[] _parent;
+		delete[] _postorder;
+		delete[] _data;
+		_capacity = size;
+		_node = new taoDNode*[_capacity];
+		_parent = new deInt[_capacity];
+		_postorder = new deInt[_capacity];
+		// slot 0 holds the data handed down to the root
+		_data = new taoABTraversalData[_capacity + 1];
+	}
+	_size = size;
+
+	// preorder, siblings in the order of the child lists
+	deInt k = 0, cur = 0;
+	_node[k] = root;
+	_parent[k++] = -1;
+	n = root;
+	for (;;)
+	{
+		if (n->getDChild())
+		{
+			n = n->getDChild();
+			_node[k] = n;
+			_parent[k] = cur;
+			cur = k++;
+			continue;
+		}
+		while (cur != 0 && !n->getDSibling())
+		{
+			cur = _parent[cur];
+			n = _node[cur];
+		}
+		if (cur == 0)
+			break;
+		n = n->getDSibling();
+		_node[k] = n;
+		_parent[k] = _parent[cur];
+		cur = k++;
+	}
+
+	// postorder: a node is emitted once the preorder walk leaves its subtree
+	deInt* open = new deInt[_size];
+	deInt top = 0;
+	k = 0;
+	for (deInt i = 0; i < _size; i++)
+	{
+		while (top > 0 && open[top - 1] != _parent[i])
+			_postorder[k++] = open[--top];
+		open[top++] = i;
+	}
+	while (top > 0)
+		_postorder[k++] = open[--top];
+	delete[] open;
+}
+
+// use the rotation matrix cached by taoDNode::updateFrame() if there is one
+void taoABDynamics::_updateLocalX(taoDNode* node)
+{
+	deCachedFrame const * home = node->cachedFrameHome();
+	if (home)
+		node->getABNode()->updateLocalX(home->transform(), *node->frameLocal());
+	else
+		node->getABNode()->updateLocalX(*node->frameHome(), *node->frameLocal());
+}
+
+void taoABDynamics::_globalJacobian(taoDNode* node)
+{
+	deCachedFrame const * global = node->cachedFrameGlobal();
+	if (global)
+		node->getABNode()->globalJacobian(global->transform());
+	else
+		node->getABNode()->globalJacobian(*node->frameGlobal());
+}
+
 void taoABDynamics::updateLocalXTreeOut(taoDNode* root)
 {
-	root->getABNode()->updateLocalX(*root->frameHome(), *root->frameLocal());
+	_updateLocalX(root);
 
 	for (taoDNode* n = root->getDChild(); n != NULL; n = n->getDSibling())
 		updateLocalXTreeOut(n);
@@ -87,7 +217,7 @@ void taoABDynamics::opSpaceInertiaMatrixOut(taoDNode* root, const deMatrix6* Oah
 
 void taoABDynamics::globalJacobianOut(taoDNode* root)
 {
-	root->getABNode()->globalJacobian(*root->frameGlobal());
+	_globalJacobian(root);
 
 	for (taoDNode* n = root->getDChild(); n != NULL; n = n->getDSibling())
 		globalJacobianOut(n);
@@ -177,7 +307,7 @@ void taoABDynamics::compute_Jg_Omega_H(taoDNode* root, const deMatrix6* Oah, con
 	deMatrix6* Oa = root->getABNode()->Omega();
 	deVector6* H = root->getABNode()->H();
 
-	root->getABNode()->globalJacobian(*root->frameGlobal());
+	_globalJacobian(root);
 	root->getABNode()->osInertiaInv(*Oa, *Oah);
 	root->getABNode()->biasAcceleration(*H, *Hh);
 
@@ -395,3 +525,165 @@ deFloat taoABDynamics::kineticEnergy(taoDNode* root, const deVector6* Vh)
 
 	return E;
 }
+
+void taoABDynamics::updateLocalXTreeOut(const taoABTraversal* tree)
+{
+	for (deInt i = 0; i < tree->size(); i++)
+		_updateLocalX(tree->node(i));
+}
+
+void taoABDynamics::globalJacobianOut(const taoABTraversal* tree)
+{
+	for (deInt i = 0; i < tree->size(); i++)
+		_globalJacobian(tree->node(i));
+}
+
+void taoABDynamics::forwardDynamics(const taoABTraversal* tree, const deVector3* gravity)
+{
+	deInt i, k, p;
+
+	tree->data(-1)->g = *gravity;
+
+	for (i = 0; i < tree->size(); i++)
+	{
+		taoDNode* n = tree->node(i);
+		p = tree->parent(i);
+		taoABTraversalData* data = tree->data(i);
+		taoABTraversalData* datah = tree->data(p);
+		const deVector6* Vh = (p < 0) ? NULL : tree->node(p)->getABNode()->V();
+		deVector6* Pa = n->getABNode()->Pa();
+		deVector6* V = n->getABNode()->V();
+		deVector6 G;
+
+		n->getABNode()->abInertiaInit(data->Ia);
+
+		n->getABNode()->velocity(*V, data->WxV, *Vh, datah->WxV);
+
+		n->getABNode()->biasForce(*Pa, *V, data->WxV);
+
+		n->getABNode()->gravityForce(G, data->g, datah->g);
+
+		n->getABNode()->externalForce(*Pa, G, *n->force());
+	}
+
+	for (k = 0; k < tree->size(); k++)
+	{
+		i = tree->postorder(k);
+		p = tree->parent(i);
+		taoDNode* n = tree->node(i);
+		deVector6* Pah = (p < 0) ? NULL : tree->node(p)->getABNode()->Pa();
+
+		n->getABNode()->abInertiaDepend(tree->data(p)->Ia, *Pah, tree->data(i)->Ia, !n->isParentRoot());
+	}
+
+	_accelerationTreeOut(tree);
+}
+
+void taoABDynamics::inverseDynamics(const taoABTraversal* tree, const deVector3* gravity)
+{
+	deInt i, k, p;
+
+	tree->data(-1)->g = *gravity;
+
+	for (i = 0; i < tree->size(); i++)
+	{
+		taoDNode* n = tree->node(i);
+		p = tree->parent(i);
+		taoABTraversalData* data = tree->data(i);
+		taoABTraversalData* datah = tree->data(p);
+		deVector6* F = n->getABNode()->Pa();
+		deVector6* A = n->getABNode()->A();
+		deVector6* V = n->getABNode()->V();
+		deVector6 P;
+		deVector6 G;
+
+		if (!n->getPropagate())
+		{
+			F->zero();
+		}
+		else
+		{
+			const deVector6* Vh = (p < 0) ? NULL : tree->node(p)->getABNode()->V();
+			const deVector6* Ah = (p < 0) ? NULL : tree->node(p)->getABNode()->A();
+
+			n->getABNode()->velocity(*V, data->WxV, *Vh, datah->WxV);
+
+			n->getABNode()->biasForce(P, *V, data->WxV);
+
+			n->getABNode()->gravityForce(G, data->g, datah->g);
+
+			n->getABNode()->externalForce(P, G, *n->force());
+
+			n->getABNode()->accelerationOnly(*A, *Ah);
+
+			n->getABNode()->netForce(*F, *A, P);
+		}
+	}
+
+	for (k = 0; k < tree->size(); k++)
+	{
+		i = tree->postorder(k);
+		p = tree->parent(i);
+		taoDNode* n = tree->node(i);
+		deVector6* Fh = (p < 0) ? NULL : tree->node(p)->getABNode()->Pa();
+
+		n->getABNode()->force(*Fh, !n->isParentRoot());
+	}
+}
+
+void taoABDynamics::_accelerationTreeOut(const taoABTraversal* tree)
+{
+	for (deInt i = 0; i < tree->size(); i++)
+	{
+		deInt p = tree->parent(i);
+		const deVector6* Ah = (p < 0) ? NULL : tree->node(p)->getABNode()->A();
+
+		tree->node(i)->getABNode()->acceleration(*tree->node(i)->getABNode()->A(), *Ah);
+	}
+}
+
+// the subtree sums are accumulated in postorder so that the additions
+// happen in the same sequence as in the recursive version
+deFloat taoABDynamics::potentialEnergy(const taoABTraversal* tree, const deVector3* gh)
+{
+	deInt i, k, p;
+
+	for (i = 0; i < tree->size(); i++)
+	{
+		taoDNode* n = tree->node(i);
+		tree->data(i)->E = n->getABNode()->potentialEnergy(*gh, *n->frameGlobal(), *n->mass(), *n->center());
+	}
+
+	for (k = 0; k < tree->size(); k++)
+	{
+		i = tree->postorder(k);
+		p = tree->parent(i);
+		if (p >= 0)
+			tree->data(p)->E += tree->data(i)->E;
+	}
+
+	return tree->data(0)->E;
+}
+
+deFloat taoABDynamics::kineticEnergy(const taoABTraversal* tree)
+{
+	deInt i, k, p;
+
+	for (i = 0; i < tree->size(); i++)
+	{
+		p = tree->parent(i);
+		const deVector6* Vh = (p < 0) ? NULL : tree->node(p)->getABNode()->V();
+
+		tree->data(i)->E = tree->node(i)->getABNode()->kineticEnergy(*tree->node(i)->getABNode()->V(), *Vh);
+	}
+
+	for (k = 0; k < tree->size(); k++)
+	{
+		i = tree->postorder(k);
+		p = tree->parent(i);
+		if (p >= 0)
+			tree->data(p)->E += tree->data(i)->E;
+	}
+
+	return tree->data(0)->E;
+}
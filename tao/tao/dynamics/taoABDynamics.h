@@ -33,9 +33,60 @@ class deVector6;
 class deFrame;
 class taoABDynamicsData;
 class taoABDynamicsData2;
+class taoABTraversalData;
 
 //#ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+/*!
+ *	\brief		Flattened traversal order of an articulated body
+ *	\ingroup	taoDynamics
+ *
+ *	This class stores the nodes of a subtree in preorder, together
+ *	with the preorder index of each parent and the postorder visiting
+ *	sequence. It also owns one contiguous array of per-node scratch
+ *	data, so that the iterative variants of taoABDynamics do not
+ *	need to put a taoABDynamicsData on the stack for each level of
+ *	the tree.
+ *
+ *	\remarks	call build() again whenever the topology of the tree
+ *			changes (nodes linked or unlinked).
+ */
+class taoABTraversal
+{
+public:
+	taoABTraversal();
+	explicit taoABTraversal(taoDNode* root);
+	~taoABTraversal();
+
+	//! (re)computes the traversal order of the subtree with \a root
+	void build(taoDNode* root);
+
+	//! \return	number of nodes, including the root
+	deInt size() const { return _size; }
+	//! \return	root of the subtree, NULL before build()
+	taoDNode* root() const { return _size > 0 ? _node[0] : NULL; }
+	//! \return	node at preorder index \a i
+	taoDNode* node(const deInt i) const { return _node[i]; }
+	//! \return	preorder index of the parent of node \a i, -1 for the root
+	deInt parent(const deInt i) const { return _parent[i]; }
+	//! \return	preorder index of the \a i-th node in postorder
+	deInt postorder(const deInt i) const { return _postorder[i]; }
+
+	//! \return	scratch data of node \a i, or of the parent of the root when \a i is -1
+	taoABTraversalData* data(const deInt i) const;
+
+private:
+	deInt _size;
+	deInt _capacity;
+	taoDNode** _node;
+	deInt* _parent;
+	deInt* _postorder;
+	taoABTraversalData* _data;
+
+	taoABTraversal(taoABTraversal const &);
+	taoABTraversal& operator=(taoABTraversal const &);
+};
+
 /*!
  *	\brief		Articulated body dynamics class
  *	\ingroup	taoDynamics
@@ -108,6 +159,22 @@ public:
 	//! resets inertia of \a node
 	static void resetInertia(taoDNode* node);
 
+	/*!
+	 *	\name	Iterative variants
+	 *
+	 *	These produce exactly the same results as their recursive
+	 *	counterparts, but walk the precomputed order of \a tree
+	 *	instead of recursing once per node.
+	 */
+	//	@{
+	static void updateLocalXTreeOut(const taoABTraversal* tree);
+	static void globalJacobianOut(const taoABTraversal* tree);
+	static void forwardDynamics(const taoABTraversal* tree, const deVector3* gravity);
+	static void inverseDynamics(const taoABTraversal* tree, const deVector3* gravity);
+	static deFloat potentialEnergy(const taoABTraversal* tree, const deVector3* gravity);
+	static deFloat kineticEnergy(const taoABTraversal* tree);
+	//	@}
+
 private:
 	static void _forwardDynamicsOutIn(taoDNode* root, taoABDynamicsData* datah, deVector6* Pah, const deVector6* Vh);
 	static void _inverseDynamicsOutIn(taoDNode* root, taoABDynamicsData2* datah, deVector6* Fh, const deVector6* Vh, const deVector6* Ah);
@@ -115,6 +182,9 @@ private:
 	static void _articulatedImpulsePathIn(taoDNode* contact, const deInt dist);
 	static void _velocityDeltaTreeOut(taoDNode* root, const deVector6* dVh, const deVector6* Vh, const deInt dist);
 	static void _plusEq_Jg_ddQ(taoDNode* node, deVector6* A);
+	static void _updateLocalX(taoDNode* node);
+	static void _globalJacobian(taoDNode* node);
+	static void _accelerationTreeOut(const taoABTraversal* tree);
 };
 
 //#endif // DOXYGEN_SHOULD_SKIP_THIS
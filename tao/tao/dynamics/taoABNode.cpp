@@ -165,6 +165,11 @@ void taoABNodeNOJ1::updateLocalX(const deFrame& homeFrame, const deFrame& localF
 	_joint->update_localX(homeX, localFrame);
 }
 
+void taoABNodeNOJ1::updateLocalX(const deTransform& homeX, const deFrame& localFrame)
+{
+	_joint->update_localX(homeX, localFrame);
+}
+
 void taoABNodeNOJ1::getFrameLocal(deFrame& localFrame)
 {
 	localFrame.set(_joint->localX());
@@ -173,15 +178,21 @@ void taoABNodeNOJ1::getFrameLocal(deFrame& localFrame)
 void taoABNodeNOJn::updateLocalX(const deFrame& homeFrame, const deFrame& localFrame)
 {
 	deTransform homeX;
+	homeX.set(homeFrame);
+	updateLocalX(homeX, localFrame);
+}
+
+void taoABNodeNOJn::updateLocalX(const deTransform& homeX, const deFrame& localFrame)
+{
+	deTransform X;
 	deFrame f;
 	f.identity();
 
-	homeX.set(homeFrame);
 	_joint[0]->update_localX(homeX, f);
 
-	homeX.identity();
+	X.identity();
 	for (deInt i = 1; i < getNOJ(); i++)
-		_joint[i]->update_localX(homeX, f);
+		_joint[i]->update_localX(X, f);
 
 }
 
@@ -213,6 +224,11 @@ void taoABNodeNOJ1::globalJacobian(const deFrame& globalFrame)
 	_joint->compute_Jg(Xg);
 }
 
+void taoABNodeNOJ1::globalJacobian(const deTransform& globalX)
+{
+	_joint->compute_Jg(globalX);
+}
+
 // A += J * ddQ
 void taoABNodeNOJ1::plusEq_Jg_ddQ(deVector6& Ag)
 {
@@ -228,11 +244,20 @@ void taoABNodeNOJ1::add2Tau_JgT_F(const deVector6& Fg)
 // 0Xi = 0Xh hXi
 // 0Xh = 0Xi hXi^-1
 void taoABNodeNOJn::globalJacobian(const deFrame& globalFrame)
+{
+	deTransform Xg;
+
+	Xg.set(globalFrame);
+
+	globalJacobian(Xg);
+}
+
+void taoABNodeNOJn::globalJacobian(const deTransform& globalX)
 {
 	deInt i;
 	deTransform Xg, Xgh;
 
-	Xg.set(globalFrame);
+	Xg = globalX;
 
 	for (i = _noj - 1; i > 0; i--)
 	{
@@ -86,6 +86,8 @@ public:
 	virtual void externalForce(deVector6& Pa, const deVector6& G, const deVector6& Fext) = 0;
 
 	virtual void updateLocalX(const deFrame& homeFrame, const deFrame& localFrame) = 0;
+	// same as above, with the home frame already converted to a transform
+	virtual void updateLocalX(const deTransform& homeX, const deFrame& localFrame) = 0;
 
 	virtual void getFrameLocal(deFrame& localFrame) = 0;
 
@@ -96,6 +98,7 @@ public:
 	// and  iXe^T = [(inv 0Xi) 0Xe]^T = (0Xe)^T * (0Xi)^(-T) = 0Xi ^(-T)
 	// since  0Xe = identity matrix    <--  {e} = {0}
 	virtual void globalJacobian(const deFrame& globalFrame) = 0;
+	virtual void globalJacobian(const deTransform& globalX) = 0;
 	// A += J * ddQ
 	virtual void plusEq_Jg_ddQ(deVector6& Ag) = 0;
 	// Tau += Jt * F
@@ -177,10 +180,12 @@ public:
 	virtual void externalForce(deVector6& Pa, const deVector6& G, const deVector6& Fext) {}
 
 	virtual void updateLocalX(const deFrame& homeFrame, const deFrame& localFrame) {}
+	virtual void updateLocalX(const deTransform& homeX, const deFrame& localFrame) {}
 	virtual void getFrameLocal(deFrame& localFrame) {}
 
 	virtual void abImpulse(deVector6& Yah, deInt propagate) {}
 	virtual void globalJacobian(const deFrame& globalFrame) {}
+	virtual void globalJacobian(const deTransform& globalX) {}
 	virtual void plusEq_Jg_ddQ(deVector6& Ag) {}
 	virtual void add2Tau_JgT_F(const deVector6& Fg) {}
 
@@ -253,9 +258,11 @@ public:
 	taoABNodeNOJ1() : _joint(NULL) {}
 
 	virtual void updateLocalX(const deFrame& homeFrame, const deFrame& localFrame);
+	virtual void updateLocalX(const deTransform& homeX, const deFrame& localFrame);
 	virtual void getFrameLocal(deFrame& localFrame);
 	virtual void abImpulse(deVector6& Yah, deInt propagate);
 	virtual void globalJacobian(const deFrame& globalFrame);
+	virtual void globalJacobian(const deTransform& globalX);
 	virtual void plusEq_Jg_ddQ(deVector6& Ag);
 	virtual void add2Tau_JgT_F(const deVector6& Fg);
 
@@ -293,9 +300,11 @@ public:
 	taoABNodeNOJn() : _noj(0), _joint(NULL) {}
 
 	virtual void updateLocalX(const deFrame& homeFrame, const deFrame& localFrame);
+	virtual void updateLocalX(const deTransform& homeX, const deFrame& localFrame);
 	virtual void getFrameLocal(deFrame& localFrame);
 	virtual void abImpulse(deVector6& Yah, deInt propagate);
 	virtual void globalJacobian(const deFrame& globalFrame);
+	virtual void globalJacobian(const deTransform& globalX);
 	virtual void plusEq_Jg_ddQ(deVector6& Ag);
 	virtual void add2Tau_JgT_F(const deVector6& Fg);
 
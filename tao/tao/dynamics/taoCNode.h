@@ -46,7 +46,6 @@ public:
 	 *	\note	for taoNodeRB, this is the center of mass frame.
 	 *	\note	for taoNode, this is the same frame getFrameGraphics()
 	 */
-	virtual deFrame* frameGlobal() = 0;
 	virtual deFrame const * frameGlobal() const = 0;
 	//!	global frame for graphics display
 	/*!
@@ -31,6 +31,7 @@ class taoJoint;
 class deVector3;
 class deVector6;
 class deFrame;
+class deCachedFrame;
 class deMatrix3;
 
 /*!
@@ -44,7 +45,7 @@ class taoDNode : public taoCNode
 public:
 	taoDNode() : _abNode(NULL), _propagate(1) {}
 	virtual ~taoDNode() {}
-	virtual void sync(deFrame* local) = 0;
+	virtual void sync(deFrame const * local) = 0;
 	//!	indicates if this node is root
 	/*!	\retval	1	this node is root
 	 *	\retval	0	this node in not root
@@ -75,11 +76,19 @@ public:
 	virtual deVector6* acceleration() = 0;
 
 	//! \return	home frame
-	virtual deFrame* frameHome() = 0;
+	/*!	\remarks	use sync() to change it, so that cachedFrameHome() follows
+	 */
+	virtual deFrame const * frameHome() const = 0;
 	//! \return	local frame
-	virtual deFrame* frameLocal() = 0;
+	virtual deFrame const * frameLocal() const = 0;
 	//! \return	global frame
 	//virtual deFrame* frameGlobal() = 0;
+	//! \return	home frame with cached rotation matrix, NULL if not kept by this node
+	virtual deCachedFrame const * cachedFrameHome() const { return NULL; }
+	//! \return	global frame with cached rotation matrix, NULL if not kept by this node
+	/*!	\remarks	valid as of the last updateFrame()
+	 */
+	virtual deCachedFrame const * cachedFrameGlobal() const { return NULL; }
 	//! \return	mass
 	virtual deFloat* mass() = 0;
 	//! \return	center of gravity in local frame
@@ -127,6 +127,53 @@ deFloat taoDynamics::kineticEnergy(taoDNode* rootNode)
 	return taoABDynamics::kineticEnergy(rootNode);
 }
 
+void taoDynamics::updateTransformation(const taoABTraversal* tree)
+{
+	for (deInt i = 0; i < tree->size(); i++)
+		tree->node(i)->updateFrame();
+}
+
+void taoDynamics::integrate(const taoABTraversal* tree, deFloat dt)
+{
+	for (deInt i = 0; i < tree->size(); i++)
+		tree->node(i)->integrate(dt);
+}
+
+void taoDynamics::globalJacobian(const taoABTraversal* tree)
+{
+	taoABDynamics::globalJacobianOut(tree);
+}
+
+void taoDynamics::invDynamics(const taoABTraversal* tree, const deVector3* gravity)
+{
+	taoDNode* root = tree->root();
+	taoABDynamics::updateLocalXTreeOut(tree); // YYY
+	deVector3 g;
+	g.inversedMultiply(root->frameGlobal()->rotation(), *gravity);
+	deVector6 A = *root->acceleration();
+	root->acceleration()->zero();
+	taoABDynamics::inverseDynamics(tree, &g);
+	*root->acceleration() = A;
+}
+
+void taoDynamics::fwdDynamics(const taoABTraversal* tree, const deVector3* gravity)
+{
+	taoABDynamics::updateLocalXTreeOut(tree); // YYY
+	deVector3 g;
+	g.inversedMultiply(tree->root()->frameGlobal()->rotation(), *gravity);
+	taoABDynamics::forwardDynamics(tree, &g);
+}
+
+deFloat taoDynamics::potentialEnergy(const taoABTraversal* tree, const deVector3* gravity)
+{
+	return taoABDynamics::potentialEnergy(tree, gravity);
+}
+
+deFloat taoDynamics::kineticEnergy(const taoABTraversal* tree)
+{
+	return taoABDynamics::kineticEnergy(tree);
+}
+
 // find dof : degrees of freedom
 deInt taoDynamics::computeDOF(taoDNode* root)
 {
@@ -26,6 +26,7 @@
 #include "taoTypes.h"
 
 class taoDNode;
+class taoABTraversal;
 class deVector3;
 class deVector6;
 
@@ -45,6 +46,10 @@ public:
 	static void reset(taoDNode* root);
 	static void updateTransformation(taoDNode* root);
 
+	//! explicit Euler step of q and dq
+	/*!
+	 *	\sa	taoIntegrator for RK4
+	 */
 	static void integrate(taoDNode* root, deFloat dt);
 
 	//! computes global Jacobina matrices
@@ -126,6 +131,23 @@ public:
 	static deFloat potentialEnergy(taoDNode* root, const deVector3* gravity);
 	static deFloat kineticEnergy(taoDNode* root);
 
+	/*!
+	 *	\name	Iterative variants
+	 *
+	 *	Same as above, but driven by the precomputed order of a
+	 *	taoABTraversal instead of recursing once per node. Use
+	 *	these for very deep trees, e.g. long serial chains.
+	 */
+	//	@{
+	static void updateTransformation(const taoABTraversal* tree);
+	static void integrate(const taoABTraversal* tree, deFloat dt);
+	static void globalJacobian(const taoABTraversal* tree);
+	static void invDynamics(const taoABTraversal* tree, const deVector3* gravity);
+	static void fwdDynamics(const taoABTraversal* tree, const deVector3* gravity);
+	static deFloat potentialEnergy(const taoABTraversal* tree, const deVector3* gravity);
+	static deFloat kineticEnergy(const taoABTraversal* tree);
+	//	@}
+
 private:
 	typedef enum {TAO_DDQ, TAO_DQ, TAO_TAU} flagType;
 	static void _Read(taoDNode* root, deFloat* v, flagType type);
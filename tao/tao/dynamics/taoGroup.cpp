@@ -25,6 +25,7 @@
 #include <tao/dynamics/taoJoint.h>
 #include <tao/dynamics/taoNode.h>
 #include <tao/dynamics/taoDynamics.h>
+#include <tao/utility/TaoDeThreadPool.h>
 
 #ifdef TAO_CONTROL
 #include "taoControlJt.h"
@@ -41,8 +42,103 @@ taoGroup::~taoGroup()
 	}
 }
 
+namespace {
+
+	struct taoStepArgs
+	{
+		const std::vector<taoNodeRoot*>* roots;
+		taoGroup::stepType type;
+		deFloat time;
+		deFloat dt;
+		deInt n;
+	};
+
+	void taoStepJob(void* arg, deInt i)
+	{
+		taoStepArgs* a = (taoStepArgs*)arg;
+		taoNodeRoot* r = (*a->roots)[i];
+
+		switch (a->type)
+		{
+		case taoGroup::TAO_STEP_UPDATE:
+			r->getGroup()->updateRoot(r, a->time, a->dt, a->n);
+			break;
+		case taoGroup::TAO_STEP_CONTROL:
+			r->getGroup()->controlRoot(r, a->time);
+			break;
+		case taoGroup::TAO_STEP_SIMULATE:
+			r->getGroup()->simulateRoot(r, a->dt);
+			break;
+		case taoGroup::TAO_STEP_TRANSFORMATION:
+			r->getGroup()->updateTransformationRoot(r);
+			break;
+		}
+	}
+
+}
+
+void taoGroup::stepParallel(deThreadPool* pool, const std::vector<taoNodeRoot*>& roots, stepType type,
+			    const deFloat time, const deFloat dt, const deInt n)
+{
+	taoStepArgs args;
+	args.roots = &roots;
+	args.type = type;
+	args.time = time;
+	args.dt = dt;
+	args.n = n;
+	pool->run(taoStepJob, &args, (deInt)roots.size());
+}
+
+void taoGroup::collectRoots(std::vector<taoNodeRoot*>& roots)
+{
+	for (taoNodeRoot* r = _rootList; r != NULL; r = r->getNext())
+		if (!r->getIsFixed())
+			roots.push_back(r);
+}
+
+void taoGroup::updateRoot(taoNodeRoot* r, const deFloat time, const deFloat dt, const deInt n)
+{
+	for (deInt i = 0; i < n; i++)
+	{
+#ifdef TAO_CONTROL
+		if (r->getController())
+			r->getController()->control(time);
+#endif
+		taoDynamics::fwdDynamics(r, &_gravity);
+		taoDynamics::integrate(r, dt);
+		taoDynamics::updateTransformation(r);
+	}
+}
+
+void taoGroup::controlRoot(taoNodeRoot* r, const deFloat time)
+{
+#ifdef TAO_CONTROL
+	if (r->getController())
+		r->getController()->control(time);
+#endif
+}
+
+void taoGroup::simulateRoot(taoNodeRoot* r, const deFloat dt)
+{
+	taoDynamics::fwdDynamics(r, &_gravity);
+	taoDynamics::integrate(r, dt);
+}
+
+void taoGroup::updateTransformationRoot(taoNodeRoot* r)
+{
+	taoDynamics::updateTransformation(r);
+}
+
 void taoGroup::update(const deFloat time, const deFloat dt, const deInt n)
 {
+	if (_pool)
+	{
+		_active.clear();
+		collectRoots(_active);
+		stepParallel(_pool, _active, TAO_STEP_UPDATE, time, dt, n);
+		return;
+	}
+
 	deInt i = 0;
 	while (i < n)
 	{
@@ -50,15 +146,7 @@ void taoGroup::update(const deFloat time, const deFloat dt, const deInt n)
 		while (r)
 		{
 			if (!r->getIsFixed())
-			{
-#ifdef TAO_CONTROL
-				if (r->getController())
-					r->getController()->control(time);
-#endif
-				taoDynamics::fwdDynamics(r, &_gravity);
-				taoDynamics::integrate(r, dt);
-				taoDynamics::updateTransformation(r);
-			}
+				updateRoot(r, time, dt, 1);
 			r = r->getNext();
 		}
 		i++;
@@ -67,43 +155,57 @@ void taoGroup::update(const deFloat time, const deFloat dt, const deInt n)
 
 void taoGroup::control(const deFloat time)
 {
+	if (_pool)
+	{
+		_active.clear();
+		collectRoots(_active);
+		stepParallel(_pool, _active, TAO_STEP_CONTROL, time, 0, 0);
+		return;
+	}
+
 	taoNodeRoot* r = _rootList;
 	while (r)
 	{
 		if (!r->getIsFixed())
-		{
-#ifdef TAO_CONTROL
-			if (r->getController())
-				r->getController()->control(time);
-#endif
-		}
+			controlRoot(r, time);
 		r = r->getNext();
 	}
 }
 
 void taoGroup::simulate(const deFloat dt)
 {
+	if (_pool)
+	{
+		_active.clear();
+		collectRoots(_active);
+		stepParallel(_pool, _active, TAO_STEP_SIMULATE, 0, dt, 0);
+		return;
+	}
+
 	taoNodeRoot* r = _rootList;
 	while (r)
 	{
 		if (!r->getIsFixed())
-		{
-			taoDynamics::fwdDynamics(r, &_gravity);
-			taoDynamics::integrate(r, dt);
-		}
+			simulateRoot(r, dt);
 		r = r->getNext();
 	}
 }
 
 void taoGroup::updateTransformation()
 {
+	if (_pool)
+	{
+		_active.clear();
+		collectRoots(_active);
+		stepParallel(_pool, _active, TAO_STEP_TRANSFORMATION, 0, 0, 0);
+		return;
+	}
+
 	taoNodeRoot* r = _rootList;
 	while (r)
 	{
 		if (!r->getIsFixed())
-		{
-			taoDynamics::updateTransformation(r);
-		}
+			updateTransformationRoot(r);
 		r = r->getNext();
 	}
 }
@@ -25,10 +25,12 @@
 
 #include "taoTypes.h"
 #include <tao/matrix/TaoDeMath.h>
+#include <vector>
 
 class taoDNode;
 class taoNode;
 class taoNodeRoot;
+class deThreadPool;
 
 /*!
  *	\brief container class to hold dynamics characters
@@ -42,7 +44,9 @@ class taoNodeRoot;
 class taoGroup
 {
 public:
-	taoGroup() : _id(-1), _isFixed(0), _rootList(NULL), _next(NULL) { _gravity.zero(); }
+	typedef enum {TAO_STEP_UPDATE, TAO_STEP_CONTROL, TAO_STEP_SIMULATE, TAO_STEP_TRANSFORMATION} stepType;
+
+	taoGroup() : _id(-1), _isFixed(0), _rootList(NULL), _next(NULL), _pool(NULL) { _gravity.zero(); }
 	~taoGroup();
 
 	void setID(deInt i) { _id = i; }
@@ -61,11 +65,39 @@ public:
 	taoNodeRoot* removeRoot(const deInt id);
 	taoNodeRoot* findRoot(const deInt id);
 
+	/*!
+	 *	\remarks	with a thread pool, the roots are stepped in parallel.
+	 *			Each root always goes through exactly the same
+	 *			sequence of operations, so the results do not
+	 *			depend on the number of threads.
+	 */
 	void update(const deFloat time, const deFloat dt, const deInt n);
 	void control(const deFloat time);
 	void simulate(const deFloat dt);
 	void updateTransformation();
 
+	//!	sets the pool used for parallel stepping, NULL (the default) for serial
+	void setThreadPool(deThreadPool* pool) { _pool = pool; }
+	deThreadPool* getThreadPool() { return _pool; }
+
+	/*!
+	 *	\name	Single root
+	 *	what update(), control(), simulate() and updateTransformation() do for each root
+	 */
+	//	@{
+	void updateRoot(taoNodeRoot* r, const deFloat time, const deFloat dt, const deInt n);
+	void controlRoot(taoNodeRoot* r, const deFloat time);
+	void simulateRoot(taoNodeRoot* r, const deFloat dt);
+	void updateTransformationRoot(taoNodeRoot* r);
+	//	@}
+
+	//!	appends the roots that are not fixed to \a roots
+	void collectRoots(std::vector<taoNodeRoot*>& roots);
+
+	//!	runs the \a type step of each of \a roots (in their own groups) as one job on \a pool
+	static void stepParallel(deThreadPool* pool, const std::vector<taoNodeRoot*>& roots, stepType type,
+				 const deFloat time, const deFloat dt, const deInt n);
+
 	taoNodeRoot* unlinkFixed(taoNodeRoot* root, taoNode* node);
 	taoNodeRoot* unlinkFree(taoNodeRoot* root, taoNode* node, deFloat inertia, deFloat damping);
 
@@ -77,6 +109,8 @@ private:
 	deVector3 _gravity;
 	taoNodeRoot* _rootList;
 	taoGroup* _next;
+	deThreadPool* _pool;
+	std::vector<taoNodeRoot*> _active;
 };
 
 #endif // _taoGroup_h
@@ -0,0 +1,215 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "taoIntegrator.h"
+#include "taoDynamics.h"
+#include "taoABDynamics.h"
+#include "taoDNode.h"
+#include "taoJoint.h"
+#include "taoVar.h"
+
+taoIntegrator::taoIntegrator(taoIntegratorType type)
+	: _type(type), _tree(NULL), _nq(0), _ndq(0)
+{
+}
+
+bool taoIntegrator::build(const taoABTraversal* tree)
+{
+	_tree = NULL;
+	_joint.clear();
+	_nq = _ndq = 0;
+
+	// the state accessors cast everything that is not spherical to
+	// taoJointDOF1, so user-defined joints cannot be handled
+	for (deInt i = 0; i < tree->size(); i++)
+		for (taoJoint* j = tree->node(i)->getJointList(); j != NULL; j = j->getNext())
+			if (j->getType() != TAO_JOINT_PRISMATIC
+			    && j->getType() != TAO_JOINT_REVOLUTE
+			    && j->getType() != TAO_JOINT_SPHERICAL)
+				return false;
+
+	_tree = tree;
+	for (deInt i = 0; i < tree->size(); i++)
+		for (taoJoint* j = tree->node(i)->getJointList(); j != NULL; j = j->getNext())
+		{
+			_joint.push_back(j);
+			_nq += (j->getType() == TAO_JOINT_SPHERICAL) ? 4 : 1;
+			_ndq += j->getDOF();
+		}
+
+	_q0.resize(_nq);
+	_q.resize(_nq);
+	_dq0.resize(_ndq);
+	_dq.resize(_ndq);
+	_ddq0.resize(_ndq);
+	for (deInt k = 0; k < 4; k++)
+	{
+		_kq[k].resize(_nq);
+		_kdq[k].resize(_ndq);
+	}
+	return true;
+}
+
+void taoIntegrator::readState(deFloat* q, deFloat* dq) const
+{
+	for (size_t i = 0; i < _joint.size(); i++)
+	{
+		if (_joint[i]->getType() == TAO_JOINT_SPHERICAL)
+		{
+			taoVarSpherical const * var = ((taoJointSpherical*)_joint[i])->getVarSpherical();
+			for (deInt k = 0; k < 4; k++)
+				q[k] = var->_Q[k];
+			var->_dQrotated.get(dq);
+			q += 4;
+			dq += 3;
+		}
+		else
+		{
+			taoVarDOF1 const * var = ((taoJointDOF1*)_joint[i])->getVarDOF1();
+			*q++ = var->_Q;
+			*dq++ = var->_dQ;
+		}
+	}
+}
+
+void taoIntegrator::writeState(const deFloat* q, const deFloat* dq) const
+{
+	for (size_t i = 0; i < _joint.size(); i++)
+	{
+		if (_joint[i]->getType() == TAO_JOINT_SPHERICAL)
+		{
+			taoVarSpherical* var = ((taoJointSpherical*)_joint[i])->getVarSpherical();
+			var->_Q.set(q);
+			var->_Q.normalize();
+			var->_dQrotated.set(dq);
+			var->_dQ.inversedMultiply(var->_Q, var->_dQrotated);
+			q += 4;
+			dq += 3;
+		}
+		else
+		{
+			taoVarDOF1* var = ((taoJointDOF1*)_joint[i])->getVarDOF1();
+			var->_Q = *q++;
+			var->_dQ = *dq++;
+		}
+	}
+}
+
+void taoIntegrator::readDerivative(deFloat* qdot, deFloat* dqdot) const
+{
+	for (size_t i = 0; i < _joint.size(); i++)
+	{
+		if (_joint[i]->getType() == TAO_JOINT_SPHERICAL)
+		{
+			taoVarSpherical const * var = ((taoJointSpherical*)_joint[i])->getVarSpherical();
+			deQuaternion dq;
+			dq.velocity(var->_Q, var->_dQrotated);
+			for (deInt k = 0; k < 4; k++)
+				qdot[k] = dq[k];
+			// ddQ is expressed in the local frame, dQrotated in the parent frame
+			deVector3 ddq;
+			ddq.multiply(var->_Q, var->_ddQ);
+			ddq.get(dqdot);
+			qdot += 4;
+			dqdot += 3;
+		}
+		else
+		{
+			taoVarDOF1 const * var = ((taoJointDOF1*)_joint[i])->getVarDOF1();
+			*qdot++ = var->_dQ;
+			*dqdot++ = var->_ddQ;
+		}
+	}
+}
+
+// q = q0 + h * kq, dq = dq0 + h * kdq
+void taoIntegrator::_stage(const deFloat* kq, const deFloat* kdq, deFloat h)
+{
+	for (deInt i = 0; i < _nq; i++)
+		_q[i] = _q0[i] + h * kq[i];
+	for (deInt i = 0; i < _ndq; i++)
+		_dq[i] = _dq0[i] + h * kdq[i];
+	writeState(&_q[0], &_dq[0]);
+}
+
+void taoIntegrator::_clampDQ()
+{
+	for (size_t i = 0; i < _joint.size(); i++)
+		if (_joint[i]->getDQclamp())
+			_joint[i]->clampDQ();
+}
+
+void taoIntegrator::integrate(const deVector3* gravity, deFloat dt)
+{
+	deInt i;
+
+	if (_tree == NULL)
+		return;
+
+	if (_type == TAO_INTEGRATOR_EULER)
+	{
+		taoDynamics::integrate(_tree, dt);
+		return;
+	}
+
+	if (_nq == 0)
+		return;
+
+	readState(&_q0[0], &_dq0[0]);
+	readDerivative(&_kq[0][0], &_kdq[0][0]);
+
+	// TAO_INTEGRATOR_RK4, the caller already evaluated the first stage
+	deInt k = 0;
+	for (size_t j = 0; j < _joint.size(); j++)
+	{
+		_joint[j]->getDDQ(&_ddq0[k]);
+		k += _joint[j]->getDOF();
+	}
+
+	_stage(&_kq[0][0], &_kdq[0][0], 0.5f * dt);
+	taoDynamics::fwdDynamics(_tree, gravity);
+	readDerivative(&_kq[1][0], &_kdq[1][0]);
+
+	_stage(&_kq[1][0], &_kdq[1][0], 0.5f * dt);
+	taoDynamics::fwdDynamics(_tree, gravity);
+	readDerivative(&_kq[2][0], &_kdq[2][0]);
+
+	_stage(&_kq[2][0], &_kdq[2][0], dt);
+	taoDynamics::fwdDynamics(_tree, gravity);
+	readDerivative(&_kq[3][0], &_kdq[3][0]);
+
+	deFloat const h = dt / 6;
+	for (i = 0; i < _nq; i++)
+		_q[i] = _q0[i] + h * (_kq[0][i] + 2 * _kq[1][i] + 2 * _kq[2][i] + _kq[3][i]);
+	for (i = 0; i < _ndq; i++)
+		_dq[i] = _dq0[i] + h * (_kdq[0][i] + 2 * _kdq[1][i] + 2 * _kdq[2][i] + _kdq[3][i]);
+	writeState(&_q[0], &_dq[0]);
+	_clampDQ();
+
+	k = 0;
+	for (size_t j = 0; j < _joint.size(); j++)
+	{
+		_joint[j]->setDDQ(&_ddq0[k]);
+		k += _joint[j]->getDOF();
+	}
+}
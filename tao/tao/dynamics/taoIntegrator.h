@@ -0,0 +1,117 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _taoIntegrator_h
+#define _taoIntegrator_h
+
+#include "taoTypes.h"
+#include <vector>
+
+class taoJoint;
+class taoABTraversal;
+class deVector3;
+
+/*!
+ *	\brief whole-tree time integration
+ *	\ingroup taoDynamics
+ *
+ *	Gathers the joint positions and velocities of a tree into flat
+ *	state vectors and advances them with a selectable scheme:
+ *
+ *	- TAO_INTEGRATOR_EULER is the explicit Euler step of
+ *	  taoDynamics::integrate() and gives bitwise identical results.
+ *	- TAO_INTEGRATOR_RK4 is the classical fourth-order Runge-Kutta
+ *	  scheme, holding tau constant over the step. It calls
+ *	  taoDynamics::fwdDynamics() three extra times per step, but
+ *	  tolerates much larger timesteps at the same energy drift.
+ *
+ *	Spherical joints contribute their quaternion (4 entries) to q
+ *	and their velocity in the parent frame (3 entries) to dq.
+ *
+ *	\remarks ************* Usage
+ *	\remarks {
+ *	\remarks		taoABTraversal tree(root);
+ *	\remarks		taoIntegrator integrator(TAO_INTEGRATOR_RK4);
+ *	\remarks		integrator.build(&tree);
+ *	\remarks		for (...) {
+ *	\remarks			taoDynamics::fwdDynamics(&tree, gravity);
+ *	\remarks			integrator.integrate(gravity, dt);
+ *	\remarks			taoDynamics::updateTransformation(&tree);
+ *	\remarks		}
+ *	\remarks }
+ */
+class taoIntegrator
+{
+public:
+	taoIntegrator(taoIntegratorType type = TAO_INTEGRATOR_EULER);
+
+	void setType(taoIntegratorType type) { _type = type; }
+	taoIntegratorType getType() const { return _type; }
+
+	//! collects the joints of \a tree and sizes the state vectors
+	/*!
+	 *	\return	false if the tree contains a joint other than
+	 *		prismatic, revolute, or spherical, in which case the
+	 *		integrator is left empty and integrate() does nothing
+	 *	\remarks	call again whenever the structure of the tree changes
+	 */
+	bool build(const taoABTraversal* tree);
+	//! number of position entries
+	deInt getSizeQ() const { return _nq; }
+	//! number of velocity entries
+	deInt getSizeDQ() const { return _ndq; }
+
+	//! copies the joint positions and velocities into \a q and \a dq
+	void readState(deFloat* q, deFloat* dq) const;
+	//! sets the joint positions and velocities, quaternions are normalized
+	void writeState(const deFloat* q, const deFloat* dq) const;
+	//! computes the time derivative of q and dq from the current joint variables
+	/*!
+	 *	\pre	q, dq, ddq
+	 */
+	void readDerivative(deFloat* qdot, deFloat* dqdot) const;
+
+	//! advances the tree by \a dt
+	/*!
+	 *	\pre	q, dq, tau, and ddq from taoDynamics::fwdDynamics()
+	 *	\post	q, dq at the end of the step, ddq is left as it was
+	 *	\remarks	\a gravity is only used by TAO_INTEGRATOR_RK4
+	 *	\remarks	frames are not updated, call taoDynamics::updateTransformation()
+	 */
+	void integrate(const deVector3* gravity, deFloat dt);
+
+private:
+	void _stage(const deFloat* kq, const deFloat* kdq, deFloat h);
+	void _clampDQ();
+
+	taoIntegratorType _type;
+	const taoABTraversal* _tree;
+	std::vector<taoJoint*> _joint;
+	deInt _nq, _ndq;
+
+	std::vector<deFloat> _q0, _dq0, _ddq0;
+	std::vector<deFloat> _q, _dq;
+	std::vector<deFloat> _kq[4], _kdq[4];
+};
+
+#endif // _taoIntegrator_h
@@ -74,11 +74,12 @@ void taoNode::_Initialize()
 	_jointList = NULL;
 }
 
-void taoNode::sync(deFrame* local)
+void taoNode::sync(deFrame const * local)
 {
-	_frameHome = *local;
-	_frameLocal = _frameHome;
-	_frameGlobal.multiply(*_parent->frameGlobal(), _frameLocal);
+	_frameHome.set(*local);
+	_frameLocal = _frameHome.frame();
+	_frameGlobal.frame().multiply(*_parent->frameGlobal(), _frameLocal);
+	_frameGlobal.update();
 
 	taoJoint* j = _jointList;
 	while (j)
@@ -105,17 +106,25 @@ void taoNode::updateFrame()
 #if 0
 	getABNode()->getFrameLocal(_frameLocal);
 #else
-	deFrame fl;
-	_frameLocal = _frameHome;
+	deFrame fl, f;
+	_frameLocal = _frameHome.frame();
 	for (taoJoint* j = _jointList; j != NULL; j = j->getNext())
 	{
 		fl.identity();
 		j->updateFrameLocal(&fl);
-		_frameGlobal = _frameLocal;
-		_frameLocal.multiply(_frameGlobal, fl);
+		f = _frameLocal;
+		_frameLocal.multiply(f, fl);
 	}
 #endif
-	_frameGlobal.multiply(*_parent->frameGlobal(), _frameLocal);
+	// the parent has already been updated, so its cached matrix is valid
+	deCachedFrame const * parentGlobal = _parent->cachedFrameGlobal();
+	if (parentGlobal)
+		_frameGlobal.multiply(*parentGlobal, _frameLocal);
+	else
+	{
+		_frameGlobal.frame().multiply(*_parent->frameGlobal(), _frameLocal);
+		_frameGlobal.update();
+	}
 }
 
 void taoNode::integrate(deFloat dt)
@@ -179,9 +188,9 @@ void taoNode::link(taoDNode* parent, deFrame const * home)
 	_parent = parent;
 	_sibling = (taoNode*)_parent->getDChild();
 	_parent->setDChild(this);
-	_frameHome = *home;
-	_frameLocal = _frameHome;
-	_frameGlobal = _frameHome;
+	_frameHome.set(*home);
+	_frameLocal = *home;
+	_frameGlobal.set(*home);
 }
 
 void taoNode::unlink()
@@ -253,7 +262,7 @@ deVector6* taoNodeRoot::acceleration()
 taoNodeRoot::taoNodeRoot(deFrame const & global)
 { 
 	_zero = 0;
-	_frameGlobal = global;
+	_frameGlobal.set(global);
 
 	_group = NULL;
 	_controller = NULL;
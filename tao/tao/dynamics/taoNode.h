@@ -43,7 +43,7 @@ public:
 	taoNode(taoDNode* parent, deFrame const * home);
 	virtual ~taoNode();
 
-	virtual void sync(deFrame* local);
+	virtual void sync(deFrame const * local);
 
 	virtual taoJoint* getJointList() { return _jointList; }
 	virtual taoJoint const * getJointList() const { return _jointList; }
@@ -58,10 +58,11 @@ public:
 	virtual deVector6* acceleration();
 	virtual void getFrameGraphics(deFrame* Tog) { *Tog = *frameGlobal(); }
 
-	virtual deFrame* frameHome() { return &_frameHome; }
-	virtual deFrame* frameLocal() { return &_frameLocal; }
-	virtual deFrame* frameGlobal() { return &_frameGlobal; }
-	virtual deFrame const * frameGlobal() const { return &_frameGlobal; }
+	virtual deFrame const * frameHome() const { return &_frameHome.frame(); }
+	virtual deFrame const * frameLocal() const { return &_frameLocal; }
+	virtual deFrame const * frameGlobal() const { return &_frameGlobal.frame(); }
+	virtual deCachedFrame const * cachedFrameHome() const { return &_frameHome; }
+	virtual deCachedFrame const * cachedFrameGlobal() const { return &_frameGlobal; }
 	virtual deFloat* mass() { return &_mass; }
 	virtual deVector3* center() { return &_center; }
 	virtual deVector3 const * center() const { return &_center; }
@@ -114,9 +115,9 @@ public:
 	virtual void force(const deVector3* Pie, const deVector3* Fie);
 
 private:
-	deFrame _frameHome;
+	deCachedFrame _frameHome;
 	deFrame _frameLocal;
-	deFrame _frameGlobal;
+	deCachedFrame _frameGlobal;
 
 	deVector3 _center;
 	deFloat _mass;
@@ -147,7 +148,7 @@ public:
 
 	virtual ~taoNodeRoot();
 
-	virtual void sync(deFrame* local) { _frameGlobal = *local; } 
+	virtual void sync(deFrame const * local) { _frameGlobal.set(*local); }
 
 	virtual taoJoint* getJointList() { return NULL; }
 	virtual taoJoint const * getJointList() const { return NULL; }
@@ -156,10 +157,11 @@ public:
 	virtual deVector6* acceleration();
 	virtual void getFrameGraphics(deFrame* Tog) { *Tog = *frameGlobal(); }
 
-	virtual deFrame* frameHome() { return &_frameGlobal; }
-	virtual deFrame* frameLocal() { return &_frameGlobal; }
-	virtual deFrame* frameGlobal() { return &_frameGlobal; }
-	virtual deFrame const * frameGlobal() const { return &_frameGlobal; }
+	virtual deFrame const * frameHome() const { return &_frameGlobal.frame(); }
+	virtual deFrame const * frameLocal() const { return &_frameGlobal.frame(); }
+	virtual deFrame const * frameGlobal() const { return &_frameGlobal.frame(); }
+	virtual deCachedFrame const * cachedFrameHome() const { return &_frameGlobal; }
+	virtual deCachedFrame const * cachedFrameGlobal() const { return &_frameGlobal; }
 	virtual deFloat* mass() { return &_zero; } // YYY
 	virtual deVector3* center() { return NULL; }
 	virtual deVector3 const * center() const { return NULL; }
@@ -168,6 +170,7 @@ public:
 	virtual void zeroForce() {}
 	virtual void addForce(const deVector6* f) {}
 
+	//! the global frame only changes in sync(), which refreshes the cache
 	virtual void updateFrame() {}
 	virtual void integrate(deFloat dt) {}
 
@@ -195,7 +198,7 @@ public:
 
 private:
 	deFloat _zero; // YYY
-	deFrame _frameGlobal;
+	deCachedFrame _frameGlobal;
 
 	taoGroup* _group;
 	taoControl* _controller;
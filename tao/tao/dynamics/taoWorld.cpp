@@ -80,8 +80,23 @@ taoGroup* taoWorld::findGroup(const deInt id)
 	return NULL;
 }
 
+void taoWorld::_CollectRoots()
+{
+	_active.clear();
+	for (taoGroup* g = _groupList; g != NULL; g = g->getNext())
+		if (!g->getIsFixed())
+			g->collectRoots(_active);
+}
+
 void taoWorld::update(const deFloat time, const deFloat dt, const deInt n)
 {
+	if (_pool)
+	{
+		_CollectRoots();
+		taoGroup::stepParallel(_pool, _active, taoGroup::TAO_STEP_UPDATE, time, dt, n);
+		return;
+	}
+
 	taoGroup* g = _groupList;
 	while (g)
 	{	
@@ -93,6 +108,13 @@ void taoWorld::update(const deFloat time, const deFloat dt, const deInt n)
 
 void taoWorld::control(const deFloat time)
 {
+	if (_pool)
+	{
+		_CollectRoots();
+		taoGroup::stepParallel(_pool, _active, taoGroup::TAO_STEP_CONTROL, time, 0, 0);
+		return;
+	}
+
 	taoGroup* g = _groupList;
 	while (g)
 	{	
@@ -104,6 +126,13 @@ void taoWorld::control(const deFloat time)
 
 void taoWorld::simulate(const deFloat dt)
 {
+	if (_pool)
+	{
+		_CollectRoots();
+		taoGroup::stepParallel(_pool, _active, taoGroup::TAO_STEP_SIMULATE, 0, dt, 0);
+		return;
+	}
+
 	taoGroup* g = _groupList;
 	while (g)
 	{	
@@ -115,6 +144,13 @@ void taoWorld::simulate(const deFloat dt)
 
 void taoWorld::updateTransformation()
 {
+	if (_pool)
+	{
+		_CollectRoots();
+		taoGroup::stepParallel(_pool, _active, taoGroup::TAO_STEP_TRANSFORMATION, 0, 0, 0);
+		return;
+	}
+
 	taoGroup* g = _groupList;
 	while (g)
 	{	
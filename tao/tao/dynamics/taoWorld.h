@@ -24,8 +24,11 @@
 #define _taoWorld_h
 
 #include "taoTypes.h"
+#include <vector>
 
 class taoGroup;
+class taoNodeRoot;
+class deThreadPool;
 
 /*!
  *	\brief container class to hold dynamics groups.
@@ -38,7 +41,7 @@ class taoGroup;
 class taoWorld
 {
 public:
-	taoWorld() : _groupList(NULL) {}
+	taoWorld() : _groupList(NULL), _pool(NULL) {}
 	~taoWorld();
 
 	taoGroup* getGroupList() { return _groupList; }
@@ -67,8 +70,22 @@ public:
 	void simulate(const deFloat dt);
 	void updateTransformation();
 
+	/*!
+	 *	\remarks	with a thread pool, the roots of all groups that are
+	 *			not fixed are stepped in parallel, one job per root.
+	 *			Groups never interact, so the results are the same
+	 *			as in serial mode, independent of the number of threads.
+	 *	\remarks	pass NULL (the default) for serial stepping.
+	 */
+	void setThreadPool(deThreadPool* pool) { _pool = pool; }
+	deThreadPool* getThreadPool() { return _pool; }
+
 private:
 	taoGroup* _groupList;
+	deThreadPool* _pool;
+	std::vector<taoNodeRoot*> _active;
+
+	void _CollectRoots();
 };
 
 #endif // _taoWorld_h
@@ -0,0 +1,67 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _deCachedFrame_h
+#define _deCachedFrame_h
+/*!
+ *	\brief		Frame with cached rotation matrix
+ *	\ingroup	deMath
+ *
+ *	This class keeps a deFrame together with the equivalent
+ *	deTransform, so that code which needs the rotation as a 3x3 matrix
+ *	does not have to convert the quaternion over and over again. The
+ *	cached transform is refreshed by set(), multiply() and update().
+ *	\remarks	if you modify frame() directly, call update() afterwards.
+ *	\sa deFrame, deTransform
+ */
+class deCachedFrame
+{
+public:
+	inline deCachedFrame() { identity(); }
+
+	//! \return frame, call update() after modifying it
+	deFrame& frame() { return _f; }
+	//! \return frame
+	const deFrame& frame() const { return _f; }
+	//! \return transform cached by the last set(), multiply() or update()
+	const deTransform& transform() const { return _x; }
+	//! \return cached rotation matrix
+	const deMatrix3& rotationMatrix() const { return _x.rotation(); }
+	//! \return translation part
+	const deVector3& translation() const { return _f.translation(); }
+
+	//! this = identity matrix
+	DE_MATH_API void identity();
+	//! refreshes the cached transform from frame()
+	DE_MATH_API void update();
+	//! this = f
+	DE_MATH_API void set(const deFrame& f);
+	//! this = f1 * f2 = [r1,p1][r2,p2] = [r1*r2, R1*p2 + p1]
+	//  where R1 is the cached rotation matrix of f1
+	DE_MATH_API void multiply(const deCachedFrame& f1, const deFrame& f2);
+
+private:
+	deFrame _f;
+	deTransform _x;
+};
+
+#endif // _deCachedFrame_h
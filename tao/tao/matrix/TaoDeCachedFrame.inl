@@ -0,0 +1,37 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _deCachedFrame_inl
+#define _deCachedFrame_inl
+
+DE_MATH_API void deCachedFrame::identity() { _f.identity(); _x.identity(); }
+DE_MATH_API void deCachedFrame::update() { _x.set(_f); }
+DE_MATH_API void deCachedFrame::set(const deFrame& f) { _f = f; _x.set(_f); }
+//! this = f1 * f2 = [r1,p1][r2,p2] = [r1*r2, R1*p2 + p1]
+DE_MATH_API void deCachedFrame::multiply(const deCachedFrame& f1, const deFrame& f2) {
+	_f.rotation().multiply(f1.frame().rotation(), f2.rotation());
+	_f.translation().multiply(f1.rotationMatrix(), f2.translation());
+	_f.translation() += f1.translation();
+	_x.set(_f);
+}
+
+#endif // _deCachedFrame_inl
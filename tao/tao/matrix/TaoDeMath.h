@@ -104,6 +104,7 @@ class deQuaternion;
 class deMatrix3;
 class deFrame;
 class deTransform;
+class deCachedFrame;
 class deVector6;
 class deMatrix6;
 
@@ -112,6 +113,7 @@ class deMatrix6;
 #include "TaoDeMatrix3.h"
 #include "TaoDeFrame.h"
 #include "TaoDeTransform.h"
+#include "TaoDeCachedFrame.h"
 #include "TaoDeVector6.h"
 #include "TaoDeMatrix6.h"
 
@@ -120,6 +122,7 @@ class deMatrix6;
 #include "TaoDeMatrix3.inl"
 #include "TaoDeFrame.inl"
 #include "TaoDeTransform.inl"
+#include "TaoDeCachedFrame.inl"
 #include "TaoDeVector6.inl"
 #include "TaoDeMatrix6.inl"
 
@@ -22,6 +22,8 @@
 
 #include <stdio.h> // NULL
 #include <stdarg.h>
+#include <string.h>
+#include <unistd.h> // usleep
 #ifdef WIN32
 #include <windows.h> // OutputDebugString
 #endif
@@ -69,6 +71,108 @@ void deLoggerOutputFile::Log(deChar *msg)
 	fprintf(logfile, "%s", msg);
 }
 
+//
+// deLoggerOutputAsync
+//
+
+deLoggerOutputAsync::deLoggerOutputAsync(deLoggerOutput* sink, deInt capacity, deInt recordSize, deInt periodUsec)
+{
+	unsigned int n = 1;
+	while (n < (unsigned int) capacity)
+		n <<= 1;
+
+	_sink = sink;
+	_recordSize = recordSize;
+	_mask = n - 1;
+	_periodUsec = periodUsec;
+	_record = new deChar[n * recordSize];
+	_head = 0;
+	_tail = 0;
+	_producing = 0;
+	_dropped = 0;
+	_quit = 0;
+
+	if (pthread_create(&_thread, NULL, _Main, this) != 0)
+		_quit = 1;
+}
+
+deLoggerOutputAsync::~deLoggerOutputAsync()
+{
+	if (!_quit)
+	{
+		_quit = 1;
+		pthread_join(_thread, NULL);
+	}
+	_Drain();
+	delete[] _record;
+	delete _sink;
+}
+
+void deLoggerOutputAsync::Log(deChar *msg)
+{
+	// a second producer racing with the first one loses its message
+	if (__sync_lock_test_and_set(&_producing, 1))
+	{
+		__sync_fetch_and_add(&_dropped, 1);
+		return;
+	}
+
+	unsigned int head = _head;
+	if (head - _tail > _mask)
+		__sync_fetch_and_add(&_dropped, 1);
+	else
+	{
+		deChar* rec = _record + (head & _mask) * _recordSize;
+		strncpy(rec, msg, _recordSize - 1);
+		rec[_recordSize - 1] = '\0';
+		// publish the record only after its contents are visible
+		__sync_synchronize();
+		_head = head + 1;
+	}
+
+	__sync_lock_release(&_producing);
+}
+
+void deLoggerOutputAsync::Flush()
+{
+	unsigned int head = _head;
+	while ((deInt)(head - _tail) > 0)
+	{
+		if (_quit)
+		{
+			// no background thread, drain on the caller
+			_Drain();
+			break;
+		}
+		usleep(_periodUsec);
+	}
+}
+
+deInt deLoggerOutputAsync::_Drain()
+{
+	deInt n = 0;
+	unsigned int head = _head;
+	__sync_synchronize();
+	while (_tail != head)
+	{
+		_sink->Log(_record + (_tail & _mask) * _recordSize);
+		// hand the slot back only after the sink is done with it
+		__sync_synchronize();
+		_tail = _tail + 1;
+		n++;
+	}
+	return n;
+}
+
+void* deLoggerOutputAsync::_Main(void* arg)
+{
+	deLoggerOutputAsync* self = (deLoggerOutputAsync*) arg;
+	while (!self->_quit)
+		if (self->_Drain() == 0)
+			usleep(self->_periodUsec);
+	return NULL;
+}
+
 //
 // deLogger
 //
@@ -24,6 +24,7 @@
 #define _DELOGGER_H
 
 #include <stdio.h>
+#include <pthread.h>
 
 #include <tao/matrix/TaoDeTypes.h>
 
@@ -111,6 +112,58 @@ private:
 	FILE *logfile;
 };
 
+/*!
+ *	\brief		Asynchronous output, hands messages to a background thread
+ *	\ingroup	deUtility
+ *
+ *	Log() copies the preformatted message into a fixed-size record of
+ *	a lock-free ring buffer and returns immediately. A background
+ *	thread drains the records into the wrapped \a sink, so slow sinks
+ *	such as deLoggerOutputFile never stall the thread that logs.
+ *
+ *	Log() never blocks and never allocates. When the ring is full, or
+ *	when another thread is logging through the same output at the same
+ *	moment, the message is dropped and counted instead. Messages
+ *	longer than the record size are truncated.
+ *
+ *	\remarks	usage: deLogger::AddOutput(new deLoggerOutputAsync(new deLoggerOutputFile("tao.log")));
+ */
+class deLoggerOutputAsync : public deLoggerOutput
+{
+public:
+	//! takes ownership of \a sink, \a capacity is rounded up to a power of two
+	deLoggerOutputAsync(deLoggerOutput* sink, deInt capacity = 1024, deInt recordSize = 256, deInt periodUsec = 1000);
+	//! stops the background thread after draining all pending records
+	~deLoggerOutputAsync();
+
+	virtual void Log(deChar *msg);
+
+	//! waits until all records logged so far have reached the sink
+	void Flush();
+	//! \return number of messages dropped so far
+	deInt GetDropped() const { return _dropped; }
+
+private:
+	static void* _Main(void* arg);
+	deInt _Drain();
+
+	deLoggerOutput* _sink;
+	deChar* _record;
+	deInt _recordSize;
+	unsigned int _mask;
+	deInt _periodUsec;
+
+	volatile unsigned int _head;	//!< written by the producer only
+	volatile unsigned int _tail;	//!< written by the background thread only
+	volatile deInt _producing;
+	volatile deInt _dropped;
+	volatile deInt _quit;
+	pthread_t _thread;
+
+	deLoggerOutputAsync(deLoggerOutputAsync const &);
+	deLoggerOutputAsync& operator=(deLoggerOutputAsync const &);
+};
+
 /*!
  *	\brief		Logger class - printing to various outputs
  *	\ingroup	deUtility
@@ -0,0 +1,178 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TaoDeThreadPool.h"
+#include <stdio.h> // NULL
+#include <sched.h>
+
+deThreadPool::deThreadPool(deInt nthreads, deInt spin)
+	: _nworkers(nthreads > 1 ? nthreads - 1 : 0), _spin(spin), _worker(NULL),
+	  _job(NULL), _arg(NULL), _njobs(0), _generation(0), _busy(0), _quit(0)
+{
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_start, NULL);
+	pthread_cond_init(&_done, NULL);
+
+	if (_nworkers > 0)
+		_worker = new Worker[_nworkers];
+	for (deInt i = 0; i < _nworkers; i++)
+	{
+		_worker[i].pool = this;
+		_worker[i].index = i + 1; // index 0 is the calling thread
+		pthread_create(&_worker[i].thread, NULL, _Main, &_worker[i]);
+	}
+}
+
+deThreadPool::~deThreadPool()
+{
+	pthread_mutex_lock(&_mutex);
+	_quit = 1;
+	pthread_cond_broadcast(&_start);
+	pthread_mutex_unlock(&_mutex);
+
+	for (deInt i = 0; i < _nworkers; i++)
+		pthread_join(_worker[i].thread, NULL);
+	delete[] _worker;
+
+	pthread_cond_destroy(&_done);
+	pthread_cond_destroy(&_start);
+	pthread_mutex_destroy(&_mutex);
+}
+
+void deThreadPool::run(deJob job, void* arg, deInt n)
+{
+	if (_nworkers == 0 || n <= 1)
+	{
+		for (deInt i = 0; i < n; i++)
+			job(arg, i);
+		return;
+	}
+
+	if (_spin)
+	{
+		_job = job;
+		_arg = arg;
+		_njobs = n;
+		_busy = _nworkers;
+		// full barrier: the job is visible before the new generation
+		__sync_fetch_and_add(&_generation, 1);
+
+		_Stride(0);
+
+		deInt spins = 0;
+		while (_busy > 0)
+			_Relax(spins);
+		__sync_synchronize();
+		return;
+	}
+
+	pthread_mutex_lock(&_mutex);
+	_job = job;
+	_arg = arg;
+	_njobs = n;
+	_busy = _nworkers;
+	_generation++;
+	pthread_cond_broadcast(&_start);
+	pthread_mutex_unlock(&_mutex);
+
+	_Stride(0);
+
+	pthread_mutex_lock(&_mutex);
+	while (_busy > 0)
+		pthread_cond_wait(&_done, &_mutex);
+	pthread_mutex_unlock(&_mutex);
+}
+
+void deThreadPool::_Stride(deInt index)
+{
+	for (deInt i = index; i < _njobs; i += _nworkers + 1)
+		_job(_arg, i);
+}
+
+void deThreadPool::_Relax(deInt& spins)
+{
+	// After a while, give the core away in case the pool has more
+	// threads than there are cores. This is cheap when nothing else
+	// is runnable.
+	if (++spins > 1000)
+	{
+		sched_yield();
+		return;
+	}
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__ ("pause");
+#endif
+}
+
+void deThreadPool::_SpinMain(Worker* w)
+{
+	deThreadPool* pool = w->pool;
+	deInt generation = 0;
+
+	for (;;)
+	{
+		deInt spins = 0;
+		while (!pool->_quit && pool->_generation == generation)
+			_Relax(spins);
+		if (pool->_quit)
+			break;
+		__sync_synchronize();
+		generation = pool->_generation;
+
+		pool->_Stride(w->index);
+
+		__sync_fetch_and_sub(&pool->_busy, 1);
+	}
+}
+
+void* deThreadPool::_Main(void* arg)
+{
+	Worker* w = (Worker*)arg;
+	deThreadPool* pool = w->pool;
+	deInt generation = 0;
+
+	if (pool->_spin)
+	{
+		_SpinMain(w);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&pool->_mutex);
+	for (;;)
+	{
+		while (!pool->_quit && pool->_generation == generation)
+			pthread_cond_wait(&pool->_start, &pool->_mutex);
+		if (pool->_quit)
+			break;
+		generation = pool->_generation;
+		pthread_mutex_unlock(&pool->_mutex);
+
+		pool->_Stride(w->index);
+
+		pthread_mutex_lock(&pool->_mutex);
+		if (--pool->_busy == 0)
+			pthread_cond_signal(&pool->_done);
+	}
+	pthread_mutex_unlock(&pool->_mutex);
+
+	return NULL;
+}
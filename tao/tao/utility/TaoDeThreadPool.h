@@ -0,0 +1,99 @@
+/* Copyright (c) 2005 Arachi, Inc. and Stanford University. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _DETHREADPOOL_H
+#define _DETHREADPOOL_H
+
+#include <pthread.h>
+
+#include <tao/matrix/TaoDeTypes.h>
+
+/*!
+ *	\brief		Fixed-size pool of worker threads
+ *	\ingroup	deUtility
+ *
+ *	run() hands out the indices 0..n-1 to the calling thread and the
+ *	workers in a fixed round-robin pattern, so a given index is always
+ *	processed by the same thread and the jobs must not depend on each
+ *	other. It returns once all jobs are done.
+ *
+ *	In spinning mode, idle workers busy-wait for the next run() instead
+ *	of sleeping on a condition variable, and run() busy-waits for them
+ *	to finish. This avoids the scheduler wake-up latency on every call,
+ *	at the price of keeping nthreads-1 cores busy all the time. Use it
+ *	for real-time loops that have cores to themselves. Waiting threads
+ *	start yielding after a short while, so that an oversubscribed
+ *	machine still makes progress.
+ *
+ *	\remarks	run() must not be called recursively from inside a job.
+ */
+class deThreadPool
+{
+public:
+	typedef void (*deJob)(void* arg, deInt index);
+
+	//! \a nthreads includes the calling thread, so 1 means no workers;
+	//! non-zero \a spin selects spinning mode
+	explicit deThreadPool(deInt nthreads, deInt spin = 0);
+	~deThreadPool();
+
+	//! \return number of threads, including the calling thread
+	deInt getNumThreads() const { return _nworkers + 1; }
+	//! \return non-zero in spinning mode
+	deInt isSpinning() const { return _spin; }
+
+	//! calls \a job(\a arg, i) for i in [0, \a n) and waits for completion
+	void run(deJob job, void* arg, deInt n);
+
+private:
+	struct Worker
+	{
+		deThreadPool* pool;
+		deInt index;
+		pthread_t thread;
+	};
+
+	static void* _Main(void* arg);
+	static void _SpinMain(Worker* w);
+	static void _Relax(deInt& spins);
+	void _Stride(deInt index);
+
+	deInt _nworkers;
+	deInt _spin;
+	Worker* _worker;
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _start;
+	pthread_cond_t _done;
+
+	deJob _job;
+	void* _arg;
+	deInt _njobs;
+	volatile deInt _generation;
+	volatile deInt _busy;
+	volatile deInt _quit;
+
+	deThreadPool(deThreadPool const &);
+	deThreadPool& operator=(deThreadPool const &);
+};
+
+#endif // _DETHREADPOOL_H
@@ -0,0 +1,127 @@
+/*
+ * Stanford Whole-Body Control Framework http://stanford-wbc.sourceforge.net/
+ *
+ * Copyright (c) 2009 Stanford University. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchIntegrator.cpp
+   \brief Energy drift versus timestep for the taoIntegrator schemes.
+   
+   Simulates an unactuated chain under gravity, which should conserve
+   its total energy, and reports the worst energy error seen over the
+   run. The reference is explicit Euler at 0.1ms, i.e. the 10 substeps
+   per 1ms sample that dynsim uses by default. For each scheme the
+   largest timestep that stays within that drift is then listed along
+   with the resulting speedup.
+*/
+
+#include "chain.h"
+#include <iostream>
+#include <sstream>
+#include <err.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using namespace std;
+using namespace tao_test;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+int main(int argc, char ** argv)
+{
+  int nlinks(7);
+  double duration(2);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-l" == opt) {
+      is >> nlinks;
+    }
+    else if ("-T" == opt) {
+      is >> duration;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -l nlinks -T seconds)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  static int const ntypes(2);
+  static taoIntegratorType const type[ntypes] = {
+    TAO_INTEGRATOR_EULER,
+    TAO_INTEGRATOR_RK4
+  };
+  static char const * name[ntypes] = { "euler", "rk4" };
+  static int const ndt(8);
+  static double const dt[ndt] = { 1e-4, 2e-4, 5e-4, 1e-3, 2e-3, 5e-3, 1e-2, 2e-2 };
+  
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  double drift[ntypes][ndt];
+  double cost[ntypes][ndt];
+  
+  cout << "# " << nlinks << " links, " << duration << " s simulated\n"
+       << "# integrator     dt[ms]  drift[J]      wallclock[ms]\n";
+  for (int it(0); it < ntypes; ++it) {
+    for (int id(0); id < ndt; ++id) {
+      taoNodeRoot * root(create_chain(nlinks, 0));
+      taoABTraversal tree(root);
+      set_state(tree);
+      taoIntegrator integrator(type[it]);
+      int const nsteps(static_cast<int>(duration / dt[id] + 0.5));
+      double const t0(now());
+      drift[it][id] = energy_drift(tree, integrator, gravity, dt[id], nsteps);
+      cost[it][id] = now() - t0;
+      delete root;
+      cout << "  " << name[it] << "\t\t"
+	   << 1e3 * dt[id] << "\t" << drift[it][id] << "\t" << 1e3 * cost[it][id] << "\n";
+    }
+  }
+  
+  double const ref_drift(drift[0][0]);
+  double const ref_cost(cost[0][0]);
+  cout << "\n# largest dt with drift <= " << ref_drift << " J (euler at " << 1e3 * dt[0] << " ms)\n"
+       << "# integrator     dt[ms]  wallclock[ms] speedup\n";
+  for (int it(0); it < ntypes; ++it) {
+    int best(-1);
+    for (int id(0); id < ndt; ++id) {
+      if (drift[it][id] <= ref_drift) {
+	best = id;
+      }
+    }
+    cout << "  " << name[it] << "\t\t";
+    if (best < 0) {
+      cout << "none\n";
+    }
+    else {
+      cout << 1e3 * dt[best] << "\t" << 1e3 * cost[it][best] << "\t\t" << ref_cost / cost[it][best] << "\n";
+    }
+  }
+}
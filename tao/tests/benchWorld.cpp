@@ -0,0 +1,157 @@
+/*
+ * Stanford Whole-Body Control Framework http://stanford-wbc.sourceforge.net/
+ *
+ * Copyright (c) 2009 Stanford University. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file benchWorld.cpp
+   \brief Serial versus parallel stepping of a taoWorld with 1 to 64
+   independent robots, one taoGroup per robot.
+*/
+
+#include "chain.h"
+#include <tao/dynamics/taoWorld.h>
+#include <tao/dynamics/taoGroup.h>
+#include <tao/utility/TaoDeThreadPool.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <err.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace std;
+using namespace tao_test;
+
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+static taoWorld * create_world(int nrobots, int nlinks, vector<taoNodeRoot*> & roots)
+{
+  taoWorld * world(new taoWorld());
+  roots.clear();
+  for (int ii(0); ii < nrobots; ++ii) {
+    taoNodeRoot * root(create_chain(nlinks, 0));
+    taoABTraversal tree(root);
+    set_state(tree);
+    taoGroup * group(new taoGroup());
+    group->gravity()->set(0, 0, -9.81);
+    group->addRoot(root, ii);
+    world->addGroup(group, ii);
+    roots.push_back(root);
+  }
+  return world;
+}
+
+
+static bool same_state(taoNodeRoot * aa, taoNodeRoot * bb)
+{
+  taoABTraversal ta(aa), tb(bb);
+  for (int ii(1); ii < ta.size(); ++ii) {
+    deFloat qa, qb, dqa, dqb;
+    ta.node(ii)->getJointList()->getQ(&qa);
+    tb.node(ii)->getJointList()->getQ(&qb);
+    ta.node(ii)->getJointList()->getDQ(&dqa);
+    tb.node(ii)->getJointList()->getDQ(&dqb);
+    if ((qa != qb) || (dqa != dqb)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+int main(int argc, char ** argv)
+{
+  int nlinks(20);
+  int nsteps(1000);
+  int nthreads(sysconf(_SC_NPROCESSORS_ONLN));
+  int maxrobots(64);
+  for (int iopt(1); iopt < argc; ++iopt) {
+    string const opt(argv[iopt]);
+    if (iopt + 1 >= argc) {
+      errx(EXIT_FAILURE, "option `%s' requires an argument", opt.c_str());
+    }
+    istringstream is(argv[++iopt]);
+    if ("-l" == opt) {
+      is >> nlinks;
+    }
+    else if ("-s" == opt) {
+      is >> nsteps;
+    }
+    else if ("-t" == opt) {
+      is >> nthreads;
+    }
+    else if ("-n" == opt) {
+      is >> maxrobots;
+    }
+    else {
+      errx(EXIT_FAILURE, "invalid option `%s' (use -l nlinks -s nsteps -t nthreads -n maxrobots)", opt.c_str());
+    }
+    if ( ! is) {
+      errx(EXIT_FAILURE, "invalid argument for option `%s'", opt.c_str());
+    }
+  }
+  
+  deThreadPool pool(nthreads);
+  deFloat const dt(1e-4);
+  
+  cout << "# " << nlinks << " links per robot, " << nsteps << " steps of " << dt
+       << " s, " << pool.getNumThreads() << " threads\n"
+       << "# robots  serial[ms]  parallel[ms]  speedup  identical\n";
+  
+  for (int nrobots(1); nrobots <= maxrobots; nrobots *= 2) {
+    vector<taoNodeRoot*> serial_roots, parallel_roots;
+    taoWorld * serial(create_world(nrobots, nlinks, serial_roots));
+    taoWorld * parallel(create_world(nrobots, nlinks, parallel_roots));
+    parallel->setThreadPool(&pool);
+    
+    double t0(now());
+    for (int ii(0); ii < nsteps; ++ii) {
+      serial->update(ii * dt, dt, 1);
+    }
+    double const t_serial(now() - t0);
+    
+    t0 = now();
+    for (int ii(0); ii < nsteps; ++ii) {
+      parallel->update(ii * dt, dt, 1);
+    }
+    double const t_parallel(now() - t0);
+    
+    bool identical(true);
+    for (int ii(0); ii < nrobots; ++ii) {
+      identical = identical && same_state(serial_roots[ii], parallel_roots[ii]);
+    }
+    
+    cout << "  " << nrobots
+	 << "\t  " << 1e3 * t_serial
+	 << "\t  " << 1e3 * t_parallel
+	 << "\t  " << t_serial / t_parallel
+	 << "\t  " << (identical ? "yes" : "NO") << "\n";
+    
+    delete serial;
+    delete parallel;
+  }
+}
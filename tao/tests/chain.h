@@ -0,0 +1,211 @@
+/*
+ * Stanford Whole-Body Control Framework http://stanford-wbc.sourceforge.net/
+ *
+ * Copyright (c) 2009 Stanford University. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ */
+
+/**
+   \file chain.h
+   \brief Synthetic TAO trees shared by the tests and benchmarks.
+*/
+
+#ifndef TAO_TESTS_CHAIN_H
+#define TAO_TESTS_CHAIN_H
+
+#include <tao/utility/TaoDeMassProp.h>
+#include <tao/dynamics/taoNode.h>
+#include <tao/dynamics/taoJoint.h>
+#include <tao/dynamics/taoVar.h>
+#include <tao/dynamics/taoDynamics.h>
+#include <tao/dynamics/taoABDynamics.h>
+#include <tao/dynamics/taoIntegrator.h>
+#include <math.h>
+
+
+namespace tao_test {
+  
+  /**
+     Build a serial chain of revolute links, with their axes cycling
+     through X, Y and Z. If branch_every is positive, every so many
+     links also get a prismatic side branch attached to their
+     parent. Node IDs are assigned in creation order, so they range
+     from 0 to N-1 as required by taoDynamics.
+  */
+  inline taoNodeRoot * create_chain(int nlinks, int branch_every)
+  {
+    deFrame global;
+    global.identity();
+    taoNodeRoot * root(new taoNodeRoot(global));
+    root->setID(-1);
+    
+    int id(0);
+    taoDNode * parent(root);
+    for (int ii(0); ii < nlinks; ++ii) {
+      int const nadd((branch_every > 0) && (ii % branch_every == 0) ? 2 : 1);
+      taoDNode * next(0);
+      for (int jj(0); jj < nadd; ++jj) {
+	deFrame home(0.02 * jj, 0.01 * jj, 0.1);
+	taoNode * node(new taoNode(parent, &home));
+	deFrame com(0.01, -0.005 * jj, 0.05);
+	deMassProp mp;
+	mp.inertia(0.01 + 0.001 * ii, 0.02, 0.015, &com);
+	mp.mass(1.0 + 0.1 * ii, &com);
+	mp.get(node->mass(), node->center(), node->inertia());
+	node->setID(id++);
+	taoJoint * joint;
+	if (0 == jj) {
+	  joint = new taoJointRevolute(static_cast<taoAxis>(ii % 3));
+	}
+	else {
+	  joint = new taoJointPrismatic(TAO_AXIS_Y);
+	}
+	joint->setDVar(new taoVarDOF1);
+	joint->reset();
+	joint->setDamping(0.0);
+	joint->setInertia(0.0);
+	node->addJoint(joint);
+	node->addABNode();
+	if (0 == jj) {
+	  next = node;
+	}
+      }
+      parent = next;
+    }
+    
+    taoDynamics::initialize(root);
+    return root;
+  }
+  
+  
+  inline void set_state(taoABTraversal const & tree)
+  {
+    for (int ii(1); ii < tree.size(); ++ii) {
+      taoJoint * joint(tree.node(ii)->getJointList());
+      int const id(tree.node(ii)->getID());
+      deFloat const q(0.3 * sin(0.7 * id + 0.1));
+      deFloat const dq(0.5 * cos(1.3 * id));
+      deFloat const tau(0.2 * sin(2.1 * id + 0.4));
+      joint->setQ(&q);
+      joint->setDQ(&dq);
+      joint->setTau(&tau);
+    }
+    taoDynamics::updateTransformation(tree.root());
+  }
+  
+  
+  /**
+     Build a two-link pendulum: a spherical joint at the root,
+     followed by a revolute joint around X. The ball joint starts
+     out tilted and spinning, so all three of its axes are excited.
+  */
+  inline taoNodeRoot * create_ball_pendulum()
+  {
+    deFrame global;
+    global.identity();
+    taoNodeRoot * root(new taoNodeRoot(global));
+    root->setID(-1);
+    
+    taoDNode * parent(root);
+    for (int ii(0); ii < 2; ++ii) {
+      deFrame home(0, 0, -0.3 * ii);
+      taoNode * node(new taoNode(parent, &home));
+      deFrame com(0.02, 0.01, -0.15);
+      deMassProp mp;
+      mp.inertia(0.01, 0.012, 0.004, &com);
+      mp.mass(1.5 - 0.5 * ii, &com);
+      mp.get(node->mass(), node->center(), node->inertia());
+      node->setID(ii);
+      taoJoint * joint;
+      if (0 == ii) {
+	joint = new taoJointSpherical();
+	joint->setDVar(new taoVarSpherical);
+      }
+      else {
+	joint = new taoJointRevolute(TAO_AXIS_X);
+	joint->setDVar(new taoVarDOF1);
+      }
+      joint->reset();
+      joint->setDamping(0.0);
+      joint->setInertia(0.0);
+      node->addJoint(joint);
+      node->addABNode();
+      parent = node;
+    }
+    
+    taoDynamics::initialize(root);
+    
+    taoJoint * ball(root->getDChild()->getJointList());
+    deQuaternion q;
+    q.set(deVector3(0.6, 0, 0.8), 0.7);
+    deFloat const dq[3] = { 0.4, -1.1, 2.0 };
+    ball->setQ(q);
+    ball->setDQ(dq);
+    static_cast<taoJointSpherical*>(ball)->getVarSpherical()->_dQrotated.multiply(q, deVector3(dq[0], dq[1], dq[2]));
+    deFloat const elbow(0.5);
+    root->getDChild()->getDChild()->getJointList()->setQ(&elbow);
+    taoDynamics::updateTransformation(root);
+    return root;
+  }
+  
+  
+  inline void zero_tau(taoABTraversal const & tree)
+  {
+    for (int ii(1); ii < tree.size(); ++ii) {
+      for (taoJoint * jj(tree.node(ii)->getJointList()); 0 != jj; jj = jj->getNext()) {
+	jj->zeroTau();
+      }
+    }
+  }
+  
+  
+  inline deFloat total_energy(taoABTraversal const & tree, deVector3 const & gravity)
+  {
+    return taoDynamics::kineticEnergy(&tree) + taoDynamics::potentialEnergy(&tree, &gravity);
+  }
+  
+  
+  /**
+     Simulate the unactuated tree for nsteps and return the largest
+     deviation of its total energy from the initial value. The tree
+     is left in its final state.
+  */
+  inline deFloat energy_drift(taoABTraversal const & tree, taoIntegrator & integrator,
+			      deVector3 const & gravity, deFloat dt, int nsteps)
+  {
+    zero_tau(tree);
+    if ( ! integrator.build(&tree)) {
+      return NAN;
+    }
+    taoDynamics::updateTransformation(&tree);
+    taoDynamics::fwdDynamics(&tree, &gravity);
+    deFloat const e0(total_energy(tree, gravity));
+    deFloat drift(0);
+    for (int ii(0); ii < nsteps; ++ii) {
+      integrator.integrate(&gravity, dt);
+      taoDynamics::updateTransformation(&tree);
+      taoDynamics::fwdDynamics(&tree, &gravity);
+      deFloat const de(fabs(total_energy(tree, gravity) - e0));
+      if ( ! (de <= drift)) {	// also propagates NaN
+	drift = de;
+      }
+    }
+    return drift;
+  }
+  
+} // namespace tao_test
+
+#endif // TAO_TESTS_CHAIN_H
@@ -23,10 +23,125 @@
    \author Roland Philippsen
 */
 
+#include "chain.h"
 #include <tao/utility/TaoDeMassProp.h>
+#include <tao/dynamics/taoDynamics.h>
+#include <tao/dynamics/taoWorld.h>
+#include <tao/dynamics/taoGroup.h>
+#include <tao/utility/TaoDeThreadPool.h>
+#include <tao/utility/TaoDeLogger.h>
 #include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <unistd.h>
 
 using namespace std;
+using namespace tao_test;
+
+
+TEST (ab_traversal, order)
+{
+  taoNodeRoot * root(create_chain(7, 3));
+  taoABTraversal tree(root);
+  ASSERT_EQ (11, tree.size()); // root, 7 links, 3 side branches
+  EXPECT_EQ (root, tree.root());
+  EXPECT_EQ (-1, tree.parent(0));
+  EXPECT_EQ (0, tree.postorder(tree.size() - 1));
+  
+  vector<int> seen(tree.size(), 0);
+  for (int kk(0); kk < tree.size(); ++kk) {
+    int const ii(tree.postorder(kk));
+    ++seen[ii];
+    // every child must have been emitted before its parent
+    for (int jj(ii + 1); jj < tree.size(); ++jj) {
+      if (tree.parent(jj) == ii) {
+	EXPECT_EQ (1, seen[jj]) << "child " << jj << " of " << ii;
+      }
+    }
+  }
+  for (int ii(1); ii < tree.size(); ++ii) {
+    EXPECT_LT (tree.parent(ii), ii);
+    EXPECT_EQ (tree.node(tree.parent(ii)), tree.node(ii)->getDParent());
+    EXPECT_EQ (1, seen[ii]);
+  }
+  
+  delete root;
+}
+
+
+TEST (ab_traversal, matches_recursive)
+{
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  
+  taoNodeRoot * root(create_chain(12, 4));
+  taoABTraversal tree(root);
+  int const ndof(taoDynamics::computeDOF(root));
+  vector<deFloat> ddq_rec(ndof), ddq_it(ndof);
+  vector<deFloat> tau_rec(ndof), tau_it(ndof);
+  
+  set_state(tree);
+  taoDynamics::fwdDynamics(root, &gravity);
+  for (int ii(1); ii < tree.size(); ++ii) {
+    tree.node(ii)->getJointList()->getDDQ(&ddq_rec[tree.node(ii)->getID()]);
+  }
+  deFloat const ke_rec(taoDynamics::kineticEnergy(root));
+  deFloat const pe_rec(taoDynamics::potentialEnergy(root, &gravity));
+  taoDynamics::invDynamics(root, &gravity);
+  for (int ii(1); ii < tree.size(); ++ii) {
+    tree.node(ii)->getJointList()->getTau(&tau_rec[tree.node(ii)->getID()]);
+  }
+  
+  set_state(tree);
+  taoDynamics::fwdDynamics(&tree, &gravity);
+  for (int ii(1); ii < tree.size(); ++ii) {
+    tree.node(ii)->getJointList()->getDDQ(&ddq_it[tree.node(ii)->getID()]);
+  }
+  deFloat const ke_it(taoDynamics::kineticEnergy(&tree));
+  deFloat const pe_it(taoDynamics::potentialEnergy(&tree, &gravity));
+  taoDynamics::invDynamics(&tree, &gravity);
+  for (int ii(1); ii < tree.size(); ++ii) {
+    tree.node(ii)->getJointList()->getTau(&tau_it[tree.node(ii)->getID()]);
+  }
+  
+  for (int ii(0); ii < ndof; ++ii) {
+    EXPECT_EQ (ddq_rec[ii], ddq_it[ii]) << "ddq[" << ii << "]";
+    EXPECT_EQ (tau_rec[ii], tau_it[ii]) << "tau[" << ii << "]";
+  }
+  EXPECT_EQ (ke_rec, ke_it);
+  EXPECT_EQ (pe_rec, pe_it);
+  
+  delete root;
+}
+
+
+TEST (ab_traversal, deep_chain)
+{
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  
+  taoNodeRoot * root(create_chain(150, 0));
+  taoABTraversal tree(root);
+  ASSERT_EQ (151, tree.size());
+  
+  set_state(tree);
+  taoDynamics::fwdDynamics(&tree, &gravity);
+  for (int ii(1); ii < tree.size(); ++ii) {
+    deFloat ddq;
+    tree.node(ii)->getJointList()->getDDQ(&ddq);
+    ASSERT_TRUE (ddq == ddq) << "NaN at node " << ii;
+  }
+  
+  // reusing the traversal for a smaller tree must not reallocate or break
+  taoNodeRoot * small(create_chain(3, 0));
+  tree.build(small);
+  EXPECT_EQ (4, tree.size());
+  EXPECT_EQ (small, tree.root());
+  
+  delete small;
+  delete root;
+}
 
 
 TEST (mass_prop, point_inertias)
@@ -211,6 +326,373 @@ TEST (mass_prop, translate_inertia)
 }
 
 
+TEST (cached_frame, matches_quaternion)
+{
+  deFrame f1, f2;
+  f1.rotation().set(deVector3(0.6, 0.0, 0.8), 0.7);
+  f1.translation().set(0.1, 0.2, -0.3);
+  f2.rotation().set(deVector3(0.0, 0.6, -0.8), -1.3);
+  f2.translation().set(-0.4, 0.05, 0.6);
+  
+  deCachedFrame c1;
+  c1.set(f1);
+  deCachedFrame c12;
+  c12.multiply(c1, f2);
+  deFrame f12;
+  f12.multiply(f1, f2);
+  
+  deTransform x12;
+  x12.set(f12);
+  for (int ii(0); ii < 3; ++ii) {
+    EXPECT_NEAR (f12.translation()[ii], c12.translation()[ii], 1e-12) << "translation[" << ii << "]";
+    for (int jj(0); jj < 3; ++jj) {
+      EXPECT_NEAR (x12.rotation().elementAt(ii, jj), c12.rotationMatrix().elementAt(ii, jj), 1e-12)
+	<< "rotation(" << ii << ", " << jj << ")";
+    }
+  }
+  for (int ii(0); ii < 4; ++ii) {
+    EXPECT_EQ (f12.rotation()[ii], c12.frame().rotation()[ii]) << "quaternion[" << ii << "]";
+  }
+}
+
+
+TEST (cached_frame, tree_update)
+{
+  taoNodeRoot * root(create_chain(9, 2));
+  taoABTraversal tree(root);
+  set_state(tree);
+  
+  for (int kk(1); kk < tree.size(); ++kk) {
+    taoDNode * node(tree.node(kk));
+    deCachedFrame const * cached(node->cachedFrameGlobal());
+    ASSERT_TRUE (cached);
+    
+    // recompute the global frame with quaternions only
+    deFrame local(*node->frameHome());
+    deFrame fl, tmp;
+    fl.identity();
+    node->getJointList()->updateFrameLocal(&fl);
+    tmp = local;
+    local.multiply(tmp, fl);
+    deFrame global;
+    global.multiply(*node->getDParent()->frameGlobal(), local);
+    
+    deTransform check;
+    check.set(*node->frameGlobal());
+    for (int ii(0); ii < 3; ++ii) {
+      EXPECT_NEAR (global.translation()[ii], cached->translation()[ii], 1e-12);
+      for (int jj(0); jj < 3; ++jj) {
+	EXPECT_EQ (check.rotation().elementAt(ii, jj), cached->rotationMatrix().elementAt(ii, jj));
+      }
+    }
+  }
+  
+  delete root;
+}
+
+
+static void expect_cache_matches(deCachedFrame const & cached, char const * what)
+{
+  deTransform check;
+  check.set(cached.frame());
+  for (int ii(0); ii < 3; ++ii) {
+    for (int jj(0); jj < 3; ++jj) {
+      EXPECT_EQ (check.rotation().elementAt(ii, jj), cached.rotationMatrix().elementAt(ii, jj))
+	<< what << " rotation(" << ii << ", " << jj << ")";
+    }
+  }
+}
+
+
+TEST (cached_frame, sync)
+{
+  taoNodeRoot * root(create_chain(9, 2));
+  taoABTraversal tree(root);
+  set_state(tree);
+  
+  // home frames only change through sync(), which keeps the cached
+  // matrices up to date without waiting for updateFrame()
+  deFrame frame;
+  frame.rotation().set(deVector3(0.0, 0.6, 0.8), 0.4);
+  frame.translation().set(0.3, -0.2, 0.1);
+  root->sync(&frame);
+  ASSERT_TRUE (root->cachedFrameGlobal());
+  expect_cache_matches(*root->cachedFrameGlobal(), "root");
+  
+  taoDNode * node(tree.node(3));
+  frame.rotation().set(deVector3(0.8, 0.0, -0.6), -0.9);
+  node->sync(&frame);
+  ASSERT_TRUE (node->cachedFrameHome());
+  expect_cache_matches(*node->cachedFrameHome(), "home");
+  for (int ii(0); ii < 4; ++ii) {
+    EXPECT_EQ (frame.rotation()[ii], node->frameHome()->rotation()[ii]);
+  }
+  
+  taoDynamics::updateTransformation(root);
+  for (int kk(0); kk < tree.size(); ++kk) {
+    expect_cache_matches(*tree.node(kk)->cachedFrameGlobal(), "global");
+  }
+  
+  delete root;
+}
+
+
+TEST (integrator, euler_matches_legacy)
+{
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  
+  taoNodeRoot * legacy(create_chain(9, 3));
+  taoNodeRoot * root(create_chain(9, 3));
+  taoABTraversal legacy_tree(legacy), tree(root);
+  set_state(legacy_tree);
+  set_state(tree);
+  taoIntegrator integrator;
+  EXPECT_EQ (TAO_INTEGRATOR_EULER, integrator.getType());
+  ASSERT_TRUE (integrator.build(&tree));
+  
+  for (int ii(0); ii < 20; ++ii) {
+    taoDynamics::fwdDynamics(&legacy_tree, &gravity);
+    taoDynamics::integrate(legacy, 1e-3);
+    taoDynamics::updateTransformation(legacy);
+    taoDynamics::fwdDynamics(&tree, &gravity);
+    integrator.integrate(&gravity, 1e-3);
+    taoDynamics::updateTransformation(&tree);
+  }
+  
+  for (int ii(1); ii < tree.size(); ++ii) {
+    deFloat qa, qb, dqa, dqb;
+    legacy_tree.node(ii)->getJointList()->getQ(&qa);
+    tree.node(ii)->getJointList()->getQ(&qb);
+    legacy_tree.node(ii)->getJointList()->getDQ(&dqa);
+    tree.node(ii)->getJointList()->getDQ(&dqb);
+    EXPECT_EQ (qa, qb) << "node " << ii;
+    EXPECT_EQ (dqa, dqb) << "node " << ii;
+  }
+  
+  delete legacy;
+  delete root;
+}
+
+
+TEST (integrator, state_roundtrip)
+{
+  taoNodeRoot * root(create_ball_pendulum());
+  taoABTraversal tree(root);
+  taoIntegrator integrator;
+  ASSERT_TRUE (integrator.build(&tree));
+  ASSERT_EQ (5, integrator.getSizeQ());
+  ASSERT_EQ (4, integrator.getSizeDQ());
+  
+  vector<deFloat> q(5), dq(4), q2(5), dq2(4);
+  integrator.readState(&q[0], &dq[0]);
+  integrator.writeState(&q[0], &dq[0]);
+  integrator.readState(&q2[0], &dq2[0]);
+  for (int ii(0); ii < 5; ++ii) {
+    EXPECT_NEAR (q[ii], q2[ii], 1e-12) << "q[" << ii << "]";
+  }
+  for (int ii(0); ii < 4; ++ii) {
+    EXPECT_NEAR (dq[ii], dq2[ii], 1e-12) << "dq[" << ii << "]";
+  }
+  
+  delete root;
+}
+
+
+TEST (integrator, rejects_user_joint)
+{
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  taoNodeRoot * root(create_chain(3, 0));
+  taoABTraversal tree(root);
+  set_state(tree);
+  taoJoint * joint(tree.node(2)->getJointList());
+  joint->setType(TAO_JOINT_USER);
+  
+  taoIntegrator integrator(TAO_INTEGRATOR_RK4);
+  EXPECT_FALSE (integrator.build(&tree));
+  EXPECT_EQ (0, integrator.getSizeQ());
+  EXPECT_EQ (0, integrator.getSizeDQ());
+  
+  deFloat q0, q1;
+  joint->getQ(&q0);
+  taoDynamics::fwdDynamics(&tree, &gravity);
+  integrator.integrate(&gravity, 1e-3);
+  joint->getQ(&q1);
+  EXPECT_EQ (q0, q1) << "an empty integrator should not touch the tree";
+  
+  joint->setType(TAO_JOINT_REVOLUTE);
+  EXPECT_TRUE (integrator.build(&tree));
+  EXPECT_EQ (3, integrator.getSizeQ());
+  
+  delete root;
+}
+
+
+TEST (integrator, energy_drift)
+{
+  deVector3 gravity;
+  gravity.set(0, 0, -9.81);
+  taoIntegratorType const type[] = {
+    TAO_INTEGRATOR_EULER,
+    TAO_INTEGRATOR_RK4
+  };
+  
+  for (int model(0); model < 3; ++model) {
+    deFloat drift[2];
+    for (int ii(0); ii < 2; ++ii) {
+      taoNodeRoot * root(2 == model ? create_ball_pendulum() : create_chain(0 == model ? 1 : 5, 0));
+      taoABTraversal tree(root);
+      if (2 != model) {
+	set_state(tree);
+      }
+      taoIntegrator integrator(type[ii]);
+      drift[ii] = energy_drift(tree, integrator, gravity, 2e-3, 500);
+      delete root;
+    }
+    EXPECT_LT (100 * drift[1], drift[0]) << "model " << model;
+  }
+}
+
+
+TEST (thread_pool, runs_all_jobs)
+{
+  static int const njobs(37);
+  struct counter {
+    static void job(void * arg, deInt index) { ++static_cast<int*>(arg)[index]; }
+  };
+  for (int spin(0); spin <= 1; ++spin) {
+    for (int nthreads(1); nthreads <= 4; ++nthreads) {
+      deThreadPool pool(nthreads, spin);
+      EXPECT_EQ (nthreads, pool.getNumThreads());
+      EXPECT_EQ (spin, pool.isSpinning());
+      vector<int> count(njobs, 0);
+      for (int ii(0); ii < 300; ++ii) {
+	pool.run(counter::job, &count[0], njobs);
+      }
+      for (int ii(0); ii < njobs; ++ii) {
+	EXPECT_EQ (300, count[ii]) << "job " << ii << " with " << nthreads << " threads, spin " << spin;
+      }
+    }
+  }
+}
+
+
+TEST (world, parallel_matches_serial)
+{
+  static int const nrobots(5);
+  taoWorld serial, parallel;
+  vector<taoNodeRoot*> serial_roots, parallel_roots;
+  for (int ii(0); ii < nrobots; ++ii) {
+    for (int jj(0); jj < 2; ++jj) {
+      taoNodeRoot * root(create_chain(4 + ii, 2));
+      taoABTraversal tree(root);
+      set_state(tree);
+      taoGroup * group(new taoGroup());
+      group->gravity()->set(0, 0, -9.81);
+      group->addRoot(root, ii);
+      if (0 == jj) {
+	serial.addGroup(group, ii);
+	serial_roots.push_back(root);
+      }
+      else {
+	parallel.addGroup(group, ii);
+	parallel_roots.push_back(root);
+      }
+    }
+  }
+  
+  deThreadPool pool(3);
+  parallel.setThreadPool(&pool);
+  for (int ii(0); ii < 50; ++ii) {
+    serial.update(ii * 1e-3, 1e-3, 2);
+    parallel.update(ii * 1e-3, 1e-3, 2);
+  }
+  
+  for (int ii(0); ii < nrobots; ++ii) {
+    taoABTraversal ts(serial_roots[ii]), tp(parallel_roots[ii]);
+    ASSERT_EQ (ts.size(), tp.size());
+    for (int jj(1); jj < ts.size(); ++jj) {
+      deFloat qs, qp;
+      ts.node(jj)->getJointList()->getQ(&qs);
+      tp.node(jj)->getJointList()->getQ(&qp);
+      EXPECT_EQ (qs, qp) << "robot " << ii << " node " << jj;
+    }
+  }
+}
+
+
+namespace {
+  
+  class CollectOutput : public deLoggerOutput {
+  public:
+    CollectOutput(): hold(0), entered(0) {}
+    
+    virtual void Log(deChar * msg) {
+      entered = 1;
+      while (hold) {
+	usleep(100);
+      }
+      messages.push_back(msg);
+    }
+    
+    vector<string> messages;
+    volatile int hold;
+    volatile int entered;
+  };
+  
+}
+
+
+TEST (logger, async_output_in_order)
+{
+  CollectOutput * sink(new CollectOutput());
+  deLoggerOutputAsync async(sink, 16, 32, 100);
+  char msg[64];
+  for (int ii(0); ii < 100; ++ii) {
+    sprintf(msg, "message %d", ii);
+    async.Log(msg);
+    if (ii % 10 == 9) {
+      async.Flush();
+    }
+  }
+  async.Flush();
+  EXPECT_EQ (0, async.GetDropped());
+  ASSERT_EQ (100u, sink->messages.size());
+  for (int ii(0); ii < 100; ++ii) {
+    sprintf(msg, "message %d", ii);
+    EXPECT_EQ (string(msg), sink->messages[ii]);
+  }
+  
+  async.Log((deChar*) "a message that is longer than the thirty-two byte records");
+  async.Flush();
+  EXPECT_EQ (31u, sink->messages.back().size());
+}
+
+
+TEST (logger, async_output_drops_when_full)
+{
+  CollectOutput * sink(new CollectOutput());
+  sink->hold = 1;
+  deLoggerOutputAsync async(sink, 4, 32, 100);
+  async.Log((deChar*) "first");
+  while ( ! sink->entered) {
+    usleep(100);
+  }
+  
+  // the first record stays in the ring until the sink returns
+  for (int ii(0); ii < 10; ++ii) {
+    async.Log((deChar*) "more");
+  }
+  EXPECT_EQ (7, async.GetDropped());
+  
+  sink->hold = 0;
+  async.Flush();
+  EXPECT_EQ (4u, sink->messages.size());
+  EXPECT_EQ (string("first"), sink->messages[0]);
+}
+
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -91,7 +91,7 @@ namespace tut02 {
     }
     
     
-    virtual jspace::Status update(jspace::Model const & model)
+    virtual jspace::RTStatus update(jspace::Model const & model)
     {
       //////////////////////////////////////////////////
       // Update the state of our task. Again, this is not critical
@@ -106,7 +106,7 @@ namespace tut02 {
 
       command_ = kp_ * (goal_ - actual_) - kd_ * model.getState().velocity_;
       
-      jspace::Status ok;
+      jspace::RTStatus ok;
       return ok;
     }
     
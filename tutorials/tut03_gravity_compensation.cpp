@@ -84,7 +84,7 @@ namespace tut03 {
     }
     
     
-    virtual jspace::Status update(jspace::Model const & model)
+    virtual jspace::RTStatus update(jspace::Model const & model)
     {
       //////////////////////////////////////////////////
       // Update the state of our task. Again, this is not critical
@@ -103,12 +103,12 @@ namespace tut03 {
       if (enable_gravity_compensation_) {
 	jspace::Vector gg;
 	if ( ! model.getGravity(gg)) {
-	  return jspace::Status(false, "failed to retrieve gravity torque");
+	  return jspace::RTStatus(jspace::STATUS_FAILED, "failed to retrieve gravity torque");
 	}
 	command_ += gg;
       }
       
-      jspace::Status ok;
+      jspace::RTStatus ok;
       return ok;
     }
     
@@ -85,7 +85,7 @@ namespace tut04 {
     }
     
     
-    virtual jspace::Status update(jspace::Model const & model)
+    virtual jspace::RTStatus update(jspace::Model const & model)
     {
       //////////////////////////////////////////////////
       // Lazy init...
@@ -113,7 +113,7 @@ namespace tut04 {
       if (inertia_compensation_) {
 	jspace::Matrix aa;
 	if ( ! model.getMassInertia(aa)) {
-	  return jspace::Status(false, "failed to retrieve inertia");
+	  return jspace::RTStatus(jspace::STATUS_FAILED, "failed to retrieve inertia");
 	}
 	command_ = aa * gamma;
       }
@@ -124,18 +124,18 @@ namespace tut04 {
       if (coriolis_compensation_) {
 	jspace::Vector cc;
 	if ( ! model.getCoriolisCentrifugal(cc)) {
-	  return jspace::Status(false, "failed to retrieve coriolis");
+	  return jspace::RTStatus(jspace::STATUS_FAILED, "failed to retrieve coriolis");
 	}
 	command_ += cc;
       }
       
       jspace::Vector gg;
       if ( ! model.getGravity(gg)) {
-	return jspace::Status(false, "failed to retrieve gravity torque");
+	return jspace::RTStatus(jspace::STATUS_FAILED, "failed to retrieve gravity torque");
       }
       command_ += gg;
       
-      jspace::Status ok;
+      jspace::RTStatus ok;
       return ok;
     }
 
@@ -135,7 +135,7 @@ namespace tut05 {
     }
     
     
-    virtual jspace::Status update(jspace::Model const & model)
+    virtual jspace::RTStatus update(jspace::Model const & model)
     {
       //////////////////////////////////////////////////
       // Lazy init...
@@ -158,7 +158,7 @@ namespace tut05 {
       
       command_ = kp_ * (goalpos_ - actual_) + kd_ * (goalvel_ - curvel_);
       
-      jspace::Status ok;
+      jspace::RTStatus ok;
       return ok;
     }
 